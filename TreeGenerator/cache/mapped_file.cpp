@@ -0,0 +1,134 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tree_generator
+{
+	MappedFile::MappedFile(const std::filesystem::path& path)
+	{
+		const std::string error = "Couldn't map " + path.string();
+#ifdef _WIN32
+		HANDLE file = CreateFileW(
+			path.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_DELETE,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error(error);
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			throw std::runtime_error(error);
+		}
+		size_ = static_cast<std::size_t>(size.QuadPart);
+		if (size_ > 0)
+		{
+			// The mapping keeps the file open by itself.
+			mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+			if (mapping_ == nullptr)
+			{
+				throw std::runtime_error(error);
+			}
+			data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+			if (data_ == nullptr)
+			{
+				CloseHandle(mapping_);
+				throw std::runtime_error(error);
+			}
+		}
+		else
+		{
+			CloseHandle(file);
+		}
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			throw std::runtime_error(error);
+		}
+		struct stat status;
+		if (fstat(file, &status) != 0)
+		{
+			close(file);
+			throw std::runtime_error(error);
+		}
+		size_ = static_cast<std::size_t>(status.st_size);
+		if (size_ > 0)
+		{
+			void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, file, 0);
+			if (data == MAP_FAILED)
+			{
+				close(file);
+				throw std::runtime_error(error);
+			}
+			data_ = static_cast<const std::byte*>(data);
+		}
+		// The mapping keeps the file open by itself.
+		close(file);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Unmap();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept :
+		data_(std::exchange(other.data_, nullptr)),
+		size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+		, mapping_(std::exchange(other.mapping_, nullptr))
+#endif
+	{
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Unmap();
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+			mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+		}
+		return *this;
+	}
+
+	void MappedFile::Unmap()
+	{
+		if (data_ == nullptr)
+		{
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(data_);
+		CloseHandle(mapping_);
+		mapping_ = nullptr;
+#else
+		munmap(const_cast<std::byte*>(data_), size_);
+#endif
+		data_ = nullptr;
+		size_ = 0;
+	}
+}
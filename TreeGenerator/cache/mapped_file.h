@@ -0,0 +1,42 @@
+#ifndef TREE_GENERATOR_CACHE_MAPPED_FILE_H_
+#define TREE_GENERATOR_CACHE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace tree_generator
+{
+	// A whole file mapped read-only into memory. Pages are loaded by the
+	// operating system as they're first touched, and shared between every
+	// process mapping the same file.
+	class MappedFile
+	{
+	public:
+		// Throws a std::runtime_error if the file can't be opened or mapped.
+		explicit MappedFile(const std::filesystem::path& path);
+		~MappedFile();
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// Disallow copy
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// The mapping starts on a page boundary, so it is aligned for any
+		// type.
+		std::span<const std::byte> Data() const { return { data_, size_ }; }
+
+	private:
+		const std::byte* data_ = nullptr;
+		std::size_t size_ = 0;
+#ifdef _WIN32
+		void* mapping_ = nullptr;
+#endif
+
+		void Unmap();
+	};
+}
+
+#endif  // !TREE_GENERATOR_CACHE_MAPPED_FILE_H_
@@ -0,0 +1,496 @@
+#include "tree_cache.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "../graphics/common/mesh_data.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr char kMagic[8] = { 'T', 'G', 'T', 'R', 'E', 'E', '\0', '\0' };
+
+		// Written natively, so that files from a machine of the other byte
+		// order can be told apart.
+		constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+		// Every section starts on this boundary, as InstanceBuffer's storage
+		// does, so the arrays can be read with aligned SIMD loads.
+		constexpr std::size_t kSectionAlignment = 64;
+
+		struct Section
+		{
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+
+		enum SectionIndex
+		{
+			kGroups,
+			kMeshes,
+			kLods,
+			kVertices,
+			kIndices,
+			kInstances,
+			kMinX,
+			kMinY,
+			kMinZ,
+			kMaxX,
+			kMaxY,
+			kMaxZ,
+			kSectionCount,
+		};
+
+		struct FileHeader
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t byteOrderMark;
+			std::uint64_t fileSize;
+			std::uint64_t keyLow;
+			std::uint64_t keyHigh;
+			float boundsMin[3];
+			float boundsMax[3];
+			std::uint32_t groupCount;
+			std::uint32_t meshCount;
+			std::uint32_t lodCount;
+			std::uint32_t reserved;
+			std::uint64_t instanceCount;
+			Section sections[kSectionCount];
+		};
+
+		struct GroupRecord
+		{
+			float color[4];
+			std::uint64_t firstInstance;
+			std::uint64_t instanceCount;
+
+			// Range of the lod table holding the indices of the group's mesh
+			// at each level of detail.
+			std::uint32_t firstLod;
+			std::uint32_t lodCount;
+
+			std::uint32_t symbol;
+			std::uint32_t reserved;
+		};
+
+		struct MeshRecord
+		{
+			std::uint64_t firstVertex;
+			std::uint64_t vertexCount;
+			std::uint64_t firstIndex;
+			std::uint64_t indexCount;
+		};
+
+		static_assert(std::is_trivially_copyable_v<Vertex> && sizeof(Vertex) == 8 * sizeof(float));
+		static_assert(std::is_trivially_copyable_v<glm::mat4> && sizeof(glm::mat4) == 16 * sizeof(float));
+		static_assert(sizeof(GroupRecord) == 48 && sizeof(MeshRecord) == 32);
+
+		std::size_t Align(std::size_t offset)
+		{
+			return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+		}
+
+		void Fail(const std::filesystem::path& path, const std::string& reason)
+		{
+			throw std::runtime_error("Invalid tree cache file " + path.string() + ": " + reason);
+		}
+
+		const FileHeader& GetHeader(std::span<const std::byte> data)
+		{
+			return *reinterpret_cast<const FileHeader*>(data.data());
+		}
+
+		template <typename T>
+		std::span<const T> GetSection(std::span<const std::byte> data, SectionIndex index)
+		{
+			const Section& section = GetHeader(data).sections[index];
+			return {
+				reinterpret_cast<const T*>(data.data() + section.offset),
+				static_cast<std::size_t>(section.size / sizeof(T)) };
+		}
+
+		// Checks the header, and that every section and table entry lies
+		// within the file.
+		void Validate(const std::filesystem::path& path, std::span<const std::byte> data)
+		{
+			if (data.size() < sizeof(FileHeader))
+			{
+				Fail(path, "too small");
+			}
+			const FileHeader& header = GetHeader(data);
+			if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+			{
+				Fail(path, "not a tree cache file");
+			}
+			if (header.version != CachedTree::kVersion)
+			{
+				Fail(path, "version " + std::to_string(header.version));
+			}
+			if (header.byteOrderMark != kByteOrderMark)
+			{
+				Fail(path, "different byte order");
+			}
+			if (header.fileSize != data.size())
+			{
+				Fail(path, "truncated");
+			}
+
+			const std::uint64_t sizes[kSectionCount] = {
+				header.groupCount * sizeof(GroupRecord),
+				header.meshCount * sizeof(MeshRecord),
+				header.lodCount * sizeof(std::uint32_t),
+				header.sections[kVertices].size / sizeof(Vertex) * sizeof(Vertex),
+				header.sections[kIndices].size / sizeof(std::uint32_t) * sizeof(std::uint32_t),
+				header.instanceCount * sizeof(glm::mat4),
+				header.instanceCount * sizeof(float),
+				header.instanceCount * sizeof(float),
+				header.instanceCount * sizeof(float),
+				header.instanceCount * sizeof(float),
+				header.instanceCount * sizeof(float),
+				header.instanceCount * sizeof(float),
+			};
+			for (int i = 0; i < kSectionCount; ++i)
+			{
+				const Section& section = header.sections[i];
+				if (section.offset % kSectionAlignment != 0 ||
+					section.size != sizes[i] ||
+					section.offset > data.size() ||
+					section.size > data.size() - section.offset)
+				{
+					Fail(path, "section " + std::to_string(i) + " out of bounds");
+				}
+			}
+
+			const std::size_t vertexCount = header.sections[kVertices].size / sizeof(Vertex);
+			const std::size_t indexCount = header.sections[kIndices].size / sizeof(std::uint32_t);
+			for (const MeshRecord& mesh : GetSection<MeshRecord>(data, kMeshes))
+			{
+				if (mesh.firstVertex > vertexCount || mesh.vertexCount > vertexCount - mesh.firstVertex ||
+					mesh.firstIndex > indexCount || mesh.indexCount > indexCount - mesh.firstIndex)
+				{
+					Fail(path, "mesh out of bounds");
+				}
+			}
+			for (std::uint32_t mesh : GetSection<std::uint32_t>(data, kLods))
+			{
+				if (mesh >= header.meshCount)
+				{
+					Fail(path, "level of detail out of bounds");
+				}
+			}
+			for (const GroupRecord& group : GetSection<GroupRecord>(data, kGroups))
+			{
+				if (group.firstInstance > header.instanceCount ||
+					group.instanceCount > header.instanceCount - group.firstInstance ||
+					group.lodCount == 0 ||
+					group.firstLod > header.lodCount ||
+					group.lodCount > header.lodCount - group.firstLod)
+				{
+					Fail(path, "group out of bounds");
+				}
+			}
+		}
+
+		class SectionWriter
+		{
+		public:
+			explicit SectionWriter(std::ostream* output) : output_(output) {}
+
+			std::uint64_t Offset() const { return offset_; }
+
+			void Write(const void* data, std::size_t size)
+			{
+				output_->write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+				offset_ += size;
+			}
+
+			void PadToSection()
+			{
+				static constexpr char kZeros[kSectionAlignment] = {};
+				Write(kZeros, Align(offset_) - offset_);
+			}
+
+		private:
+			std::ostream* output_;
+			std::uint64_t offset_ = 0;
+		};
+	}
+
+	CachedTree::CachedTree(const std::filesystem::path& path) :
+		file_(path)
+	{
+		const std::span<const std::byte> data = file_.Data();
+		Validate(path, data);
+
+		const FileHeader& header = GetHeader(data);
+		key_ = { header.keyLow, header.keyHigh };
+		bounds_.min = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		bounds_.max = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+		instances_ = GetSection<glm::mat4>(data, kInstances);
+		for (int i = 0; i < 6; ++i)
+		{
+			instanceBounds_[i] = GetSection<float>(data, static_cast<SectionIndex>(kMinX + i));
+		}
+	}
+
+	std::vector<lsystem::MatrixMeshGroup> CachedTree::GetGroups() const
+	{
+		const std::span<const std::byte> data = file_.Data();
+		const std::span<const Vertex> vertices = GetSection<Vertex>(data, kVertices);
+		const std::span<const std::uint32_t> indices = GetSection<std::uint32_t>(data, kIndices);
+		const std::span<const std::uint32_t> lods = GetSection<std::uint32_t>(data, kLods);
+
+		std::vector<std::shared_ptr<const MeshData>> meshes;
+		for (const MeshRecord& record : GetSection<MeshRecord>(data, kMeshes))
+		{
+			auto mesh = std::make_shared<MeshData>();
+			mesh->vertices.assign(
+				vertices.begin() + record.firstVertex,
+				vertices.begin() + record.firstVertex + record.vertexCount);
+			mesh->indices.assign(
+				indices.begin() + record.firstIndex,
+				indices.begin() + record.firstIndex + record.indexCount);
+			for (unsigned int index : mesh->indices)
+			{
+				if (index >= mesh->vertices.size())
+				{
+					throw std::runtime_error("Invalid tree cache file: index out of bounds");
+				}
+			}
+			meshes.push_back(std::move(mesh));
+		}
+
+		std::vector<lsystem::MatrixMeshGroup> groups;
+		for (const GroupRecord& record : GetSection<GroupRecord>(data, kGroups))
+		{
+			lsystem::MatrixMeshGroup& group = groups.emplace_back();
+			group.instances = instances_.subspan(record.firstInstance, record.instanceCount);
+			group.material.color = glm::vec4(
+				record.color[0], record.color[1], record.color[2], record.color[3]);
+			for (std::uint32_t lod = 0; lod < record.lodCount; ++lod)
+			{
+				group.lods.push_back(meshes[lods[record.firstLod + lod]]);
+			}
+			group.mesh = group.lods.front();
+			group.symbol = static_cast<lsystem::Symbol>(record.symbol);
+		}
+		return groups;
+	}
+
+	InstanceBounds CachedTree::GetInstanceBounds() const
+	{
+		InstanceBounds bounds;
+		bounds.Resize(instances_.size());
+		for (std::size_t i = 0; i < instances_.size(); ++i)
+		{
+			BoundingBox box;
+			box.min = glm::vec3(MinX()[i], MinY()[i], MinZ()[i]);
+			box.max = glm::vec3(MaxX()[i], MaxY()[i], MaxZ()[i]);
+			bounds.Set(i, box);
+		}
+		return bounds;
+	}
+
+	void WriteCachedTree(
+		const utility::ContentHash& key,
+		std::span<const lsystem::MatrixMeshGroup> groups,
+		const InstanceBounds& bounds,
+		std::ostream* output)
+	{
+		// Tables first, to lay out the file before writing any of it.
+		std::vector<GroupRecord> groupRecords;
+		std::vector<MeshRecord> meshRecords;
+		std::vector<std::uint32_t> lods;
+		std::vector<const MeshData*> meshes;
+		std::unordered_map<const MeshData*, std::uint32_t> meshIndices;
+		std::uint64_t instanceCount = 0;
+		std::uint64_t vertexCount = 0;
+		std::uint64_t indexCount = 0;
+		for (const lsystem::MatrixMeshGroup& group : groups)
+		{
+			GroupRecord& record = groupRecords.emplace_back();
+			std::memcpy(record.color, &group.material.color.x, sizeof(record.color));
+			record.firstInstance = instanceCount;
+			record.instanceCount = group.instances.size();
+			instanceCount += group.instances.size();
+
+			// Groups always have their mesh as the first level of detail.
+			std::vector<const MeshData*> groupLods = { group.mesh.get() };
+			for (std::size_t lod = 1; lod < group.lods.size(); ++lod)
+			{
+				groupLods.push_back(group.lods[lod].get());
+			}
+			record.firstLod = static_cast<std::uint32_t>(lods.size());
+			record.lodCount = static_cast<std::uint32_t>(groupLods.size());
+			record.symbol = static_cast<unsigned char>(group.symbol);
+			for (const MeshData* mesh : groupLods)
+			{
+				auto [entry, isNew] = meshIndices.try_emplace(
+					mesh, static_cast<std::uint32_t>(meshes.size()));
+				if (isNew)
+				{
+					meshes.push_back(mesh);
+					meshRecords.push_back(
+						{ vertexCount, mesh->vertices.size(), indexCount, mesh->indices.size() });
+					vertexCount += mesh->vertices.size();
+					indexCount += mesh->indices.size();
+				}
+				lods.push_back(entry->second);
+			}
+		}
+		if (bounds.Size() != instanceCount)
+		{
+			throw std::invalid_argument("Every instance needs bounds to be cached");
+		}
+
+		FileHeader header = {};
+		std::memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = CachedTree::kVersion;
+		header.byteOrderMark = kByteOrderMark;
+		header.keyLow = key.low;
+		header.keyHigh = key.high;
+		const BoundingBox totalBounds = bounds.GetTotalBounds();
+		for (int i = 0; i < 3; ++i)
+		{
+			header.boundsMin[i] = totalBounds.min[i];
+			header.boundsMax[i] = totalBounds.max[i];
+		}
+		header.groupCount = static_cast<std::uint32_t>(groupRecords.size());
+		header.meshCount = static_cast<std::uint32_t>(meshRecords.size());
+		header.lodCount = static_cast<std::uint32_t>(lods.size());
+		header.instanceCount = instanceCount;
+		const std::uint64_t sizes[kSectionCount] = {
+			groupRecords.size() * sizeof(GroupRecord),
+			meshRecords.size() * sizeof(MeshRecord),
+			lods.size() * sizeof(std::uint32_t),
+			vertexCount * sizeof(Vertex),
+			indexCount * sizeof(std::uint32_t),
+			instanceCount * sizeof(glm::mat4),
+			instanceCount * sizeof(float),
+			instanceCount * sizeof(float),
+			instanceCount * sizeof(float),
+			instanceCount * sizeof(float),
+			instanceCount * sizeof(float),
+			instanceCount * sizeof(float),
+		};
+		std::uint64_t offset = Align(sizeof(FileHeader));
+		for (int i = 0; i < kSectionCount; ++i)
+		{
+			header.sections[i] = { offset, sizes[i] };
+			offset = Align(offset + sizes[i]);
+		}
+		header.fileSize = offset;
+
+		SectionWriter writer(output);
+		writer.Write(&header, sizeof(header));
+		writer.PadToSection();
+		writer.Write(groupRecords.data(), sizes[kGroups]);
+		writer.PadToSection();
+		writer.Write(meshRecords.data(), sizes[kMeshes]);
+		writer.PadToSection();
+		writer.Write(lods.data(), sizes[kLods]);
+		writer.PadToSection();
+		for (const MeshData* mesh : meshes)
+		{
+			writer.Write(mesh->vertices.data(), mesh->vertices.size() * sizeof(Vertex));
+		}
+		writer.PadToSection();
+		for (const MeshData* mesh : meshes)
+		{
+			writer.Write(mesh->indices.data(), mesh->indices.size() * sizeof(std::uint32_t));
+		}
+		writer.PadToSection();
+		for (const lsystem::MatrixMeshGroup& group : groups)
+		{
+			writer.Write(group.instances.data(), group.instances.size_bytes());
+		}
+		writer.PadToSection();
+		for (const float* component :
+			{ bounds.MinX(), bounds.MinY(), bounds.MinZ(), bounds.MaxX(), bounds.MaxY(), bounds.MaxZ() })
+		{
+			writer.Write(component, instanceCount * sizeof(float));
+			writer.PadToSection();
+		}
+		output->flush();
+		if (!*output)
+		{
+			throw std::runtime_error("Failed to write tree cache file");
+		}
+	}
+
+	TreeCache::TreeCache(std::filesystem::path directory) :
+		directory_(std::move(directory))
+	{
+		std::filesystem::create_directories(directory_);
+	}
+
+	std::filesystem::path TreeCache::GetPath(const utility::ContentHash& key) const
+	{
+		return directory_ / (key.ToString() + ".tree");
+	}
+
+	std::unique_ptr<CachedTree> TreeCache::Find(const utility::ContentHash& key) const
+	{
+		const std::filesystem::path path = GetPath(key);
+		std::error_code error;
+		if (!std::filesystem::exists(path, error))
+		{
+			return nullptr;
+		}
+		try
+		{
+			auto tree = std::make_unique<CachedTree>(path);
+			return tree->Key() == key ? std::move(tree) : nullptr;
+		}
+		catch (const std::runtime_error&)
+		{
+			// Left to be replaced by the next Store().
+			return nullptr;
+		}
+	}
+
+	void TreeCache::Store(
+		const utility::ContentHash& key,
+		std::span<const lsystem::MatrixMeshGroup> groups,
+		const InstanceBounds& bounds) const
+	{
+		const std::filesystem::path path = GetPath(key);
+		std::filesystem::path temporaryPath = path;
+		// Unique to the thread and the moment, so that concurrent stores of
+		// the same tree write to different files.
+		temporaryPath += "." + std::to_string(
+			std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+			static_cast<std::size_t>(std::chrono::steady_clock::now().time_since_epoch().count())) + ".tmp";
+		try
+		{
+			{
+				std::ofstream output(temporaryPath, std::ios::binary);
+				if (!output)
+				{
+					throw std::runtime_error("Couldn't create " + temporaryPath.string());
+				}
+				WriteCachedTree(key, groups, bounds, &output);
+			}
+			std::filesystem::rename(temporaryPath, path);
+		}
+		catch (...)
+		{
+			std::error_code error;
+			std::filesystem::remove(temporaryPath, error);
+			throw;
+		}
+	}
+}
@@ -0,0 +1,115 @@
+#ifndef TREE_GENERATOR_CACHE_TREE_CACHE_H_
+#define TREE_GENERATOR_CACHE_TREE_CACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../graphics/common/bounding_box.h"
+#include "../lsystem/rendering/mesh_generator_action.h"
+#include "../utility/content_hash.h"
+#include "mapped_file.h"
+
+namespace tree_generator
+{
+	// A generated tree read from a cache file, which stays mapped into
+	// memory for as long as this exists.
+	//
+	// The file holds a table of the groups' meshes and, after it, the
+	// instances as one array per attribute: every model matrix, then every
+	// bounding box as one array per component, as in InstanceBounds. Each
+	// array starts on a 64-byte boundary, so opening a file only checks
+	// its tables, and the instance arrays are used in place without being
+	// parsed or copied.
+	class CachedTree
+	{
+	public:
+		// Bumped whenever the layout changes, so older files are ignored.
+		static constexpr std::uint32_t kVersion = 2;
+
+		// Throws a std::runtime_error if the file can't be mapped, or isn't a
+		// cache file of this version written on a machine of the same byte
+		// order.
+		explicit CachedTree(const std::filesystem::path& path);
+
+		// The key the tree was stored under.
+		const utility::ContentHash& Key() const { return key_; }
+
+		// Bounds of all of the instances.
+		const BoundingBox& GetBounds() const { return bounds_; }
+
+		// Model matrices of every instance, each group's after the one
+		// before, straight from the mapping.
+		std::span<const glm::mat4> Instances() const { return instances_; }
+
+		// Bounds of each instance, in the same order as the matrices.
+		std::span<const float> MinX() const { return instanceBounds_[0]; }
+		std::span<const float> MinY() const { return instanceBounds_[1]; }
+		std::span<const float> MinZ() const { return instanceBounds_[2]; }
+		std::span<const float> MaxX() const { return instanceBounds_[3]; }
+		std::span<const float> MaxY() const { return instanceBounds_[4]; }
+		std::span<const float> MaxZ() const { return instanceBounds_[5]; }
+
+		// Returns the groups as GenerateMatrices() did. Their meshes are
+		// copied out of the file, but their instances point into the
+		// mapping, and are only valid for as long as this exists.
+		std::vector<lsystem::MatrixMeshGroup> GetGroups() const;
+
+		// Copies the instance bounds, e.g. to build a Bvh over them.
+		InstanceBounds GetInstanceBounds() const;
+
+	private:
+		MappedFile file_;
+		utility::ContentHash key_;
+		BoundingBox bounds_;
+		std::span<const glm::mat4> instances_;
+		std::array<std::span<const float>, 6> instanceBounds_;
+	};
+
+	// Writes groups as returned by MeshGenerator::GenerateMatrices(), and
+	// the bounds of their instances, to a cache file. Meshes shared between
+	// groups or levels of detail are written once.
+	//
+	// Throws a std::invalid_argument if the bounds don't match the
+	// instances, and a std::runtime_error if writing fails.
+	void WriteCachedTree(
+		const utility::ContentHash& key,
+		std::span<const lsystem::MatrixMeshGroup> groups,
+		const InstanceBounds& bounds,
+		std::ostream* output);
+
+	// A directory of cached trees, named by their keys, which identify the
+	// inputs they were generated from.
+	class TreeCache
+	{
+	public:
+		// Creates the directory if it doesn't exist.
+		explicit TreeCache(std::filesystem::path directory);
+
+		std::filesystem::path GetPath(const utility::ContentHash& key) const;
+
+		// Returns the tree stored under the key, or null if there is none,
+		// or only one from an older version.
+		std::unique_ptr<CachedTree> Find(const utility::ContentHash& key) const;
+
+		// Stores the tree under the key, replacing any tree already there.
+		// The file is written under a temporary name first and then renamed,
+		// so other processes sharing the directory never see it half
+		// written.
+		void Store(
+			const utility::ContentHash& key,
+			std::span<const lsystem::MatrixMeshGroup> groups,
+			const InstanceBounds& bounds) const;
+
+	private:
+		std::filesystem::path directory_;
+	};
+}
+
+#endif  // !TREE_GENERATOR_CACHE_TREE_CACHE_H_
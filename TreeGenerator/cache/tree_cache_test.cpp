@@ -0,0 +1,174 @@
+#include "tree_cache.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../graphics/common/instance_buffer.h"
+#include "../graphics/common/mesh_data.h"
+
+using ::testing::ElementsAreArray;
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		// A directory of its own for each test, removed afterwards, and a
+		// tree of two groups: one with a coarser level of detail that is
+		// also the other group's mesh.
+		class TreeCacheTest : public ::testing::Test
+		{
+		protected:
+			void SetUp() override
+			{
+				directory_ = std::filesystem::temp_directory_path() /
+					("tree_generator_cache_" +
+						std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+				std::filesystem::remove_all(directory_);
+
+				const auto fine = std::make_shared<const MeshData>(CreateCylinder(6));
+				const auto coarse = std::make_shared<const MeshData>(CreateCylinder(3));
+				instances_.Resize(5);
+				bounds_.Resize(5);
+				for (std::size_t i = 0; i < 5; ++i)
+				{
+					instances_[i] = glm::translate(glm::mat4(1.0f), glm::vec3(i, 2.0f * i, 0.0f));
+					bounds_.Set(i, TransformBounds(ComputeBounds(*fine), instances_[i]));
+				}
+				groups_.push_back({
+					fine,
+					instances_.Matrices().subspan(0, 3),
+					{ glm::vec4(0.5f, 0.2f, 0.0f, 1.0f) },
+					{ fine, coarse },
+					lsystem::Symbol{ 'F' } });
+				groups_.push_back({
+					coarse,
+					instances_.Matrices().subspan(3, 2),
+					{ glm::vec4(0.0f, 0.5f, 0.0f, 1.0f) },
+					{ coarse },
+					lsystem::Symbol{ 'X' } });
+			}
+
+			void TearDown() override
+			{
+				std::filesystem::remove_all(directory_);
+			}
+
+			std::filesystem::path directory_;
+			InstanceBuffer instances_;
+			InstanceBounds bounds_;
+			std::vector<lsystem::MatrixMeshGroup> groups_;
+		};
+
+		const utility::ContentHash kKey = utility::HashBytes("tree");
+
+		TEST_F(TreeCacheTest, MapsInstancesInPlace)
+		{
+			const TreeCache cache(directory_);
+			cache.Store(kKey, groups_, bounds_);
+
+			const std::unique_ptr<CachedTree> tree = cache.Find(kKey);
+
+			ASSERT_NE(tree, nullptr);
+			EXPECT_EQ(tree->Key(), kKey);
+			EXPECT_THAT(tree->Instances(), ElementsAreArray(instances_.Matrices()));
+			EXPECT_NE(tree->Instances().data(), instances_.Data());
+			EXPECT_EQ(reinterpret_cast<std::uintptr_t>(tree->Instances().data()) % 64, 0u);
+			EXPECT_EQ(tree->GetBounds().min, bounds_.GetTotalBounds().min);
+			EXPECT_EQ(tree->GetBounds().max, bounds_.GetTotalBounds().max);
+			EXPECT_THAT(tree->MinX(), ElementsAreArray(bounds_.MinX(), 5));
+			EXPECT_THAT(tree->MaxY(), ElementsAreArray(bounds_.MaxY(), 5));
+		}
+
+		TEST_F(TreeCacheTest, RestoresGroupsAndSharedMeshes)
+		{
+			const TreeCache cache(directory_);
+			cache.Store(kKey, groups_, bounds_);
+			const std::unique_ptr<CachedTree> tree = cache.Find(kKey);
+			ASSERT_NE(tree, nullptr);
+
+			const std::vector<lsystem::MatrixMeshGroup> groups = tree->GetGroups();
+
+			ASSERT_THAT(groups, SizeIs(2));
+			for (std::size_t i = 0; i < groups.size(); ++i)
+			{
+				EXPECT_EQ(groups[i].material.color, groups_[i].material.color);
+				EXPECT_EQ(groups[i].symbol, groups_[i].symbol);
+				EXPECT_EQ(groups[i].instances.data(), tree->Instances().data() + 3 * i);
+				EXPECT_THAT(groups[i].instances, ElementsAreArray(groups_[i].instances));
+				ASSERT_THAT(groups[i].lods, SizeIs(groups_[i].lods.size()));
+				EXPECT_EQ(groups[i].mesh, groups[i].lods.front());
+				EXPECT_EQ(groups[i].mesh->indices, groups_[i].mesh->indices);
+				ASSERT_THAT(groups[i].mesh->vertices, SizeIs(groups_[i].mesh->vertices.size()));
+				for (std::size_t v = 0; v < groups[i].mesh->vertices.size(); ++v)
+				{
+					EXPECT_EQ(groups[i].mesh->vertices[v].position, groups_[i].mesh->vertices[v].position);
+				}
+			}
+			// Written once, and shared again when read back.
+			EXPECT_EQ(groups[0].lods[1], groups[1].mesh);
+
+			const InstanceBounds bounds = tree->GetInstanceBounds();
+			ASSERT_EQ(bounds.Size(), 5u);
+			EXPECT_EQ(bounds.Get(4).max, bounds_.Get(4).max);
+		}
+
+		TEST_F(TreeCacheTest, MissesUnknownKeys)
+		{
+			const TreeCache cache(directory_);
+			cache.Store(kKey, groups_, bounds_);
+
+			EXPECT_EQ(cache.Find(utility::HashBytes("bush")), nullptr);
+
+			// A file under the wrong name isn't trusted either.
+			std::filesystem::copy_file(
+				cache.GetPath(kKey), cache.GetPath(utility::HashBytes("bush")));
+			EXPECT_EQ(cache.Find(utility::HashBytes("bush")), nullptr);
+		}
+
+		TEST_F(TreeCacheTest, IgnoresInvalidFiles)
+		{
+			const TreeCache cache(directory_);
+			cache.Store(kKey, groups_, bounds_);
+			const std::filesystem::path path = cache.GetPath(kKey);
+			const std::uintmax_t size = std::filesystem::file_size(path);
+
+			std::filesystem::resize_file(path, size - 64);
+			EXPECT_THROW(CachedTree tree(path), std::runtime_error);
+			EXPECT_EQ(cache.Find(kKey), nullptr);
+
+			// An older version.
+			cache.Store(kKey, groups_, bounds_);
+			{
+				std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+				file.seekp(8);
+				const std::uint32_t version = CachedTree::kVersion - 1;
+				file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+			}
+			EXPECT_EQ(cache.Find(kKey), nullptr);
+
+			cache.Store(kKey, groups_, bounds_);
+			EXPECT_NE(cache.Find(kKey), nullptr);
+		}
+
+		TEST_F(TreeCacheTest, RejectsMismatchedBounds)
+		{
+			bounds_.Resize(4);
+			std::ostringstream output;
+
+			EXPECT_THROW(WriteCachedTree(kKey, groups_, bounds_, &output), std::invalid_argument);
+		}
+	}
+}
@@ -0,0 +1,385 @@
+#include "batch_job.h"
+
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "../export/glb_writer.h"
+#include "../export/obj_writer.h"
+#include "../export/ply_writer.h"
+#include "../graphics/common/instance_buffer.h"
+#include "../graphics/common/mesh_instances.h"
+#include "../json_utility/lsystem_json.h"
+#include "../lsystem/rendering/mesh_definition.h"
+#include "../lsystem/rendering/mesh_generator_action.h"
+#include "../utility/task_pool.h"
+
+namespace tree_generator::cli
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		double GetSeconds(Clock::time_point start, Clock::time_point end)
+		{
+			return std::chrono::duration<double>(end - start).count();
+		}
+
+		glm::vec3 ParseVec3(const nlohmann::json& json)
+		{
+			if (!json.is_array() || json.size() != 3)
+			{
+				throw std::invalid_argument("Expected an array of 3 numbers: " + json.dump());
+			}
+			return { json[0].get<float>(), json[1].get<float>(), json[2].get<float>() };
+		}
+
+		glm::vec4 ParseColor(const nlohmann::json& json)
+		{
+			if (!json.is_array() || json.size() != 4)
+			{
+				throw std::invalid_argument("Expected an RGBA color: " + json.dump());
+			}
+			return {
+				json[0].get<float>(), json[1].get<float>(), json[2].get<float>(), json[3].get<float>() };
+		}
+
+		lsystem::MeshType ParseMeshType(const std::string& name)
+		{
+			for (lsystem::MeshType meshType : lsystem::MeshTypeIterator())
+			{
+				if (lsystem::GetName(meshType) == name)
+				{
+					return meshType;
+				}
+			}
+			throw std::invalid_argument("Unknown mesh type: " + name);
+		}
+
+		std::unique_ptr<lsystem::MeshGeneratorAction> ParseAction(const nlohmann::json& json)
+		{
+			const std::string type = json.at("type").get<std::string>();
+			if (type == "draw")
+			{
+				const lsystem::MeshType meshType =
+					ParseMeshType(json.value("mesh", lsystem::GetName(lsystem::MeshType::Cylinder)));
+				std::unique_ptr<lsystem::MeshDefinition> definition;
+				if (meshType == lsystem::MeshType::Cylinder)
+				{
+					CylinderOptions options;
+					options.hasCaps = json.value("caps", false);
+					options.hasUvs = json.value("uvs", false);
+					definition = std::make_unique<lsystem::CylinderDefinition>(
+						json.value("sideCount", 8),
+						json.value("height", 0.15f),
+						json.value("radius", 0.1f),
+						options);
+				}
+				else
+				{
+					definition = lsystem::MeshDefinition::FromMeshType(meshType);
+				}
+				const Material material = {
+					json.contains("color") ? ParseColor(json["color"]) : glm::vec4(1.0f) };
+				return std::make_unique<lsystem::DrawAction>(std::move(definition), material);
+			}
+			if (type == "push")
+			{
+				return std::make_unique<lsystem::PushStateAction>();
+			}
+			if (type == "pop")
+			{
+				return std::make_unique<lsystem::PopStateAction>();
+			}
+			if (type == "rotate")
+			{
+				return std::make_unique<lsystem::RotateAction>(ParseVec3(json.at("angles")));
+			}
+			if (type == "move")
+			{
+				return std::make_unique<lsystem::MoveAction>(json.value("distance", 1.0f));
+			}
+			throw std::invalid_argument("Unknown action type: " + type);
+		}
+
+		lsystem::MeshGenerator ParseMeshGenerator(const nlohmann::json& json)
+		{
+			lsystem::MeshGenerator generator;
+			for (const auto& [symbol, action] : json.items())
+			{
+				if (symbol.size() != 1)
+				{
+					throw std::invalid_argument("Action symbols must be one character: " + symbol);
+				}
+				generator.Define(lsystem::ToSymbol(symbol[0]), ParseAction(action));
+			}
+			return generator;
+		}
+
+		ExportFormat ParseFormat(const std::string& name)
+		{
+			if (name == "obj")
+			{
+				return ExportFormat::Obj;
+			}
+			if (name == "ply")
+			{
+				return ExportFormat::Ply;
+			}
+			if (name == "glb")
+			{
+				return ExportFormat::Glb;
+			}
+			throw std::invalid_argument("Unknown export format: " + name);
+		}
+
+		const char* GetExtension(ExportFormat format)
+		{
+			switch (format)
+			{
+			case ExportFormat::Obj:
+				return ".obj";
+			case ExportFormat::Ply:
+				return ".ply";
+			case ExportFormat::Glb:
+				return ".glb";
+			}
+			return "";
+		}
+	}
+
+	Batch ParseBatch(const nlohmann::json& json)
+	{
+		Batch batch;
+		batch.format = ParseFormat(json.value("format", "glb"));
+		batch.outputDirectory = json.value("outputDirectory", ".");
+		batch.threadCount = json.value("threadCount", 0u);
+		batch.cacheDirectory = json.value("cacheDirectory", "");
+
+		// Jobs run at the same time, so two with one name would write the
+		// same file at once.
+		std::unordered_set<std::string> names;
+		for (const nlohmann::json& jobJson : json.at("jobs"))
+		{
+			BatchJob& job = batch.jobs.emplace_back();
+			job.name = jobJson.at("name").get<std::string>();
+			if (job.name.empty() || job.name.find_first_of("/\\") != std::string::npos)
+			{
+				throw std::invalid_argument("Job names must be file names: " + job.name);
+			}
+			if (!names.insert(job.name).second)
+			{
+				throw std::invalid_argument("Job names must be unique: " + job.name);
+			}
+			jobJson.at("lsystem").get_to(job.lSystem);
+			job.iterations = jobJson.at("iterations").get<int>();
+			if (job.iterations < 0)
+			{
+				throw std::invalid_argument("Iterations can't be negative: " + job.name);
+			}
+			job.meshGenerator = jobJson.contains("actions") ?
+				ParseMeshGenerator(jobJson["actions"]) : lsystem::CreateDefaultMeshGenerator();
+			job.key = lsystem::HashTree(job.lSystem, job.iterations, job.meshGenerator);
+		}
+		return batch;
+	}
+
+	JobResult RunJob(
+		const BatchJob& job,
+		ExportFormat format,
+		const std::filesystem::path& outputDirectory,
+		const TreeCache* cache)
+	{
+		JobResult result;
+		result.name = job.name;
+		result.path = outputDirectory / (job.name + GetExtension(format));
+		try
+		{
+			const Clock::time_point start = Clock::now();
+			std::unique_ptr<CachedTree> cachedTree =
+				cache != nullptr ? cache->Find(job.key) : nullptr;
+			std::vector<lsystem::MatrixMeshGroup> groups;
+			InstanceBuffer instances;
+			InstanceBounds bounds;
+			Clock::time_point derived = start;
+			if (cachedTree != nullptr)
+			{
+				result.wasCached = true;
+				groups = cachedTree->GetGroups();
+			}
+			else
+			{
+				const std::vector<lsystem::Symbol> symbols =
+					lsystem::Generate(job.lSystem, job.iterations);
+				result.symbolCount = symbols.size();
+				derived = Clock::now();
+
+				groups = job.meshGenerator.GenerateMatrices(symbols, &instances, &bounds);
+			}
+			const Clock::time_point interpreted = Clock::now();
+			result.timings.derive = GetSeconds(start, derived);
+			result.timings.interpret = GetSeconds(derived, interpreted);
+
+			// A tree that can't be cached, say in a full or read-only
+			// directory, is still exported.
+			Clock::time_point stored = interpreted;
+			if (cachedTree == nullptr && cache != nullptr)
+			{
+				try
+				{
+					cache->Store(job.key, groups, bounds);
+				}
+				catch (const std::exception& e)
+				{
+					result.warning = std::string("couldn't cache the tree: ") + e.what();
+				}
+				stored = Clock::now();
+				result.timings.cacheStore = GetSeconds(interpreted, stored);
+			}
+
+			std::vector<MeshInstances> sources;
+			for (const lsystem::MatrixMeshGroup& group : groups)
+			{
+				sources.push_back({ group.mesh.get(), group.instances, group.material });
+				result.instanceCount += group.instances.size();
+			}
+			result.triangleCount = GetInstancedTriangleCount(sources);
+
+			{
+				std::ofstream output(result.path, std::ios::binary);
+				if (!output)
+				{
+					throw std::runtime_error("Couldn't open " + result.path.string());
+				}
+				switch (format)
+				{
+				case ExportFormat::Obj:
+				{
+					std::filesystem::path materialPath = result.path;
+					materialPath.replace_extension(".mtl");
+					{
+						std::ofstream materials(materialPath, std::ios::binary);
+						WriteObjMaterials(sources, &materials);
+					}
+					result.byteCount += std::filesystem::file_size(materialPath);
+					WriteObj(sources, &output, materialPath.filename().string());
+					break;
+				}
+				case ExportFormat::Ply:
+					WritePly(sources, &output);
+					break;
+				case ExportFormat::Glb:
+					WriteGlb(sources, &output);
+					break;
+				}
+			}
+			result.byteCount += std::filesystem::file_size(result.path);
+			result.timings.exportFile = GetSeconds(stored, Clock::now());
+		}
+		catch (const std::exception& e)
+		{
+			result.error = e.what();
+		}
+		return result;
+	}
+
+	std::vector<JobResult> RunBatch(const Batch& batch)
+	{
+		std::filesystem::create_directories(batch.outputDirectory);
+
+		// The jobs get their own threads, since the mesh generator may use
+		// the default pool, whose tasks mustn't wait on each other.
+		utility::TaskPool pool(
+			batch.threadCount == 0 ? std::thread::hardware_concurrency() : batch.threadCount);
+		std::optional<TreeCache> cache;
+		if (!batch.cacheDirectory.empty())
+		{
+			cache.emplace(batch.cacheDirectory);
+		}
+		std::vector<JobResult> results(batch.jobs.size());
+		utility::ParallelFor(pool, batch.jobs.size(), [&](std::size_t i) {
+			results[i] = RunJob(
+				batch.jobs[i],
+				batch.format,
+				batch.outputDirectory,
+				cache.has_value() ? &*cache : nullptr);
+			});
+		return results;
+	}
+
+	void PrintReport(
+		const std::vector<JobResult>& results, double wallSeconds, std::ostream* output)
+	{
+		constexpr double kMegabyte = 1024.0 * 1024.0;
+		std::ostream& out = *output;
+		const std::ios::fmtflags flags = out.flags();
+		out << std::left << std::setw(20) << "job" << std::right
+			<< std::setw(12) << "symbols"
+			<< std::setw(12) << "instances"
+			<< std::setw(12) << "triangles"
+			<< std::setw(12) << "derive ms"
+			<< std::setw(14) << "interpret ms"
+			<< std::setw(10) << "store ms"
+			<< std::setw(12) << "export ms"
+			<< std::setw(10) << "MB/s" << '\n';
+
+		std::size_t failedCount = 0;
+		std::size_t triangleCount = 0;
+		std::size_t byteCount = 0;
+		out << std::fixed << std::setprecision(1);
+		for (const JobResult& result : results)
+		{
+			out << std::left << std::setw(20) << result.name << std::right;
+			if (!result.error.empty())
+			{
+				++failedCount;
+				out << "failed: " << result.error << '\n';
+				continue;
+			}
+			triangleCount += result.triangleCount;
+			byteCount += result.byteCount;
+			const double megabytesPerSecond = result.timings.exportFile > 0.0 ?
+				result.byteCount / kMegabyte / result.timings.exportFile : 0.0;
+			if (result.wasCached)
+			{
+				out << std::setw(12) << "cached";
+			}
+			else
+			{
+				out << std::setw(12) << result.symbolCount;
+			}
+			out << std::setw(12) << result.instanceCount
+				<< std::setw(12) << result.triangleCount
+				<< std::setw(12) << result.timings.derive * 1000.0
+				<< std::setw(14) << result.timings.interpret * 1000.0
+				<< std::setw(10) << result.timings.cacheStore * 1000.0
+				<< std::setw(12) << result.timings.exportFile * 1000.0
+				<< std::setw(10) << megabytesPerSecond << '\n';
+			if (!result.warning.empty())
+			{
+				out << std::setw(20) << "" << "warning: " << result.warning << '\n';
+			}
+		}
+
+		out << results.size() - failedCount << " of " << results.size() << " jobs succeeded in "
+			<< std::setprecision(3) << wallSeconds << " s";
+		if (wallSeconds > 0.0)
+		{
+			out << " (" << std::setprecision(1)
+				<< results.size() / wallSeconds << " jobs/s, "
+				<< triangleCount / wallSeconds / 1e6 << "M triangles/s, "
+				<< byteCount / kMegabyte / wallSeconds << " MB/s)";
+		}
+		out << '\n';
+		out.flags(flags);
+	}
+}
@@ -0,0 +1,142 @@
+#ifndef TREE_GENERATOR_CLI_BATCH_JOB_H_
+#define TREE_GENERATOR_CLI_BATCH_JOB_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../lsystem/core/lsystem.h"
+#include "../cache/tree_cache.h"
+#include "../lsystem/rendering/mesh_generator.h"
+#include "../utility/content_hash.h"
+
+namespace tree_generator::cli
+{
+	enum class ExportFormat
+	{
+		Obj,
+		Ply,
+		Glb,
+	};
+
+	// One tree to generate and export.
+	struct BatchJob
+	{
+		// Also the exported file's name, without the extension.
+		std::string name;
+		lsystem::LSystem lSystem;
+		int iterations;
+		lsystem::MeshGenerator meshGenerator;
+
+		// Identifies the generated tree in the cache. See
+		// lsystem::HashTree(); the job's name isn't part of it.
+		utility::ContentHash key;
+	};
+
+	struct Batch
+	{
+		std::vector<BatchJob> jobs;
+		ExportFormat format;
+		std::filesystem::path outputDirectory;
+
+		// Number of jobs run at once. Zero uses every hardware thread.
+		unsigned int threadCount;
+
+		// Where generated trees are cached across runs. Empty if they
+		// aren't.
+		std::filesystem::path cacheDirectory;
+	};
+
+	// Reads a batch from a job file, such as:
+	//
+	// {
+	//   "outputDirectory": "trees",
+	//   "cacheDirectory": "cache",
+	//   "format": "glb",
+	//   "jobs": [
+	//     {
+	//       "name": "bush",
+	//       "lsystem": { "axiom": "X", "rules": { "X": "F[+X][-X]" } },
+	//       "iterations": 6,
+	//       "actions": {
+	//         "F": { "type": "draw", "mesh": "Cylinder", "sideCount": 8,
+	//                "height": 0.15, "radius": 0.1, "caps": false, "uvs": false,
+	//                "color": [0.5, 0.2, 0, 1] },
+	//         "X": { "type": "draw", "mesh": "Quad", "color": [0, 0.5, 0, 1] },
+	//         "[": { "type": "push" },
+	//         "]": { "type": "pop" },
+	//         "+": { "type": "rotate", "angles": [0, 0, 22.5] },
+	//         "-": { "type": "rotate", "angles": [0, 0, -22.5] },
+	//         "A": { "type": "move", "distance": 0.15 }
+	//       }
+	//     }
+	//   ]
+	// }
+	//
+	// The format is "obj", "ply" or "glb", and defaults to "glb". Jobs
+	// without actions use the editor's default ones, shown above. Each job
+	// is exported to a file named after it, so names must be unique.
+	//
+	// Throws a std::invalid_argument, or one of nlohmann::json's
+	// exceptions, if the batch is malformed.
+	Batch ParseBatch(const nlohmann::json& json);
+
+	// Wall-clock time spent in each stage of a job, in seconds.
+	struct StageTimings
+	{
+		double derive = 0.0;
+		double interpret = 0.0;
+
+		// Writing a generated tree to the cache, if there is one.
+		double cacheStore = 0.0;
+		double exportFile = 0.0;
+	};
+
+	struct JobResult
+	{
+		std::string name;
+		std::filesystem::path path;
+		std::size_t symbolCount = 0;
+		std::size_t instanceCount = 0;
+		std::size_t triangleCount = 0;
+		std::size_t byteCount = 0;
+		StageTimings timings;
+
+		// Whether the tree was read from the cache instead of generated, in
+		// which case the symbols aren't counted and interpreting is mapping
+		// the cache file.
+		bool wasCached = false;
+
+		// Empty if the job succeeded.
+		std::string error;
+
+		// Set if the job succeeded, but couldn't store its tree in the
+		// cache.
+		std::string warning;
+	};
+
+	// Derives the job's L-system, generates its instances and exports them
+	// to the output directory, which must exist. If there is a cache, the
+	// tree is read from it when it's there, and stored in it otherwise.
+	// Failures are reported in the result rather than thrown.
+	JobResult RunJob(
+		const BatchJob& job,
+		ExportFormat format,
+		const std::filesystem::path& outputDirectory,
+		const TreeCache* cache = nullptr);
+
+	// Runs every job of the batch, several at once, creating the output
+	// directory if needed. Results are in the order of the jobs.
+	std::vector<JobResult> RunBatch(const Batch& batch);
+
+	// Writes a table of each job's timings and throughput, and the totals
+	// over the batch, which took wallSeconds to run.
+	void PrintReport(
+		const std::vector<JobResult>& results, double wallSeconds, std::ostream* output);
+}
+
+#endif  // !TREE_GENERATOR_CLI_BATCH_JOB_H_
@@ -0,0 +1,210 @@
+#include "batch_job.h"
+
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
+
+namespace tree_generator::cli
+{
+	namespace
+	{
+		// A directory of its own for each test, removed afterwards.
+		class BatchJobTest : public ::testing::Test
+		{
+		protected:
+			void SetUp() override
+			{
+				directory_ = std::filesystem::temp_directory_path() /
+					("tree_generator_cli_" +
+						std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+				std::filesystem::remove_all(directory_);
+			}
+
+			void TearDown() override
+			{
+				std::filesystem::remove_all(directory_);
+			}
+
+			std::filesystem::path directory_;
+		};
+
+		nlohmann::json CreateJob(const std::string& name, int iterations)
+		{
+			return {
+				{ "name", name },
+				{ "lsystem", { { "axiom", "X" }, { "rules", { { "X", "F[+X][-X]" } } } } },
+				{ "iterations", iterations },
+			};
+		}
+
+		TEST_F(BatchJobTest, ParsesBatch)
+		{
+			const nlohmann::json json = {
+				{ "outputDirectory", directory_.string() },
+				{ "format", "ply" },
+				{ "threadCount", 3 },
+				{ "jobs", { CreateJob("a", 2), CreateJob("b", 4) } },
+			};
+
+			const Batch batch = ParseBatch(json);
+
+			EXPECT_EQ(batch.format, ExportFormat::Ply);
+			EXPECT_EQ(batch.outputDirectory, directory_);
+			EXPECT_EQ(batch.threadCount, 3u);
+			ASSERT_THAT(batch.jobs, SizeIs(2));
+			EXPECT_EQ(batch.jobs[1].name, "b");
+			EXPECT_EQ(batch.jobs[1].iterations, 4);
+			EXPECT_EQ(lsystem::ToString(batch.jobs[1].lSystem.axiom), "X");
+		}
+
+		TEST_F(BatchJobTest, RejectsMalformedBatches)
+		{
+			nlohmann::json json = { { "format", "fbx" }, { "jobs", { CreateJob("a", 2) } } };
+			EXPECT_THROW(ParseBatch(json), std::invalid_argument);
+
+			json = { { "jobs", { CreateJob("../a", 2) } } };
+			EXPECT_THROW(ParseBatch(json), std::invalid_argument);
+
+			json = { { "jobs", { CreateJob("a", 2), CreateJob("b", 3), CreateJob("a", 4) } } };
+			EXPECT_THROW(ParseBatch(json), std::invalid_argument);
+
+			nlohmann::json job = CreateJob("a", 2);
+			job["actions"] = { { "FF", { { "type", "push" } } } };
+			json = { { "jobs", { job } } };
+			EXPECT_THROW(ParseBatch(json), std::invalid_argument);
+
+			job["actions"] = { { "F", { { "type", "jump" } } } };
+			json = { { "jobs", { job } } };
+			EXPECT_THROW(ParseBatch(json), std::invalid_argument);
+
+			job["actions"] = { { "F", { { "type", "draw" }, { "mesh", "Sphere" } } } };
+			json = { { "jobs", { job } } };
+			EXPECT_THROW(ParseBatch(json), std::invalid_argument);
+		}
+
+		TEST_F(BatchJobTest, ExportsEveryJobInOrder)
+		{
+			for (const char* format : { "obj", "ply", "glb" })
+			{
+				const nlohmann::json json = {
+					{ "outputDirectory", directory_.string() },
+					{ "format", format },
+					{ "threadCount", 2 },
+					{ "jobs", { CreateJob("small", 2), CreateJob("large", 5), CreateJob("medium", 3) } },
+				};
+				const Batch batch = ParseBatch(json);
+
+				const std::vector<JobResult> results = RunBatch(batch);
+
+				ASSERT_THAT(results, SizeIs(3));
+				EXPECT_EQ(results[0].name, "small");
+				EXPECT_EQ(results[1].name, "large");
+				EXPECT_EQ(results[2].name, "medium");
+				for (const JobResult& result : results)
+				{
+					EXPECT_EQ(result.error, "") << format;
+					EXPECT_TRUE(std::filesystem::exists(result.path)) << format;
+					EXPECT_GT(result.triangleCount, 0u) << format;
+					EXPECT_GE(result.byteCount, std::filesystem::file_size(result.path)) << format;
+				}
+				EXPECT_GT(results[1].instanceCount, results[2].instanceCount);
+				EXPECT_GT(results[2].instanceCount, results[0].instanceCount);
+			}
+			EXPECT_TRUE(std::filesystem::exists(directory_ / "large.mtl"));
+		}
+
+		TEST_F(BatchJobTest, ReusesCachedTrees)
+		{
+			nlohmann::json renamed = CreateJob("renamed", 4);
+			const nlohmann::json json = {
+				{ "outputDirectory", (directory_ / "output").string() },
+				{ "cacheDirectory", (directory_ / "cache").string() },
+				{ "jobs", { CreateJob("tree", 4), CreateJob("other", 3) } },
+			};
+			const Batch batch = ParseBatch(json);
+			EXPECT_NE(batch.jobs[0].key, batch.jobs[1].key);
+
+			const std::vector<JobResult> generated = RunBatch(batch);
+			const std::vector<JobResult> cached = RunBatch(batch);
+
+			ASSERT_THAT(cached, SizeIs(2));
+			for (std::size_t i = 0; i < cached.size(); ++i)
+			{
+				EXPECT_FALSE(generated[i].wasCached);
+				EXPECT_TRUE(cached[i].wasCached);
+				EXPECT_EQ(cached[i].error, "");
+				EXPECT_EQ(cached[i].instanceCount, generated[i].instanceCount);
+				EXPECT_EQ(cached[i].triangleCount, generated[i].triangleCount);
+				EXPECT_EQ(cached[i].byteCount, generated[i].byteCount);
+			}
+
+			// The key ignores the name, but not the settings.
+			nlohmann::json changed = CreateJob("tree", 4);
+			changed["lsystem"]["rules"]["X"] = "F[+X]";
+			const Batch other = ParseBatch({ { "jobs", { renamed, changed } } });
+			EXPECT_EQ(other.jobs[0].key, batch.jobs[0].key);
+			EXPECT_NE(other.jobs[1].key, batch.jobs[0].key);
+
+			nlohmann::json open = CreateJob("open", 4);
+			open["actions"] = { { "F", { { "type", "draw" } } } };
+			nlohmann::json capped = open;
+			capped["name"] = "capped";
+			capped["actions"]["F"]["caps"] = true;
+			const Batch cylinders = ParseBatch({ { "jobs", { open, capped } } });
+			EXPECT_NE(cylinders.jobs[0].key, cylinders.jobs[1].key);
+		}
+
+		TEST_F(BatchJobTest, ExportsTreesThatCantBeCached)
+		{
+			const nlohmann::json json = {
+				{ "outputDirectory", directory_.string() },
+				{ "jobs", { CreateJob("uncached", 3) } },
+			};
+			const Batch batch = ParseBatch(json);
+			std::filesystem::create_directories(directory_);
+			const TreeCache cache(directory_ / "cache");
+			std::filesystem::remove_all(directory_ / "cache");
+
+			const JobResult result = RunJob(batch.jobs[0], ExportFormat::Ply, directory_, &cache);
+
+			EXPECT_EQ(result.error, "");
+			EXPECT_THAT(result.warning, HasSubstr("couldn't cache"));
+			EXPECT_TRUE(std::filesystem::exists(result.path));
+
+			std::ostringstream report;
+			PrintReport({ result }, 1.0, &report);
+			EXPECT_THAT(report.str(), HasSubstr("warning: couldn't cache"));
+			EXPECT_THAT(report.str(), HasSubstr("1 of 1 jobs succeeded"));
+		}
+
+		TEST_F(BatchJobTest, ReportsFailuresWithoutThrowing)
+		{
+			const nlohmann::json json = {
+				{ "outputDirectory", directory_.string() },
+				{ "jobs", { CreateJob("orphan", 2) } },
+			};
+			const Batch batch = ParseBatch(json);
+
+			// The output directory is never created.
+			const JobResult missingDirectory =
+				RunJob(batch.jobs[0], ExportFormat::Glb, directory_ / "missing");
+
+			EXPECT_THAT(missingDirectory.error, HasSubstr("Couldn't open"));
+
+			std::ostringstream report;
+			PrintReport({ missingDirectory }, 1.0, &report);
+			EXPECT_THAT(report.str(), HasSubstr("orphan"));
+			EXPECT_THAT(report.str(), HasSubstr("0 of 1 jobs succeeded"));
+		}
+	}
+}
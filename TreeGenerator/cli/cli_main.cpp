@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "batch_job.h"
+
+// Generates and exports every tree of a job file, without a window, e.g.
+// on render-farm nodes with no display.
+int main(int argc, char* argv[])
+{
+	if (argc != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <job file>" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		std::ifstream file(argv[1]);
+		if (!file)
+		{
+			std::cerr << "Couldn't open " << argv[1] << std::endl;
+			return EXIT_FAILURE;
+		}
+		const ::tree_generator::cli::Batch batch =
+			::tree_generator::cli::ParseBatch(nlohmann::json::parse(file));
+
+		const auto start = std::chrono::steady_clock::now();
+		const std::vector<::tree_generator::cli::JobResult> results =
+			::tree_generator::cli::RunBatch(batch);
+		const double wallSeconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+
+		::tree_generator::cli::PrintReport(results, wallSeconds, &std::cout);
+		for (const ::tree_generator::cli::JobResult& result : results)
+		{
+			if (!result.error.empty())
+			{
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#ifndef TREE_GENERATOR_EXPORT_BUFFERED_WRITER_H_
+#define TREE_GENERATOR_EXPORT_BUFFERED_WRITER_H_
+
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tree_generator
+{
+	// Collects small writes into a large buffer, and writes the buffer to
+	// the stream whenever it fills up, so that exporters can format one
+	// number at a time without going through the stream for each.
+	class BufferedWriter
+	{
+	public:
+		static constexpr std::size_t kDefaultCapacity = std::size_t{ 1 } << 20;
+
+		explicit BufferedWriter(std::ostream* output, std::size_t capacity = kDefaultCapacity)
+			: output_(output),
+			buffer_(capacity)
+		{
+		}
+
+		void Write(std::string_view text)
+		{
+			if (text.size() > buffer_.size())
+			{
+				Flush();
+				output_->write(text.data(), static_cast<std::streamsize>(text.size()));
+				return;
+			}
+			std::memcpy(Reserve(text.size()), text.data(), text.size());
+			size_ += text.size();
+		}
+
+		void Write(char c)
+		{
+			*Reserve(1) = c;
+			++size_;
+		}
+
+		// Writes the shortest decimal representation that reads back as
+		// the same number.
+		template <typename T>
+			requires std::is_arithmetic_v<T>
+		void WriteNumber(T value)
+		{
+			// Enough for any float, double or 64-bit integer.
+			constexpr std::size_t kMaxLength = 32;
+			char* first = Reserve(kMaxLength);
+			const std::to_chars_result result = std::to_chars(first, first + kMaxLength, value);
+			size_ += result.ptr - first;
+		}
+
+		// Writes the value's bytes in little-endian order.
+		template <typename T>
+			requires std::is_arithmetic_v<T>
+		void WriteLittleEndian(T value)
+		{
+			char* destination = Reserve(sizeof(T));
+			std::memcpy(destination, &value, sizeof(T));
+			if constexpr (std::endian::native == std::endian::big)
+			{
+				for (std::size_t i = 0; i < sizeof(T) / 2; ++i)
+				{
+					std::swap(destination[i], destination[sizeof(T) - 1 - i]);
+				}
+			}
+			size_ += sizeof(T);
+		}
+
+		// Writes the buffer to the stream. Throws a std::runtime_error if
+		// the stream failed.
+		void Flush()
+		{
+			output_->write(buffer_.data(), static_cast<std::streamsize>(size_));
+			size_ = 0;
+			if (!*output_)
+			{
+				throw std::runtime_error("Failed to write exported geometry");
+			}
+		}
+
+	private:
+		// Returns room for count more bytes, flushing first if needed.
+		char* Reserve(std::size_t count)
+		{
+			if (size_ + count > buffer_.size())
+			{
+				Flush();
+			}
+			return buffer_.data() + size_;
+		}
+
+		std::ostream* output_;
+		std::vector<char> buffer_;
+		std::size_t size_ = 0;
+	};
+}
+
+#endif  // !TREE_GENERATOR_EXPORT_BUFFERED_WRITER_H_
@@ -0,0 +1,88 @@
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../graphics/common/mesh_data.h"
+#include "glb_writer.h"
+#include "obj_writer.h"
+#include "ply_writer.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		// Discards everything written to it, counting the bytes, so that the
+		// benchmarks measure formatting rather than the disk.
+		class CountingBuffer : public std::streambuf
+		{
+		public:
+			std::size_t Count() const { return count_; }
+
+		protected:
+			std::streamsize xsputn(const char*, std::streamsize count) override
+			{
+				count_ += count;
+				return count;
+			}
+
+			int_type overflow(int_type c) override
+			{
+				++count_;
+				return traits_type::not_eof(c);
+			}
+
+		private:
+			std::size_t count_ = 0;
+		};
+
+		// A tree's worth of 8-sided branch segments: 16 triangles each.
+		std::vector<glm::mat4> CreateInstances(std::size_t count)
+		{
+			std::vector<glm::mat4> instances(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				instances[i] = glm::translate(glm::mat4(1.0f), glm::vec3(i % 100, i / 100 % 100, i / 10000))
+					* glm::rotate(glm::mat4(1.0f), 0.1f * i, glm::vec3(0.0f, 0.0f, 1.0f))
+					* glm::scale(glm::mat4(1.0f), glm::vec3(0.1f, 1.0f, 0.1f));
+			}
+			return instances;
+		}
+
+		template <auto Write>
+		void BM_Export(benchmark::State& state)
+		{
+			const MeshData cylinder = CreateCylinder(8);
+			const std::vector<glm::mat4> instances = CreateInstances(state.range(0));
+			const MeshInstances source{ &cylinder, instances, { glm::vec4(0.4f, 0.3f, 0.2f, 1.0f) } };
+
+			std::size_t byteCount = 0;
+			for (auto _ : state)
+			{
+				CountingBuffer buffer;
+				std::ostream output(&buffer);
+				Write({ &source, 1 }, &output);
+				byteCount += buffer.Count();
+			}
+			state.SetBytesProcessed(byteCount);
+			state.SetItemsProcessed(state.iterations() * GetInstancedTriangleCount({ &source, 1 }));
+		}
+
+		void WriteObjWithoutMaterials(std::span<const MeshInstances> sources, std::ostream* output)
+		{
+			WriteObj(sources, output);
+		}
+
+		BENCHMARK(BM_Export<WriteObjWithoutMaterials>)
+			->Name("BM_ExportObj")->Arg(1 << 12)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+		BENCHMARK(BM_Export<WritePly>)
+			->Name("BM_ExportPly")->Arg(1 << 12)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+		BENCHMARK(BM_Export<WriteGlb>)
+			->Name("BM_ExportGlb")->Arg(1 << 12)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+	}
+}
@@ -0,0 +1,428 @@
+#include "glb_writer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "buffered_writer.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr std::uint32_t kGlbMagic = 0x46546C67;  // "glTF"
+		constexpr std::uint32_t kGlbVersion = 2;
+		constexpr std::uint32_t kJsonChunkType = 0x4E4F534A;  // "JSON"
+		constexpr std::uint32_t kBinaryChunkType = 0x004E4942;  // "BIN\0"
+		constexpr std::size_t kGlbHeaderSize = 12;
+		constexpr std::size_t kChunkHeaderSize = 8;
+
+		constexpr int kUnsignedShort = 5123;
+		constexpr int kUnsignedInt = 5125;
+		constexpr int kFloat = 5126;
+		constexpr int kArrayBuffer = 34962;
+		constexpr int kElementArrayBuffer = 34963;
+
+		// Vertices are stored interleaved, as in Vertex.
+		constexpr std::size_t kVertexStride = 8 * sizeof(float);
+
+		std::size_t PadToFour(std::size_t size)
+		{
+			return (size + 3) & ~std::size_t{ 3 };
+		}
+
+		// Where a source's data is in the binary chunk.
+		struct SourceLayout
+		{
+			std::size_t vertexOffset;
+			std::size_t indexOffset;
+			std::size_t indexSize;
+			bool hasShortIndices;
+			std::size_t translationOffset;
+			std::size_t rotationOffset;
+			std::size_t scaleOffset;
+		};
+
+		// Sources without instances or triangles aren't exported, since
+		// glTF accessors can't be empty.
+		bool IsExported(const MeshInstances& source)
+		{
+			return !source.instances.empty() && !source.mesh->indices.empty();
+		}
+
+		// Lays out each exported source's vertices, indices and instance
+		// attributes one after the other, and returns the binary chunk's
+		// size.
+		std::size_t LayOut(
+			std::span<const MeshInstances> sources, std::vector<SourceLayout>* layouts)
+		{
+			std::size_t size = 0;
+			for (const MeshInstances& source : sources)
+			{
+				if (!IsExported(source))
+				{
+					continue;
+				}
+				SourceLayout& layout = layouts->emplace_back();
+				layout.hasShortIndices =
+					source.mesh->vertices.size() <= std::numeric_limits<std::uint16_t>::max();
+				layout.vertexOffset = size;
+				size += source.mesh->vertices.size() * kVertexStride;
+				layout.indexOffset = size;
+				layout.indexSize = source.mesh->indices.size() *
+					(layout.hasShortIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t));
+				size += PadToFour(layout.indexSize);
+				layout.translationOffset = size;
+				size += source.instances.size() * sizeof(glm::vec3);
+				layout.rotationOffset = size;
+				size += source.instances.size() * sizeof(glm::vec4);
+				layout.scaleOffset = size;
+				size += source.instances.size() * sizeof(glm::vec3);
+			}
+			return size;
+		}
+
+		nlohmann::json CreateBufferView(
+			std::size_t offset, std::size_t length, int target = 0, std::size_t stride = 0)
+		{
+			nlohmann::json view = {
+				{ "buffer", 0 },
+				{ "byteOffset", offset },
+				{ "byteLength", length },
+			};
+			if (stride != 0)
+			{
+				view["byteStride"] = stride;
+			}
+			if (target != 0)
+			{
+				view["target"] = target;
+			}
+			return view;
+		}
+
+		nlohmann::json CreateAccessor(
+			std::size_t bufferView,
+			std::size_t offset,
+			int componentType,
+			std::size_t count,
+			const char* type)
+		{
+			return {
+				{ "bufferView", bufferView },
+				{ "byteOffset", offset },
+				{ "componentType", componentType },
+				{ "count", count },
+				{ "type", type },
+			};
+		}
+
+		std::string CreateJson(
+			std::span<const MeshInstances> sources,
+			std::span<const SourceLayout> layouts,
+			std::size_t binarySize)
+		{
+			nlohmann::json gltf = {
+				{ "asset", { { "version", "2.0" }, { "generator", "Tree Generator" } } },
+				{ "scene", 0 },
+			};
+			if (!layouts.empty())
+			{
+				gltf["extensionsUsed"] = { "EXT_mesh_gpu_instancing" };
+				// Without it, a loader would draw each mesh only once.
+				gltf["extensionsRequired"] = { "EXT_mesh_gpu_instancing" };
+				gltf["buffers"] = { { { "byteLength", binarySize } } };
+			}
+
+			nlohmann::json bufferViews = nlohmann::json::array();
+			nlohmann::json accessors = nlohmann::json::array();
+			nlohmann::json materials = nlohmann::json::array();
+			nlohmann::json meshes = nlohmann::json::array();
+			nlohmann::json nodes = nlohmann::json::array();
+			std::size_t layoutIndex = 0;
+			for (const MeshInstances& source : sources)
+			{
+				if (!IsExported(source))
+				{
+					continue;
+				}
+				const SourceLayout& layout = layouts[layoutIndex++];
+				const std::size_t vertexCount = source.mesh->vertices.size();
+				const std::size_t instanceCount = source.instances.size();
+
+				// POSITION accessors need their bounds.
+				glm::vec3 min(std::numeric_limits<float>::max());
+				glm::vec3 max(std::numeric_limits<float>::lowest());
+				for (const Vertex& vertex : source.mesh->vertices)
+				{
+					min = glm::min(min, vertex.position);
+					max = glm::max(max, vertex.position);
+				}
+
+				const std::size_t vertexView = bufferViews.size();
+				bufferViews.push_back(CreateBufferView(
+					layout.vertexOffset, vertexCount * kVertexStride, kArrayBuffer, kVertexStride));
+				const std::size_t indexView = bufferViews.size();
+				bufferViews.push_back(CreateBufferView(
+					layout.indexOffset, layout.indexSize, kElementArrayBuffer));
+				// Instance attributes are tightly packed, with no stride.
+				const std::size_t instanceView = bufferViews.size();
+				bufferViews.push_back(CreateBufferView(
+					layout.translationOffset, layout.scaleOffset +
+					instanceCount * sizeof(glm::vec3) - layout.translationOffset));
+
+				const std::size_t position = accessors.size();
+				accessors.push_back(CreateAccessor(vertexView, 0, kFloat, vertexCount, "VEC3"));
+				accessors.back()["min"] = { min.x, min.y, min.z };
+				accessors.back()["max"] = { max.x, max.y, max.z };
+				accessors.push_back(CreateAccessor(
+					vertexView, sizeof(glm::vec3), kFloat, vertexCount, "VEC3"));
+				accessors.push_back(CreateAccessor(
+					vertexView, 2 * sizeof(glm::vec3), kFloat, vertexCount, "VEC2"));
+				accessors.push_back(CreateAccessor(
+					indexView,
+					0,
+					layout.hasShortIndices ? kUnsignedShort : kUnsignedInt,
+					source.mesh->indices.size(),
+					"SCALAR"));
+				accessors.push_back(CreateAccessor(
+					instanceView, 0, kFloat, instanceCount, "VEC3"));
+				accessors.push_back(CreateAccessor(
+					instanceView,
+					layout.rotationOffset - layout.translationOffset,
+					kFloat,
+					instanceCount,
+					"VEC4"));
+				accessors.push_back(CreateAccessor(
+					instanceView,
+					layout.scaleOffset - layout.translationOffset,
+					kFloat,
+					instanceCount,
+					"VEC3"));
+
+				const glm::vec4& color = source.material.color;
+				nlohmann::json material = {
+					{ "pbrMetallicRoughness", {
+						{ "baseColorFactor", { color.x, color.y, color.z, color.w } },
+						{ "metallicFactor", 0.0f },
+						{ "roughnessFactor", 1.0f },
+					} },
+				};
+				if (color.w < 1.0f)
+				{
+					material["alphaMode"] = "BLEND";
+				}
+				materials.push_back(std::move(material));
+
+				meshes.push_back({ { "primitives", { {
+					{ "attributes", {
+						{ "POSITION", position },
+						{ "NORMAL", position + 1 },
+						{ "TEXCOORD_0", position + 2 },
+					} },
+					{ "indices", position + 3 },
+					{ "material", materials.size() - 1 },
+				} } } });
+
+				nodes.push_back({
+					{ "mesh", meshes.size() - 1 },
+					{ "extensions", { { "EXT_mesh_gpu_instancing", { { "attributes", {
+						{ "TRANSLATION", position + 4 },
+						{ "ROTATION", position + 5 },
+						{ "SCALE", position + 6 },
+					} } } } } },
+				});
+			}
+
+			// A scene's nodes must not be empty when present, so an empty
+			// scene leaves them out.
+			nlohmann::json scene = nlohmann::json::object();
+			if (!nodes.empty())
+			{
+				scene["nodes"] = nlohmann::json::array();
+				for (std::size_t i = 0; i < nodes.size(); ++i)
+				{
+					scene["nodes"].push_back(i);
+				}
+			}
+			gltf["scenes"] = nlohmann::json::array({ std::move(scene) });
+			if (!nodes.empty())
+			{
+				gltf["bufferViews"] = std::move(bufferViews);
+				gltf["accessors"] = std::move(accessors);
+				gltf["materials"] = std::move(materials);
+				gltf["meshes"] = std::move(meshes);
+				gltf["nodes"] = std::move(nodes);
+			}
+			return gltf.dump();
+		}
+
+		void WriteVector(BufferedWriter* writer, const float* values, int count)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				writer->WriteLittleEndian(values[i]);
+			}
+		}
+
+		void WritePadding(BufferedWriter* writer, std::size_t size, char padding)
+		{
+			for (std::size_t i = size; i < PadToFour(size); ++i)
+			{
+				writer->Write(padding);
+			}
+		}
+
+		void WriteSource(
+			const MeshInstances& source,
+			const SourceLayout& layout,
+			std::vector<InstanceTransform>* transforms,
+			BufferedWriter* writer)
+		{
+			for (const Vertex& vertex : source.mesh->vertices)
+			{
+				WriteVector(writer, &vertex.position.x, 3);
+				WriteVector(writer, &vertex.normal.x, 3);
+				WriteVector(writer, &vertex.uv.x, 2);
+			}
+			for (unsigned int index : source.mesh->indices)
+			{
+				if (layout.hasShortIndices)
+				{
+					writer->WriteLittleEndian(static_cast<std::uint16_t>(index));
+				}
+				else
+				{
+					writer->WriteLittleEndian(static_cast<std::uint32_t>(index));
+				}
+			}
+			WritePadding(writer, layout.indexSize, '\0');
+
+			transforms->resize(source.instances.size());
+			for (std::size_t i = 0; i < source.instances.size(); ++i)
+			{
+				(*transforms)[i] = DecomposeInstance(source.instances[i]);
+			}
+			for (const InstanceTransform& transform : *transforms)
+			{
+				WriteVector(writer, &transform.translation.x, 3);
+			}
+			for (const InstanceTransform& transform : *transforms)
+			{
+				WriteVector(writer, &transform.rotation.x, 4);
+			}
+			for (const InstanceTransform& transform : *transforms)
+			{
+				WriteVector(writer, &transform.scale.x, 3);
+			}
+		}
+	}
+
+	InstanceTransform DecomposeInstance(const glm::mat4& model)
+	{
+		const glm::vec3 columns[] = { glm::vec3(model[0]), glm::vec3(model[1]), glm::vec3(model[2]) };
+		InstanceTransform transform;
+		transform.translation = glm::vec3(model[3]);
+		transform.scale = glm::vec3(
+			glm::length(columns[0]), glm::length(columns[1]), glm::length(columns[2]));
+		if (glm::dot(glm::cross(columns[0], columns[1]), columns[2]) < 0.0f)
+		{
+			transform.scale.x = -transform.scale.x;
+		}
+		if (transform.scale.x == 0.0f || transform.scale.y == 0.0f || transform.scale.z == 0.0f)
+		{
+			// Nothing is left to rotate.
+			transform.rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			return transform;
+		}
+
+		// m[i][j] is row i and column j of the rotation, unlike glm's
+		// column-first indexing. The quaternion is found from the largest
+		// of its components, to stay accurate near 180 degree rotations.
+		float m[3][3];
+		for (int column = 0; column < 3; ++column)
+		{
+			const glm::vec3 axis = columns[column] / transform.scale[column];
+			for (int row = 0; row < 3; ++row)
+			{
+				m[row][column] = axis[row];
+			}
+		}
+		glm::vec4& q = transform.rotation;
+		const float trace = m[0][0] + m[1][1] + m[2][2];
+		if (trace > 0.0f)
+		{
+			const float s = 2.0f * std::sqrt(1.0f + trace);
+			q = glm::vec4(
+				(m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s, 0.25f * s);
+		}
+		else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+		{
+			const float s = 2.0f * std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]);
+			q = glm::vec4(
+				0.25f * s, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s, (m[2][1] - m[1][2]) / s);
+		}
+		else if (m[1][1] > m[2][2])
+		{
+			const float s = 2.0f * std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]);
+			q = glm::vec4(
+				(m[0][1] + m[1][0]) / s, 0.25f * s, (m[1][2] + m[2][1]) / s, (m[0][2] - m[2][0]) / s);
+		}
+		else
+		{
+			const float s = 2.0f * std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]);
+			q = glm::vec4(
+				(m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, 0.25f * s, (m[1][0] - m[0][1]) / s);
+		}
+		q = glm::normalize(q);
+		return transform;
+	}
+
+	void WriteGlb(std::span<const MeshInstances> sources, std::ostream* output)
+	{
+		std::vector<SourceLayout> layouts;
+		const std::size_t binarySize = LayOut(sources, &layouts);
+		const std::string json = CreateJson(sources, layouts, binarySize);
+
+		std::size_t totalSize = kGlbHeaderSize + kChunkHeaderSize + PadToFour(json.size());
+		if (binarySize > 0)
+		{
+			totalSize += kChunkHeaderSize + binarySize;
+		}
+		if (totalSize > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw std::invalid_argument("Too much geometry to export to GLB");
+		}
+
+		BufferedWriter writer(output);
+		writer.WriteLittleEndian(kGlbMagic);
+		writer.WriteLittleEndian(kGlbVersion);
+		writer.WriteLittleEndian(static_cast<std::uint32_t>(totalSize));
+
+		writer.WriteLittleEndian(static_cast<std::uint32_t>(PadToFour(json.size())));
+		writer.WriteLittleEndian(kJsonChunkType);
+		writer.Write(json);
+		WritePadding(&writer, json.size(), ' ');
+
+		if (binarySize > 0)
+		{
+			writer.WriteLittleEndian(static_cast<std::uint32_t>(binarySize));
+			writer.WriteLittleEndian(kBinaryChunkType);
+			std::vector<InstanceTransform> transforms;
+			std::size_t layoutIndex = 0;
+			for (const MeshInstances& source : sources)
+			{
+				if (IsExported(source))
+				{
+					WriteSource(source, layouts[layoutIndex++], &transforms, &writer);
+				}
+			}
+		}
+		writer.Flush();
+	}
+}
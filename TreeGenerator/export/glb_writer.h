@@ -0,0 +1,40 @@
+#ifndef TREE_GENERATOR_EXPORT_GLB_WRITER_H_
+#define TREE_GENERATOR_EXPORT_GLB_WRITER_H_
+
+#include <ostream>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "../graphics/common/mesh_instances.h"
+
+namespace tree_generator
+{
+	// An instance's model matrix split into the parts glTF stores, applied
+	// as translation * rotation * scale. The rotation is a unit quaternion
+	// in glTF's (x, y, z, w) order.
+	struct InstanceTransform
+	{
+		glm::vec3 translation;
+		glm::vec4 rotation;
+		glm::vec3 scale;
+	};
+
+	// Splits the model matrix into translation, rotation and scale. A
+	// mirroring matrix gets a negative x scale. Shear can't be represented,
+	// and is lost; the mesh generator's matrices never have any.
+	InstanceTransform DecomposeInstance(const glm::mat4& model);
+
+	// Writes the sources to a binary glTF 2.0 file. Each source's mesh is
+	// stored once, and drawn by one node with its instances as
+	// EXT_mesh_gpu_instancing attributes, so the file grows with the
+	// number of instances by 40 bytes each rather than by their geometry.
+	// Sources are written straight from their meshes and matrices into
+	// the binary chunk, whose layout is known up front.
+	//
+	// Throws a std::runtime_error if writing fails, and a
+	// std::invalid_argument if the file would be larger than GLB's 4 GiB.
+	void WriteGlb(std::span<const MeshInstances> sources, std::ostream* output);
+}
+
+#endif  // !TREE_GENERATOR_EXPORT_GLB_WRITER_H_
@@ -0,0 +1,257 @@
+#include "glb_writer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <nlohmann/json.hpp>
+
+#include "../graphics/common/mesh_data.h"
+
+using ::testing::ElementsAre;
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		// Reads a little-endian value; the tests assume a little-endian host.
+		template <typename T>
+		T Read(const std::string& data, std::size_t offset)
+		{
+			T value;
+			std::memcpy(&value, data.data() + offset, sizeof(T));
+			return value;
+		}
+
+		struct GlbFile
+		{
+			nlohmann::json json;
+			std::string binary;
+		};
+
+		GlbFile Parse(const std::string& file)
+		{
+			EXPECT_EQ(Read<std::uint32_t>(file, 0), 0x46546C67u);
+			EXPECT_EQ(Read<std::uint32_t>(file, 4), 2u);
+			EXPECT_EQ(Read<std::uint32_t>(file, 8), file.size());
+
+			GlbFile glb;
+			const std::uint32_t jsonSize = Read<std::uint32_t>(file, 12);
+			EXPECT_EQ(jsonSize % 4, 0u);
+			EXPECT_EQ(Read<std::uint32_t>(file, 16), 0x4E4F534Au);
+			glb.json = nlohmann::json::parse(file.substr(20, jsonSize));
+			const std::size_t binaryChunk = 20 + jsonSize;
+			if (binaryChunk < file.size())
+			{
+				const std::uint32_t binarySize = Read<std::uint32_t>(file, binaryChunk);
+				EXPECT_EQ(Read<std::uint32_t>(file, binaryChunk + 4), 0x004E4942u);
+				glb.binary = file.substr(binaryChunk + 8, binarySize);
+			}
+			return glb;
+		}
+
+		// Returns where the accessor's i-th element starts in the binary chunk.
+		std::size_t GetElementOffset(const GlbFile& glb, std::size_t accessor, std::size_t i)
+		{
+			const nlohmann::json& a = glb.json["accessors"][accessor];
+			const nlohmann::json& view = glb.json["bufferViews"][a["bufferView"].get<std::size_t>()];
+			const std::size_t componentCount =
+				a["type"] == "SCALAR" ? 1 : a["type"] == "VEC2" ? 2 : a["type"] == "VEC3" ? 3 : 4;
+			const std::size_t componentSize = a["componentType"] == 5123 ? 2 : 4;
+			const std::size_t stride = view.value("byteStride", componentCount * componentSize);
+			return view["byteOffset"].get<std::size_t>() + a["byteOffset"].get<std::size_t>() + i * stride;
+		}
+
+		glm::mat4 Compose(const InstanceTransform& transform)
+		{
+			const glm::vec4& q = transform.rotation;
+			const glm::mat4 rotation(
+				glm::vec4(
+					1.0f - 2.0f * (q.y * q.y + q.z * q.z),
+					2.0f * (q.x * q.y + q.z * q.w),
+					2.0f * (q.x * q.z - q.y * q.w),
+					0.0f),
+				glm::vec4(
+					2.0f * (q.x * q.y - q.z * q.w),
+					1.0f - 2.0f * (q.x * q.x + q.z * q.z),
+					2.0f * (q.y * q.z + q.x * q.w),
+					0.0f),
+				glm::vec4(
+					2.0f * (q.x * q.z + q.y * q.w),
+					2.0f * (q.y * q.z - q.x * q.w),
+					1.0f - 2.0f * (q.x * q.x + q.y * q.y),
+					0.0f),
+				glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+			return glm::translate(glm::mat4(1.0f), transform.translation) *
+				rotation *
+				glm::scale(glm::mat4(1.0f), transform.scale);
+		}
+
+		void ExpectNear(const glm::mat4& actual, const glm::mat4& expected)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					EXPECT_NEAR(actual[column][row], expected[column][row], 1e-5f)
+						<< "column " << column << ", row " << row;
+				}
+			}
+		}
+
+		TEST(GlbWriterTest, DecomposesRigidScaledMatrices)
+		{
+			const glm::vec3 axes[] = {
+				glm::vec3(1.0f, 0.0f, 0.0f),
+				glm::vec3(0.0f, 1.0f, 0.0f),
+				glm::vec3(0.0f, 0.0f, 1.0f),
+				glm::normalize(glm::vec3(1.0f, -2.0f, 3.0f)),
+			};
+			for (const glm::vec3& axis : axes)
+			{
+				for (float degrees : { 0.0f, 30.0f, 90.0f, 179.0f, 180.0f, 270.0f })
+				{
+					const glm::mat4 model =
+						glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, -3.0f)) *
+						glm::rotate(glm::mat4(1.0f), glm::radians(degrees), axis) *
+						glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 2.0f, 0.25f));
+
+					const InstanceTransform transform = DecomposeInstance(model);
+
+					EXPECT_NEAR(glm::length(transform.rotation), 1.0f, 1e-6f);
+					ExpectNear(Compose(transform), model);
+				}
+			}
+		}
+
+		TEST(GlbWriterTest, DecomposesMirroringMatrices)
+		{
+			const glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+
+			const InstanceTransform transform = DecomposeInstance(model);
+
+			EXPECT_LT(transform.scale.x, 0.0f);
+			ExpectNear(Compose(transform), model);
+		}
+
+		TEST(GlbWriterTest, StoresEachMeshOnceWithInstanceAttributes)
+		{
+			const MeshData cylinder = CreateCylinder(5);
+			const std::vector<glm::mat4> instances = {
+				glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
+				glm::rotate(glm::mat4(1.0f), 1.0f, glm::vec3(0.0f, 0.0f, 1.0f)),
+				glm::scale(glm::mat4(1.0f), glm::vec3(0.1f, 3.0f, 0.1f)),
+			};
+			const MeshInstances source{ &cylinder, instances, { glm::vec4(0.5f, 0.25f, 0.0f, 1.0f) } };
+
+			std::ostringstream output;
+			WriteGlb({ &source, 1 }, &output);
+			const GlbFile glb = Parse(output.str());
+
+			EXPECT_THAT(glb.json["extensionsRequired"], ElementsAre("EXT_mesh_gpu_instancing"));
+			EXPECT_EQ(glb.json["buffers"][0]["byteLength"], glb.binary.size());
+			ASSERT_THAT(glb.json["meshes"], SizeIs(1));
+			ASSERT_THAT(glb.json["nodes"], SizeIs(1));
+			EXPECT_THAT(glb.json["scenes"][0]["nodes"], ElementsAre(0));
+			EXPECT_THAT(
+				glb.json["materials"][0]["pbrMetallicRoughness"]["baseColorFactor"],
+				ElementsAre(0.5f, 0.25f, 0.0f, 1.0f));
+
+			const nlohmann::json& primitive = glb.json["meshes"][0]["primitives"][0];
+			const std::size_t position = primitive["attributes"]["POSITION"];
+			const std::size_t indices = primitive["indices"];
+			EXPECT_EQ(glb.json["accessors"][position]["count"], cylinder.vertices.size());
+			EXPECT_EQ(glb.json["accessors"][indices]["count"], cylinder.indices.size());
+			for (std::size_t i = 0; i < cylinder.vertices.size(); ++i)
+			{
+				const std::size_t offset = GetElementOffset(glb, position, i);
+				EXPECT_EQ(
+					glm::vec3(
+						Read<float>(glb.binary, offset),
+						Read<float>(glb.binary, offset + 4),
+						Read<float>(glb.binary, offset + 8)),
+					cylinder.vertices[i].position);
+			}
+			for (std::size_t i = 0; i < cylinder.indices.size(); ++i)
+			{
+				EXPECT_EQ(
+					Read<std::uint16_t>(glb.binary, GetElementOffset(glb, indices, i)),
+					cylinder.indices[i]);
+			}
+
+			const nlohmann::json& attributes =
+				glb.json["nodes"][0]["extensions"]["EXT_mesh_gpu_instancing"]["attributes"];
+			for (std::size_t i = 0; i < instances.size(); ++i)
+			{
+				InstanceTransform transform;
+				std::memcpy(&transform.translation,
+					glb.binary.data() + GetElementOffset(glb, attributes["TRANSLATION"], i), 12);
+				std::memcpy(&transform.rotation,
+					glb.binary.data() + GetElementOffset(glb, attributes["ROTATION"], i), 16);
+				std::memcpy(&transform.scale,
+					glb.binary.data() + GetElementOffset(glb, attributes["SCALE"], i), 12);
+				ExpectNear(Compose(transform), instances[i]);
+			}
+		}
+
+		TEST(GlbWriterTest, AlignsEverySourceAndSkipsEmptyOnes)
+		{
+			// 3 indices of 2 bytes need padding before the next source.
+			MeshData triangle;
+			triangle.vertices.resize(3);
+			triangle.indices = { 0, 1, 2 };
+			const std::vector<glm::mat4> instances = { glm::mat4(1.0f) };
+			const MeshInstances sources[] = {
+				{ &triangle, instances, { glm::vec4(1.0f) } },
+				{ &triangle, {}, { glm::vec4(1.0f) } },
+				{ &triangle, instances, { glm::vec4(1.0f, 1.0f, 1.0f, 0.5f) } },
+			};
+
+			std::ostringstream output;
+			WriteGlb(sources, &output);
+			const GlbFile glb = Parse(output.str());
+
+			EXPECT_THAT(glb.json["nodes"], SizeIs(2));
+			EXPECT_EQ(glb.json["materials"][1]["alphaMode"], "BLEND");
+			EXPECT_EQ(glb.binary.size() % 4, 0u);
+			for (const nlohmann::json& view : glb.json["bufferViews"])
+			{
+				EXPECT_EQ(view["byteOffset"].get<std::size_t>() % 4, 0u);
+				EXPECT_LE(
+					view["byteOffset"].get<std::size_t>() + view["byteLength"].get<std::size_t>(),
+					glb.binary.size());
+			}
+		}
+
+		TEST(GlbWriterTest, WritesEmptyScene)
+		{
+			const MeshData cylinder = CreateCylinder(4);
+			const MeshInstances uninstanced{ &cylinder, {}, { glm::vec4(1.0f) } };
+			for (std::span<const MeshInstances> sources :
+				{ std::span<const MeshInstances>(), std::span<const MeshInstances>(&uninstanced, 1) })
+			{
+				std::ostringstream output;
+				WriteGlb(sources, &output);
+				const GlbFile glb = Parse(output.str());
+
+				EXPECT_EQ(glb.json["asset"]["version"], "2.0");
+				EXPECT_FALSE(glb.json.contains("buffers"));
+				EXPECT_FALSE(glb.json.contains("nodes"));
+				EXPECT_TRUE(glb.binary.empty());
+
+				// glTF doesn't allow a scene with an empty list of nodes.
+				ASSERT_THAT(glb.json["scenes"], SizeIs(1));
+				EXPECT_FALSE(glb.json["scenes"][0].contains("nodes"));
+			}
+		}
+	}
+}
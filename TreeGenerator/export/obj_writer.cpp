@@ -0,0 +1,119 @@
+#include "obj_writer.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../graphics/common/mesh_baker.h"
+#include "buffered_writer.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		void WriteVector(BufferedWriter* writer, std::string_view keyword, const float* values, int count)
+		{
+			writer->Write(keyword);
+			for (int i = 0; i < count; ++i)
+			{
+				writer->Write(' ');
+				writer->WriteNumber(values[i]);
+			}
+			writer->Write('\n');
+		}
+
+		// Writes "v/vt/vn" for a 1-based index shared by all three.
+		void WriteCorner(BufferedWriter* writer, std::uint64_t index)
+		{
+			writer->Write(' ');
+			writer->WriteNumber(index);
+			writer->Write('/');
+			writer->WriteNumber(index);
+			writer->Write('/');
+			writer->WriteNumber(index);
+		}
+	}
+
+	std::string GetExportMaterialName(std::size_t sourceIndex)
+	{
+		return "material" + std::to_string(sourceIndex);
+	}
+
+	void WriteObj(
+		std::span<const MeshInstances> sources,
+		std::ostream* output,
+		std::string_view materialLibrary)
+	{
+		BufferedWriter writer(output);
+		writer.Write("# Tree Generator\n");
+		if (!materialLibrary.empty())
+		{
+			writer.Write("mtllib ");
+			writer.Write(materialLibrary);
+			writer.Write('\n');
+		}
+
+		std::vector<Vertex> vertices;
+		std::vector<std::uint32_t> indices;
+		// OBJ indices are 1-based, and count from the start of the file.
+		std::uint64_t firstVertex = 1;
+		for (std::size_t s = 0; s < sources.size(); ++s)
+		{
+			const MeshInstances& source = sources[s];
+			const std::string material = GetExportMaterialName(s);
+			writer.Write("g ");
+			writer.Write(material);
+			writer.Write("\nusemtl ");
+			writer.Write(material);
+			writer.Write('\n');
+
+			vertices.resize(source.mesh->vertices.size());
+			indices.resize(source.mesh->indices.size());
+			for (const glm::mat4& model : source.instances)
+			{
+				// The indices are offset below, where they can be 64-bit.
+				BakeInstance(*source.mesh, model, 0, vertices.data(), indices.data());
+
+				for (const Vertex& vertex : vertices)
+				{
+					WriteVector(&writer, "v", &vertex.position.x, 3);
+				}
+				for (const Vertex& vertex : vertices)
+				{
+					WriteVector(&writer, "vt", &vertex.uv.x, 2);
+				}
+				for (const Vertex& vertex : vertices)
+				{
+					WriteVector(&writer, "vn", &vertex.normal.x, 3);
+				}
+				for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+				{
+					writer.Write('f');
+					WriteCorner(&writer, firstVertex + indices[i]);
+					WriteCorner(&writer, firstVertex + indices[i + 1]);
+					WriteCorner(&writer, firstVertex + indices[i + 2]);
+					writer.Write('\n');
+				}
+				firstVertex += vertices.size();
+			}
+		}
+		writer.Flush();
+	}
+
+	void WriteObjMaterials(std::span<const MeshInstances> sources, std::ostream* output)
+	{
+		BufferedWriter writer(output);
+		for (std::size_t s = 0; s < sources.size(); ++s)
+		{
+			const glm::vec4& color = sources[s].material.color;
+			writer.Write("newmtl ");
+			writer.Write(GetExportMaterialName(s));
+			writer.Write('\n');
+			WriteVector(&writer, "Kd", &color.x, 3);
+			WriteVector(&writer, "d", &color.w, 1);
+			writer.Write('\n');
+		}
+		writer.Flush();
+	}
+}
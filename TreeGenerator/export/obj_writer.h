@@ -0,0 +1,32 @@
+#ifndef TREE_GENERATOR_EXPORT_OBJ_WRITER_H_
+#define TREE_GENERATOR_EXPORT_OBJ_WRITER_H_
+
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../graphics/common/mesh_instances.h"
+
+namespace tree_generator
+{
+	// Returns the name of the i-th source's material in exported files.
+	std::string GetExportMaterialName(std::size_t sourceIndex);
+
+	// Writes every instance of the sources to a Wavefront OBJ file, as one
+	// group per source using that source's material. Instances are
+	// transformed as they are written, through a buffer, so memory use
+	// doesn't grow with the number of instances. If materialLibrary isn't
+	// empty, the file references it with mtllib.
+	//
+	// Throws a std::runtime_error if writing fails.
+	void WriteObj(
+		std::span<const MeshInstances> sources,
+		std::ostream* output,
+		std::string_view materialLibrary = {});
+
+	// Writes the sources' materials to a material library for WriteObj.
+	void WriteObjMaterials(std::span<const MeshInstances> sources, std::ostream* output);
+}
+
+#endif  // !TREE_GENERATOR_EXPORT_OBJ_WRITER_H_
@@ -0,0 +1,144 @@
+#include "obj_writer.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../graphics/common/mesh_data.h"
+
+using ::testing::ElementsAre;
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		MeshData CreateTriangle()
+		{
+			MeshData mesh;
+			mesh.vertices = {
+				{ glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 0.0f) },
+				{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 0.0f) },
+				{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 1.0f) },
+			};
+			mesh.indices = { 0, 1, 2 };
+			return mesh;
+		}
+
+		// Returns the lines that start with the keyword, without it.
+		std::vector<std::string> GetLines(const std::string& text, const std::string& keyword)
+		{
+			std::vector<std::string> lines;
+			std::istringstream stream(text);
+			std::string line;
+			while (std::getline(stream, line))
+			{
+				if (line.starts_with(keyword + " "))
+				{
+					lines.push_back(line.substr(keyword.size() + 1));
+				}
+			}
+			return lines;
+		}
+
+		TEST(ObjWriterTest, WritesTransformedInstances)
+		{
+			const MeshData triangle = CreateTriangle();
+			const std::vector<glm::mat4> instances = {
+				glm::mat4(1.0f),
+				glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)),
+			};
+			const MeshInstances source{ &triangle, instances, { glm::vec4(1.0f) } };
+
+			std::ostringstream output;
+			WriteObj({ &source, 1 }, &output);
+
+			EXPECT_THAT(GetLines(output.str(), "v"), ElementsAre(
+				"0 0 0", "1 0 0", "0 1 0",
+				"2 0 0", "3 0 0", "2 1 0"));
+			EXPECT_THAT(GetLines(output.str(), "vt"), SizeIs(6));
+			EXPECT_THAT(GetLines(output.str(), "vn"), SizeIs(6));
+			EXPECT_THAT(GetLines(output.str(), "f"), ElementsAre(
+				"1/1/1 2/2/2 3/3/3",
+				"4/4/4 5/5/5 6/6/6"));
+		}
+
+		TEST(ObjWriterTest, TransformsNormals)
+		{
+			const MeshData triangle = CreateTriangle();
+			const std::vector<glm::mat4> instances = {
+				glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+			};
+			const MeshInstances source{ &triangle, instances, { glm::vec4(1.0f) } };
+
+			std::ostringstream output;
+			WriteObj({ &source, 1 }, &output);
+
+			for (const std::string& line : GetLines(output.str(), "vn"))
+			{
+				std::istringstream stream(line);
+				glm::vec3 normal;
+				stream >> normal.x >> normal.y >> normal.z;
+				EXPECT_NEAR(normal.z, -1.0f, 1e-6f);
+			}
+		}
+
+		TEST(ObjWriterTest, GroupsSourcesByMaterial)
+		{
+			const MeshData triangle = CreateTriangle();
+			const std::vector<glm::mat4> instances = { glm::mat4(1.0f) };
+			const MeshInstances sources[] = {
+				{ &triangle, instances, { glm::vec4(1.0f, 0.0f, 0.0f, 1.0f) } },
+				{ &triangle, instances, { glm::vec4(0.0f, 0.5f, 0.0f, 1.0f) } },
+			};
+
+			std::ostringstream output;
+			WriteObj(sources, &output, "tree.mtl");
+			std::ostringstream materials;
+			WriteObjMaterials(sources, &materials);
+
+			EXPECT_THAT(GetLines(output.str(), "mtllib"), ElementsAre("tree.mtl"));
+			EXPECT_THAT(GetLines(output.str(), "usemtl"), ElementsAre("material0", "material1"));
+			// The second source's faces continue the first's vertices.
+			EXPECT_THAT(GetLines(output.str(), "f"), ElementsAre(
+				"1/1/1 2/2/2 3/3/3",
+				"4/4/4 5/5/5 6/6/6"));
+			EXPECT_THAT(GetLines(materials.str(), "newmtl"), ElementsAre("material0", "material1"));
+			EXPECT_THAT(GetLines(materials.str(), "Kd"), ElementsAre("1 0 0", "0 0.5 0"));
+		}
+
+		TEST(ObjWriterTest, WritesFloatsExactly)
+		{
+			MeshData triangle = CreateTriangle();
+			triangle.vertices[0].position = glm::vec3(0.1f, 1.0f / 3.0f, -1e-7f);
+			const std::vector<glm::mat4> instances = { glm::mat4(1.0f) };
+			const MeshInstances source{ &triangle, instances, { glm::vec4(1.0f) } };
+
+			std::ostringstream output;
+			WriteObj({ &source, 1 }, &output);
+
+			std::istringstream stream(GetLines(output.str(), "v").front());
+			glm::vec3 position;
+			stream >> position.x >> position.y >> position.z;
+			EXPECT_EQ(position, triangle.vertices[0].position);
+		}
+
+		TEST(ObjWriterTest, ThrowsWhenStreamFails)
+		{
+			const MeshData triangle = CreateTriangle();
+			const std::vector<glm::mat4> instances = { glm::mat4(1.0f) };
+			const MeshInstances source{ &triangle, instances, { glm::vec4(1.0f) } };
+
+			std::ostringstream output;
+			output.setstate(std::ios::badbit);
+
+			EXPECT_THROW(WriteObj({ &source, 1 }, &output), std::runtime_error);
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#include "ply_writer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../graphics/common/mesh_baker.h"
+#include "buffered_writer.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		std::uint8_t ToByte(float channel)
+		{
+			return static_cast<std::uint8_t>(std::clamp(channel, 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+
+	void WritePly(std::span<const MeshInstances> sources, std::ostream* output)
+	{
+		const std::size_t vertexCount = GetInstancedVertexCount(sources);
+		const std::size_t faceCount = GetInstancedTriangleCount(sources);
+		if (vertexCount > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw std::invalid_argument("Too many vertices to export to PLY");
+		}
+
+		BufferedWriter writer(output);
+		writer.Write(
+			"ply\n"
+			"format binary_little_endian 1.0\n"
+			"comment Tree Generator\n"
+			"element vertex ");
+		writer.Write(std::to_string(vertexCount));
+		writer.Write(
+			"\n"
+			"property float x\n"
+			"property float y\n"
+			"property float z\n"
+			"property float nx\n"
+			"property float ny\n"
+			"property float nz\n"
+			"property float s\n"
+			"property float t\n"
+			"property uchar red\n"
+			"property uchar green\n"
+			"property uchar blue\n"
+			"property uchar alpha\n"
+			"element face ");
+		writer.Write(std::to_string(faceCount));
+		writer.Write(
+			"\n"
+			"property list uchar uint vertex_indices\n"
+			"end_header\n");
+
+		// PLY stores all vertices before any faces, so the instances are
+		// visited twice: once to transform them, and once to offset their
+		// indices.
+		std::vector<Vertex> vertices;
+		std::vector<std::uint32_t> indices;
+		for (const MeshInstances& source : sources)
+		{
+			const glm::vec4& color = source.material.color;
+			const std::uint8_t rgba[] = {
+				ToByte(color.x), ToByte(color.y), ToByte(color.z), ToByte(color.w) };
+
+			vertices.resize(source.mesh->vertices.size());
+			indices.resize(source.mesh->indices.size());
+			for (const glm::mat4& model : source.instances)
+			{
+				BakeInstance(*source.mesh, model, 0, vertices.data(), indices.data());
+				for (const Vertex& vertex : vertices)
+				{
+					writer.WriteLittleEndian(vertex.position.x);
+					writer.WriteLittleEndian(vertex.position.y);
+					writer.WriteLittleEndian(vertex.position.z);
+					writer.WriteLittleEndian(vertex.normal.x);
+					writer.WriteLittleEndian(vertex.normal.y);
+					writer.WriteLittleEndian(vertex.normal.z);
+					writer.WriteLittleEndian(vertex.uv.x);
+					writer.WriteLittleEndian(vertex.uv.y);
+					for (std::uint8_t channel : rgba)
+					{
+						writer.WriteLittleEndian(channel);
+					}
+				}
+			}
+		}
+
+		std::uint32_t firstVertex = 0;
+		for (const MeshInstances& source : sources)
+		{
+			const std::vector<unsigned int>& meshIndices = source.mesh->indices;
+			const std::uint32_t meshVertexCount =
+				static_cast<std::uint32_t>(source.mesh->vertices.size());
+			for (std::size_t instance = 0; instance < source.instances.size(); ++instance)
+			{
+				for (std::size_t i = 0; i + 2 < meshIndices.size(); i += 3)
+				{
+					writer.WriteLittleEndian(std::uint8_t{ 3 });
+					writer.WriteLittleEndian(firstVertex + meshIndices[i]);
+					writer.WriteLittleEndian(firstVertex + meshIndices[i + 1]);
+					writer.WriteLittleEndian(firstVertex + meshIndices[i + 2]);
+				}
+				firstVertex += meshVertexCount;
+			}
+		}
+		writer.Flush();
+	}
+}
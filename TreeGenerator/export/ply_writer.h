@@ -0,0 +1,23 @@
+#ifndef TREE_GENERATOR_EXPORT_PLY_WRITER_H_
+#define TREE_GENERATOR_EXPORT_PLY_WRITER_H_
+
+#include <ostream>
+#include <span>
+
+#include "../graphics/common/mesh_instances.h"
+
+namespace tree_generator
+{
+	// Writes every instance of the sources to a binary little-endian PLY
+	// file. Each vertex has a position, normal, uv and its source's
+	// material color; each face is a triangle. Instances are transformed
+	// as they are written, through a buffer, so memory use doesn't grow
+	// with the number of instances.
+	//
+	// Throws a std::runtime_error if writing fails, and a
+	// std::invalid_argument if there are too many vertices to index with
+	// 32 bits.
+	void WritePly(std::span<const MeshInstances> sources, std::ostream* output);
+}
+
+#endif  // !TREE_GENERATOR_EXPORT_PLY_WRITER_H_
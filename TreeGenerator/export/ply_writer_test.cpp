@@ -0,0 +1,123 @@
+#include "ply_writer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../graphics/common/mesh_data.h"
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr std::size_t kVertexSize = 8 * sizeof(float) + 4;
+		constexpr std::size_t kFaceSize = 1 + 3 * sizeof(std::uint32_t);
+
+		struct PlyFile
+		{
+			std::string header;
+			std::string body;
+		};
+
+		PlyFile Split(const std::string& file)
+		{
+			const std::string end = "end_header\n";
+			const std::size_t position = file.find(end);
+			if (position == std::string::npos)
+			{
+				return { file, {} };
+			}
+			return { file.substr(0, position + end.size()), file.substr(position + end.size()) };
+		}
+
+		// Reads a little-endian value; the tests assume a little-endian host.
+		template <typename T>
+		T Read(const std::string& body, std::size_t offset)
+		{
+			T value;
+			std::memcpy(&value, body.data() + offset, sizeof(T));
+			return value;
+		}
+
+		TEST(PlyWriterTest, WritesHeaderWithCounts)
+		{
+			const MeshData cylinder = CreateCylinder(6);
+			const std::vector<glm::mat4> instances(3, glm::mat4(1.0f));
+			const MeshInstances source{ &cylinder, instances, { glm::vec4(1.0f) } };
+
+			std::ostringstream output;
+			WritePly({ &source, 1 }, &output);
+			const PlyFile file = Split(output.str());
+
+			EXPECT_THAT(file.header, HasSubstr("format binary_little_endian 1.0\n"));
+			EXPECT_THAT(file.header, HasSubstr("element vertex 36\n"));
+			EXPECT_THAT(file.header, HasSubstr("element face 36\n"));
+			EXPECT_THAT(file.body, SizeIs(36 * kVertexSize + 36 * kFaceSize));
+		}
+
+		TEST(PlyWriterTest, WritesTransformedVerticesAndOffsetFaces)
+		{
+			MeshData triangle;
+			triangle.vertices = {
+				{ glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 0.0f) },
+				{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 0.0f) },
+				{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 1.0f) },
+			};
+			triangle.indices = { 0, 1, 2 };
+			const std::vector<glm::mat4> instances = {
+				glm::mat4(1.0f),
+				glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f)),
+			};
+			const MeshInstances source{ &triangle, instances, { glm::vec4(1.0f, 0.0f, 0.5f, 1.0f) } };
+
+			std::ostringstream output;
+			WritePly({ &source, 1 }, &output);
+			const std::string body = Split(output.str()).body;
+			ASSERT_THAT(body, SizeIs(6 * kVertexSize + 2 * kFaceSize));
+
+			// The second instance's second vertex.
+			const std::size_t vertex = 4 * kVertexSize;
+			EXPECT_EQ(Read<float>(body, vertex), 1.0f);
+			EXPECT_EQ(Read<float>(body, vertex + 4), 0.0f);
+			EXPECT_EQ(Read<float>(body, vertex + 8), 5.0f);
+			EXPECT_EQ(Read<float>(body, vertex + 20), 1.0f);
+			EXPECT_EQ(Read<float>(body, vertex + 24), 1.0f);
+			EXPECT_EQ(Read<std::uint8_t>(body, vertex + 32), 255);
+			EXPECT_EQ(Read<std::uint8_t>(body, vertex + 33), 0);
+			EXPECT_EQ(Read<std::uint8_t>(body, vertex + 34), 128);
+			EXPECT_EQ(Read<std::uint8_t>(body, vertex + 35), 255);
+
+			const std::size_t face = 6 * kVertexSize + kFaceSize;
+			EXPECT_EQ(Read<std::uint8_t>(body, face), 3);
+			EXPECT_THAT(
+				(std::vector<std::uint32_t>{
+					Read<std::uint32_t>(body, face + 1),
+					Read<std::uint32_t>(body, face + 5),
+					Read<std::uint32_t>(body, face + 9) }),
+				ElementsAre(3, 4, 5));
+		}
+
+		TEST(PlyWriterTest, WritesEmptySources)
+		{
+			std::ostringstream output;
+			WritePly({}, &output);
+			const PlyFile file = Split(output.str());
+
+			EXPECT_THAT(file.header, HasSubstr("element vertex 0\n"));
+			EXPECT_THAT(file.header, HasSubstr("element face 0\n"));
+			EXPECT_TRUE(file.body.empty());
+		}
+	}
+}
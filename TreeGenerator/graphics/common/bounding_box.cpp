@@ -0,0 +1,107 @@
+#include "bounding_box.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace tree_generator
+{
+	void BoundingBox::Add(glm::vec3 point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void BoundingBox::Add(const BoundingBox& box)
+	{
+		min = glm::min(min, box.min);
+		max = glm::max(max, box.max);
+	}
+
+	bool BoundingBox::Contains(const BoundingBox& box) const
+	{
+		return box.IsEmpty() || (
+			min.x <= box.min.x && min.y <= box.min.y && min.z <= box.min.z &&
+			max.x >= box.max.x && max.y >= box.max.y && max.z >= box.max.z);
+	}
+
+	bool BoundingBox::Overlaps(const BoundingBox& box) const
+	{
+		return min.x <= box.max.x && min.y <= box.max.y && min.z <= box.max.z &&
+			max.x >= box.min.x && max.y >= box.min.y && max.z >= box.min.z;
+	}
+
+	BoundingBox ComputeBounds(const MeshData& mesh)
+	{
+		BoundingBox bounds;
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			bounds.Add(vertex.position);
+		}
+		return bounds;
+	}
+
+	BoundingBox TransformBounds(const BoundingBox& box, const glm::mat4& model)
+	{
+		if (box.IsEmpty())
+		{
+			return box;
+		}
+
+		// The extent along each axis is the sum of the absolute projections
+		// of the box's half-axes onto it.
+		const glm::vec3 center = glm::vec3(model * glm::vec4(box.Center(), 1.0f));
+		const glm::vec3 extent = box.Extent();
+		const glm::vec3 transformedExtent =
+			glm::abs(glm::vec3(model[0])) * extent.x +
+			glm::abs(glm::vec3(model[1])) * extent.y +
+			glm::abs(glm::vec3(model[2])) * extent.z;
+		return { center - transformedExtent, center + transformedExtent };
+	}
+
+	void InstanceBounds::Resize(std::size_t size)
+	{
+		constexpr float kEmptyMin = std::numeric_limits<float>::max();
+		constexpr float kEmptyMax = std::numeric_limits<float>::lowest();
+		minX_.resize(size, kEmptyMin);
+		minY_.resize(size, kEmptyMin);
+		minZ_.resize(size, kEmptyMin);
+		maxX_.resize(size, kEmptyMax);
+		maxY_.resize(size, kEmptyMax);
+		maxZ_.resize(size, kEmptyMax);
+	}
+
+	BoundingBox InstanceBounds::Get(std::size_t index) const
+	{
+		return {
+			glm::vec3(minX_[index], minY_[index], minZ_[index]),
+			glm::vec3(maxX_[index], maxY_[index], maxZ_[index]) };
+	}
+
+	void InstanceBounds::Set(std::size_t index, const BoundingBox& box)
+	{
+		minX_[index] = box.min.x;
+		minY_[index] = box.min.y;
+		minZ_[index] = box.min.z;
+		maxX_[index] = box.max.x;
+		maxY_[index] = box.max.y;
+		maxZ_[index] = box.max.z;
+	}
+
+	BoundingBox InstanceBounds::GetTotalBounds() const
+	{
+		if (Size() == 0)
+		{
+			return {};
+		}
+
+		return {
+			glm::vec3(
+				*std::min_element(minX_.begin(), minX_.end()),
+				*std::min_element(minY_.begin(), minY_.end()),
+				*std::min_element(minZ_.begin(), minZ_.end())),
+			glm::vec3(
+				*std::max_element(maxX_.begin(), maxX_.end()),
+				*std::max_element(maxY_.begin(), maxY_.end()),
+				*std::max_element(maxZ_.begin(), maxZ_.end())) };
+	}
+}
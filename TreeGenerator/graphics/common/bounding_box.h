@@ -0,0 +1,73 @@
+#ifndef TREE_GENERATOR_BOUNDING_BOX_H_
+#define TREE_GENERATOR_BOUNDING_BOX_H_
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	// Axis-aligned bounding box. A default constructed box is empty, and
+	// becomes the bounds of whatever is added to it.
+	struct BoundingBox
+	{
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+		bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+		glm::vec3 Center() const { return 0.5f * (min + max); }
+		glm::vec3 Extent() const { return 0.5f * (max - min); }
+
+		void Add(glm::vec3 point);
+		void Add(const BoundingBox& box);
+
+		bool Contains(const BoundingBox& box) const;
+		bool Overlaps(const BoundingBox& box) const;
+	};
+
+	BoundingBox ComputeBounds(const MeshData& mesh);
+
+	// Returns the smallest axis-aligned box containing the transformed box.
+	BoundingBox TransformBounds(const BoundingBox& box, const glm::mat4& model);
+
+	// Bounding boxes of many instances, stored as one array per component so
+	// that they can be tested against planes several at a time.
+	class InstanceBounds
+	{
+	public:
+		// Existing boxes are preserved up to the new size. Boxes beyond the
+		// old size are empty.
+		void Resize(std::size_t size);
+		void Clear() { Resize(0); }
+
+		std::size_t Size() const { return minX_.size(); }
+
+		BoundingBox Get(std::size_t index) const;
+		void Set(std::size_t index, const BoundingBox& box);
+
+		// Bounds of all of the instances.
+		BoundingBox GetTotalBounds() const;
+
+		const float* MinX() const { return minX_.data(); }
+		const float* MinY() const { return minY_.data(); }
+		const float* MinZ() const { return minZ_.data(); }
+		const float* MaxX() const { return maxX_.data(); }
+		const float* MaxY() const { return maxY_.data(); }
+		const float* MaxZ() const { return maxZ_.data(); }
+
+	private:
+		std::vector<float> minX_;
+		std::vector<float> minY_;
+		std::vector<float> minZ_;
+		std::vector<float> maxX_;
+		std::vector<float> maxY_;
+		std::vector<float> maxZ_;
+	};
+}
+
+#endif  // !TREE_GENERATOR_BOUNDING_BOX_H_
@@ -0,0 +1,190 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <utility>
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr int kMortonBitsPerAxis = 10;
+		constexpr int kRadixBits = 11;
+		constexpr std::uint32_t kRadixMask = (1u << kRadixBits) - 1;
+
+		// Spreads the lower 10 bits of the value out to every third bit.
+		std::uint32_t SpreadBits(std::uint32_t value)
+		{
+			value = (value * 0x00010001u) & 0xFF0000FFu;
+			value = (value * 0x00000101u) & 0x0F00F00Fu;
+			value = (value * 0x00000011u) & 0xC30C30C3u;
+			value = (value * 0x00000005u) & 0x49249249u;
+			return value;
+		}
+
+		std::uint32_t GetMortonCode(glm::vec3 normalized)
+		{
+			constexpr float kScale = static_cast<float>((1 << kMortonBitsPerAxis) - 1);
+			const glm::vec3 scaled = glm::clamp(normalized * kScale, glm::vec3(0.0f), glm::vec3(kScale));
+			return (SpreadBits(static_cast<std::uint32_t>(scaled.x)) << 2) |
+				(SpreadBits(static_cast<std::uint32_t>(scaled.y)) << 1) |
+				SpreadBits(static_cast<std::uint32_t>(scaled.z));
+		}
+
+		// Stable least significant digit radix sort of the items by their
+		// codes, which are sorted along with them.
+		void SortByCode(std::vector<std::uint32_t>* codes, std::vector<std::uint32_t>* items)
+		{
+			std::vector<std::uint32_t> sortedCodes(codes->size());
+			std::vector<std::uint32_t> sortedItems(items->size());
+			for (int shift = 0; shift < 3 * kMortonBitsPerAxis; shift += kRadixBits)
+			{
+				std::array<std::uint32_t, kRadixMask + 1> offsets{};
+				for (std::uint32_t code : *codes)
+				{
+					++offsets[(code >> shift) & kRadixMask];
+				}
+				std::uint32_t offset = 0;
+				for (std::uint32_t& count : offsets)
+				{
+					offset += std::exchange(count, offset);
+				}
+				for (std::size_t i = 0; i < codes->size(); ++i)
+				{
+					std::uint32_t& destination = offsets[((*codes)[i] >> shift) & kRadixMask];
+					sortedCodes[destination] = (*codes)[i];
+					sortedItems[destination] = (*items)[i];
+					++destination;
+				}
+				codes->swap(sortedCodes);
+				items->swap(sortedItems);
+			}
+		}
+	}
+
+	Bvh::Bvh(const InstanceBounds& bounds)
+	{
+		const std::uint32_t count = static_cast<std::uint32_t>(bounds.Size());
+		if (count == 0)
+		{
+			return;
+		}
+
+		BoundingBox centers;
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			centers.Add(bounds.Get(i).Center());
+		}
+		const glm::vec3 size = centers.max - centers.min;
+		const glm::vec3 scale(
+			size.x > 0.0f ? 1.0f / size.x : 0.0f,
+			size.y > 0.0f ? 1.0f / size.y : 0.0f,
+			size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+		mortonCodes_.resize(count);
+		items_.resize(count);
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			mortonCodes_[i] = GetMortonCode((bounds.Get(i).Center() - centers.min) * scale);
+			items_[i] = i;
+		}
+		SortByCode(&mortonCodes_, &items_);
+
+		// A binary tree with leaves of at least one item has fewer than
+		// twice as many nodes as items.
+		nodes_.reserve(2 * static_cast<std::size_t>(count) - 1);
+		itemBounds_.Resize(count);
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			itemBounds_.Set(i, bounds.Get(items_[i]));
+		}
+		Build(0, count);
+
+		mortonCodes_.clear();
+		mortonCodes_.shrink_to_fit();
+	}
+
+	BoundingBox Bvh::GetBounds() const
+	{
+		return nodes_.empty() ? BoundingBox() : nodes_[0].bounds;
+	}
+
+	void Bvh::FindOverlapping(const BoundingBox& box, std::vector<std::uint32_t>* result) const
+	{
+		if (nodes_.empty())
+		{
+			return;
+		}
+
+		std::vector<std::uint32_t> stack{ 0 };
+		while (!stack.empty())
+		{
+			const BvhNode& node = nodes_[stack.back()];
+			const std::uint32_t index = stack.back();
+			stack.pop_back();
+			if (!node.bounds.Overlaps(box))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				// Leaf bounds are only a union, so each item is tested too.
+				for (std::uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i)
+				{
+					if (itemBounds_.Get(i).Overlaps(box))
+					{
+						result->push_back(items_[i]);
+					}
+				}
+				continue;
+			}
+			stack.push_back(node.GetRightChild());
+			stack.push_back(index + 1);
+		}
+	}
+
+	std::uint32_t Bvh::Build(std::uint32_t first, std::uint32_t last)
+	{
+		const std::uint32_t index = static_cast<std::uint32_t>(nodes_.size());
+		nodes_.push_back({});
+
+		if (last - first <= kMaxLeafSize)
+		{
+			BoundingBox leafBounds;
+			for (std::uint32_t i = first; i < last; ++i)
+			{
+				leafBounds.Add(itemBounds_.Get(i));
+			}
+			nodes_[index] = { leafBounds, first, last - first };
+			return index;
+		}
+
+		// Split after the last item that shares the first item's prefix up
+		// to the highest differing bit. Items with equal codes are split in
+		// the middle.
+		std::uint32_t split = first + (last - first) / 2;
+		const std::uint32_t firstCode = mortonCodes_[first];
+		const std::uint32_t lastCode = mortonCodes_[last - 1];
+		if (firstCode != lastCode)
+		{
+			const int prefixLength = std::countl_zero(firstCode ^ lastCode);
+			auto sharesPrefix = [&](std::uint32_t code) {
+				return std::countl_zero(firstCode ^ code) > prefixLength;
+			};
+			split = static_cast<std::uint32_t>(std::partition_point(
+				mortonCodes_.begin() + first,
+				mortonCodes_.begin() + last,
+				sharesPrefix) - mortonCodes_.begin());
+		}
+
+		Build(first, split);
+		const std::uint32_t right = Build(split, last);
+
+		BoundingBox innerBounds = nodes_[index + 1].bounds;
+		innerBounds.Add(nodes_[right].bounds);
+		nodes_[index] = { innerBounds, right, 0 };
+		return index;
+	}
+}
@@ -0,0 +1,66 @@
+#ifndef TREE_GENERATOR_BVH_H_
+#define TREE_GENERATOR_BVH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bounding_box.h"
+
+namespace tree_generator
+{
+	struct BvhNode
+	{
+		BoundingBox bounds;
+
+		// Leaves refer to itemCount items starting at firstItem in
+		// Bvh::GetItems(). Inner nodes have an itemCount of 0; their left
+		// child directly follows them, and firstItem is their right child.
+		std::uint32_t firstItem;
+		std::uint32_t itemCount;
+
+		bool IsLeaf() const { return itemCount > 0; }
+		std::uint32_t GetRightChild() const { return firstItem; }
+	};
+
+	// Bounding volume hierarchy over instance bounds, built as a linear BVH:
+	// the instances are sorted along a Morton curve through their centers,
+	// and each node is split where the Morton codes first differ. Building
+	// takes linear time, at the cost of a somewhat looser tree than a
+	// surface area heuristic would give.
+	class Bvh
+	{
+	public:
+		static constexpr std::uint32_t kMaxLeafSize = 4;
+
+		Bvh() = default;
+		explicit Bvh(const InstanceBounds& bounds);
+
+		// Nodes in depth-first order. The root is the first node, unless the
+		// hierarchy is empty.
+		const std::vector<BvhNode>& GetNodes() const { return nodes_; }
+
+		// Instance indices in the order the leaves refer to them, and the
+		// bounds of each of those instances.
+		const std::vector<std::uint32_t>& GetItems() const { return items_; }
+		const InstanceBounds& GetItemBounds() const { return itemBounds_; }
+
+		// Bounds of all of the instances.
+		BoundingBox GetBounds() const;
+
+		// Appends the index of every instance whose bounds overlap the box.
+		void FindOverlapping(const BoundingBox& box, std::vector<std::uint32_t>* result) const;
+
+	private:
+		std::vector<BvhNode> nodes_;
+		std::vector<std::uint32_t> items_;
+		InstanceBounds itemBounds_;
+		std::vector<std::uint32_t> mortonCodes_;
+
+		// Builds the node for the sorted items in [first, last), and returns
+		// its index.
+		std::uint32_t Build(std::uint32_t first, std::uint32_t last);
+	};
+}
+
+#endif  // !TREE_GENERATOR_BVH_H_
@@ -0,0 +1,64 @@
+#include "bvh.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		InstanceBounds CreateRandomBounds(std::size_t count)
+		{
+			std::mt19937 random(42);
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+			std::uniform_real_distribution<float> size(0.0f, 1.0f);
+
+			InstanceBounds bounds;
+			bounds.Resize(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const glm::vec3 min(position(random), position(random), position(random));
+				bounds.Set(i, { min, min + glm::vec3(size(random), size(random), size(random)) });
+			}
+			return bounds;
+		}
+
+		void BM_BuildBvh(benchmark::State& state)
+		{
+			const InstanceBounds bounds = CreateRandomBounds(state.range(0));
+
+			for (auto _ : state)
+			{
+				Bvh bvh(bounds);
+				benchmark::DoNotOptimize(bvh.GetNodes().data());
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		void BM_FindOverlapping(benchmark::State& state)
+		{
+			const InstanceBounds bounds = CreateRandomBounds(state.range(0));
+			const Bvh bvh(bounds);
+			const BoundingBox box{ glm::vec3(-10.0f), glm::vec3(10.0f) };
+			std::vector<std::uint32_t> result;
+
+			for (auto _ : state)
+			{
+				result.clear();
+				bvh.FindOverlapping(box, &result);
+				benchmark::DoNotOptimize(result.data());
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		BENCHMARK(BM_BuildBvh)->Arg(1 << 10)->Arg(1000000)->Unit(benchmark::kMillisecond);
+		BENCHMARK(BM_FindOverlapping)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+	}
+}
@@ -0,0 +1,188 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+#include "transform.h"
+
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::UnorderedElementsAreArray;
+
+namespace tree_generator
+{
+	namespace
+	{
+		InstanceBounds CreateRandomBounds(std::size_t count)
+		{
+			std::mt19937 random(42);
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+			std::uniform_real_distribution<float> size(0.0f, 5.0f);
+
+			InstanceBounds bounds;
+			bounds.Resize(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const glm::vec3 min(position(random), position(random), position(random));
+				bounds.Set(i, { min, min + glm::vec3(size(random), size(random), size(random)) });
+			}
+			return bounds;
+		}
+
+		// Checks that every node contains its children and items, and
+		// returns the items below the node.
+		std::vector<std::uint32_t> CollectItems(const Bvh& bvh, std::uint32_t index)
+		{
+			const BvhNode& node = bvh.GetNodes()[index];
+			std::vector<std::uint32_t> items;
+			if (node.IsLeaf())
+			{
+				EXPECT_LE(node.itemCount, Bvh::kMaxLeafSize);
+				for (std::uint32_t i = node.firstItem; i < node.firstItem + node.itemCount; ++i)
+				{
+					EXPECT_TRUE(node.bounds.Contains(bvh.GetItemBounds().Get(i)));
+					items.push_back(bvh.GetItems()[i]);
+				}
+				return items;
+			}
+
+			for (std::uint32_t child : { index + 1, node.GetRightChild() })
+			{
+				EXPECT_TRUE(node.bounds.Contains(bvh.GetNodes()[child].bounds));
+				std::vector<std::uint32_t> childItems = CollectItems(bvh, child);
+				items.insert(items.end(), childItems.begin(), childItems.end());
+			}
+			return items;
+		}
+
+		std::vector<std::uint32_t> CreateIndices(std::size_t count)
+		{
+			std::vector<std::uint32_t> indices(count);
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				indices[i] = i;
+			}
+			return indices;
+		}
+
+		TEST(BoundingBoxTest, DefaultBoxIsEmpty)
+		{
+			BoundingBox box;
+			EXPECT_TRUE(box.IsEmpty());
+
+			box.Add(glm::vec3(1.0f, 2.0f, 3.0f));
+			EXPECT_FALSE(box.IsEmpty());
+			EXPECT_EQ(box.min, glm::vec3(1.0f, 2.0f, 3.0f));
+			EXPECT_EQ(box.max, glm::vec3(1.0f, 2.0f, 3.0f));
+		}
+
+		TEST(BoundingBoxTest, TransformBoundsContainsTransformedCorners)
+		{
+			const BoundingBox box{ glm::vec3(-1.0f, 0.0f, -0.5f), glm::vec3(1.0f, 2.0f, 0.5f) };
+			const glm::mat4 model = ToMatrix({ glm::vec3(3.0f, -2.0f, 1.0f), glm::vec3(30.0f, 45.0f, 60.0f), 2.0f });
+
+			const BoundingBox transformed = TransformBounds(box, model);
+
+			BoundingBox expected;
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				const glm::vec3 point(
+					corner & 1 ? box.max.x : box.min.x,
+					corner & 2 ? box.max.y : box.min.y,
+					corner & 4 ? box.max.z : box.min.z);
+				expected.Add(glm::vec3(model * glm::vec4(point, 1.0f)));
+			}
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				EXPECT_NEAR(transformed.min[axis], expected.min[axis], 1e-4f);
+				EXPECT_NEAR(transformed.max[axis], expected.max[axis], 1e-4f);
+			}
+		}
+
+		TEST(BoundingBoxTest, TransformBoundsKeepsEmptyBoxEmpty)
+		{
+			EXPECT_TRUE(TransformBounds(BoundingBox(), glm::mat4(2.0f)).IsEmpty());
+		}
+
+		TEST(BoundingBoxTest, InstanceBoundsTotalBoundsContainsAll)
+		{
+			InstanceBounds bounds = CreateRandomBounds(100);
+
+			const BoundingBox total = bounds.GetTotalBounds();
+
+			for (std::size_t i = 0; i < bounds.Size(); ++i)
+			{
+				EXPECT_TRUE(total.Contains(bounds.Get(i)));
+			}
+			EXPECT_TRUE(InstanceBounds().GetTotalBounds().IsEmpty());
+		}
+
+		TEST(BvhTest, NoInstancesBuildsEmptyHierarchy)
+		{
+			Bvh bvh{ InstanceBounds() };
+
+			EXPECT_THAT(bvh.GetNodes(), IsEmpty());
+			EXPECT_TRUE(bvh.GetBounds().IsEmpty());
+
+			std::vector<std::uint32_t> result;
+			bvh.FindOverlapping({ glm::vec3(-1.0f), glm::vec3(1.0f) }, &result);
+			EXPECT_THAT(result, IsEmpty());
+		}
+
+		TEST(BvhTest, NodesContainEveryInstanceOnce)
+		{
+			InstanceBounds bounds = CreateRandomBounds(1000);
+
+			Bvh bvh(bounds);
+
+			EXPECT_THAT(CollectItems(bvh, 0), UnorderedElementsAreArray(CreateIndices(1000)));
+			EXPECT_LT(bvh.GetNodes().size(), 2 * bounds.Size());
+			EXPECT_EQ(bvh.GetBounds().min, bounds.GetTotalBounds().min);
+			EXPECT_EQ(bvh.GetBounds().max, bounds.GetTotalBounds().max);
+		}
+
+		TEST(BvhTest, InstancesWithEqualCentersAreSplit)
+		{
+			InstanceBounds bounds;
+			bounds.Resize(100);
+			for (std::size_t i = 0; i < bounds.Size(); ++i)
+			{
+				const float size = static_cast<float>(i);
+				bounds.Set(i, { glm::vec3(-size), glm::vec3(size) });
+			}
+
+			Bvh bvh(bounds);
+
+			EXPECT_THAT(CollectItems(bvh, 0), UnorderedElementsAreArray(CreateIndices(100)));
+		}
+
+		TEST(BvhTest, FindOverlappingMatchesTestingEveryInstance)
+		{
+			InstanceBounds bounds = CreateRandomBounds(1000);
+			Bvh bvh(bounds);
+			const BoundingBox box{ glm::vec3(-20.0f, -50.0f, 0.0f), glm::vec3(10.0f, 0.0f, 30.0f) };
+
+			std::vector<std::uint32_t> expected;
+			for (std::uint32_t i = 0; i < bounds.Size(); ++i)
+			{
+				if (bounds.Get(i).Overlaps(box))
+				{
+					expected.push_back(i);
+				}
+			}
+			std::vector<std::uint32_t> actual;
+			bvh.FindOverlapping(box, &actual);
+
+			EXPECT_THAT(expected, Not(IsEmpty()));
+			EXPECT_THAT(actual, UnorderedElementsAreArray(expected));
+		}
+	}
+}
@@ -3,6 +3,8 @@
 
 #include <glm/glm.hpp>
 
+#include "frustum.h"
+
 namespace tree_generator
 {
 	class Camera
@@ -22,6 +24,12 @@ namespace tree_generator
 		};
 		virtual void SetViewport(Viewport viewport) = 0;
 
+		// Maps world space to clip space.
+		virtual glm::mat4 GetViewProjection() const = 0;
+
+		// Planes bounding what the camera currently sees, in world space.
+		virtual Frustum GetFrustum() const = 0;
+
 		virtual void Bind() = 0;
 
 	protected:
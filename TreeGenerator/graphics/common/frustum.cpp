@@ -0,0 +1,75 @@
+#include "frustum.h"
+
+namespace tree_generator
+{
+	Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+	{
+		// See Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes
+		// from the World-View-Projection Matrix".
+		auto Row = [&viewProjection](int row) {
+			return glm::vec4(
+				viewProjection[0][row],
+				viewProjection[1][row],
+				viewProjection[2][row],
+				viewProjection[3][row]);
+			};
+
+		Frustum frustum;
+		frustum.planes = {
+			Row(3) + Row(0),
+			Row(3) - Row(0),
+			Row(3) + Row(1),
+			Row(3) - Row(1),
+			Row(3) + Row(2),
+			Row(3) - Row(2) };
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	Containment Frustum::Classify(const BoundingBox& box, std::uint32_t* planeMask) const
+	{
+		Containment containment = Containment::Inside;
+		for (int i = 0; i < kPlaneCount; ++i)
+		{
+			const std::uint32_t planeBit = 1u << i;
+			if ((*planeMask & planeBit) == 0)
+			{
+				continue;
+			}
+
+			// The corners furthest along and against the normal.
+			const glm::vec3 normal = glm::vec3(planes[i]);
+			const glm::vec3 positive(
+				normal.x >= 0.0f ? box.max.x : box.min.x,
+				normal.y >= 0.0f ? box.max.y : box.min.y,
+				normal.z >= 0.0f ? box.max.z : box.min.z);
+			const glm::vec3 negative(
+				normal.x >= 0.0f ? box.min.x : box.max.x,
+				normal.y >= 0.0f ? box.min.y : box.max.y,
+				normal.z >= 0.0f ? box.min.z : box.max.z);
+
+			if (glm::dot(normal, positive) + planes[i].w < 0.0f)
+			{
+				return Containment::Outside;
+			}
+			if (glm::dot(normal, negative) + planes[i].w < 0.0f)
+			{
+				containment = Containment::Intersecting;
+			}
+			else
+			{
+				*planeMask &= ~planeBit;
+			}
+		}
+		return containment;
+	}
+
+	Containment Frustum::Classify(const BoundingBox& box) const
+	{
+		std::uint32_t planeMask = kAllPlanes;
+		return Classify(box, &planeMask);
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef TREE_GENERATOR_FRUSTUM_H_
+#define TREE_GENERATOR_FRUSTUM_H_
+
+#include <array>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+
+namespace tree_generator
+{
+	enum class Containment
+	{
+		Outside,
+		Intersecting,
+		Inside
+	};
+
+	// The six planes bounding what a camera can see. Each plane is stored as
+	// (normal, distance), with the normal of unit length and pointing into
+	// the frustum, so a point p is on the inner side when
+	// dot(normal, p) + distance >= 0.
+	struct Frustum
+	{
+		static constexpr int kPlaneCount = 6;
+		static constexpr std::uint32_t kAllPlanes = (1u << kPlaneCount) - 1;
+
+		std::array<glm::vec4, kPlaneCount> planes;
+
+		// Extracts the planes from a projection * view matrix that maps to
+		// OpenGL's clip space.
+		static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+		// Classifies the box against the planes whose bits are set in
+		// planeMask. On return, the mask only keeps the planes the box
+		// intersects, so the planes it is inside of can be skipped for
+		// anything it contains.
+		Containment Classify(const BoundingBox& box, std::uint32_t* planeMask) const;
+		Containment Classify(const BoundingBox& box) const;
+	};
+}
+
+#endif  // !TREE_GENERATOR_FRUSTUM_H_
@@ -0,0 +1,258 @@
+#include "frustum_culler.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+#if defined(__AVX2__)
+#define TREE_GENERATOR_FRUSTUM_CULLER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TREE_GENERATOR_FRUSTUM_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace tree_generator
+{
+	namespace
+	{
+#if defined(TREE_GENERATOR_FRUSTUM_CULLER_AVX2)
+		constexpr const char* kInstructionSet = "AVX2";
+#elif defined(TREE_GENERATOR_FRUSTUM_CULLER_SSE2)
+		constexpr const char* kInstructionSet = "SSE2";
+#else
+		constexpr const char* kInstructionSet = "Scalar";
+#endif
+
+		// A plane and, for each axis, the bounds array holding the corner
+		// furthest along its normal.
+		struct PlaneTest
+		{
+			glm::vec4 plane;
+			const float* x;
+			const float* y;
+			const float* z;
+		};
+
+		// Sets up the tests for the planes whose bits are set in planeMask,
+		// and returns the number of tests.
+		int GetPlaneTests(
+			const Frustum& frustum,
+			std::uint32_t planeMask,
+			const InstanceBounds& bounds,
+			PlaneTest* tests)
+		{
+			int testCount = 0;
+			for (int i = 0; i < Frustum::kPlaneCount; ++i)
+			{
+				if ((planeMask & (1u << i)) == 0)
+				{
+					continue;
+				}
+
+				const glm::vec4& plane = frustum.planes[i];
+				tests[testCount++] = {
+					plane,
+					plane.x >= 0.0f ? bounds.MaxX() : bounds.MinX(),
+					plane.y >= 0.0f ? bounds.MaxY() : bounds.MinY(),
+					plane.z >= 0.0f ? bounds.MaxZ() : bounds.MinZ() };
+			}
+			return testCount;
+		}
+
+		bool IsVisible(const PlaneTest* tests, int testCount, std::size_t i)
+		{
+			for (int j = 0; j < testCount; ++j)
+			{
+				const PlaneTest& test = tests[j];
+				if (!(test.plane.x * test.x[i] +
+					test.plane.y * test.y[i] +
+					test.plane.z * test.z[i] +
+					test.plane.w >= 0.0f))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Tests the instances in [first, last) and appends the visible ones
+		// to `visible`, mapped through `items` if it isn't null.
+		void AppendVisible(
+			const PlaneTest* tests,
+			int testCount,
+			std::size_t first,
+			std::size_t last,
+			const std::uint32_t* items,
+			std::vector<std::uint32_t>* visible)
+		{
+			auto Append = [items, visible](std::size_t i) {
+				visible->push_back(items == nullptr ? static_cast<std::uint32_t>(i) : items[i]);
+				};
+
+			std::size_t i = first;
+#if defined(TREE_GENERATOR_FRUSTUM_CULLER_AVX2)
+			for (; i + 8 <= last; i += 8)
+			{
+				__m256 isInside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (int j = 0; j < testCount; ++j)
+				{
+					const PlaneTest& test = tests[j];
+					__m256 distance = _mm256_add_ps(
+						_mm256_add_ps(
+							_mm256_mul_ps(_mm256_set1_ps(test.plane.x), _mm256_loadu_ps(test.x + i)),
+							_mm256_mul_ps(_mm256_set1_ps(test.plane.y), _mm256_loadu_ps(test.y + i))),
+						_mm256_add_ps(
+							_mm256_mul_ps(_mm256_set1_ps(test.plane.z), _mm256_loadu_ps(test.z + i)),
+							_mm256_set1_ps(test.plane.w)));
+					isInside = _mm256_and_ps(
+						isInside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+				}
+				for (unsigned int mask = _mm256_movemask_ps(isInside); mask != 0; mask &= mask - 1)
+				{
+					Append(i + std::countr_zero(mask));
+				}
+			}
+#elif defined(TREE_GENERATOR_FRUSTUM_CULLER_SSE2)
+			for (; i + 4 <= last; i += 4)
+			{
+				__m128 isInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int j = 0; j < testCount; ++j)
+				{
+					const PlaneTest& test = tests[j];
+					__m128 distance = _mm_add_ps(
+						_mm_add_ps(
+							_mm_mul_ps(_mm_set1_ps(test.plane.x), _mm_loadu_ps(test.x + i)),
+							_mm_mul_ps(_mm_set1_ps(test.plane.y), _mm_loadu_ps(test.y + i))),
+						_mm_add_ps(
+							_mm_mul_ps(_mm_set1_ps(test.plane.z), _mm_loadu_ps(test.z + i)),
+							_mm_set1_ps(test.plane.w)));
+					isInside = _mm_and_ps(isInside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+				}
+				for (unsigned int mask = _mm_movemask_ps(isInside); mask != 0; mask &= mask - 1)
+				{
+					Append(i + std::countr_zero(mask));
+				}
+			}
+#endif
+			for (; i < last; ++i)
+			{
+				if (IsVisible(tests, testCount, i))
+				{
+					Append(i);
+				}
+			}
+		}
+
+		// Returns the range of items below the node. Subtrees are stored
+		// depth-first, so their items are contiguous, from the leftmost leaf
+		// to the rightmost.
+		std::pair<std::uint32_t, std::uint32_t> GetItemRange(
+			const std::vector<BvhNode>& nodes, std::uint32_t index)
+		{
+			std::uint32_t first = index;
+			while (!nodes[first].IsLeaf())
+			{
+				++first;
+			}
+			std::uint32_t last = index;
+			while (!nodes[last].IsLeaf())
+			{
+				last = nodes[last].GetRightChild();
+			}
+			return { nodes[first].firstItem, nodes[last].firstItem + nodes[last].itemCount };
+		}
+	}
+
+	void CullInstances(
+		const Frustum& frustum,
+		const InstanceBounds& bounds,
+		std::vector<std::uint32_t>* visible)
+	{
+		PlaneTest tests[Frustum::kPlaneCount];
+		const int testCount = GetPlaneTests(frustum, Frustum::kAllPlanes, bounds, tests);
+		AppendVisible(tests, testCount, 0, bounds.Size(), nullptr, visible);
+	}
+
+	void CullInstances(
+		const Frustum& frustum,
+		const Bvh& bvh,
+		std::vector<std::uint32_t>* visible)
+	{
+		const std::vector<BvhNode>& nodes = bvh.GetNodes();
+		if (nodes.empty())
+		{
+			return;
+		}
+
+		const std::size_t firstVisible = visible->size();
+		struct Entry
+		{
+			std::uint32_t node;
+			std::uint32_t planeMask;
+		};
+		std::vector<Entry> stack{ { 0, Frustum::kAllPlanes } };
+		while (!stack.empty())
+		{
+			auto [index, planeMask] = stack.back();
+			stack.pop_back();
+
+			const BvhNode& node = nodes[index];
+			switch (frustum.Classify(node.bounds, &planeMask))
+			{
+			case Containment::Outside:
+				continue;
+			case Containment::Inside:
+			{
+				auto [first, last] = GetItemRange(nodes, index);
+				visible->insert(
+					visible->end(),
+					bvh.GetItems().begin() + first,
+					bvh.GetItems().begin() + last);
+				continue;
+			}
+			case Containment::Intersecting:
+				break;
+			}
+
+			if (node.IsLeaf())
+			{
+				PlaneTest tests[Frustum::kPlaneCount];
+				const int testCount = GetPlaneTests(frustum, planeMask, bvh.GetItemBounds(), tests);
+				AppendVisible(
+					tests,
+					testCount,
+					node.firstItem,
+					node.firstItem + node.itemCount,
+					bvh.GetItems().data(),
+					visible);
+				continue;
+			}
+			stack.push_back({ node.GetRightChild(), planeMask });
+			stack.push_back({ index + 1, planeMask });
+		}
+
+		std::sort(visible->begin() + firstVisible, visible->end());
+	}
+
+	std::size_t GatherVisibleInstances(
+		std::span<const glm::mat4> instances,
+		std::size_t firstInstance,
+		std::span<const std::uint32_t> visible,
+		glm::mat4* output)
+	{
+		auto first = std::lower_bound(visible.begin(), visible.end(), firstInstance);
+		auto last = std::lower_bound(first, visible.end(), firstInstance + instances.size());
+		glm::mat4* next = output;
+		for (auto i = first; i != last; ++i)
+		{
+			*next++ = instances[*i - firstInstance];
+		}
+		return next - output;
+	}
+
+	const char* GetFrustumCullerInstructionSet()
+	{
+		return kInstructionSet;
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef TREE_GENERATOR_FRUSTUM_CULLER_H_
+#define TREE_GENERATOR_FRUSTUM_CULLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+#include "bvh.h"
+#include "frustum.h"
+
+namespace tree_generator
+{
+	// Appends the index of every instance whose bounds are at least partly
+	// inside the frustum to `visible`, in increasing order. The bounds are
+	// tested several at a time with SIMD instructions, where available.
+	void CullInstances(
+		const Frustum& frustum,
+		const InstanceBounds& bounds,
+		std::vector<std::uint32_t>* visible);
+
+	// Same as above, but skips the instances below any BVH node outside of
+	// the frustum, and accepts those below any node inside of it without
+	// testing them. The time taken scales with the number of visible
+	// instances rather than the total.
+	void CullInstances(
+		const Frustum& frustum,
+		const Bvh& bvh,
+		std::vector<std::uint32_t>* visible);
+
+	// Copies the matrices of the visible instances out of `instances`, whose
+	// first matrix is instance number firstInstance, to `output`. The
+	// visible indices must be in increasing order, as the culling functions
+	// return them. Returns the number of matrices copied.
+	std::size_t GatherVisibleInstances(
+		std::span<const glm::mat4> instances,
+		std::size_t firstInstance,
+		std::span<const std::uint32_t> visible,
+		glm::mat4* output);
+
+	// Name of the instruction set CullInstances() was compiled for.
+	const char* GetFrustumCullerInstructionSet();
+}
+
+#endif  // !TREE_GENERATOR_FRUSTUM_CULLER_H_
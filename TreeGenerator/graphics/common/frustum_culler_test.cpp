@@ -0,0 +1,144 @@
+#include "frustum_culler.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bounding_box.h"
+#include "bvh.h"
+#include "frustum.h"
+
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+using ::testing::Not;
+
+namespace tree_generator
+{
+	namespace
+	{
+		// Looks down the negative z axis from the origin.
+		Frustum CreateFrustum()
+		{
+			const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+			const glm::mat4 view = glm::lookAt(
+				glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			return Frustum::FromMatrix(projection * view);
+		}
+
+		BoundingBox CreateBox(glm::vec3 center, float size)
+		{
+			return { center - glm::vec3(size), center + glm::vec3(size) };
+		}
+
+		InstanceBounds CreateRandomBounds(std::size_t count)
+		{
+			std::mt19937 random(42);
+			std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+			std::uniform_real_distribution<float> size(0.0f, 5.0f);
+
+			InstanceBounds bounds;
+			bounds.Resize(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				bounds.Set(i, CreateBox(
+					glm::vec3(position(random), position(random), position(random)),
+					size(random)));
+			}
+			return bounds;
+		}
+
+		std::vector<std::uint32_t> CullEachInstance(
+			const Frustum& frustum, const InstanceBounds& bounds)
+		{
+			std::vector<std::uint32_t> visible;
+			for (std::uint32_t i = 0; i < bounds.Size(); ++i)
+			{
+				if (frustum.Classify(bounds.Get(i)) != Containment::Outside)
+				{
+					visible.push_back(i);
+				}
+			}
+			return visible;
+		}
+
+		TEST(FrustumTest, ClassifiesBoxes)
+		{
+			Frustum frustum = CreateFrustum();
+
+			EXPECT_EQ(frustum.Classify(CreateBox(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f)), Containment::Inside);
+			EXPECT_EQ(frustum.Classify(CreateBox(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f)), Containment::Outside);
+			EXPECT_EQ(frustum.Classify(CreateBox(glm::vec3(20.0f, 0.0f, -10.0f), 1.0f)), Containment::Outside);
+			EXPECT_EQ(frustum.Classify(CreateBox(glm::vec3(10.0f, 0.0f, -10.0f), 1.0f)), Containment::Intersecting);
+			EXPECT_EQ(frustum.Classify(CreateBox(glm::vec3(0.0f, 0.0f, -100.0f), 1.0f)), Containment::Intersecting);
+			EXPECT_EQ(frustum.Classify(CreateBox(glm::vec3(0.0f, 0.0f, -200.0f), 1.0f)), Containment::Outside);
+		}
+
+		TEST(FrustumTest, PlaneMaskKeepsIntersectedPlanes)
+		{
+			Frustum frustum = CreateFrustum();
+			std::uint32_t planeMask = Frustum::kAllPlanes;
+
+			frustum.Classify(CreateBox(glm::vec3(10.0f, 0.0f, -10.0f), 1.0f), &planeMask);
+
+			// Only the right plane.
+			EXPECT_EQ(planeMask, 1u << 1);
+		}
+
+		TEST(FrustumCullerTest, CullingMatchesClassifyingEachInstance)
+		{
+			Frustum frustum = CreateFrustum();
+			InstanceBounds bounds = CreateRandomBounds(1001);
+			std::vector<std::uint32_t> expected = CullEachInstance(frustum, bounds);
+
+			std::vector<std::uint32_t> visible;
+			CullInstances(frustum, bounds, &visible);
+
+			EXPECT_THAT(expected, Not(IsEmpty()));
+			EXPECT_THAT(visible, ElementsAreArray(expected));
+		}
+
+		TEST(FrustumCullerTest, BvhCullingMatchesClassifyingEachInstance)
+		{
+			Frustum frustum = CreateFrustum();
+			InstanceBounds bounds = CreateRandomBounds(10000);
+			std::vector<std::uint32_t> expected = CullEachInstance(frustum, bounds);
+
+			std::vector<std::uint32_t> visible;
+			CullInstances(frustum, Bvh(bounds), &visible);
+
+			EXPECT_THAT(visible, ElementsAreArray(expected));
+		}
+
+		TEST(FrustumCullerTest, BvhCullingOfEmptyHierarchyFindsNothing)
+		{
+			std::vector<std::uint32_t> visible;
+			CullInstances(CreateFrustum(), Bvh(), &visible);
+
+			EXPECT_THAT(visible, IsEmpty());
+		}
+
+		TEST(FrustumCullerTest, GatherCopiesVisibleInstancesInRange)
+		{
+			std::vector<glm::mat4> instances;
+			for (int i = 0; i < 4; ++i)
+			{
+				instances.push_back(glm::mat4(static_cast<float>(10 + i)));
+			}
+			const std::vector<std::uint32_t> visible{ 3, 10, 11, 13, 20 };
+			std::vector<glm::mat4> output(instances.size());
+
+			std::size_t count = GatherVisibleInstances(instances, 10, visible, output.data());
+
+			ASSERT_EQ(count, 3);
+			EXPECT_EQ(output[0], glm::mat4(10.0f));
+			EXPECT_EQ(output[1], glm::mat4(11.0f));
+			EXPECT_EQ(output[2], glm::mat4(13.0f));
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#include "impostor.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "octahedral.h"
+
+namespace tree_generator
+{
+	glm::vec3 GetImpostorFrameDirection(int x, int y, int frameCount)
+	{
+		const glm::vec2 cell(
+			(x + 0.5f) / frameCount * 2.0f - 1.0f,
+			(y + 0.5f) / frameCount * 2.0f - 1.0f);
+		return DecodeOctahedral(cell);
+	}
+
+	glm::ivec2 GetImpostorFrame(glm::vec3 direction, int frameCount)
+	{
+		const glm::vec2 cell = (EncodeOctahedral(direction) * 0.5f + 0.5f) * static_cast<float>(frameCount);
+		return glm::ivec2(
+			std::clamp(static_cast<int>(cell.x), 0, frameCount - 1),
+			std::clamp(static_cast<int>(cell.y), 0, frameCount - 1));
+	}
+
+	glm::vec3 GetImpostorUp(glm::vec3 direction)
+	{
+		return glm::abs(direction.y) > 0.999f
+			? glm::vec3(0.0f, 0.0f, 1.0f)
+			: glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+
+	glm::mat4 GetImpostorView(glm::vec3 direction, glm::vec3 center, float radius)
+	{
+		return glm::lookAt(center + direction * radius, center, GetImpostorUp(direction));
+	}
+
+	glm::mat4 GetImpostorProjection(float radius)
+	{
+		return glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+	}
+}
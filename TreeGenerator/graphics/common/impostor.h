@@ -0,0 +1,58 @@
+#ifndef TREE_GENERATOR_IMPOSTOR_H_
+#define TREE_GENERATOR_IMPOSTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace tree_generator
+{
+	// Geometry rendered from many directions into one texture, so that it
+	// can be drawn far away as a single quad.
+	//
+	// The atlas is a grid of frameCount x frameCount frames. Frame (x, y) is
+	// an orthographic view of the geometry's bounding sphere from
+	// GetImpostorFrameDirection(x, y, frameCount), looking at its center.
+	// Frame (0, 0) and the rows of each image start at the bottom left, as
+	// OpenGL reads and samples them.
+	struct ImpostorAtlas
+	{
+		int frameCount = 0;
+		int frameSize = 0;
+
+		// Bounding sphere of the baked geometry, in its own space.
+		glm::vec3 center = glm::vec3(0.0f);
+		float radius = 0.0f;
+
+		// RGBA colors, with an alpha of 0 where nothing was drawn.
+		std::vector<std::uint8_t> color;
+
+		// Depths from 0 at the front of the bounding sphere to 1 at its back,
+		// and 1 where nothing was drawn.
+		std::vector<float> depth;
+
+		// Width and height of the atlas, in pixels.
+		int GetSize() const { return frameCount * frameSize; }
+	};
+
+	// Direction towards the viewer of the frame, at the center of the
+	// frame's cell in the octahedral mapping.
+	glm::vec3 GetImpostorFrameDirection(int x, int y, int frameCount);
+
+	// Returns the frame whose cell of the octahedral mapping contains the
+	// direction towards the viewer.
+	glm::ivec2 GetImpostorFrame(glm::vec3 direction, int frameCount);
+
+	// Vertical axis of the frame seen from the direction: the y axis
+	// projected onto the frame, or the z axis when looking along y.
+	glm::vec3 GetImpostorUp(glm::vec3 direction);
+
+	// Camera of the frame seen from the direction: an orthographic view of
+	// the bounding sphere, with its front at the near plane and its back at
+	// the far plane.
+	glm::mat4 GetImpostorView(glm::vec3 direction, glm::vec3 center, float radius);
+	glm::mat4 GetImpostorProjection(float radius);
+}
+
+#endif  // !TREE_GENERATOR_IMPOSTOR_H_
@@ -0,0 +1,34 @@
+#ifndef TREE_GENERATOR_IMPOSTOR_RENDERER_H_
+#define TREE_GENERATOR_IMPOSTOR_RENDERER_H_
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "impostor.h"
+
+namespace tree_generator
+{
+	// Draws instances of an impostor as quads facing the camera, each
+	// showing the atlas frame nearest to the direction it is seen from.
+	class ImpostorRenderer
+	{
+	public:
+		virtual ~ImpostorRenderer() = default;
+
+		virtual void SetAtlas(const ImpostorAtlas& atlas) = 0;
+
+		// Each instance is where the origin of the baked geometry is placed
+		// (xyz) and a uniform scale (w). Impostors can't be rotated, since
+		// their frames were rendered from directions in the geometry's own
+		// space.
+		virtual void SetInstances(std::span<const glm::vec4> instances) = 0;
+
+		virtual void Render() = 0;
+
+	protected:
+		ImpostorRenderer() {}
+	};
+}
+
+#endif  // !TREE_GENERATOR_IMPOSTOR_RENDERER_H_
@@ -0,0 +1,60 @@
+#include "instance_buffer.h"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace tree_generator
+{
+	InstanceBuffer::~InstanceBuffer()
+	{
+		::operator delete(data_, std::align_val_t(kAlignment));
+	}
+
+	InstanceBuffer::InstanceBuffer(InstanceBuffer&& other) noexcept :
+		data_(std::exchange(other.data_, nullptr)),
+		size_(std::exchange(other.size_, 0)),
+		capacity_(std::exchange(other.capacity_, 0))
+	{
+	}
+
+	InstanceBuffer& InstanceBuffer::operator=(InstanceBuffer&& other) noexcept
+	{
+		if (this != &other)
+		{
+			::operator delete(data_, std::align_val_t(kAlignment));
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+			capacity_ = std::exchange(other.capacity_, 0);
+		}
+		return *this;
+	}
+
+	void InstanceBuffer::Resize(std::size_t size)
+	{
+		if (size > capacity_)
+		{
+			// Grow geometrically so repeated small increases stay cheap.
+			Reserve(size > capacity_ * 2 ? size : capacity_ * 2);
+		}
+		size_ = size;
+	}
+
+	void InstanceBuffer::Reserve(std::size_t capacity)
+	{
+		if (capacity <= capacity_)
+		{
+			return;
+		}
+
+		glm::mat4* data = static_cast<glm::mat4*>(::operator new(
+			sizeof(glm::mat4) * capacity, std::align_val_t(kAlignment)));
+		if (size_ > 0)
+		{
+			std::memcpy(data, data_, sizeof(glm::mat4) * size_);
+		}
+		::operator delete(data_, std::align_val_t(kAlignment));
+		data_ = data;
+		capacity_ = capacity;
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef TREE_GENERATOR_INSTANCE_BUFFER_H_
+#define TREE_GENERATOR_INSTANCE_BUFFER_H_
+
+#include <cstddef>
+#include <span>
+
+#include <glm/glm.hpp>
+
+namespace tree_generator
+{
+	// Growable storage for per-instance model matrices, ready to be uploaded
+	// to the GPU as-is.
+	//
+	// The storage is aligned for SIMD access, and is kept when the buffer is
+	// shrunk or cleared, so reusing one buffer across generations avoids
+	// reallocating it.
+	class InstanceBuffer
+	{
+	public:
+		static constexpr std::size_t kAlignment = 64;
+
+		InstanceBuffer() = default;
+		~InstanceBuffer();
+
+		InstanceBuffer(InstanceBuffer&& other) noexcept;
+		InstanceBuffer& operator=(InstanceBuffer&& other) noexcept;
+
+		// Disallow copy
+		InstanceBuffer(const InstanceBuffer&) = delete;
+		InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+		// Existing matrices are preserved up to the new size. Matrices beyond
+		// the old size are uninitialized.
+		void Resize(std::size_t size);
+		void Reserve(std::size_t capacity);
+		void Clear() { size_ = 0; }
+
+		std::size_t Size() const { return size_; }
+		std::size_t Capacity() const { return capacity_; }
+
+		glm::mat4* Data() { return data_; }
+		const glm::mat4* Data() const { return data_; }
+
+		std::span<glm::mat4> Matrices() { return { data_, size_ }; }
+		std::span<const glm::mat4> Matrices() const { return { data_, size_ }; }
+
+		glm::mat4& operator[](std::size_t index) { return data_[index]; }
+		const glm::mat4& operator[](std::size_t index) const { return data_[index]; }
+
+	private:
+		glm::mat4* data_ = nullptr;
+		std::size_t size_ = 0;
+		std::size_t capacity_ = 0;
+	};
+}
+
+#endif  // !TREE_GENERATOR_INSTANCE_BUFFER_H_
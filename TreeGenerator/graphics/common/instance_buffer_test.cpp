@@ -0,0 +1,61 @@
+#include "instance_buffer.h"
+
+#include <cstdint>
+#include <utility>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+namespace tree_generator
+{
+	namespace
+	{
+		TEST(GraphicsInstanceBufferTest, StorageIsAligned)
+		{
+			InstanceBuffer buffer;
+			buffer.Resize(3);
+			EXPECT_EQ(
+				reinterpret_cast<std::uintptr_t>(buffer.Data()) % InstanceBuffer::kAlignment,
+				0);
+		}
+
+		TEST(GraphicsInstanceBufferTest, ResizePreservesMatrices)
+		{
+			InstanceBuffer buffer;
+			buffer.Resize(2);
+			buffer[0] = glm::mat4(1.0f);
+			buffer[1] = glm::mat4(2.0f);
+
+			buffer.Resize(100);
+			EXPECT_EQ(buffer.Size(), 100);
+			EXPECT_EQ(buffer[0], glm::mat4(1.0f));
+			EXPECT_EQ(buffer[1], glm::mat4(2.0f));
+		}
+
+		TEST(GraphicsInstanceBufferTest, ClearKeepsCapacity)
+		{
+			InstanceBuffer buffer;
+			buffer.Resize(10);
+			const glm::mat4* data = buffer.Data();
+
+			buffer.Clear();
+			buffer.Resize(10);
+			EXPECT_EQ(buffer.Data(), data);
+			EXPECT_GE(buffer.Capacity(), 10);
+		}
+
+		TEST(GraphicsInstanceBufferTest, MoveTransfersStorage)
+		{
+			InstanceBuffer buffer;
+			buffer.Resize(1);
+			buffer[0] = glm::mat4(3.0f);
+
+			InstanceBuffer moved = std::move(buffer);
+			EXPECT_EQ(buffer.Size(), 0);
+			EXPECT_EQ(moved.Matrices().size(), 1);
+			EXPECT_EQ(moved[0], glm::mat4(3.0f));
+		}
+	}
+}
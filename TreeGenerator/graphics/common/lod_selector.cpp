@@ -0,0 +1,78 @@
+#include "lod_selector.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace tree_generator
+{
+	float GetScreenSize(
+		const BoundingBox& box, const glm::mat4& viewProjection, float viewportHeight)
+	{
+		if (box.IsEmpty())
+		{
+			return 0.0f;
+		}
+
+		const glm::vec3 center = box.Center();
+		const float radius = glm::length(box.Extent());
+		const float w =
+			viewProjection[0][3] * center.x +
+			viewProjection[1][3] * center.y +
+			viewProjection[2][3] * center.z +
+			viewProjection[3][3];
+		if (w <= radius)
+		{
+			return std::numeric_limits<float>::infinity();
+		}
+
+		// The view's rows are orthonormal, so the length of the clip space
+		// y row is the projection's vertical scale.
+		const float scale = glm::length(
+			glm::vec3(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1]));
+		return radius * scale * viewportHeight / w;
+	}
+
+	LodSelector::LodSelector(std::vector<float> thresholds, float hysteresis) :
+		thresholds_(std::move(thresholds)),
+		hysteresis_(hysteresis)
+	{
+		if (!std::is_sorted(thresholds_.begin(), thresholds_.end(), std::greater<>()))
+		{
+			throw std::invalid_argument(
+				"Failed to initialize LodSelector: thresholds must be decreasing");
+		}
+	}
+
+	int LodSelector::Select(float screenSize, int currentLod) const
+	{
+		const int lodCount = GetLodCount();
+		int lod = std::clamp(currentLod, 0, lodCount - 1);
+		while (lod + 1 < lodCount && screenSize < thresholds_[lod] * (1.0f - hysteresis_))
+		{
+			++lod;
+		}
+		while (lod > 0 && screenSize >= thresholds_[lod - 1] * (1.0f + hysteresis_))
+		{
+			--lod;
+		}
+		return lod;
+	}
+
+	void LodSelector::Select(
+		const InstanceBounds& bounds,
+		std::span<const std::uint32_t> instances,
+		const glm::mat4& viewProjection,
+		float viewportHeight,
+		std::span<std::uint8_t> lods) const
+	{
+		for (std::uint32_t instance : instances)
+		{
+			const float screenSize = GetScreenSize(
+				bounds.Get(instance), viewProjection, viewportHeight);
+			lods[instance] = static_cast<std::uint8_t>(Select(screenSize, lods[instance]));
+		}
+	}
+}
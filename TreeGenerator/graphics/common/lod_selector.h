@@ -0,0 +1,54 @@
+#ifndef TREE_GENERATOR_LOD_SELECTOR_H_
+#define TREE_GENERATOR_LOD_SELECTOR_H_
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+
+namespace tree_generator
+{
+	// Diameter, in pixels, of the box's bounding sphere when projected onto a
+	// viewport viewportHeight pixels tall, measured at the sphere's center.
+	// Infinite when the sphere reaches behind the camera.
+	float GetScreenSize(
+		const BoundingBox& box, const glm::mat4& viewProjection, float viewportHeight);
+
+	// Chooses a level of detail from how large something appears on screen.
+	//
+	// Level i is meant for screen sizes of at least thresholds[i], and the
+	// last level for anything smaller than the last threshold. So that
+	// something near a threshold doesn't switch level every frame, the level
+	// only changes once the size is past the threshold by the hysteresis,
+	// as a fraction of the threshold.
+	class LodSelector
+	{
+	public:
+		// The thresholds must be in decreasing order.
+		LodSelector(std::vector<float> thresholds, float hysteresis);
+
+		int GetLodCount() const { return static_cast<int>(thresholds_.size()) + 1; }
+
+		// Returns the level to use at the screen size, for something that is
+		// currently drawn at currentLod.
+		int Select(float screenSize, int currentLod) const;
+
+		// Updates lods[i] for each of the instances i, from the screen size
+		// of their bounds.
+		void Select(
+			const InstanceBounds& bounds,
+			std::span<const std::uint32_t> instances,
+			const glm::mat4& viewProjection,
+			float viewportHeight,
+			std::span<std::uint8_t> lods) const;
+
+	private:
+		std::vector<float> thresholds_;
+		float hysteresis_;
+	};
+}
+
+#endif  // !TREE_GENERATOR_LOD_SELECTOR_H_
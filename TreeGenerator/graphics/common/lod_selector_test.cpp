@@ -0,0 +1,126 @@
+#include "lod_selector.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bounding_box.h"
+
+using ::testing::ElementsAre;
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr float kViewportHeight = 100.0f;
+
+		// Looks down the negative z axis from the origin.
+		glm::mat4 CreateViewProjection()
+		{
+			const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+			const glm::mat4 view = glm::lookAt(
+				glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			return projection * view;
+		}
+
+		BoundingBox CreateBox(glm::vec3 center, float size)
+		{
+			return { center - glm::vec3(size), center + glm::vec3(size) };
+		}
+
+		TEST(LodSelectorTest, ScreenSizeIsProjectedDiameter)
+		{
+			const glm::mat4 viewProjection = CreateViewProjection();
+			const BoundingBox box = CreateBox(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f);
+
+			// Project the top of the bounding sphere, at the center's depth.
+			const float radius = glm::length(box.Extent());
+			const glm::vec4 top = viewProjection * glm::vec4(0.0f, radius, -10.0f, 1.0f);
+			const float expected = top.y / top.w * kViewportHeight;
+
+			EXPECT_NEAR(GetScreenSize(box, viewProjection, kViewportHeight), expected, 1e-3f);
+		}
+
+		TEST(LodSelectorTest, ScreenSizeShrinksWithDistance)
+		{
+			const glm::mat4 viewProjection = CreateViewProjection();
+			const float near = GetScreenSize(
+				CreateBox(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f), viewProjection, kViewportHeight);
+			const float far = GetScreenSize(
+				CreateBox(glm::vec3(5.0f, 0.0f, -20.0f), 1.0f), viewProjection, kViewportHeight);
+
+			EXPECT_NEAR(far, near / 2.0f, 1e-3f);
+		}
+
+		TEST(LodSelectorTest, ScreenSizeIsInfiniteAroundCamera)
+		{
+			const float size = GetScreenSize(
+				CreateBox(glm::vec3(0.0f, 0.0f, -0.5f), 1.0f), CreateViewProjection(), kViewportHeight);
+
+			EXPECT_EQ(size, std::numeric_limits<float>::infinity());
+		}
+
+		TEST(LodSelectorTest, SelectsLevelFromThresholds)
+		{
+			LodSelector selector({ 100.0f, 10.0f, 1.0f }, 0.0f);
+
+			EXPECT_EQ(selector.GetLodCount(), 4);
+			EXPECT_EQ(selector.Select(500.0f, 3), 0);
+			EXPECT_EQ(selector.Select(100.0f, 3), 0);
+			EXPECT_EQ(selector.Select(50.0f, 0), 1);
+			EXPECT_EQ(selector.Select(5.0f, 0), 2);
+			EXPECT_EQ(selector.Select(0.5f, 0), 3);
+			EXPECT_EQ(selector.Select(0.0f, 1), 3);
+		}
+
+		TEST(LodSelectorTest, KeepsLevelWithinHysteresis)
+		{
+			LodSelector selector({ 100.0f, 10.0f }, 0.1f);
+
+			// Just below and above the threshold between levels 0 and 1.
+			EXPECT_EQ(selector.Select(95.0f, 0), 0);
+			EXPECT_EQ(selector.Select(105.0f, 1), 1);
+
+			// Past the hysteresis.
+			EXPECT_EQ(selector.Select(85.0f, 0), 1);
+			EXPECT_EQ(selector.Select(115.0f, 1), 0);
+		}
+
+		TEST(LodSelectorTest, ClampsCurrentLevel)
+		{
+			LodSelector selector({ 100.0f }, 0.1f);
+
+			EXPECT_EQ(selector.Select(50.0f, 7), 1);
+			EXPECT_EQ(selector.Select(500.0f, -1), 0);
+		}
+
+		TEST(LodSelectorTest, RejectsIncreasingThresholds)
+		{
+			EXPECT_THROW(LodSelector({ 10.0f, 100.0f }, 0.0f), std::invalid_argument);
+		}
+
+		TEST(LodSelectorTest, SelectsOnlyGivenInstances)
+		{
+			InstanceBounds bounds;
+			bounds.Resize(3);
+			bounds.Set(0, CreateBox(glm::vec3(0.0f, 0.0f, -2.0f), 1.0f));
+			bounds.Set(1, CreateBox(glm::vec3(0.0f, 0.0f, -90.0f), 0.1f));
+			bounds.Set(2, CreateBox(glm::vec3(0.0f, 0.0f, -90.0f), 0.1f));
+
+			LodSelector selector({ 10.0f, 1.0f }, 0.1f);
+			std::vector<std::uint8_t> lods(3, 1);
+			const std::vector<std::uint32_t> instances{ 0, 1 };
+			selector.Select(bounds, instances, CreateViewProjection(), kViewportHeight, lods);
+
+			EXPECT_THAT(lods, ElementsAre(0, 2, 1));
+		}
+	}
+}
@@ -0,0 +1,189 @@
+#include "mesh_baker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr std::uint32_t kNoVertex = std::numeric_limits<std::uint32_t>::max();
+
+		// Cells smaller than this would overflow the cell coordinates for
+		// positions of ordinary magnitude, so exact welding uses them too.
+		constexpr double kMinCellSize = 1e-6;
+
+		struct Cell
+		{
+			std::int64_t x;
+			std::int64_t y;
+			std::int64_t z;
+
+			bool operator==(const Cell& other) const = default;
+		};
+
+		struct CellHash
+		{
+			std::size_t operator()(const Cell& cell) const
+			{
+				std::size_t hash = std::hash<std::int64_t>()(cell.x);
+				hash ^= std::hash<std::int64_t>()(cell.y) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+				hash ^= std::hash<std::int64_t>()(cell.z) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+				return hash;
+			}
+		};
+
+		bool IsWithin(glm::vec3 a, glm::vec3 b, float tolerance)
+		{
+			glm::vec3 difference = glm::abs(a - b);
+			return difference.x <= tolerance &&
+				difference.y <= tolerance &&
+				difference.z <= tolerance;
+		}
+
+		bool IsWithin(const Vertex& a, const Vertex& b, float tolerance)
+		{
+			return IsWithin(a.position, b.position, tolerance) &&
+				IsWithin(a.normal, b.normal, tolerance) &&
+				std::abs(a.uv.x - b.uv.x) <= tolerance &&
+				std::abs(a.uv.y - b.uv.y) <= tolerance;
+		}
+	}
+
+	MeshData BakedMesh::ToMeshData() const
+	{
+		MeshData mesh;
+		mesh.vertices = vertices;
+		mesh.indices.reserve(IndexCount());
+		mesh.indices.insert(mesh.indices.end(), shortIndices.begin(), shortIndices.end());
+		mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+		return mesh;
+	}
+
+	void BakeInstance(
+		const MeshData& mesh,
+		const glm::mat4& model,
+		std::uint32_t firstVertex,
+		Vertex* vertices,
+		std::uint32_t* indices)
+	{
+		// Normals need the inverse transpose, in case the model matrix
+		// doesn't scale uniformly.
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+		for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			const Vertex& vertex = mesh.vertices[i];
+			vertices[i] = {
+				glm::vec3(model * glm::vec4(vertex.position, 1.0f)),
+				glm::normalize(normalMatrix * vertex.normal),
+				vertex.uv };
+		}
+		for (std::size_t i = 0; i < mesh.indices.size(); ++i)
+		{
+			indices[i] = firstVertex + mesh.indices[i];
+		}
+	}
+
+	void WeldVertices(
+		float tolerance,
+		std::vector<Vertex>* vertices,
+		std::vector<std::uint32_t>* indices)
+	{
+		// Any vertex close enough to another is in the same or a neighboring
+		// cell, when the cells are as large as the tolerance.
+		const double cellSize = std::max<double>(tolerance, kMinCellSize);
+		auto GetCell = [cellSize](glm::vec3 position) {
+			return Cell{
+				static_cast<std::int64_t>(std::floor(position.x / cellSize)),
+				static_cast<std::int64_t>(std::floor(position.y / cellSize)),
+				static_cast<std::int64_t>(std::floor(position.z / cellSize)) };
+			};
+
+		// The kept vertices in each cell form a linked list through
+		// nextInCell.
+		std::unordered_map<Cell, std::uint32_t, CellHash> cellHeads;
+		cellHeads.reserve(vertices->size());
+		std::vector<std::uint32_t> nextInCell;
+		nextInCell.reserve(vertices->size());
+
+		std::vector<std::uint32_t> remap(vertices->size());
+		std::uint32_t keptCount = 0;
+		for (std::size_t i = 0; i < vertices->size(); ++i)
+		{
+			const Vertex& vertex = (*vertices)[i];
+			const Cell cell = GetCell(vertex.position);
+
+			// Lists run newest first, and the neighboring cells in no order,
+			// so every match is compared to find the earliest.
+			std::uint32_t match = kNoVertex;
+			for (std::int64_t dx = -1; dx <= 1; ++dx)
+			{
+				for (std::int64_t dy = -1; dy <= 1; ++dy)
+				{
+					for (std::int64_t dz = -1; dz <= 1; ++dz)
+					{
+						auto head = cellHeads.find({ cell.x + dx, cell.y + dy, cell.z + dz });
+						if (head == cellHeads.end())
+						{
+							continue;
+						}
+						for (std::uint32_t kept = head->second;
+							kept != kNoVertex && kept < match;
+							kept = nextInCell[kept])
+						{
+							if (IsWithin((*vertices)[kept], vertex, tolerance))
+							{
+								match = kept;
+							}
+						}
+					}
+				}
+			}
+
+			if (match != kNoVertex)
+			{
+				remap[i] = match;
+				continue;
+			}
+
+			// Kept vertices are compacted in place. They never overtake the
+			// vertex being read, so nothing unread is overwritten.
+			(*vertices)[keptCount] = vertex;
+			auto [head, isInserted] = cellHeads.try_emplace(cell, kNoVertex);
+			nextInCell.push_back(head->second);
+			head->second = keptCount;
+			remap[i] = keptCount;
+			++keptCount;
+		}
+
+		vertices->resize(keptCount);
+		for (std::uint32_t& index : *indices)
+		{
+			index = remap[index];
+		}
+	}
+
+	BakedMesh CreateBakedMesh(
+		std::vector<Vertex> vertices, std::vector<std::uint32_t> indices)
+	{
+		BakedMesh mesh;
+		mesh.vertices = std::move(vertices);
+		if (mesh.vertices.size() <= std::size_t{ std::numeric_limits<std::uint16_t>::max() } + 1)
+		{
+			mesh.shortIndices.reserve(indices.size());
+			for (std::uint32_t index : indices)
+			{
+				mesh.shortIndices.push_back(static_cast<std::uint16_t>(index));
+			}
+		}
+		else
+		{
+			mesh.indices = std::move(indices);
+		}
+		return mesh;
+	}
+}
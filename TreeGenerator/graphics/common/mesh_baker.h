@@ -0,0 +1,56 @@
+#ifndef TREE_GENERATOR_MESH_BAKER_H_
+#define TREE_GENERATOR_MESH_BAKER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	// The geometry of many mesh instances merged into one mesh, with every
+	// vertex already transformed by its instance's model matrix.
+	struct BakedMesh
+	{
+		std::vector<Vertex> vertices;
+
+		// Indices are 16-bit when every vertex can be addressed with them,
+		// and 32-bit otherwise. Only one of the two is ever non-empty.
+		std::vector<std::uint16_t> shortIndices;
+		std::vector<std::uint32_t> indices;
+
+		std::size_t IndexCount() const { return shortIndices.size() + indices.size(); }
+
+		// Returns the mesh with 32-bit indices.
+		MeshData ToMeshData() const;
+	};
+
+	// Writes the mesh's vertices, transformed by the model matrix, to
+	// `vertices`, and its indices, offset by firstVertex, to `indices`. Both
+	// outputs must have room for all of the mesh's vertices and indices.
+	void BakeInstance(
+		const MeshData& mesh,
+		const glm::mat4& model,
+		std::uint32_t firstVertex,
+		Vertex* vertices,
+		std::uint32_t* indices);
+
+	// Merges vertices whose positions, normals and uvs all differ by at most
+	// `tolerance` in every component, and remaps the indices to match. Each
+	// vertex is merged into the first earlier vertex that is close enough,
+	// so the result doesn't depend on how many vertices are chained together.
+	void WeldVertices(
+		float tolerance,
+		std::vector<Vertex>* vertices,
+		std::vector<std::uint32_t>* indices);
+
+	// Creates a baked mesh from the vertices and indices, narrowing the
+	// indices to 16 bits if possible.
+	BakedMesh CreateBakedMesh(
+		std::vector<Vertex> vertices, std::vector<std::uint32_t> indices);
+}
+
+#endif  // !TREE_GENERATOR_MESH_BAKER_H_
@@ -0,0 +1,172 @@
+#include "mesh_baker.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "mesh_data.h"
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr float kTolerance = 1e-5f;
+
+		void ExpectNear(glm::vec3 actual, glm::vec3 expected)
+		{
+			EXPECT_NEAR(actual.x, expected.x, kTolerance);
+			EXPECT_NEAR(actual.y, expected.y, kTolerance);
+			EXPECT_NEAR(actual.z, expected.z, kTolerance);
+		}
+
+		Vertex CreateVertex(glm::vec3 position, glm::vec2 uv = glm::vec2(0.0f))
+		{
+			return { position, glm::vec3(0.0f, 0.0f, 1.0f), uv };
+		}
+
+		TEST(MeshBakerTest, BakeInstanceTransformsVertices)
+		{
+			MeshData mesh = CreateQuad();
+			glm::mat4 model(2.0f);
+			model[3] = glm::vec4(1.0f, 2.0f, 3.0f, 1.0f);
+
+			std::vector<Vertex> vertices(mesh.vertices.size());
+			std::vector<std::uint32_t> indices(mesh.indices.size());
+			BakeInstance(mesh, model, 10, vertices.data(), indices.data());
+
+			for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+			{
+				ExpectNear(
+					vertices[i].position,
+					2.0f * mesh.vertices[i].position + glm::vec3(1.0f, 2.0f, 3.0f));
+				ExpectNear(vertices[i].normal, mesh.vertices[i].normal);
+				EXPECT_EQ(vertices[i].uv, mesh.vertices[i].uv);
+			}
+			for (std::size_t i = 0; i < mesh.indices.size(); ++i)
+			{
+				EXPECT_EQ(indices[i], mesh.indices[i] + 10);
+			}
+		}
+
+		TEST(MeshBakerTest, BakeInstanceKeepsNormalsPerpendicularUnderNonUniformScale)
+		{
+			MeshData mesh;
+			mesh.vertices.push_back({
+				glm::vec3(0.0f),
+				glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)),
+				glm::vec2(0.0f) });
+			glm::mat4 model(1.0f);
+			model[0][0] = 2.0f;
+
+			Vertex vertex;
+			BakeInstance(mesh, model, 0, &vertex, nullptr);
+
+			ExpectNear(vertex.normal, glm::normalize(glm::vec3(0.5f, 1.0f, 0.0f)));
+		}
+
+		TEST(MeshBakerTest, WeldVerticesMergesVerticesWithinTolerance)
+		{
+			std::vector<Vertex> vertices{
+				CreateVertex(glm::vec3(0.0f)),
+				CreateVertex(glm::vec3(1.0f, 0.0f, 0.0f)),
+				CreateVertex(glm::vec3(0.0f, 0.0f, 0.0005f)),
+				CreateVertex(glm::vec3(1.0f, 0.0f, 0.0f)),
+			};
+			std::vector<std::uint32_t> indices{ 0, 1, 2, 3, 2, 1 };
+
+			WeldVertices(0.001f, &vertices, &indices);
+
+			EXPECT_THAT(vertices, SizeIs(2));
+			EXPECT_THAT(indices, ElementsAre(0, 1, 0, 1, 0, 1));
+		}
+
+		TEST(MeshBakerTest, WeldVerticesMergesAcrossCellBoundaries)
+		{
+			std::vector<Vertex> vertices{
+				CreateVertex(glm::vec3(0.0999f, 0.0f, 0.0f)),
+				CreateVertex(glm::vec3(0.1001f, 0.0f, 0.0f)),
+			};
+			std::vector<std::uint32_t> indices{ 1, 0 };
+
+			WeldVertices(0.1f, &vertices, &indices);
+
+			EXPECT_THAT(vertices, SizeIs(1));
+			EXPECT_THAT(indices, ElementsAre(0, 0));
+		}
+
+		TEST(MeshBakerTest, WeldVerticesMergesIntoTheEarliestMatch)
+		{
+			// The last vertex is close enough to both others, and the later
+			// one is in its own cell.
+			std::vector<Vertex> vertices{
+				CreateVertex(glm::vec3(0.15f, 0.0f, 0.0f)),
+				CreateVertex(glm::vec3(0.01f, 0.0f, 0.0f)),
+				CreateVertex(glm::vec3(0.08f, 0.0f, 0.0f)),
+			};
+			std::vector<std::uint32_t> indices{ 0, 1, 2 };
+
+			WeldVertices(0.1f, &vertices, &indices);
+
+			EXPECT_THAT(vertices, SizeIs(2));
+			EXPECT_THAT(indices, ElementsAre(0, 1, 0));
+		}
+
+		TEST(MeshBakerTest, WeldVerticesKeepsVerticesWithDifferentAttributes)
+		{
+			std::vector<Vertex> vertices{
+				CreateVertex(glm::vec3(0.0f), glm::vec2(0.0f, 0.0f)),
+				CreateVertex(glm::vec3(0.0f), glm::vec2(1.0f, 0.0f)),
+				{ glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.0f) },
+			};
+			std::vector<std::uint32_t> indices{ 0, 1, 2 };
+
+			WeldVertices(0.001f, &vertices, &indices);
+
+			EXPECT_THAT(vertices, SizeIs(3));
+			EXPECT_THAT(indices, ElementsAre(0, 1, 2));
+		}
+
+		TEST(MeshBakerTest, WeldVerticesWithZeroToleranceOnlyMergesEqualVertices)
+		{
+			std::vector<Vertex> vertices{
+				CreateVertex(glm::vec3(5.0f)),
+				CreateVertex(glm::vec3(5.0f, 5.0f, 5.0001f)),
+				CreateVertex(glm::vec3(5.0f)),
+			};
+			std::vector<std::uint32_t> indices{ 2, 1, 0 };
+
+			WeldVertices(0.0f, &vertices, &indices);
+
+			EXPECT_THAT(vertices, SizeIs(2));
+			EXPECT_THAT(indices, ElementsAre(0, 1, 0));
+		}
+
+		TEST(MeshBakerTest, CreateBakedMeshUsesShortIndicesWhenPossible)
+		{
+			std::vector<Vertex> vertices(65536, CreateVertex(glm::vec3(0.0f)));
+			BakedMesh mesh = CreateBakedMesh(vertices, { 0, 65535, 1 });
+
+			EXPECT_THAT(mesh.shortIndices, ElementsAre(0, 65535, 1));
+			EXPECT_THAT(mesh.indices, IsEmpty());
+			EXPECT_EQ(mesh.IndexCount(), 3);
+		}
+
+		TEST(MeshBakerTest, CreateBakedMeshUsesLongIndicesForManyVertices)
+		{
+			std::vector<Vertex> vertices(65537, CreateVertex(glm::vec3(0.0f)));
+			BakedMesh mesh = CreateBakedMesh(vertices, { 0, 65536, 1 });
+
+			EXPECT_THAT(mesh.shortIndices, IsEmpty());
+			EXPECT_THAT(mesh.indices, ElementsAre(0, 65536, 1));
+			EXPECT_THAT(mesh.ToMeshData().indices, ElementsAre(0, 65536, 1));
+		}
+	}
+}
@@ -1,6 +1,10 @@
 #include "mesh_data.h"
 
+#include <array>
+#include <cmath>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
 
 #include <glm/gtc/constants.hpp>
 
@@ -8,15 +12,46 @@ namespace tree_generator
 {
 	namespace
 	{
-		std::vector<glm::vec2> CalculateCirclePositions(int sideCount)
+		// Side counts up to this have their circle computed once and kept.
+		constexpr int kMaxTableSideCount = 256;
+
+		// Each angle is computed from its index rather than by accumulating
+		// steps, so rounding can't add a side.
+		void ComputeCirclePositions(int sideCount, std::vector<glm::vec2>* positions)
 		{
-			float sideStep = glm::two_pi<float>() / sideCount;
-			std::vector<glm::vec2> positions;
-			for (float angle = 0.0f; angle < glm::two_pi<float>(); angle += sideStep)
+			positions->resize(sideCount);
+			for (int i = 0; i < sideCount; ++i)
 			{
-				positions.emplace_back(glm::cos(angle), glm::sin(angle));
+				const double angle = glm::two_pi<double>() * i / sideCount;
+				(*positions)[i] = glm::vec2(std::cos(angle), std::sin(angle));
 			}
-			return positions;
+		}
+
+		// Returns the cosine and sine of sideCount angles evenly spaced
+		// around the circle, starting at 0. Tables are filled once per side
+		// count, so that cylinders built in parallel only read them. Larger
+		// side counts are computed into `storage` instead.
+		std::span<const glm::vec2> GetCirclePositions(
+			int sideCount, std::vector<glm::vec2>* storage)
+		{
+			if (sideCount > kMaxTableSideCount)
+			{
+				ComputeCirclePositions(sideCount, storage);
+				return *storage;
+			}
+
+			struct Table
+			{
+				std::once_flag isFilled;
+				std::vector<glm::vec2> positions;
+			};
+			static std::array<Table, kMaxTableSideCount + 1> tables;
+
+			Table& table = tables[sideCount];
+			std::call_once(table.isFilled, [sideCount, &table]() {
+				ComputeCirclePositions(sideCount, &table.positions);
+				});
+			return table.positions;
 		}
 	}
 
@@ -60,8 +95,29 @@ namespace tree_generator
 		return quad;
 	}
 
+	std::size_t GetCylinderVertexCount(int sideCount, const CylinderOptions& options)
+	{
+		if (sideCount < 3)
+		{
+			return 0;
+		}
+		const std::size_t columnCount = sideCount + (options.hasUvs ? 1 : 0);
+		const std::size_t capVertexCount = options.hasCaps ? 2 * (sideCount + 1) : 0;
+		return 2 * columnCount + capVertexCount;
+	}
+
+	std::size_t GetCylinderIndexCount(int sideCount, const CylinderOptions& options)
+	{
+		if (sideCount < 3)
+		{
+			return 0;
+		}
+		const std::size_t sideIndexCount = 6 * static_cast<std::size_t>(sideCount);
+		return options.hasCaps ? 2 * sideIndexCount : sideIndexCount;
+	}
+
 	// Reference: http://www.songho.ca/opengl/gl_cylinder.html
-	MeshData CreateCylinder(int sideCount, float height, float radius)
+	MeshData CreateCylinder(int sideCount, float height, float radius, const CylinderOptions& options)
 	{
 		if (sideCount < 3)
 		{
@@ -69,37 +125,91 @@ namespace tree_generator
 			return {};
 		}
 
-		std::vector<glm::vec2> circle = CalculateCirclePositions(sideCount);
 		MeshData mesh;
-		glm::vec3 offset(0.0f, height / 2, 0.0f);
-		for (int i = 0; i < circle.size(); ++i)
+		mesh.vertices.resize(GetCylinderVertexCount(sideCount, options));
+		mesh.indices.resize(GetCylinderIndexCount(sideCount, options));
+		WriteCylinder(sideCount, height, radius, options, mesh.vertices, mesh.indices);
+		return mesh;
+	}
+
+	void WriteCylinder(
+		int sideCount,
+		float height,
+		float radius,
+		const CylinderOptions& options,
+		std::span<Vertex> vertices,
+		std::span<unsigned int> indices)
+	{
+		if (sideCount < 3)
+		{
+			throw std::invalid_argument("Cylinder must have at least 3 sides");
+		}
+		if (vertices.size() != GetCylinderVertexCount(sideCount, options) ||
+			indices.size() != GetCylinderIndexCount(sideCount, options))
 		{
-			glm::vec3 normal = glm::vec3(circle[i].x, 0, circle[i].y);
-			glm::vec3 basePosition = normal * radius;
-			mesh.vertices.push_back({ basePosition - offset, normal });
-			mesh.vertices.push_back({ basePosition + offset, normal });
+			throw std::invalid_argument("Cylinder buffers have the wrong size");
+		}
 
-			if (i < circle.size() - 1)
-			{
-				mesh.indices.push_back(2 * i + 3);
-				mesh.indices.push_back(2 * i + 2);
-				mesh.indices.push_back(2 * i + 1);
+		std::vector<glm::vec2> circleStorage;
+		const std::span<const glm::vec2> circle = GetCirclePositions(sideCount, &circleStorage);
+		const glm::vec3 offset(0.0f, height / 2, 0.0f);
 
-				mesh.indices.push_back(2 * i + 2);
-				mesh.indices.push_back(2 * i);
-				mesh.indices.push_back(2 * i + 1);
-			}
-			else
+		// Each column is a bottom vertex followed by a top vertex.
+		const int columnCount = sideCount + (options.hasUvs ? 1 : 0);
+		for (int i = 0; i < columnCount; ++i)
+		{
+			const glm::vec2 point = circle[i % sideCount];
+			const glm::vec3 normal(point.x, 0.0f, point.y);
+			const glm::vec3 basePosition = normal * radius;
+			const float u = options.hasUvs ? static_cast<float>(i) / sideCount : 0.0f;
+			const float topV = options.hasUvs ? 1.0f : 0.0f;
+			vertices[2 * i] = { basePosition - offset, normal, glm::vec2(u, 0.0f) };
+			vertices[2 * i + 1] = { basePosition + offset, normal, glm::vec2(u, topV) };
+		}
+
+		std::size_t index = 0;
+		for (int i = 0; i < sideCount; ++i)
+		{
+			const unsigned int column = 2 * i;
+			const unsigned int nextColumn = 2 * ((i + 1) % columnCount);
+			indices[index++] = nextColumn + 1;
+			indices[index++] = nextColumn;
+			indices[index++] = column + 1;
+
+			indices[index++] = nextColumn;
+			indices[index++] = column;
+			indices[index++] = column + 1;
+		}
+
+		if (!options.hasCaps)
+		{
+			return;
+		}
+
+		// Each cap is its center followed by its rim. The bottom cap winds
+		// the other way around, so that both face outwards.
+		unsigned int first = 2 * columnCount;
+		for (float side : { -1.0f, 1.0f })
+		{
+			const glm::vec3 normal(0.0f, side, 0.0f);
+			const glm::vec2 centerUv = options.hasUvs ? glm::vec2(0.5f) : glm::vec2(0.0f);
+			vertices[first] = { offset * side, normal, centerUv };
+			for (int i = 0; i < sideCount; ++i)
 			{
-				mesh.indices.push_back(0);
-				mesh.indices.push_back(1);
-				mesh.indices.push_back(2 * i + 1);
+				const glm::vec2 point = circle[i];
+				const glm::vec2 uv = options.hasUvs ? point * 0.5f + 0.5f : glm::vec2(0.0f);
+				vertices[first + 1 + i] = {
+					glm::vec3(point.x * radius, 0.0f, point.y * radius) + offset * side,
+					normal,
+					uv };
 
-				mesh.indices.push_back(0);
-				mesh.indices.push_back(2 * i);
-				mesh.indices.push_back(2 * i + 1);
+				const unsigned int rim = first + 1 + i;
+				const unsigned int nextRim = first + 1 + (i + 1) % sideCount;
+				indices[index++] = first;
+				indices[index++] = side < 0.0f ? rim : nextRim;
+				indices[index++] = side < 0.0f ? nextRim : rim;
 			}
+			first += sideCount + 1;
 		}
-		return mesh;
 	}
 }
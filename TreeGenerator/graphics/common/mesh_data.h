@@ -1,6 +1,8 @@
 #ifndef TREE_GENERATOR_MESH_DATA_H_
 #define TREE_GENERATOR_MESH_DATA_H_
 
+#include <cstddef>
+#include <span>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -27,7 +29,43 @@ namespace tree_generator
 		glm::vec2 bottomRight,
 		glm::vec2 topRight);
 
-	MeshData CreateCylinder(int sideCount, float height = 1.0f, float radius = 1.0f);
+	struct CylinderOptions
+	{
+		// Closes both ends with flat fans, with their own vertices so that
+		// their normals point along the axis.
+		bool hasCaps = false;
+
+		// Gives the sides uvs, with u running from 0 to 1 around the
+		// cylinder and v from 0 at the bottom to 1 at the top, and the caps
+		// uvs mapping them onto the unit square. The sides' first column of
+		// vertices is repeated at u = 1, so that the last side doesn't wrap
+		// back to u = 0. Otherwise all uvs are 0, so that stacked cylinders
+		// can be welded together.
+		bool hasUvs = false;
+	};
+
+	// Number of vertices and indices of a cylinder, for WriteCylinder().
+	std::size_t GetCylinderVertexCount(int sideCount, const CylinderOptions& options = {});
+	std::size_t GetCylinderIndexCount(int sideCount, const CylinderOptions& options = {});
+
+	// A cylinder around the y axis, centered on the origin, open at both
+	// ends unless it has caps.
+	MeshData CreateCylinder(
+		int sideCount,
+		float height = 1.0f,
+		float radius = 1.0f,
+		const CylinderOptions& options = {});
+
+	// Writes the cylinder created by CreateCylinder() into the spans, which
+	// must hold exactly GetCylinderVertexCount() and GetCylinderIndexCount()
+	// elements, without allocating for up to 256 sides.
+	void WriteCylinder(
+		int sideCount,
+		float height,
+		float radius,
+		const CylinderOptions& options,
+		std::span<Vertex> vertices,
+		std::span<unsigned int> indices);
 }
 
 #endif  // !TREE_GENERATOR_MESH_DATA_H_
\ No newline at end of file
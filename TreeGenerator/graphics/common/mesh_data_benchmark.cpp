@@ -0,0 +1,40 @@
+#include "mesh_data.h"
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace tree_generator
+{
+	namespace
+	{
+		void BM_CreateCylinder(benchmark::State& state)
+		{
+			const int sideCount = static_cast<int>(state.range(0));
+
+			for (auto _ : state)
+			{
+				MeshData cylinder = CreateCylinder(sideCount);
+				benchmark::DoNotOptimize(cylinder.vertices.data());
+			}
+			state.SetItemsProcessed(state.iterations());
+		}
+
+		void BM_WriteCylinder(benchmark::State& state)
+		{
+			const int sideCount = static_cast<int>(state.range(0));
+			std::vector<Vertex> vertices(GetCylinderVertexCount(sideCount));
+			std::vector<unsigned int> indices(GetCylinderIndexCount(sideCount));
+
+			for (auto _ : state)
+			{
+				WriteCylinder(sideCount, 1.0f, 1.0f, {}, vertices, indices);
+				benchmark::DoNotOptimize(vertices.data());
+			}
+			state.SetItemsProcessed(state.iterations());
+		}
+
+		BENCHMARK(BM_CreateCylinder)->Arg(8)->Arg(64);
+		BENCHMARK(BM_WriteCylinder)->Arg(8)->Arg(64);
+	}
+}
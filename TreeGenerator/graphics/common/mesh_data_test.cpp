@@ -0,0 +1,140 @@
+#include "mesh_data.h"
+
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		using Position = std::tuple<float, float, float>;
+
+		Position ToTuple(glm::vec3 position)
+		{
+			// Rounded, so that positions computed from the same angle match.
+			const glm::vec3 rounded = glm::round(position * 1e4f);
+			return { rounded.x, rounded.y, rounded.z };
+		}
+
+		// Counts the mesh's edges, by position, in each direction.
+		std::map<std::pair<Position, Position>, int> CountEdges(const MeshData& mesh)
+		{
+			std::map<std::pair<Position, Position>, int> edges;
+			for (std::size_t i = 0; i < mesh.indices.size(); i += 3)
+			{
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const glm::vec3 from = mesh.vertices[mesh.indices[i + corner]].position;
+					const glm::vec3 to = mesh.vertices[mesh.indices[i + (corner + 1) % 3]].position;
+					++edges[{ ToTuple(from), ToTuple(to) }];
+				}
+			}
+			return edges;
+		}
+
+		TEST(MeshDataTest, CylinderHasExactlySideCountSides)
+		{
+			for (int sideCount = 3; sideCount <= 300; ++sideCount)
+			{
+				const MeshData cylinder = CreateCylinder(sideCount);
+
+				EXPECT_THAT(cylinder.vertices, SizeIs(2 * sideCount)) << sideCount << " sides";
+				EXPECT_THAT(cylinder.indices, SizeIs(6 * sideCount)) << sideCount << " sides";
+				EXPECT_EQ(cylinder.vertices.size(), GetCylinderVertexCount(sideCount));
+				EXPECT_EQ(cylinder.indices.size(), GetCylinderIndexCount(sideCount));
+			}
+		}
+
+		TEST(MeshDataTest, CylinderTrianglesFaceOutwards)
+		{
+			CylinderOptions options;
+			options.hasCaps = true;
+			const MeshData cylinder = CreateCylinder(8, 2.0f, 0.5f, options);
+
+			for (std::size_t i = 0; i < cylinder.indices.size(); i += 3)
+			{
+				const glm::vec3 p0 = cylinder.vertices[cylinder.indices[i]].position;
+				const glm::vec3 p1 = cylinder.vertices[cylinder.indices[i + 1]].position;
+				const glm::vec3 p2 = cylinder.vertices[cylinder.indices[i + 2]].position;
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+
+				EXPECT_GT(glm::dot(normal, center), 0.0f) << "triangle " << i / 3;
+				EXPECT_GT(glm::dot(normal, cylinder.vertices[cylinder.indices[i]].normal), 0.0f)
+					<< "triangle " << i / 3;
+			}
+		}
+
+		TEST(MeshDataTest, CappedCylinderIsClosed)
+		{
+			CylinderOptions options;
+			options.hasCaps = true;
+			const MeshData cylinder = CreateCylinder(7, 1.0f, 1.0f, options);
+
+			EXPECT_THAT(cylinder.vertices, SizeIs(GetCylinderVertexCount(7, options)));
+			EXPECT_THAT(cylinder.indices, SizeIs(GetCylinderIndexCount(7, options)));
+
+			// Every edge is used once in each direction.
+			const std::map<std::pair<Position, Position>, int> edges = CountEdges(cylinder);
+			for (const auto& [edge, count] : edges)
+			{
+				EXPECT_EQ(count, 1);
+				EXPECT_TRUE(edges.contains({ edge.second, edge.first }));
+			}
+		}
+
+		TEST(MeshDataTest, CylinderUvsDontWrapAtSeam)
+		{
+			CylinderOptions options;
+			options.hasUvs = true;
+			const MeshData cylinder = CreateCylinder(6, 1.0f, 1.0f, options);
+
+			ASSERT_THAT(cylinder.vertices, SizeIs(2 * 7));
+			for (std::size_t i = 0; i < cylinder.indices.size(); i += 3)
+			{
+				// Every side spans a sixth of the texture.
+				float minU = 1.0f;
+				float maxU = 0.0f;
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const float u = cylinder.vertices[cylinder.indices[i + corner]].uv.x;
+					minU = glm::min(minU, u);
+					maxU = glm::max(maxU, u);
+				}
+				EXPECT_NEAR(maxU - minU, 1.0f / 6.0f, 1e-6f);
+			}
+
+			// The last column is the first again, at u = 1.
+			const Vertex& first = cylinder.vertices[0];
+			const Vertex& last = cylinder.vertices[12];
+			EXPECT_EQ(first.position, last.position);
+			EXPECT_EQ(first.uv.x, 0.0f);
+			EXPECT_EQ(last.uv.x, 1.0f);
+			EXPECT_EQ(cylinder.vertices[13].uv.y, 1.0f);
+		}
+
+		TEST(MeshDataTest, WriteCylinderRejectsWrongSizes)
+		{
+			std::vector<Vertex> vertices(GetCylinderVertexCount(5));
+			std::vector<unsigned int> indices(GetCylinderIndexCount(5));
+
+			EXPECT_NO_THROW(WriteCylinder(5, 1.0f, 1.0f, {}, vertices, indices));
+			EXPECT_THROW(
+				WriteCylinder(6, 1.0f, 1.0f, {}, vertices, indices),
+				std::invalid_argument);
+			EXPECT_THROW(
+				WriteCylinder(2, 1.0f, 1.0f, {}, vertices, indices),
+				std::invalid_argument);
+		}
+	}
+}
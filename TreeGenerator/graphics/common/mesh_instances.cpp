@@ -0,0 +1,24 @@
+#include "mesh_instances.h"
+
+namespace tree_generator
+{
+	std::size_t GetInstancedVertexCount(std::span<const MeshInstances> sources)
+	{
+		std::size_t count = 0;
+		for (const MeshInstances& source : sources)
+		{
+			count += source.mesh->vertices.size() * source.instances.size();
+		}
+		return count;
+	}
+
+	std::size_t GetInstancedTriangleCount(std::span<const MeshInstances> sources)
+	{
+		std::size_t count = 0;
+		for (const MeshInstances& source : sources)
+		{
+			count += source.mesh->indices.size() / 3 * source.instances.size();
+		}
+		return count;
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef TREE_GENERATOR_MESH_INSTANCES_H_
+#define TREE_GENERATOR_MESH_INSTANCES_H_
+
+#include <cstddef>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "material.h"
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	// Instances of one mesh, drawn with one material, that are read without
+	// being merged into one mesh: by exporters, which transform each
+	// instance as they write it, by the impostor baker and by point cloud
+	// sampling.
+	struct MeshInstances
+	{
+		const MeshData* mesh;
+		std::span<const glm::mat4> instances;
+		Material material;
+	};
+
+	// Total number of vertices and triangles of every instance.
+	std::size_t GetInstancedVertexCount(std::span<const MeshInstances> sources);
+	std::size_t GetInstancedTriangleCount(std::span<const MeshInstances> sources);
+}
+
+#endif  // !TREE_GENERATOR_MESH_INSTANCES_H_
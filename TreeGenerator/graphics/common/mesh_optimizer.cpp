@@ -0,0 +1,453 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+namespace tree_generator
+{
+	static_assert(std::is_same_v<unsigned int, std::uint32_t>,
+		"MeshData indices must be usable as 32-bit indices");
+
+	namespace
+	{
+		constexpr std::uint32_t kNoIndex = std::numeric_limits<std::uint32_t>::max();
+
+		// Parameters of Forsyth's vertex scores. The optimizer models a
+		// larger LRU cache than AnalyzeVertexCache(), which the original
+		// article found works well for smaller FIFO caches too.
+		constexpr int kScoreCacheSize = 32;
+		constexpr float kCacheDecayPower = 1.5f;
+		constexpr float kLastTriangleScore = 0.75f;
+		constexpr float kValenceBoostScale = 2.0f;
+		constexpr float kValenceBoostPower = 0.5f;
+
+		float GetVertexScore(int cachePosition, std::uint32_t remainingTriangles)
+		{
+			if (remainingTriangles == 0)
+			{
+				return -1.0f;
+			}
+
+			float score = 0.0f;
+			if (cachePosition >= 0 && cachePosition < 3)
+			{
+				// The last triangle's vertices score lower than the ones
+				// before it, so that strips don't keep turning back.
+				score = kLastTriangleScore;
+			}
+			else if (cachePosition >= 3)
+			{
+				const float scale = 1.0f / (kScoreCacheSize - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scale, kCacheDecayPower);
+			}
+
+			// Vertices with few triangles left are finished off first, so
+			// that they don't need to be transformed again later.
+			return score + kValenceBoostScale *
+				std::pow(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+		}
+
+		// Simulates a FIFO cache without storing it: a vertex is cached if
+		// fewer than cacheSize misses happened since its own last miss.
+		class FifoCache
+		{
+		public:
+			FifoCache(std::size_t vertexCount, int cacheSize)
+				: timestamps_(vertexCount, 0),
+				cacheSize_(static_cast<std::uint32_t>(cacheSize)),
+				time_(cacheSize_ + 1)
+			{
+			}
+
+			// Returns whether the vertex missed the cache, and adds it if
+			// it did.
+			bool Access(std::uint32_t vertex)
+			{
+				if (time_ - timestamps_[vertex] <= cacheSize_)
+				{
+					return false;
+				}
+				timestamps_[vertex] = time_++;
+				return true;
+			}
+
+			// Returns the number of vertices of the triangle that missed.
+			int AccessTriangle(const std::uint32_t* triangle)
+			{
+				return Access(triangle[0]) + Access(triangle[1]) + Access(triangle[2]);
+			}
+
+			void Clear()
+			{
+				time_ += cacheSize_ + 1;
+			}
+
+		private:
+			std::vector<std::uint32_t> timestamps_;
+			std::uint32_t cacheSize_;
+			std::uint32_t time_;
+		};
+
+		std::size_t GetVertexCount(std::span<const std::uint32_t> indices)
+		{
+			return indices.empty() ? 0 : std::size_t{ *std::max_element(indices.begin(), indices.end()) } + 1;
+		}
+
+		struct Cluster
+		{
+			std::size_t firstTriangle;
+			std::size_t triangleCount;
+			float sortKey;
+		};
+
+		// Splits the triangles where the cache is cold anyway: wherever all
+		// three vertices of a triangle miss it.
+		std::vector<std::size_t> FindHardBoundaries(
+			std::size_t vertexCount, std::span<const std::uint32_t> indices)
+		{
+			std::vector<std::size_t> boundaries;
+			FifoCache cache(vertexCount, kVertexCacheSize);
+			for (std::size_t t = 0; t < indices.size() / 3; ++t)
+			{
+				if (cache.AccessTriangle(&indices[3 * t]) == 3)
+				{
+					boundaries.push_back(t);
+				}
+			}
+			boundaries.push_back(indices.size() / 3);
+			return boundaries;
+		}
+
+		// Splits each hard cluster further wherever the triangles since the
+		// last split, drawn from a cold cache, have an ACMR within threshold
+		// of the whole cluster's.
+		std::vector<Cluster> FindClusters(
+			std::size_t vertexCount,
+			std::span<const std::uint32_t> indices,
+			std::span<const std::size_t> hardBoundaries,
+			float threshold)
+		{
+			std::vector<Cluster> clusters;
+			FifoCache cache(vertexCount, kVertexCacheSize);
+			for (std::size_t b = 0; b + 1 < hardBoundaries.size(); ++b)
+			{
+				const std::size_t first = hardBoundaries[b];
+				const std::size_t end = hardBoundaries[b + 1];
+
+				cache.Clear();
+				int clusterMisses = 0;
+				for (std::size_t t = first; t < end; ++t)
+				{
+					clusterMisses += cache.AccessTriangle(&indices[3 * t]);
+				}
+				const float maxAcmr = threshold * clusterMisses / (end - first);
+
+				cache.Clear();
+				std::size_t start = first;
+				int misses = 0;
+				for (std::size_t t = first; t < end; ++t)
+				{
+					misses += cache.AccessTriangle(&indices[3 * t]);
+					const std::size_t count = t + 1 - start;
+					if (t + 1 < end && misses <= maxAcmr * count)
+					{
+						clusters.push_back({ start, count, 0.0f });
+						start = t + 1;
+						misses = 0;
+						cache.Clear();
+					}
+				}
+				clusters.push_back({ start, end - start, 0.0f });
+			}
+			return clusters;
+		}
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(
+		std::span<const std::uint32_t> indices, int cacheSize)
+	{
+		VertexCacheStatistics statistics;
+		const std::size_t vertexCount = GetVertexCount(indices);
+		if (indices.size() < 3)
+		{
+			return statistics;
+		}
+
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<bool> isReferenced(vertexCount, false);
+		std::size_t referencedCount = 0;
+		std::size_t misses = 0;
+		for (std::uint32_t index : indices)
+		{
+			misses += cache.Access(index);
+			if (!isReferenced[index])
+			{
+				isReferenced[index] = true;
+				++referencedCount;
+			}
+		}
+
+		statistics.acmr = static_cast<float>(misses) / (indices.size() / 3);
+		statistics.atvr = static_cast<float>(misses) / referencedCount;
+		return statistics;
+	}
+
+	void OptimizeVertexCache(std::size_t vertexCount, std::vector<std::uint32_t>* indices)
+	{
+		const std::size_t triangleCount = indices->size() / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		// The triangles not yet emitted that use each vertex are
+		// adjacency[firstAdjacent[v], firstAdjacent[v] + remaining[v]).
+		std::vector<std::uint32_t> remaining(vertexCount, 0);
+		for (std::uint32_t index : *indices)
+		{
+			++remaining[index];
+		}
+		std::vector<std::uint32_t> firstAdjacent(vertexCount + 1, 0);
+		std::partial_sum(remaining.begin(), remaining.end(), firstAdjacent.begin() + 1);
+		std::vector<std::uint32_t> adjacency(indices->size());
+		{
+			std::vector<std::uint32_t> cursor(firstAdjacent.begin(), firstAdjacent.end() - 1);
+			for (std::size_t i = 0; i < indices->size(); ++i)
+			{
+				adjacency[cursor[(*indices)[i]]++] = static_cast<std::uint32_t>(i / 3);
+			}
+		}
+
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (std::size_t v = 0; v < vertexCount; ++v)
+		{
+			vertexScores[v] = GetVertexScore(-1, remaining[v]);
+		}
+		std::vector<float> triangleScores(triangleCount);
+		for (std::size_t t = 0; t < triangleCount; ++t)
+		{
+			triangleScores[t] =
+				vertexScores[(*indices)[3 * t]] +
+				vertexScores[(*indices)[3 * t + 1]] +
+				vertexScores[(*indices)[3 * t + 2]];
+		}
+		std::vector<bool> isEmitted(triangleCount, false);
+
+		std::vector<std::uint32_t> optimized;
+		optimized.reserve(indices->size());
+
+		// The cache holds kScoreCacheSize vertices, plus room for the
+		// vertices that the last triangle pushed out of it.
+		std::array<std::uint32_t, kScoreCacheSize + 3> cache;
+		std::array<std::uint32_t, kScoreCacheSize + 3> nextCache;
+		std::size_t cacheCount = 0;
+
+		std::size_t nextUnemitted = 0;
+		std::uint32_t best = static_cast<std::uint32_t>(std::distance(triangleScores.begin(),
+			std::max_element(triangleScores.begin(), triangleScores.end())));
+		while (best != kNoIndex)
+		{
+			isEmitted[best] = true;
+			const std::uint32_t* triangle = &(*indices)[3 * best];
+			optimized.insert(optimized.end(), triangle, triangle + 3);
+
+			std::size_t nextCount = 0;
+			auto Push = [&nextCache, &nextCount](std::uint32_t vertex, std::size_t searchCount) {
+				if (std::find(nextCache.begin(), nextCache.begin() + searchCount, vertex) ==
+					nextCache.begin() + searchCount)
+				{
+					nextCache[nextCount++] = vertex;
+				}
+				};
+			for (int i = 0; i < 3; ++i)
+			{
+				Push(triangle[i], nextCount);
+			}
+			const std::size_t triangleVertexCount = nextCount;
+			for (std::size_t i = 0; i < cacheCount; ++i)
+			{
+				Push(cache[i], triangleVertexCount);
+			}
+
+			for (int i = 0; i < 3; ++i)
+			{
+				const std::uint32_t vertex = triangle[i];
+				const auto begin = adjacency.begin() + firstAdjacent[vertex];
+				const auto end = begin + remaining[vertex];
+				std::iter_swap(std::find(begin, end, best), end - 1);
+				--remaining[vertex];
+			}
+
+			// Rescore every vertex whose position in the cache changed,
+			// including those pushed out of it, and their triangles.
+			for (std::size_t i = 0; i < nextCount; ++i)
+			{
+				const std::uint32_t vertex = nextCache[i];
+				cachePositions[vertex] = i < kScoreCacheSize ? static_cast<int>(i) : -1;
+				const float score = GetVertexScore(cachePositions[vertex], remaining[vertex]);
+				const float delta = score - vertexScores[vertex];
+				vertexScores[vertex] = score;
+
+				const auto begin = adjacency.begin() + firstAdjacent[vertex];
+				for (auto t = begin; t != begin + remaining[vertex]; ++t)
+				{
+					triangleScores[*t] += delta;
+				}
+			}
+
+			cacheCount = std::min<std::size_t>(nextCount, kScoreCacheSize);
+			std::copy(nextCache.begin(), nextCache.begin() + cacheCount, cache.begin());
+
+			best = kNoIndex;
+			float bestScore = -std::numeric_limits<float>::infinity();
+			for (std::size_t i = 0; i < cacheCount; ++i)
+			{
+				const std::uint32_t vertex = cache[i];
+				const auto begin = adjacency.begin() + firstAdjacent[vertex];
+				for (auto t = begin; t != begin + remaining[vertex]; ++t)
+				{
+					if (triangleScores[*t] > bestScore)
+					{
+						best = *t;
+						bestScore = triangleScores[*t];
+					}
+				}
+			}
+
+			// Nothing in the cache has triangles left, so any triangle is
+			// as good as another.
+			if (best == kNoIndex)
+			{
+				while (nextUnemitted < triangleCount && isEmitted[nextUnemitted])
+				{
+					++nextUnemitted;
+				}
+				if (nextUnemitted < triangleCount)
+				{
+					best = static_cast<std::uint32_t>(nextUnemitted);
+				}
+			}
+		}
+
+		*indices = std::move(optimized);
+	}
+
+	void OptimizeOverdraw(
+		std::span<const Vertex> vertices,
+		std::vector<std::uint32_t>* indices,
+		float threshold)
+	{
+		const std::size_t triangleCount = indices->size() / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		std::vector<Cluster> clusters = FindClusters(
+			vertices.size(),
+			*indices,
+			FindHardBoundaries(vertices.size(), *indices),
+			threshold);
+		if (clusters.size() == 1)
+		{
+			return;
+		}
+
+		// Clusters facing away from the mesh's center are on its outside,
+		// and drawn first.
+		auto GetPosition = [&vertices, indices](std::size_t t, int corner) {
+			return vertices[(*indices)[3 * t + corner]].position;
+			};
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		std::vector<glm::vec3> clusterCentroids(clusters.size());
+		std::vector<glm::vec3> clusterNormals(clusters.size());
+		for (std::size_t c = 0; c < clusters.size(); ++c)
+		{
+			glm::vec3 centroid(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+			for (std::size_t t = clusters[c].firstTriangle;
+				t < clusters[c].firstTriangle + clusters[c].triangleCount;
+				++t)
+			{
+				const glm::vec3 p0 = GetPosition(t, 0);
+				const glm::vec3 p1 = GetPosition(t, 1);
+				const glm::vec3 p2 = GetPosition(t, 2);
+				const glm::vec3 scaledNormal = glm::cross(p1 - p0, p2 - p0);
+				const float triangleArea = glm::length(scaledNormal);
+				centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+				normal += scaledNormal;
+				area += triangleArea;
+			}
+
+			meshCentroid += centroid;
+			meshArea += area;
+			clusterCentroids[c] = area > 0.0f ? centroid / area : centroid;
+			const float normalLength = glm::length(normal);
+			clusterNormals[c] = normalLength > 0.0f ? normal / normalLength : normal;
+		}
+		if (meshArea > 0.0f)
+		{
+			meshCentroid /= meshArea;
+		}
+
+		for (std::size_t c = 0; c < clusters.size(); ++c)
+		{
+			clusters[c].sortKey = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+		}
+		std::stable_sort(clusters.begin(), clusters.end(),
+			[](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<std::uint32_t> sorted;
+		sorted.reserve(indices->size());
+		for (const Cluster& cluster : clusters)
+		{
+			const auto first = indices->begin() + 3 * cluster.firstTriangle;
+			sorted.insert(sorted.end(), first, first + 3 * cluster.triangleCount);
+		}
+		*indices = std::move(sorted);
+	}
+
+	void OptimizeVertexFetch(std::vector<Vertex>* vertices, std::vector<std::uint32_t>* indices)
+	{
+		std::vector<std::uint32_t> remap(vertices->size(), kNoIndex);
+		std::vector<Vertex> reordered;
+		reordered.reserve(vertices->size());
+		for (std::uint32_t& index : *indices)
+		{
+			if (remap[index] == kNoIndex)
+			{
+				remap[index] = static_cast<std::uint32_t>(reordered.size());
+				reordered.push_back((*vertices)[index]);
+			}
+			index = remap[index];
+		}
+		*vertices = std::move(reordered);
+	}
+
+	MeshOptimizationReport OptimizeMesh(
+		std::vector<Vertex>* vertices, std::vector<std::uint32_t>* indices)
+	{
+		MeshOptimizationReport report;
+		report.before = AnalyzeVertexCache(*indices);
+		OptimizeVertexCache(vertices->size(), indices);
+		OptimizeOverdraw(*vertices, indices);
+		OptimizeVertexFetch(vertices, indices);
+		report.after = AnalyzeVertexCache(*indices);
+		return report;
+	}
+
+	MeshOptimizationReport OptimizeMesh(MeshData* mesh)
+	{
+		return OptimizeMesh(&mesh->vertices, &mesh->indices);
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef TREE_GENERATOR_MESH_OPTIMIZER_H_
+#define TREE_GENERATOR_MESH_OPTIMIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	// Size of the FIFO post-transform cache that AnalyzeVertexCache()
+	// simulates by default, a conservative estimate for current GPUs.
+	constexpr int kVertexCacheSize = 16;
+
+	// How well a triangle list reuses transformed vertices.
+	struct VertexCacheStatistics
+	{
+		// Average cache miss ratio: vertices transformed per triangle,
+		// between 0.5 for an ideal mesh and 3 when nothing is reused.
+		float acmr = 0.0f;
+
+		// Average transform to vertex ratio: vertices transformed per
+		// vertex referenced, 1 when every vertex is transformed only once.
+		float atvr = 0.0f;
+	};
+
+	struct MeshOptimizationReport
+	{
+		VertexCacheStatistics before;
+		VertexCacheStatistics after;
+	};
+
+	// Simulates drawing the triangle list through a FIFO cache of
+	// cacheSize vertices.
+	VertexCacheStatistics AnalyzeVertexCache(
+		std::span<const std::uint32_t> indices, int cacheSize = kVertexCacheSize);
+
+	// Reorders the triangles so that consecutive triangles share vertices,
+	// with Forsyth's "Linear-Speed Vertex Cache Optimisation". Vertices
+	// are only read through `indices`, so any vertex layout works.
+	void OptimizeVertexCache(std::size_t vertexCount, std::vector<std::uint32_t>* indices);
+
+	// Reorders clusters of triangles so that the outermost are drawn first
+	// and hide what is behind them, following Sander et al., "Fast Triangle
+	// Reordering for Vertex Locality and Reduced Overdraw". The indices
+	// should already be optimized for the vertex cache; clusters are split
+	// wherever that order misses the cache anyway, and elsewhere only as
+	// long as the ACMR stays within `threshold` times the original.
+	void OptimizeOverdraw(
+		std::span<const Vertex> vertices,
+		std::vector<std::uint32_t>* indices,
+		float threshold = 1.05f);
+
+	// Reorders the vertices in the order the indices first use them, and
+	// drops unused vertices, so that vertex fetches read memory in order.
+	void OptimizeVertexFetch(std::vector<Vertex>* vertices, std::vector<std::uint32_t>* indices);
+
+	// Optimizes the mesh for the vertex cache, overdraw and vertex fetch,
+	// in that order, without changing the triangles drawn.
+	MeshOptimizationReport OptimizeMesh(
+		std::vector<Vertex>* vertices, std::vector<std::uint32_t>* indices);
+	MeshOptimizationReport OptimizeMesh(MeshData* mesh);
+}
+
+#endif  // !TREE_GENERATOR_MESH_OPTIMIZER_H_
@@ -0,0 +1,69 @@
+#include "mesh_optimizer.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "mesh_baker.h"
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr std::size_t kSegmentsPerBranch = 64;
+
+		// Straight branches of stacked cylinders merged into one mesh and
+		// welded, like a baked tree's: each segment shares its bottom ring
+		// with the top of the one below.
+		MeshData CreateBakedBranches(std::size_t segmentCount)
+		{
+			const MeshData cylinder = CreateCylinder(8);
+			MeshData mesh;
+			mesh.vertices.resize(segmentCount * cylinder.vertices.size());
+			mesh.indices.resize(segmentCount * cylinder.indices.size());
+			for (std::size_t i = 0; i < segmentCount; ++i)
+			{
+				const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(
+					3.0f * (i / kSegmentsPerBranch),
+					static_cast<float>(i % kSegmentsPerBranch),
+					0.0f));
+				BakeInstance(
+					cylinder,
+					model,
+					static_cast<std::uint32_t>(i * cylinder.vertices.size()),
+					&mesh.vertices[i * cylinder.vertices.size()],
+					&mesh.indices[i * cylinder.indices.size()]);
+			}
+			WeldVertices(1e-5f, &mesh.vertices, &mesh.indices);
+			return mesh;
+		}
+
+		void BM_OptimizeMesh(benchmark::State& state)
+		{
+			const MeshData baked = CreateBakedBranches(state.range(0));
+
+			MeshOptimizationReport report;
+			for (auto _ : state)
+			{
+				state.PauseTiming();
+				MeshData mesh = baked;
+				state.ResumeTiming();
+
+				report = OptimizeMesh(&mesh);
+				benchmark::DoNotOptimize(mesh.indices.data());
+			}
+			state.SetItemsProcessed(state.iterations() * baked.indices.size() / 3);
+			state.counters["acmr_before"] = report.before.acmr;
+			state.counters["acmr_after"] = report.after.acmr;
+			state.counters["atvr_before"] = report.before.atvr;
+			state.counters["atvr_after"] = report.after.atvr;
+		}
+
+		BENCHMARK(BM_OptimizeMesh)->Arg(1 << 10)->Arg(1 << 14)->Unit(benchmark::kMillisecond);
+	}
+}
@@ -0,0 +1,205 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "mesh_data.h"
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+namespace tree_generator
+{
+	namespace
+	{
+		using Triangle = std::array<std::uint32_t, 3>;
+
+		// A size x size grid of quads in the xy plane, with its triangles
+		// shuffled. Each vertex's uv.x is its original index, so triangles
+		// can be recognized after the vertices are reordered.
+		MeshData CreateShuffledGrid(int size)
+		{
+			MeshData mesh;
+			for (int y = 0; y <= size; ++y)
+			{
+				for (int x = 0; x <= size; ++x)
+				{
+					mesh.vertices.push_back({
+						glm::vec3(x, y, 0.0f),
+						glm::vec3(0.0f, 0.0f, 1.0f),
+						glm::vec2(static_cast<float>(mesh.vertices.size()), 0.0f) });
+				}
+			}
+
+			std::vector<Triangle> triangles;
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					const std::uint32_t bottomLeft = y * (size + 1) + x;
+					const std::uint32_t topLeft = bottomLeft + size + 1;
+					triangles.push_back({ bottomLeft, bottomLeft + 1, topLeft });
+					triangles.push_back({ topLeft, bottomLeft + 1, topLeft + 1 });
+				}
+			}
+			std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+			for (const Triangle& triangle : triangles)
+			{
+				mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+			}
+			return mesh;
+		}
+
+		// Returns the mesh's triangles by the original indices of their
+		// vertices, each rotated to start at its smallest index, sorted.
+		std::vector<Triangle> GetTriangles(const MeshData& mesh)
+		{
+			std::vector<Triangle> triangles;
+			for (std::size_t i = 0; i < mesh.indices.size(); i += 3)
+			{
+				Triangle triangle;
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					triangle[corner] = static_cast<std::uint32_t>(
+						mesh.vertices[mesh.indices[i + corner]].uv.x);
+				}
+				std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+				triangles.push_back(triangle);
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		}
+
+		TEST(MeshOptimizerTest, AnalyzeVertexCacheCountsMisses)
+		{
+			const std::vector<std::uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+
+			const VertexCacheStatistics statistics = AnalyzeVertexCache(indices);
+
+			EXPECT_FLOAT_EQ(statistics.acmr, 2.0f);
+			EXPECT_FLOAT_EQ(statistics.atvr, 1.0f);
+		}
+
+		TEST(MeshOptimizerTest, AnalyzeVertexCacheEvictsOldestVertex)
+		{
+			// With room for three vertices, vertex 0 is evicted by vertex 3
+			// and missed again.
+			const std::vector<std::uint32_t> indices = { 0, 1, 2, 1, 2, 3, 0, 2, 3 };
+
+			const VertexCacheStatistics statistics = AnalyzeVertexCache(indices, 3);
+
+			EXPECT_FLOAT_EQ(statistics.acmr, 5.0f / 3.0f);
+			EXPECT_FLOAT_EQ(statistics.atvr, 5.0f / 4.0f);
+		}
+
+		TEST(MeshOptimizerTest, OptimizeVertexCacheKeepsTrianglesAndImprovesAcmr)
+		{
+			MeshData mesh = CreateShuffledGrid(32);
+			const std::vector<Triangle> expected = GetTriangles(mesh);
+			const VertexCacheStatistics before = AnalyzeVertexCache(mesh.indices);
+
+			OptimizeVertexCache(mesh.vertices.size(), &mesh.indices);
+
+			EXPECT_THAT(GetTriangles(mesh), ElementsAreArray(expected));
+			const VertexCacheStatistics after = AnalyzeVertexCache(mesh.indices);
+			EXPECT_LT(after.acmr, before.acmr);
+			// A grid's ideal ACMR is 0.5, and Forsyth's order comes within
+			// about 0.2 of it with a small cache.
+			EXPECT_LT(after.acmr, 0.8f);
+		}
+
+		TEST(MeshOptimizerTest, OptimizeOverdrawKeepsTrianglesWithinThreshold)
+		{
+			MeshData mesh = CreateShuffledGrid(32);
+			OptimizeVertexCache(mesh.vertices.size(), &mesh.indices);
+			const std::vector<Triangle> expected = GetTriangles(mesh);
+			const VertexCacheStatistics before = AnalyzeVertexCache(mesh.indices);
+
+			OptimizeOverdraw(mesh.vertices, &mesh.indices, 1.05f);
+
+			EXPECT_THAT(GetTriangles(mesh), ElementsAreArray(expected));
+			// Reordering clusters costs a few misses at their boundaries.
+			EXPECT_LT(AnalyzeVertexCache(mesh.indices).acmr, 1.1f * before.acmr);
+		}
+
+		TEST(MeshOptimizerTest, OptimizeOverdrawDrawsOutsideFirst)
+		{
+			// Two copies of a quad facing +z, one behind the other, drawn
+			// back to front.
+			MeshData mesh;
+			for (float z : { -1.0f, 1.0f })
+			{
+				const std::uint32_t first = static_cast<std::uint32_t>(mesh.vertices.size());
+				for (glm::vec2 corner : { glm::vec2(0, 0), glm::vec2(1, 0), glm::vec2(0, 1), glm::vec2(1, 1) })
+				{
+					mesh.vertices.push_back({
+						glm::vec3(corner, z), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f) });
+				}
+				for (std::uint32_t index : { 0, 1, 2, 2, 1, 3 })
+				{
+					mesh.indices.push_back(first + index);
+				}
+			}
+
+			OptimizeOverdraw(mesh.vertices, &mesh.indices, 1.05f);
+
+			EXPECT_THAT(mesh.indices, ElementsAre(4, 5, 6, 6, 5, 7, 0, 1, 2, 2, 1, 3));
+		}
+
+		TEST(MeshOptimizerTest, OptimizeVertexFetchOrdersVerticesByFirstUse)
+		{
+			std::vector<Vertex> vertices(5);
+			for (std::size_t i = 0; i < vertices.size(); ++i)
+			{
+				vertices[i].uv.x = static_cast<float>(i);
+			}
+			std::vector<std::uint32_t> indices = { 3, 1, 4, 4, 1, 0 };
+
+			OptimizeVertexFetch(&vertices, &indices);
+
+			EXPECT_THAT(indices, ElementsAre(0, 1, 2, 2, 1, 3));
+			ASSERT_EQ(vertices.size(), 4);
+			EXPECT_FLOAT_EQ(vertices[0].uv.x, 3.0f);
+			EXPECT_FLOAT_EQ(vertices[1].uv.x, 1.0f);
+			EXPECT_FLOAT_EQ(vertices[2].uv.x, 4.0f);
+			EXPECT_FLOAT_EQ(vertices[3].uv.x, 0.0f);
+		}
+
+		TEST(MeshOptimizerTest, OptimizeMeshReportsStatisticsBeforeAndAfter)
+		{
+			MeshData mesh = CreateShuffledGrid(32);
+			const std::vector<Triangle> expected = GetTriangles(mesh);
+			const VertexCacheStatistics before = AnalyzeVertexCache(mesh.indices);
+
+			const MeshOptimizationReport report = OptimizeMesh(&mesh);
+
+			EXPECT_THAT(GetTriangles(mesh), ElementsAreArray(expected));
+			EXPECT_FLOAT_EQ(report.before.acmr, before.acmr);
+			EXPECT_FLOAT_EQ(report.before.atvr, before.atvr);
+			EXPECT_FLOAT_EQ(report.after.acmr, AnalyzeVertexCache(mesh.indices).acmr);
+			EXPECT_LT(report.after.acmr, report.before.acmr);
+			EXPECT_LT(report.after.atvr, report.before.atvr);
+		}
+
+		TEST(MeshOptimizerTest, OptimizeMeshAcceptsEmptyMesh)
+		{
+			MeshData mesh;
+
+			const MeshOptimizationReport report = OptimizeMesh(&mesh);
+
+			EXPECT_THAT(mesh.vertices, IsEmpty());
+			EXPECT_THAT(mesh.indices, IsEmpty());
+			EXPECT_EQ(report.before.acmr, 0.0f);
+			EXPECT_EQ(report.after.acmr, 0.0f);
+		}
+	}
+}
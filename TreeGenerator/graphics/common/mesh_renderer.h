@@ -1,10 +1,14 @@
 #ifndef TREE_GENERATOR_MESH_RENDERER_H_
 #define TREE_GENERATOR_MESH_RENDERER_H_
 
+#include <span>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include "material.h"
 #include "mesh_data.h"
+#include "packed_mesh.h"
 #include "transform.h"
 
 namespace tree_generator
@@ -25,6 +29,34 @@ namespace tree_generator
 		virtual void SetMeshData(
 			const MeshData& meshData, const std::vector<Transform>& instances) = 0;
 
+		// Uploads the model matrices as-is, without recomputing them from
+		// transforms or copying them into an intermediate buffer.
+		virtual void SetMeshData(
+			const MeshData& meshData, std::span<const glm::mat4> instances) = 0;
+
+		// Draws every local instance once per placement, with the model matrix
+		// placement * local, without expanding the instances on the CPU.
+		virtual void SetMeshData(
+			const MeshData& meshData,
+			std::span<const glm::mat4> localInstances,
+			std::span<const glm::mat4> placements) = 0;
+
+		// Uploads a quantized mesh, which takes half the memory of a
+		// MeshData's, drawn with the model matrices.
+		virtual void SetMeshData(
+			const PackedMesh& meshData, std::span<const glm::mat4> instances) = 0;
+
+		// Replaces the instances of a mesh set with complete model matrices,
+		// keeping the mesh itself. Meant for uploading the visible instances
+		// after culling, which can change every frame.
+		virtual void SetInstances(std::span<const glm::mat4> instances) = 0;
+
+		// Replaces the mesh of a mesh set with complete model matrices,
+		// keeping its instances, so that editing a mesh doesn't upload them
+		// again.
+		virtual void SetMesh(const MeshData& meshData) = 0;
+		virtual void SetMesh(const PackedMesh& meshData) = 0;
+
 		virtual void SetMaterial(Material material) = 0;
 
 		virtual void Render(RenderMode mode) = 0;
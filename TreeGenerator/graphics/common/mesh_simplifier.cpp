@@ -0,0 +1,799 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+namespace tree_generator
+{
+	namespace
+	{
+		// How much more a vertex resists moving off its open edges and
+		// feature edges than off its triangles' planes.
+		constexpr double kBorderWeight = 10.0;
+		constexpr double kFeatureWeight = 4.0;
+
+		// Cosine of the furthest a collapse may turn any triangle.
+		constexpr double kMinNormalCos = 0.25;
+
+		// Sum of weighted squared distances to a set of planes, as a
+		// symmetric 4x4 matrix.
+		struct Quadric
+		{
+			double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+			double b2 = 0.0, bc = 0.0, bd = 0.0;
+			double c2 = 0.0, cd = 0.0;
+			double d2 = 0.0;
+			double weight = 0.0;
+
+			// Adds the plane through `point` with the unit normal.
+			void AddPlane(glm::dvec3 normal, glm::dvec3 point, double planeWeight)
+			{
+				const double d = -glm::dot(normal, point);
+				a2 += planeWeight * normal.x * normal.x;
+				ab += planeWeight * normal.x * normal.y;
+				ac += planeWeight * normal.x * normal.z;
+				ad += planeWeight * normal.x * d;
+				b2 += planeWeight * normal.y * normal.y;
+				bc += planeWeight * normal.y * normal.z;
+				bd += planeWeight * normal.y * d;
+				c2 += planeWeight * normal.z * normal.z;
+				cd += planeWeight * normal.z * d;
+				d2 += planeWeight * d * d;
+				weight += planeWeight;
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+				b2 += other.b2; bc += other.bc; bd += other.bd;
+				c2 += other.c2; cd += other.cd;
+				d2 += other.d2;
+				weight += other.weight;
+				return *this;
+			}
+
+			// Returns the root mean square distance of the point to the
+			// planes.
+			double GetError(glm::dvec3 p) const
+			{
+				if (weight <= 0.0)
+				{
+					return 0.0;
+				}
+				const double error =
+					a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x +
+					b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y +
+					c2 * p.z * p.z + 2.0 * cd * p.z +
+					d2;
+				return std::sqrt(std::max(error, 0.0) / weight);
+			}
+		};
+
+		// How a point, the vertices at one position, may move. Points whose
+		// vertices differ in their other attributes are seams, and move along
+		// the seam with every vertex at once; points where the surface
+		// branches or seams cross are locked.
+		enum class PointKind
+		{
+			Manifold,
+			Border,
+			Seam,
+			Locked,
+		};
+
+		// Collapses run between vertices, but are checked and applied to
+		// their whole points.
+		struct Collapse
+		{
+			double error;
+			std::uint32_t from;
+			std::uint32_t to;
+			std::uint32_t fromVersion;
+			std::uint32_t toVersion;
+
+			bool operator>(const Collapse& other) const { return error > other.error; }
+		};
+
+		std::uint64_t GetEdgeKey(std::uint32_t from, std::uint32_t to)
+		{
+			return (std::uint64_t{ from } << 32) | to;
+		}
+
+		struct PositionHash
+		{
+			std::size_t operator()(const glm::vec3& position) const
+			{
+				std::size_t hash = std::hash<float>()(position.x);
+				hash ^= std::hash<float>()(position.y) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+				hash ^= std::hash<float>()(position.z) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+				return hash;
+			}
+		};
+
+		class Simplifier
+		{
+		public:
+			Simplifier(
+				const SimplifyOptions& options,
+				std::vector<Vertex>* vertices,
+				std::vector<std::uint32_t>* indices)
+				: options_(options),
+				vertices_(*vertices),
+				indices_(*indices),
+				points_(vertices->size()),
+				nextWedges_(vertices->size()),
+				isTriangleRemoved_(indices->size() / 3, false),
+				triangleCount_(indices->size() / 3)
+			{
+				FindPoints();
+
+				// Triangles that use a point twice have no area to keep, and
+				// would confuse the adjacency.
+				for (std::uint32_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					const std::uint32_t p0 = points_[indices_[3 * t]];
+					const std::uint32_t p1 = points_[indices_[3 * t + 1]];
+					const std::uint32_t p2 = points_[indices_[3 * t + 2]];
+					if (p0 == p1 || p1 == p2 || p2 == p0)
+					{
+						isTriangleRemoved_[t] = true;
+						--triangleCount_;
+						continue;
+					}
+					pointTriangles_[p0].push_back(t);
+					pointTriangles_[p1].push_back(t);
+					pointTriangles_[p2].push_back(t);
+				}
+				ClassifyPoints();
+				AddQuadrics();
+				for (std::uint32_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					if (isTriangleRemoved_[t])
+					{
+						continue;
+					}
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const std::uint32_t a = indices_[3 * t + corner];
+						const std::uint32_t b = indices_[3 * t + (corner + 1) % 3];
+						PushCollapse(a, b);
+						PushCollapse(b, a);
+					}
+				}
+			}
+
+			float Simplify()
+			{
+				double maxError = 0.0;
+				while (triangleCount_ > options_.targetTriangleCount && !collapses_.empty())
+				{
+					const Collapse collapse = collapses_.top();
+					collapses_.pop();
+					if (collapse.error > options_.maxError)
+					{
+						break;
+					}
+					const std::uint32_t from = points_[collapse.from];
+					const std::uint32_t to = points_[collapse.to];
+					if (isPointRemoved_[from] ||
+						isPointRemoved_[to] ||
+						versions_[from] != collapse.fromVersion ||
+						versions_[to] != collapse.toVersion ||
+						!CanCollapse(collapse.from, collapse.to))
+					{
+						continue;
+					}
+
+					DoCollapse(collapse.from, collapse.to);
+					maxError = std::max(maxError, collapse.error);
+				}
+				if (options_.doRemoveParts && triangleCount_ > options_.targetTriangleCount)
+				{
+					maxError = std::max(maxError, RemoveParts());
+				}
+				Compact();
+				return static_cast<float>(maxError);
+			}
+
+		private:
+			glm::dvec3 GetPosition(std::uint32_t vertex) const
+			{
+				return glm::dvec3(vertices_[vertex].position);
+			}
+
+			// Groups the vertices by position. The vertices of each point,
+			// its wedges, form a ring through nextWedges_.
+			void FindPoints()
+			{
+				std::unordered_map<glm::vec3, std::uint32_t, PositionHash> firstVertices;
+				firstVertices.reserve(vertices_.size());
+				std::uint32_t pointCount = 0;
+				for (std::uint32_t v = 0; v < vertices_.size(); ++v)
+				{
+					auto [first, isInserted] = firstVertices.try_emplace(vertices_[v].position, v);
+					if (isInserted)
+					{
+						points_[v] = pointCount++;
+						nextWedges_[v] = v;
+						continue;
+					}
+					points_[v] = points_[first->second];
+					nextWedges_[v] = nextWedges_[first->second];
+					nextWedges_[first->second] = v;
+				}
+				pointKinds_.resize(pointCount, PointKind::Manifold);
+				quadrics_.resize(pointCount);
+				pointTriangles_.resize(pointCount);
+				versions_.resize(pointCount, 0);
+				isPointRemoved_.resize(pointCount, false);
+			}
+
+			// A point is on the border where the surface is open, and on a
+			// seam where only its vertices' attributes split: each of a seam
+			// point's two vertices has one open edge in and one out, along
+			// the same positions as the other's. Anything else is locked, as
+			// are borders if the options say so.
+			void ClassifyPoints()
+			{
+				std::unordered_map<std::uint64_t, std::uint32_t> vertexEdges;
+				std::unordered_map<std::uint64_t, std::uint32_t> pointEdges;
+				vertexEdges.reserve(indices_.size());
+				pointEdges.reserve(indices_.size());
+				ForEachEdge([&](std::uint32_t a, std::uint32_t b) {
+					++vertexEdges[GetEdgeKey(a, b)];
+					++pointEdges[GetEdgeKey(points_[a], points_[b])];
+					});
+
+				// The far end of each vertex's open edges, or kNone if it has
+				// none, or kMany if it has more than one.
+				constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+				constexpr std::uint32_t kMany = kNone - 1;
+				auto addOpenEdge = [](std::uint32_t* end, std::uint32_t other) {
+					*end = *end == kNone ? other : kMany;
+					};
+				std::vector<std::uint32_t> openOut(vertices_.size(), kNone);
+				std::vector<std::uint32_t> openIn(vertices_.size(), kNone);
+				std::vector<int> pointOpenOut(pointKinds_.size(), 0);
+				std::vector<int> pointOpenIn(pointKinds_.size(), 0);
+				ForEachEdge([&](std::uint32_t a, std::uint32_t b) {
+					if (!pointEdges.contains(GetEdgeKey(points_[b], points_[a])))
+					{
+						++pointOpenOut[points_[a]];
+						++pointOpenIn[points_[b]];
+					}
+					if (!vertexEdges.contains(GetEdgeKey(b, a)))
+					{
+						addOpenEdge(&openOut[a], b);
+						addOpenEdge(&openIn[b], a);
+					}
+					});
+
+				std::vector<bool> isClassified(pointKinds_.size(), false);
+				for (std::uint32_t v = 0; v < vertices_.size(); ++v)
+				{
+					const std::uint32_t point = points_[v];
+					if (isClassified[point])
+					{
+						continue;
+					}
+					isClassified[point] = true;
+
+					const bool isClosed = pointOpenOut[point] == 0 && pointOpenIn[point] == 0;
+					const std::uint32_t wedge = nextWedges_[v];
+					PointKind& kind = pointKinds_[point];
+					if (wedge == v)
+					{
+						if (isClosed)
+						{
+							kind = PointKind::Manifold;
+						}
+						else if (pointOpenOut[point] == 1 && pointOpenIn[point] == 1)
+						{
+							kind = options_.doLockBorders ? PointKind::Locked : PointKind::Border;
+						}
+						else
+						{
+							kind = PointKind::Locked;
+						}
+						continue;
+					}
+
+					auto isOpenEnd = [kNone, kMany](std::uint32_t end) {
+						return end != kNone && end != kMany;
+						};
+					const bool isSeam =
+						isClosed &&
+						nextWedges_[wedge] == v &&
+						isOpenEnd(openOut[v]) && isOpenEnd(openIn[v]) &&
+						isOpenEnd(openOut[wedge]) && isOpenEnd(openIn[wedge]) &&
+						points_[openOut[v]] == points_[openIn[wedge]] &&
+						points_[openIn[v]] == points_[openOut[wedge]];
+					kind = isSeam ? PointKind::Seam : PointKind::Locked;
+				}
+			}
+
+			template <typename Function>
+			void ForEachEdge(Function function) const
+			{
+				for (std::uint32_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					if (isTriangleRemoved_[t])
+					{
+						continue;
+					}
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						function(indices_[3 * t + corner], indices_[3 * t + (corner + 1) % 3]);
+					}
+				}
+			}
+
+			void AddQuadrics()
+			{
+				std::unordered_map<std::uint64_t, std::uint32_t> edgeTriangles;
+				edgeTriangles.reserve(indices_.size());
+				std::vector<glm::dvec3> normals(isTriangleRemoved_.size());
+				for (std::uint32_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					if (isTriangleRemoved_[t])
+					{
+						continue;
+					}
+					const glm::dvec3 p0 = GetPosition(indices_[3 * t]);
+					const glm::dvec3 p1 = GetPosition(indices_[3 * t + 1]);
+					const glm::dvec3 p2 = GetPosition(indices_[3 * t + 2]);
+					const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+					const double length = glm::length(normal);
+					if (length <= 0.0)
+					{
+						continue;
+					}
+					normals[t] = normal / length;
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const std::uint32_t a = points_[indices_[3 * t + corner]];
+						const std::uint32_t b = points_[indices_[3 * t + (corner + 1) % 3]];
+						quadrics_[a].AddPlane(normals[t], p0, 1.0);
+						edgeTriangles.emplace(GetEdgeKey(a, b), t);
+					}
+				}
+
+				// Edges on the border or a crease are held in place by a plane
+				// through them, perpendicular to their triangle.
+				const double minFeatureCos = std::cos(glm::radians(static_cast<double>(options_.featureAngle)));
+				for (std::uint32_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					if (isTriangleRemoved_[t])
+					{
+						continue;
+					}
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const std::uint32_t a = indices_[3 * t + corner];
+						const std::uint32_t b = indices_[3 * t + (corner + 1) % 3];
+						auto other = edgeTriangles.find(GetEdgeKey(points_[b], points_[a]));
+
+						double weight = 0.0;
+						if (other == edgeTriangles.end())
+						{
+							weight = kBorderWeight;
+						}
+						else if (glm::dot(normals[t], normals[other->second]) < minFeatureCos)
+						{
+							weight = kFeatureWeight;
+						}
+						const glm::dvec3 edge = GetPosition(b) - GetPosition(a);
+						const glm::dvec3 constraint = glm::cross(edge, normals[t]);
+						const double length = glm::length(constraint);
+						if (weight > 0.0 && length > 0.0)
+						{
+							quadrics_[points_[a]].AddPlane(constraint / length, GetPosition(a), weight);
+							quadrics_[points_[b]].AddPlane(constraint / length, GetPosition(a), weight);
+						}
+					}
+				}
+			}
+
+			void PushCollapse(std::uint32_t from, std::uint32_t to)
+			{
+				const std::uint32_t fromPoint = points_[from];
+				const std::uint32_t toPoint = points_[to];
+				const PointKind kind = pointKinds_[fromPoint];
+				if (kind == PointKind::Locked ||
+					(kind == PointKind::Seam && pointKinds_[toPoint] != PointKind::Seam))
+				{
+					return;
+				}
+				Quadric quadric = quadrics_[fromPoint];
+				quadric += quadrics_[toPoint];
+				collapses_.push({
+					quadric.GetError(GetPosition(to)),
+					from,
+					to,
+					versions_[fromPoint],
+					versions_[toPoint] });
+			}
+
+			bool HasPoint(std::uint32_t triangle, std::uint32_t point) const
+			{
+				return points_[indices_[3 * triangle]] == point ||
+					points_[indices_[3 * triangle + 1]] == point ||
+					points_[indices_[3 * triangle + 2]] == point;
+			}
+
+			bool HasVertex(std::uint32_t triangle, std::uint32_t vertex) const
+			{
+				return indices_[3 * triangle] == vertex ||
+					indices_[3 * triangle + 1] == vertex ||
+					indices_[3 * triangle + 2] == vertex;
+			}
+
+			// Number of the point's triangles that use both vertices.
+			int CountEdgeTriangles(std::uint32_t point, std::uint32_t a, std::uint32_t b) const
+			{
+				int count = 0;
+				for (std::uint32_t t : pointTriangles_[point])
+				{
+					count += HasVertex(t, a) && HasVertex(t, b);
+				}
+				return count;
+			}
+
+			void GetNeighbors(std::uint32_t point, std::vector<std::uint32_t>* neighbors) const
+			{
+				neighbors->clear();
+				for (std::uint32_t t : pointTriangles_[point])
+				{
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const std::uint32_t other = points_[indices_[3 * t + corner]];
+						if (other != point)
+						{
+							neighbors->push_back(other);
+						}
+					}
+				}
+				std::sort(neighbors->begin(), neighbors->end());
+				neighbors->erase(std::unique(neighbors->begin(), neighbors->end()), neighbors->end());
+			}
+
+			bool CanCollapse(std::uint32_t from, std::uint32_t to)
+			{
+				const std::uint32_t fromPoint = points_[from];
+				const std::uint32_t toPoint = points_[to];
+				int sharedTriangleCount = 0;
+				for (std::uint32_t t : pointTriangles_[fromPoint])
+				{
+					sharedTriangleCount += HasPoint(t, toPoint);
+				}
+				if (sharedTriangleCount == 0)
+				{
+					return false;
+				}
+
+				// Border points may only slide along the border, and seam
+				// points along the seam, with the vertices on both of its
+				// sides moving along their own open edge.
+				const PointKind kind = pointKinds_[fromPoint];
+				if (kind == PointKind::Border && sharedTriangleCount != 1)
+				{
+					return false;
+				}
+				if (kind == PointKind::Seam &&
+					(sharedTriangleCount != 2 ||
+						CountEdgeTriangles(fromPoint, from, to) != 1 ||
+						CountEdgeTriangles(fromPoint, nextWedges_[from], nextWedges_[to]) != 1))
+				{
+					return false;
+				}
+
+				// The edge's points must have no neighbors in common other
+				// than across the edge's triangles, or the collapse would join
+				// two parts of the surface into a non-manifold edge.
+				GetNeighbors(fromPoint, &fromNeighbors_);
+				GetNeighbors(toPoint, &toNeighbors_);
+				sharedNeighbors_.clear();
+				std::set_intersection(
+					fromNeighbors_.begin(), fromNeighbors_.end(),
+					toNeighbors_.begin(), toNeighbors_.end(),
+					std::back_inserter(sharedNeighbors_));
+				if (static_cast<int>(sharedNeighbors_.size()) != sharedTriangleCount)
+				{
+					return false;
+				}
+
+				// No remaining triangle may turn too far, which would fold the
+				// surface over, or become degenerate.
+				const glm::dvec3 target = GetPosition(to);
+				for (std::uint32_t t : pointTriangles_[fromPoint])
+				{
+					if (HasPoint(t, toPoint))
+					{
+						continue;
+					}
+					glm::dvec3 before[3];
+					glm::dvec3 after[3];
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const std::uint32_t vertex = indices_[3 * t + corner];
+						before[corner] = GetPosition(vertex);
+						after[corner] = points_[vertex] == fromPoint ? target : before[corner];
+					}
+					const glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					const glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					if (glm::dot(normalBefore, normalAfter) <=
+						kMinNormalCos * glm::length(normalBefore) * glm::length(normalAfter))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			void DoCollapse(std::uint32_t from, std::uint32_t to)
+			{
+				const std::uint32_t fromPoint = points_[from];
+				const std::uint32_t toPoint = points_[to];
+
+				// A seam's other vertex moves onto the other side's vertex at
+				// the target, which CanCollapse() made sure it has an edge to.
+				const std::uint32_t otherFrom = nextWedges_[from];
+				const std::uint32_t otherTo = nextWedges_[to];
+				auto getTarget = [&](std::uint32_t vertex) {
+					return vertex == otherFrom && vertex != from ? otherTo : to;
+					};
+
+				for (std::uint32_t t : pointTriangles_[fromPoint])
+				{
+					if (HasPoint(t, toPoint))
+					{
+						isTriangleRemoved_[t] = true;
+						--triangleCount_;
+						for (int corner = 0; corner < 3; ++corner)
+						{
+							const std::uint32_t point = points_[indices_[3 * t + corner]];
+							if (point != fromPoint)
+							{
+								std::erase(pointTriangles_[point], t);
+							}
+						}
+						continue;
+					}
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						std::uint32_t& vertex = indices_[3 * t + corner];
+						if (points_[vertex] == fromPoint)
+						{
+							vertex = getTarget(vertex);
+						}
+					}
+					pointTriangles_[toPoint].push_back(t);
+				}
+				pointTriangles_[fromPoint].clear();
+				isPointRemoved_[fromPoint] = true;
+				quadrics_[toPoint] += quadrics_[fromPoint];
+				++versions_[toPoint];
+
+				for (std::uint32_t t : pointTriangles_[toPoint])
+				{
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						const std::uint32_t a = indices_[3 * t + corner];
+						const std::uint32_t b = indices_[3 * t + (corner + 1) % 3];
+						if (points_[a] == toPoint || points_[b] == toPoint)
+						{
+							PushCollapse(a, b);
+							PushCollapse(b, a);
+						}
+					}
+				}
+			}
+
+			// Removes connected parts of the mesh, smallest first, until it
+			// has at most the target triangle count. A part's error is half
+			// its bounding box's diagonal, about as far as its surface moves
+			// when it shrinks away. Returns the largest error of any removed
+			// part.
+			double RemoveParts()
+			{
+				std::vector<std::uint32_t> parents(pointKinds_.size());
+				std::iota(parents.begin(), parents.end(), 0);
+				auto find = [&parents](std::uint32_t point) {
+					while (parents[point] != point)
+					{
+						parents[point] = parents[parents[point]];
+						point = parents[point];
+					}
+					return point;
+					};
+				ForEachEdge([&](std::uint32_t a, std::uint32_t b) {
+					parents[find(points_[a])] = find(points_[b]);
+					});
+
+				// Parts are numbered in order of their first triangle.
+				struct Part
+				{
+					glm::dvec3 min;
+					glm::dvec3 max;
+					std::size_t triangleCount = 0;
+					bool isRemoved = false;
+				};
+				std::vector<Part> parts;
+				std::unordered_map<std::uint32_t, std::size_t> rootParts;
+				auto getPart = [&](std::uint32_t triangle) -> Part& {
+					return parts[rootParts.at(find(points_[indices_[3 * triangle]]))];
+					};
+				for (std::uint32_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					if (isTriangleRemoved_[t])
+					{
+						continue;
+					}
+					auto [root, isInserted] =
+						rootParts.try_emplace(find(points_[indices_[3 * t]]), parts.size());
+					if (isInserted)
+					{
+						const glm::dvec3 position = GetPosition(indices_[3 * t]);
+						parts.push_back({ position, position });
+					}
+					Part& part = parts[root->second];
+					++part.triangleCount;
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						part.min = glm::min(part.min, GetPosition(indices_[3 * t + corner]));
+						part.max = glm::max(part.max, GetPosition(indices_[3 * t + corner]));
+					}
+				}
+
+				auto getError = [](const Part& part) { return glm::length(part.max - part.min) / 2.0; };
+				std::vector<std::size_t> order(parts.size());
+				std::iota(order.begin(), order.end(), 0);
+				std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+					return getError(parts[a]) < getError(parts[b]);
+					});
+
+				double maxError = 0.0;
+				std::size_t remainingCount = triangleCount_;
+				for (std::size_t index : order)
+				{
+					Part& part = parts[index];
+					if (remainingCount <= options_.targetTriangleCount || getError(part) > options_.maxError)
+					{
+						break;
+					}
+					part.isRemoved = true;
+					remainingCount -= part.triangleCount;
+					maxError = std::max(maxError, getError(part));
+				}
+
+				for (std::uint32_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					if (!isTriangleRemoved_[t] && getPart(t).isRemoved)
+					{
+						isTriangleRemoved_[t] = true;
+						--triangleCount_;
+					}
+				}
+				return maxError;
+			}
+
+			void Compact()
+			{
+				std::vector<std::uint32_t> remap(vertices_.size(), 0);
+				std::vector<bool> isUsed(vertices_.size(), false);
+				std::size_t keptIndexCount = 0;
+				for (std::size_t t = 0; t < isTriangleRemoved_.size(); ++t)
+				{
+					if (isTriangleRemoved_[t])
+					{
+						continue;
+					}
+					for (int corner = 0; corner < 3; ++corner)
+					{
+						isUsed[indices_[3 * t + corner]] = true;
+						indices_[keptIndexCount++] = indices_[3 * t + corner];
+					}
+				}
+				indices_.resize(keptIndexCount);
+
+				std::uint32_t keptVertexCount = 0;
+				for (std::size_t v = 0; v < vertices_.size(); ++v)
+				{
+					if (isUsed[v])
+					{
+						remap[v] = keptVertexCount;
+						vertices_[keptVertexCount++] = vertices_[v];
+					}
+				}
+				vertices_.resize(keptVertexCount);
+				for (std::uint32_t& index : indices_)
+				{
+					index = remap[index];
+				}
+			}
+
+			const SimplifyOptions& options_;
+			std::vector<Vertex>& vertices_;
+			std::vector<std::uint32_t>& indices_;
+
+			// Per vertex.
+			std::vector<std::uint32_t> points_;
+			std::vector<std::uint32_t> nextWedges_;
+
+			// Per point.
+			std::vector<PointKind> pointKinds_;
+			std::vector<Quadric> quadrics_;
+			std::vector<std::vector<std::uint32_t>> pointTriangles_;
+			std::vector<std::uint32_t> versions_;
+			std::vector<bool> isPointRemoved_;
+
+			std::vector<bool> isTriangleRemoved_;
+			std::size_t triangleCount_;
+
+			std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses_;
+
+			// Scratch space for CanCollapse().
+			std::vector<std::uint32_t> fromNeighbors_;
+			std::vector<std::uint32_t> toNeighbors_;
+			std::vector<std::uint32_t> sharedNeighbors_;
+		};
+	}
+
+	float SimplifyMesh(
+		const SimplifyOptions& options,
+		std::vector<Vertex>* vertices,
+		std::vector<std::uint32_t>* indices)
+	{
+		return Simplifier(options, vertices, indices).Simplify();
+	}
+
+	float SimplifyMesh(const SimplifyOptions& options, MeshData* mesh)
+	{
+		return SimplifyMesh(options, &mesh->vertices, &mesh->indices);
+	}
+
+	std::vector<MeshData> GenerateSimplifiedLods(
+		const MeshData& mesh,
+		int lodCount,
+		float triangleRatio,
+		const SimplifyOptions& options)
+	{
+		if (lodCount < 1)
+		{
+			throw std::invalid_argument("LOD count must be positive");
+		}
+		if (triangleRatio <= 0.0f || triangleRatio > 1.0f)
+		{
+			throw std::invalid_argument("Triangle ratio must be in (0, 1]");
+		}
+
+		std::vector<MeshData> lods;
+		lods.reserve(lodCount);
+		lods.push_back(mesh);
+		SimplifyOptions lodOptions = options;
+		for (int lod = 1; lod < lodCount; ++lod)
+		{
+			MeshData simplified = lods.back();
+			lodOptions.targetTriangleCount = static_cast<std::size_t>(
+				simplified.indices.size() / 3 * triangleRatio);
+			SimplifyMesh(lodOptions, &simplified);
+			if (simplified.indices.size() == lods.back().indices.size())
+			{
+				// Every following level would keep every triangle too.
+				break;
+			}
+			lods.push_back(std::move(simplified));
+		}
+		return lods;
+	}
+}
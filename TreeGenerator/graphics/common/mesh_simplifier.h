@@ -0,0 +1,68 @@
+#ifndef TREE_GENERATOR_MESH_SIMPLIFIER_H_
+#define TREE_GENERATOR_MESH_SIMPLIFIER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	struct SimplifyOptions
+	{
+		// Simplification stops once the mesh has at most this many
+		// triangles...
+		std::size_t targetTriangleCount = 0;
+
+		// ...or once the next collapse would move the surface further than
+		// this from where it was, in the mesh's units.
+		float maxError = std::numeric_limits<float>::max();
+
+		// Open edges, such as where a baked mesh meets another material's,
+		// resist being moved, and can't move at all when locked.
+		bool doLockBorders = false;
+
+		// Edges where the surface bends more sharply than this, in degrees,
+		// resist being moved across, which keeps the outline of coarse
+		// branches: an 8-sided cylinder bends by 45 degrees at each edge.
+		float featureAngle = 30.0f;
+
+		// Once no more edges can be collapsed, removes whole connected
+		// parts of the mesh, smallest first, within the maximum error. The
+		// separate tubes of a baked tree's branches can't get any coarser
+		// than three sides otherwise.
+		bool doRemoveParts = false;
+	};
+
+	// Removes triangles by collapsing edges in order of least quadric error
+	// (Garland and Heckbert, "Surface Simplification Using Quadric Error
+	// Metrics"). Each collapse moves one vertex onto another, so the kept
+	// vertices keep their attributes. Vertices at the same position are
+	// moved together: where only their other attributes differ, like
+	// along a uv seam or where baked branches meet at an angle, the seam
+	// is simplified by moving both of its sides along it. Points where
+	// seams cross or meet a border, or where the surface branches, stay.
+	// Unused vertices are removed, keeping the rest in order.
+	//
+	// Returns the largest error of any collapse, as a distance.
+	float SimplifyMesh(
+		const SimplifyOptions& options,
+		std::vector<Vertex>* vertices,
+		std::vector<std::uint32_t>* indices);
+	float SimplifyMesh(const SimplifyOptions& options, MeshData* mesh);
+
+	// Returns up to lodCount levels of detail, each simplified from the one
+	// before to triangleRatio of its triangles, starting with the mesh
+	// itself. The options' target triangle count is ignored. No more levels
+	// are returned once one can't remove any triangles, e.g. because of
+	// the maximum error.
+	std::vector<MeshData> GenerateSimplifiedLods(
+		const MeshData& mesh,
+		int lodCount,
+		float triangleRatio = 0.5f,
+		const SimplifyOptions& options = {});
+}
+
+#endif  // !TREE_GENERATOR_MESH_SIMPLIFIER_H_
@@ -0,0 +1,306 @@
+#include "mesh_simplifier.h"
+
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "mesh_baker.h"
+#include "mesh_data.h"
+
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		// A size x size grid of quads over [0, size]^2 in the xz plane,
+		// facing up, raised by height(x, z).
+		template <typename Height>
+		MeshData CreateGrid(int size, Height height)
+		{
+			MeshData mesh;
+			for (int z = 0; z <= size; ++z)
+			{
+				for (int x = 0; x <= size; ++x)
+				{
+					mesh.vertices.push_back({
+						glm::vec3(x, height(x, z), z),
+						glm::vec3(0.0f, 1.0f, 0.0f),
+						glm::vec2(x, z) / static_cast<float>(size) });
+				}
+			}
+			for (int z = 0; z < size; ++z)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					const unsigned int corner = z * (size + 1) + x;
+					const unsigned int above = corner + size + 1;
+					mesh.indices.insert(mesh.indices.end(), { corner, above, corner + 1 });
+					mesh.indices.insert(mesh.indices.end(), { corner + 1, above, above + 1 });
+				}
+			}
+			return mesh;
+		}
+
+		MeshData CreateFlatGrid(int size)
+		{
+			return CreateGrid(size, [](int, int) { return 0.0f; });
+		}
+
+		// segmentCount cylinders stacked into one welded tube. With uvs, the
+		// tube has seams around every joint and along its side.
+		MeshData CreateTube(int sideCount, int segmentCount, const CylinderOptions& options = {})
+		{
+			const MeshData cylinder = CreateCylinder(sideCount, 1.0f, 1.0f, options);
+			MeshData tube;
+			tube.vertices.resize(segmentCount * cylinder.vertices.size());
+			tube.indices.resize(segmentCount * cylinder.indices.size());
+			for (int i = 0; i < segmentCount; ++i)
+			{
+				glm::mat4 model(1.0f);
+				model[3] = glm::vec4(0.0f, static_cast<float>(i), 0.0f, 1.0f);
+				BakeInstance(
+					cylinder,
+					model,
+					static_cast<std::uint32_t>(i * cylinder.vertices.size()),
+					&tube.vertices[i * cylinder.vertices.size()],
+					&tube.indices[i * cylinder.indices.size()]);
+			}
+			WeldVertices(1e-5f, &tube.vertices, &tube.indices);
+			return tube;
+		}
+
+		struct PositionPairLess
+		{
+			bool operator()(
+				const std::pair<glm::vec3, glm::vec3>& a,
+				const std::pair<glm::vec3, glm::vec3>& b) const
+			{
+				return std::tie(a.first.x, a.first.y, a.first.z, a.second.x, a.second.y, a.second.z) <
+					std::tie(b.first.x, b.first.y, b.first.z, b.second.x, b.second.y, b.second.z);
+			}
+		};
+
+		std::size_t GetTriangleCount(const MeshData& mesh)
+		{
+			return mesh.indices.size() / 3;
+		}
+
+		glm::vec3 GetNormal(const MeshData& mesh, std::size_t triangle)
+		{
+			const glm::vec3 p0 = mesh.vertices[mesh.indices[3 * triangle]].position;
+			const glm::vec3 p1 = mesh.vertices[mesh.indices[3 * triangle + 1]].position;
+			const glm::vec3 p2 = mesh.vertices[mesh.indices[3 * triangle + 2]].position;
+			return glm::cross(p1 - p0, p2 - p0);
+		}
+
+		TEST(MeshSimplifierTest, SimplifiesFlatGridWithoutError)
+		{
+			MeshData mesh = CreateFlatGrid(8);
+			SimplifyOptions options;
+			options.targetTriangleCount = 2;
+
+			const float error = SimplifyMesh(options, &mesh);
+
+			EXPECT_EQ(GetTriangleCount(mesh), 2);
+			EXPECT_THAT(mesh.vertices, SizeIs(4));
+			EXPECT_NEAR(error, 0.0f, 1e-5f);
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				// Only the corners are left.
+				EXPECT_TRUE(vertex.position.x == 0.0f || vertex.position.x == 8.0f);
+				EXPECT_TRUE(vertex.position.z == 0.0f || vertex.position.z == 8.0f);
+			}
+		}
+
+		TEST(MeshSimplifierTest, LockedBordersKeepEveryBorderVertex)
+		{
+			MeshData mesh = CreateFlatGrid(8);
+			SimplifyOptions options;
+			options.doLockBorders = true;
+
+			SimplifyMesh(options, &mesh);
+
+			int borderVertexCount = 0;
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				borderVertexCount +=
+					vertex.position.x == 0.0f || vertex.position.x == 8.0f ||
+					vertex.position.z == 0.0f || vertex.position.z == 8.0f;
+			}
+			EXPECT_EQ(borderVertexCount, 32);
+			// Filling the border needs at least 30 triangles.
+			EXPECT_LT(GetTriangleCount(mesh), 40);
+		}
+
+		TEST(MeshSimplifierTest, StopsAtMaxError)
+		{
+			MeshData mesh = CreateTube(8, 16);
+			SimplifyOptions options;
+			options.maxError = 1e-4f;
+
+			const float error = SimplifyMesh(options, &mesh);
+
+			// The rings between the ends of a straight tube can be removed
+			// without error, but its sides can't.
+			EXPECT_LE(error, 1e-4f);
+			EXPECT_EQ(GetTriangleCount(mesh), 16);
+			EXPECT_THAT(mesh.vertices, SizeIs(16));
+		}
+
+		TEST(MeshSimplifierTest, ReachesTargetWithoutFoldingOver)
+		{
+			MeshData mesh = CreateGrid(32, [](int x, int z) {
+				return 2.0f * std::sin(x * 0.3f) * std::cos(z * 0.2f);
+				});
+			SimplifyOptions options;
+			options.targetTriangleCount = GetTriangleCount(mesh) / 8;
+
+			const float error = SimplifyMesh(options, &mesh);
+
+			// Each collapse removes two triangles, or one on the border.
+			EXPECT_LE(GetTriangleCount(mesh), options.targetTriangleCount);
+			EXPECT_GE(GetTriangleCount(mesh), options.targetTriangleCount - 1);
+			EXPECT_GT(error, 0.0f);
+			for (std::size_t t = 0; t < GetTriangleCount(mesh); ++t)
+			{
+				EXPECT_GT(GetNormal(mesh, t).y, 0.0f);
+			}
+		}
+
+		TEST(MeshSimplifierTest, MovesBothSidesOfSeams)
+		{
+			// Two grids side by side, touching along x = 4 but with their own
+			// vertices there, like the two sides of a uv seam: the left one's
+			// have u = 1, and the right one's u = 0.
+			MeshData mesh = CreateFlatGrid(4);
+			const MeshData right = CreateFlatGrid(4);
+			const unsigned int offset = static_cast<unsigned int>(mesh.vertices.size());
+			for (Vertex vertex : right.vertices)
+			{
+				vertex.position.x += 4.0f;
+				mesh.vertices.push_back(vertex);
+			}
+			for (unsigned int index : right.indices)
+			{
+				mesh.indices.push_back(offset + index);
+			}
+			SimplifyOptions options;
+			options.targetTriangleCount = 4;
+
+			SimplifyMesh(options, &mesh);
+
+			// The seam gets coarser, and every vertex still on it has a twin
+			// on the other side.
+			EXPECT_EQ(GetTriangleCount(mesh), 4);
+			std::multiset<float> leftSeam;
+			std::multiset<float> rightSeam;
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				if (vertex.position.x == 4.0f)
+				{
+					(vertex.uv.x == 1.0f ? leftSeam : rightSeam).insert(vertex.position.z);
+				}
+			}
+			EXPECT_LT(leftSeam.size(), 5u);
+			EXPECT_EQ(leftSeam, rightSeam);
+		}
+
+		TEST(MeshSimplifierTest, SimplifiesUvMappedTubesWithoutTearing)
+		{
+			CylinderOptions cylinderOptions;
+			cylinderOptions.hasUvs = true;
+			MeshData mesh = CreateTube(8, 8, cylinderOptions);
+			const std::size_t triangleCount = GetTriangleCount(mesh);
+			SimplifyOptions options;
+			options.targetTriangleCount = triangleCount / 2;
+
+			SimplifyMesh(options, &mesh);
+
+			// The surface is only open at the tube's ends, so no seam tore.
+			EXPECT_EQ(GetTriangleCount(mesh), triangleCount / 2);
+			std::set<std::pair<glm::vec3, glm::vec3>, PositionPairLess> edges;
+			for (std::size_t i = 0; i < mesh.indices.size(); ++i)
+			{
+				const std::size_t next = i % 3 == 2 ? i - 2 : i + 1;
+				edges.insert({
+					mesh.vertices[mesh.indices[i]].position,
+					mesh.vertices[mesh.indices[next]].position });
+			}
+			for (const auto& [from, to] : edges)
+			{
+				if (!edges.contains({ to, from }))
+				{
+					EXPECT_EQ(from.y, to.y);
+					EXPECT_TRUE(from.y == -0.5f || from.y == 7.5f) << from.y;
+				}
+			}
+		}
+
+		TEST(MeshSimplifierTest, RemovesSmallestPartsOnceNothingCollapses)
+		{
+			// Separate open tubes can't get coarser than three sides.
+			MeshData mesh = CreateTube(8, 1);
+			const MeshData small = CreateCylinder(8, 0.5f, 0.5f);
+			const unsigned int offset = static_cast<unsigned int>(mesh.vertices.size());
+			for (Vertex vertex : small.vertices)
+			{
+				vertex.position.x += 4.0f;
+				mesh.vertices.push_back(vertex);
+			}
+			for (unsigned int index : small.indices)
+			{
+				mesh.indices.push_back(offset + index);
+			}
+			SimplifyOptions options;
+			options.targetTriangleCount = 6;
+
+			MeshData kept = mesh;
+			SimplifyMesh(options, &kept);
+			EXPECT_EQ(GetTriangleCount(kept), 12);
+
+			options.doRemoveParts = true;
+			const float error = SimplifyMesh(options, &mesh);
+
+			EXPECT_EQ(GetTriangleCount(mesh), 6);
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				EXPECT_LT(vertex.position.x, 2.0f);
+			}
+			// The small tube's error is at most half its diagonal.
+			EXPECT_GT(error, 0.0f);
+			EXPECT_LE(error, glm::length(glm::vec3(1.0f, 0.5f, 1.0f)) / 2.0f);
+		}
+
+		TEST(MeshSimplifierTest, GeneratesLodsWithFewerTriangles)
+		{
+			const MeshData mesh = CreateGrid(16, [](int x, int z) {
+				return std::sin(x * 0.5f) * std::cos(z * 0.5f);
+				});
+
+			const std::vector<MeshData> lods = GenerateSimplifiedLods(mesh, 3, 0.5f);
+
+			ASSERT_THAT(lods, SizeIs(3));
+			EXPECT_EQ(lods[0].indices, mesh.indices);
+			EXPECT_EQ(GetTriangleCount(lods[1]), GetTriangleCount(mesh) / 2);
+			EXPECT_EQ(GetTriangleCount(lods[2]), GetTriangleCount(mesh) / 4);
+		}
+
+		TEST(MeshSimplifierTest, RejectsInvalidLodParameters)
+		{
+			const MeshData mesh = CreateFlatGrid(2);
+
+			EXPECT_THROW(GenerateSimplifiedLods(mesh, 0), std::invalid_argument);
+			EXPECT_THROW(GenerateSimplifiedLods(mesh, 2, 0.0f), std::invalid_argument);
+		}
+	}
+}
@@ -0,0 +1,342 @@
+#include "occlusion_culler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TREE_GENERATOR_OCCLUSION_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr int kSimdWidth = 4;
+
+		// Screen space position, with z holding the depth.
+		glm::vec3 ToScreen(const glm::vec4& clip, int width, int height)
+		{
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			return {
+				(ndc.x * 0.5f + 0.5f) * width,
+				(ndc.y * 0.5f + 0.5f) * height,
+				ndc.z * 0.5f + 0.5f };
+		}
+
+		bool IsInFrontOfNearPlane(const glm::vec4& clip)
+		{
+			return clip.w <= 0.0f || clip.z < -clip.w;
+		}
+
+		// Edge function of the edge from p to q: positive on its left side.
+		struct Edge
+		{
+			float a;
+			float b;
+			float c;
+
+			Edge(glm::vec3 p, glm::vec3 q) :
+				a(p.y - q.y),
+				b(q.x - p.x),
+				c(-(a * p.x + b * p.y))
+			{
+			}
+
+			float At(float x, float y) const { return a * x + b * y + c; }
+		};
+	}
+
+	OcclusionCuller::OcclusionCuller(int width, int height) :
+		width_(std::max(width, 1)),
+		height_(std::max(height, 1)),
+		stride_((width_ + kSimdWidth - 1) / kSimdWidth * kSimdWidth),
+		depthBuffer_(static_cast<std::size_t>(stride_) * height_, 1.0f),
+		viewProjection_(1.0f)
+	{
+	}
+
+	void OcclusionCuller::Begin(const glm::mat4& viewProjection)
+	{
+		viewProjection_ = viewProjection;
+		std::fill(depthBuffer_.begin(), depthBuffer_.end(), 1.0f);
+		levels_.clear();
+	}
+
+	void OcclusionCuller::RasterizeOccluder(const MeshData& mesh, const glm::mat4& model)
+	{
+		const glm::mat4 modelViewProjection = viewProjection_ * model;
+		for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			std::array<glm::vec4, 3> clip;
+			bool isClipped = false;
+			for (int j = 0; j < 3; ++j)
+			{
+				clip[j] = modelViewProjection *
+					glm::vec4(mesh.vertices[mesh.indices[i + j]].position, 1.0f);
+				isClipped = isClipped || IsInFrontOfNearPlane(clip[j]);
+			}
+			if (isClipped)
+			{
+				continue;
+			}
+
+			RasterizeTriangle(
+				ToScreen(clip[0], width_, height_),
+				ToScreen(clip[1], width_, height_),
+				ToScreen(clip[2], width_, height_));
+		}
+	}
+
+	void OcclusionCuller::RasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+	{
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (std::abs(area) < std::numeric_limits<float>::epsilon())
+		{
+			return;
+		}
+		if (area < 0.0f)
+		{
+			std::swap(b, c);
+			area = -area;
+		}
+
+		// The pixels whose centers (at x + 0.5) are within the triangle's
+		// bounds, with maxX and maxY exclusive.
+		const int minX = std::max(0, static_cast<int>(std::ceil(std::min({ a.x, b.x, c.x }) - 0.5f)));
+		const int minY = std::max(0, static_cast<int>(std::ceil(std::min({ a.y, b.y, c.y }) - 0.5f)));
+		const int maxX = std::min(width_, static_cast<int>(std::floor(std::max({ a.x, b.x, c.x }) - 0.5f)) + 1);
+		const int maxY = std::min(height_, static_cast<int>(std::floor(std::max({ a.y, b.y, c.y }) - 0.5f)) + 1);
+		if (minX >= maxX || minY >= maxY)
+		{
+			return;
+		}
+
+		// Centers on an edge count as inside, so that triangles sharing the
+		// edge leave no gaps between them.
+		const Edge edges[3] = { Edge(b, c), Edge(c, a), Edge(a, b) };
+
+		// Depth is affine in screen space. It is clamped to the vertices'
+		// depths, which the pixel centers near the edges can overshoot.
+		const float dzdx = (edges[0].a * a.z + edges[1].a * b.z + edges[2].a * c.z) / area;
+		const float dzdy = (edges[0].b * a.z + edges[1].b * b.z + edges[2].b * c.z) / area;
+		const float z0 = a.z - dzdx * a.x - dzdy * a.y;
+		const float maxDepth = std::max({ a.z, b.z, c.z });
+
+		// Groups of pixels start at a multiple of the SIMD width. Pixels left
+		// of minX are never inside the triangle, and those right of the
+		// screen fall in the padding.
+		const int firstX = minX / kSimdWidth * kSimdWidth;
+		for (int y = minY; y < maxY; ++y)
+		{
+			const float centerY = y + 0.5f;
+			float* row = depthBuffer_.data() + static_cast<std::size_t>(y) * stride_;
+			int x = firstX;
+#ifdef TREE_GENERATOR_OCCLUSION_CULLER_SSE2
+			const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 maxDepths = _mm_set1_ps(maxDepth);
+			__m128 rowEdges[3];
+			__m128 edgeA[3];
+			for (int e = 0; e < 3; ++e)
+			{
+				rowEdges[e] = _mm_set1_ps(edges[e].b * centerY + edges[e].c);
+				edgeA[e] = _mm_set1_ps(edges[e].a);
+			}
+			const __m128 rowDepth = _mm_set1_ps(z0 + dzdy * centerY);
+			const __m128 depthDx = _mm_set1_ps(dzdx);
+			for (; x < maxX; x += kSimdWidth)
+			{
+				const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+				__m128 isCovered = _mm_cmpge_ps(
+					_mm_add_ps(_mm_mul_ps(edgeA[0], centerX), rowEdges[0]), zero);
+				isCovered = _mm_and_ps(isCovered, _mm_cmpge_ps(
+					_mm_add_ps(_mm_mul_ps(edgeA[1], centerX), rowEdges[1]), zero));
+				isCovered = _mm_and_ps(isCovered, _mm_cmpge_ps(
+					_mm_add_ps(_mm_mul_ps(edgeA[2], centerX), rowEdges[2]), zero));
+				if (_mm_movemask_ps(isCovered) == 0)
+				{
+					continue;
+				}
+
+				const __m128 depth = _mm_min_ps(
+					_mm_add_ps(rowDepth, _mm_mul_ps(depthDx, centerX)), maxDepths);
+				const __m128 previous = _mm_loadu_ps(row + x);
+				const __m128 nearest = _mm_min_ps(previous, depth);
+				_mm_storeu_ps(row + x, _mm_or_ps(
+					_mm_and_ps(isCovered, nearest),
+					_mm_andnot_ps(isCovered, previous)));
+			}
+#endif
+			for (; x < maxX; ++x)
+			{
+				const float centerX = x + 0.5f;
+				if (edges[0].At(centerX, centerY) >= 0.0f &&
+					edges[1].At(centerX, centerY) >= 0.0f &&
+					edges[2].At(centerX, centerY) >= 0.0f)
+				{
+					const float depth = std::min(z0 + dzdx * centerX + dzdy * centerY, maxDepth);
+					row[x] = std::min(row[x], depth);
+				}
+			}
+		}
+	}
+
+	void OcclusionCuller::Finish()
+	{
+		levels_.clear();
+
+		// Occluders only cover some of the pixels at their edges, and their
+		// depth varies within each pixel. Taking the furthest depth of each
+		// pixel's 3x3 neighborhood covers both: pixels at an edge get the
+		// depth of the pixels beyond it, and every pixel's depth reaches the
+		// furthest point within it. The maximum is separable, so it is
+		// taken along rows, then along columns.
+		std::vector<float> rowMaxima(static_cast<std::size_t>(width_) * height_);
+		for (int y = 0; y < height_; ++y)
+		{
+			const float* row = depthBuffer_.data() + static_cast<std::size_t>(y) * stride_;
+			float* maxima = rowMaxima.data() + static_cast<std::size_t>(y) * width_;
+			for (int x = 0; x < width_; ++x)
+			{
+				maxima[x] = std::max({
+					row[std::max(x - 1, 0)],
+					row[x],
+					row[std::min(x + 1, width_ - 1)] });
+			}
+		}
+
+		Level base{ width_, height_, std::vector<float>(static_cast<std::size_t>(width_) * height_) };
+		for (int y = 0; y < height_; ++y)
+		{
+			const float* above = rowMaxima.data() + static_cast<std::size_t>(std::max(y - 1, 0)) * width_;
+			const float* row = rowMaxima.data() + static_cast<std::size_t>(y) * width_;
+			const float* below = rowMaxima.data() + static_cast<std::size_t>(std::min(y + 1, height_ - 1)) * width_;
+			float* depths = base.depths.data() + static_cast<std::size_t>(y) * width_;
+			for (int x = 0; x < width_; ++x)
+			{
+				depths[x] = std::max({ above[x], row[x], below[x] });
+			}
+		}
+		levels_.push_back(std::move(base));
+
+		while (levels_.back().width > 1 || levels_.back().height > 1)
+		{
+			const Level& previous = levels_.back();
+			Level level{
+				(previous.width + 1) / 2,
+				(previous.height + 1) / 2,
+				{} };
+			level.depths.resize(static_cast<std::size_t>(level.width) * level.height);
+			for (int y = 0; y < level.height; ++y)
+			{
+				const int y0 = 2 * y;
+				const int y1 = std::min(y0 + 1, previous.height - 1);
+				for (int x = 0; x < level.width; ++x)
+				{
+					const int x0 = 2 * x;
+					const int x1 = std::min(x0 + 1, previous.width - 1);
+					level.depths[static_cast<std::size_t>(y) * level.width + x] = std::max({
+						previous.depths[static_cast<std::size_t>(y0) * previous.width + x0],
+						previous.depths[static_cast<std::size_t>(y0) * previous.width + x1],
+						previous.depths[static_cast<std::size_t>(y1) * previous.width + x0],
+						previous.depths[static_cast<std::size_t>(y1) * previous.width + x1] });
+				}
+			}
+			levels_.push_back(std::move(level));
+		}
+	}
+
+	ProjectedBounds OcclusionCuller::Project(const BoundingBox& box) const
+	{
+		ProjectedBounds projected{
+			glm::vec2(std::numeric_limits<float>::max()),
+			glm::vec2(std::numeric_limits<float>::lowest()),
+			std::numeric_limits<float>::max(),
+			false };
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec4 clip = viewProjection_ * glm::vec4(
+				corner & 1 ? box.max.x : box.min.x,
+				corner & 2 ? box.max.y : box.min.y,
+				corner & 4 ? box.max.z : box.min.z,
+				1.0f);
+			if (IsInFrontOfNearPlane(clip))
+			{
+				projected.isClipped = true;
+				return projected;
+			}
+
+			const glm::vec3 screen = ToScreen(clip, width_, height_);
+			projected.min = glm::min(projected.min, glm::vec2(screen.x, screen.y));
+			projected.max = glm::max(projected.max, glm::vec2(screen.x, screen.y));
+			projected.nearestDepth = std::min(projected.nearestDepth, screen.z);
+		}
+		return projected;
+	}
+
+	bool OcclusionCuller::IsVisible(const BoundingBox& box) const
+	{
+		const ProjectedBounds projected = Project(box);
+		if (projected.isClipped || levels_.empty())
+		{
+			return true;
+		}
+		// Only the part of the box on screen can be hidden by anything, so
+		// boxes entirely off screen are left to frustum culling.
+		if (projected.max.x < 0.0f || projected.min.x >= width_ ||
+			projected.max.y < 0.0f || projected.min.y >= height_)
+		{
+			return true;
+		}
+
+		const int minX = std::clamp(static_cast<int>(std::floor(projected.min.x)), 0, width_ - 1);
+		const int minY = std::clamp(static_cast<int>(std::floor(projected.min.y)), 0, height_ - 1);
+		const int maxX = std::clamp(static_cast<int>(std::floor(projected.max.x)), 0, width_ - 1);
+		const int maxY = std::clamp(static_cast<int>(std::floor(projected.max.y)), 0, height_ - 1);
+
+		// The finest level where the box covers at most 2x2 texels.
+		int levelIndex = 0;
+		while (levelIndex + 1 < GetLevelCount() &&
+			((maxX >> levelIndex) - (minX >> levelIndex) > 1 ||
+				(maxY >> levelIndex) - (minY >> levelIndex) > 1))
+		{
+			++levelIndex;
+		}
+
+		const Level& level = levels_[levelIndex];
+		for (int y = minY >> levelIndex; y <= maxY >> levelIndex; ++y)
+		{
+			for (int x = minX >> levelIndex; x <= maxX >> levelIndex; ++x)
+			{
+				if (projected.nearestDepth <= level.depths[static_cast<std::size_t>(y) * level.width + x])
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void OcclusionCuller::CullInstances(
+		const InstanceBounds& bounds,
+		std::span<const std::uint32_t> candidates,
+		std::vector<std::uint32_t>* visible) const
+	{
+		for (std::uint32_t candidate : candidates)
+		{
+			if (IsVisible(bounds.Get(candidate)))
+			{
+				visible->push_back(candidate);
+			}
+		}
+	}
+
+	float OcclusionCuller::GetDepth(int level, int x, int y) const
+	{
+		return levels_[level].depths[static_cast<std::size_t>(y) * levels_[level].width + x];
+	}
+}
@@ -0,0 +1,99 @@
+#ifndef TREE_GENERATOR_OCCLUSION_CULLER_H_
+#define TREE_GENERATOR_OCCLUSION_CULLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounding_box.h"
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	// Screen space rectangle and nearest depth covered by a bounding box, in
+	// pixels of the culler's depth buffer and depths from 0 (near) to 1 (far).
+	struct ProjectedBounds
+	{
+		glm::vec2 min;
+		glm::vec2 max;
+		float nearestDepth;
+
+		// Whether the box reaches in front of the near plane, in which case
+		// the rectangle is meaningless.
+		bool isClipped;
+
+		float Area() const { return (max.x - min.x) * (max.y - min.y); }
+	};
+
+	// Occlusion culling against a coarse depth buffer, entirely on the CPU.
+	//
+	// Occluders are rasterized into the depth buffer, and a hierarchy of
+	// downsampled copies is built from it, each texel holding the furthest
+	// depth of the four below it. A bounding box is hidden if it is behind
+	// every texel of the level where it covers at most 2x2 texels.
+	//
+	// Occluders are sampled at pixel centers, and each pixel is then given
+	// the furthest depth around it, so that the pixels an occluder only
+	// partly covers don't hide anything. Triangles crossing the near plane
+	// are skipped.
+	class OcclusionCuller
+	{
+	public:
+		OcclusionCuller(int width, int height);
+
+		int GetWidth() const { return width_; }
+		int GetHeight() const { return height_; }
+
+		// Clears the depth buffer, and sets the matrix mapping world space to
+		// OpenGL's clip space for the following calls.
+		void Begin(const glm::mat4& viewProjection);
+
+		// Rasterizes the mesh's triangles, transformed by the model matrix.
+		// Both sides of each triangle occlude.
+		void RasterizeOccluder(const MeshData& mesh, const glm::mat4& model);
+
+		// Builds the depth hierarchy from the rasterized occluders. Must be
+		// called before testing anything.
+		void Finish();
+
+		ProjectedBounds Project(const BoundingBox& box) const;
+
+		bool IsVisible(const BoundingBox& box) const;
+
+		// Appends the candidates whose bounds are not hidden to `visible`.
+		void CullInstances(
+			const InstanceBounds& bounds,
+			std::span<const std::uint32_t> candidates,
+			std::vector<std::uint32_t>* visible) const;
+
+		// Number of levels in the depth hierarchy; level 0 is the depth
+		// buffer itself.
+		int GetLevelCount() const { return static_cast<int>(levels_.size()); }
+		float GetDepth(int level, int x, int y) const;
+
+	private:
+		struct Level
+		{
+			int width;
+			int height;
+			std::vector<float> depths;
+		};
+
+		int width_;
+		int height_;
+
+		// Rows of the depth buffer are padded to a multiple of the SIMD
+		// width, so whole groups of pixels can always be written.
+		int stride_;
+		std::vector<float> depthBuffer_;
+		std::vector<Level> levels_;
+		glm::mat4 viewProjection_;
+
+		void RasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c);
+	};
+}
+
+#endif  // !TREE_GENERATOR_OCCLUSION_CULLER_H_
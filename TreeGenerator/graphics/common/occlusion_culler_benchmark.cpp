@@ -0,0 +1,107 @@
+#include "occlusion_culler.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bounding_box.h"
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		// A dense canopy of leaves in front of many smaller instances, seen
+		// from the origin down the negative z axis.
+		struct CanopyScene
+		{
+			CanopyScene(int leafCount, std::size_t instanceCount) :
+				leaf(CreateQuad()),
+				viewProjection(
+					glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f) *
+					glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)))
+			{
+				std::mt19937 random(42);
+				std::uniform_real_distribution<float> spread(-12.0f, 12.0f);
+				std::uniform_real_distribution<float> leafDepth(-12.0f, -8.0f);
+				std::uniform_real_distribution<float> angle(-30.0f, 30.0f);
+				for (int i = 0; i < leafCount; ++i)
+				{
+					glm::mat4 model = glm::translate(
+						glm::mat4(1.0f),
+						glm::vec3(spread(random), 0.6f * spread(random), leafDepth(random)));
+					model = glm::rotate(model, glm::radians(angle(random)), glm::vec3(0.0f, 1.0f, 0.0f));
+					leaves.push_back(glm::scale(model, glm::vec3(1.5f)));
+				}
+
+				std::uniform_real_distribution<float> instanceDepth(-60.0f, -15.0f);
+				std::uniform_real_distribution<float> size(0.05f, 0.5f);
+				bounds.Resize(instanceCount);
+				for (std::size_t i = 0; i < instanceCount; ++i)
+				{
+					const float z = instanceDepth(random);
+					const glm::vec3 center(spread(random) * -z / 10.0f, 0.6f * spread(random) * -z / 10.0f, z);
+					bounds.Set(i, { center - glm::vec3(size(random)), center + glm::vec3(size(random)) });
+					candidates.push_back(static_cast<std::uint32_t>(i));
+				}
+			}
+
+			MeshData leaf;
+			std::vector<glm::mat4> leaves;
+			InstanceBounds bounds;
+			std::vector<std::uint32_t> candidates;
+			glm::mat4 viewProjection;
+		};
+
+		void BM_RasterizeOccluders(benchmark::State& state)
+		{
+			const CanopyScene scene(static_cast<int>(state.range(0)), 0);
+			OcclusionCuller culler(256, 144);
+
+			for (auto _ : state)
+			{
+				culler.Begin(scene.viewProjection);
+				for (const glm::mat4& model : scene.leaves)
+				{
+					culler.RasterizeOccluder(scene.leaf, model);
+				}
+				culler.Finish();
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		// The culled counter is the fraction of instances found hidden.
+		void BM_CullHiddenInstances(benchmark::State& state)
+		{
+			const CanopyScene scene(2000, static_cast<std::size_t>(state.range(0)));
+			OcclusionCuller culler(256, 144);
+			std::vector<std::uint32_t> visible;
+
+			for (auto _ : state)
+			{
+				culler.Begin(scene.viewProjection);
+				for (const glm::mat4& model : scene.leaves)
+				{
+					culler.RasterizeOccluder(scene.leaf, model);
+				}
+				culler.Finish();
+
+				visible.clear();
+				culler.CullInstances(scene.bounds, scene.candidates, &visible);
+				benchmark::DoNotOptimize(visible.data());
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+			state.counters["culled"] =
+				1.0 - static_cast<double>(visible.size()) / scene.candidates.size();
+		}
+
+		BENCHMARK(BM_RasterizeOccluders)->Arg(500)->Arg(2000)->Unit(benchmark::kMicrosecond);
+		BENCHMARK(BM_CullHiddenInstances)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+	}
+}
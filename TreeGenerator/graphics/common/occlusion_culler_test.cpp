@@ -0,0 +1,151 @@
+#include "occlusion_culler.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bounding_box.h"
+#include "mesh_data.h"
+
+using ::testing::ElementsAre;
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr int kWidth = 64;
+		constexpr int kHeight = 64;
+
+		// Looks down the negative z axis from the origin.
+		glm::mat4 CreateViewProjection()
+		{
+			const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+			const glm::mat4 view = glm::lookAt(
+				glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			return projection * view;
+		}
+
+		// A square facing the camera, covering [-halfSize, halfSize] in x and
+		// y at the given distance.
+		glm::mat4 CreateWall(float distance, float halfSize)
+		{
+			glm::mat4 model(halfSize);
+			model[3] = glm::vec4(0.0f, 0.0f, -distance, 1.0f);
+			return model;
+		}
+
+		BoundingBox CreateBox(glm::vec3 center, float size)
+		{
+			return { center - glm::vec3(size), center + glm::vec3(size) };
+		}
+
+		OcclusionCuller CreateCullerWithWall(float distance, float halfSize)
+		{
+			OcclusionCuller culler(kWidth, kHeight);
+			culler.Begin(CreateViewProjection());
+			culler.RasterizeOccluder(
+				CreateQuad(glm::vec2(-1.0f, -1.0f), glm::vec2(-1.0f, 1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 1.0f)),
+				CreateWall(distance, halfSize));
+			culler.Finish();
+			return culler;
+		}
+
+		TEST(OcclusionCullerTest, NothingIsHiddenWithoutOccluders)
+		{
+			OcclusionCuller culler(kWidth, kHeight);
+			culler.Begin(CreateViewProjection());
+			culler.Finish();
+
+			EXPECT_TRUE(culler.IsVisible(CreateBox(glm::vec3(0.0f, 0.0f, -50.0f), 1.0f)));
+		}
+
+		TEST(OcclusionCullerTest, BoxBehindOccluderIsHidden)
+		{
+			OcclusionCuller culler = CreateCullerWithWall(5.0f, 3.0f);
+
+			EXPECT_FALSE(culler.IsVisible(CreateBox(glm::vec3(0.0f, 0.0f, -20.0f), 1.0f)));
+			EXPECT_FALSE(culler.IsVisible(CreateBox(glm::vec3(4.0f, -3.0f, -20.0f), 1.0f)));
+		}
+
+		TEST(OcclusionCullerTest, BoxInFrontOfOccluderIsVisible)
+		{
+			OcclusionCuller culler = CreateCullerWithWall(5.0f, 3.0f);
+
+			EXPECT_TRUE(culler.IsVisible(CreateBox(glm::vec3(0.0f, 0.0f, -3.0f), 0.5f)));
+		}
+
+		TEST(OcclusionCullerTest, BoxIntersectingOccluderIsVisible)
+		{
+			OcclusionCuller culler = CreateCullerWithWall(5.0f, 3.0f);
+
+			EXPECT_TRUE(culler.IsVisible(CreateBox(glm::vec3(0.0f, 0.0f, -5.0f), 0.5f)));
+		}
+
+		TEST(OcclusionCullerTest, BoxPeekingPastOccluderIsVisible)
+		{
+			OcclusionCuller culler = CreateCullerWithWall(5.0f, 3.0f);
+
+			// Behind the wall, but reaching a little past its right side.
+			EXPECT_TRUE(culler.IsVisible(CreateBox(glm::vec3(11.0f, 0.0f, -20.0f), 1.0f)));
+		}
+
+		TEST(OcclusionCullerTest, BoxReachingPastNearPlaneIsVisible)
+		{
+			OcclusionCuller culler = CreateCullerWithWall(5.0f, 3.0f);
+
+			EXPECT_TRUE(culler.IsVisible({ glm::vec3(-1.0f, -1.0f, -20.0f), glm::vec3(1.0f, 1.0f, 1.0f) }));
+		}
+
+		TEST(OcclusionCullerTest, PartlyCoveredPixelsDoNotOcclude)
+		{
+			OcclusionCuller culler(4, 4);
+			culler.Begin(glm::mat4(1.0f));
+			// Covers the left half of the screen, and half of the pixel column
+			// to its right. Every pixel next to one that isn't covered could
+			// be partly uncovered.
+			culler.RasterizeOccluder(
+				CreateQuad(glm::vec2(-1.0f, -1.0f), glm::vec2(-1.0f, 1.0f), glm::vec2(0.25f, -1.0f), glm::vec2(0.25f, 1.0f)),
+				glm::mat4(1.0f));
+			culler.Finish();
+
+			for (int y = 0; y < 4; ++y)
+			{
+				EXPECT_FLOAT_EQ(culler.GetDepth(0, 0, y), 0.5f);
+				EXPECT_FLOAT_EQ(culler.GetDepth(0, 1, y), 0.5f);
+				EXPECT_FLOAT_EQ(culler.GetDepth(0, 2, y), 1.0f);
+				EXPECT_FLOAT_EQ(culler.GetDepth(0, 3, y), 1.0f);
+			}
+		}
+
+		TEST(OcclusionCullerTest, HierarchyKeepsFurthestDepth)
+		{
+			OcclusionCuller culler = CreateCullerWithWall(5.0f, 3.0f);
+
+			ASSERT_EQ(culler.GetLevelCount(), 7);
+			EXPECT_LT(culler.GetDepth(0, kWidth / 2, kHeight / 2), 1.0f);
+			EXPECT_LT(culler.GetDepth(3, 4, 4), 1.0f);
+			EXPECT_FLOAT_EQ(culler.GetDepth(6, 0, 0), 1.0f);
+		}
+
+		TEST(OcclusionCullerTest, CullInstancesKeepsVisibleCandidates)
+		{
+			OcclusionCuller culler = CreateCullerWithWall(5.0f, 3.0f);
+			InstanceBounds bounds;
+			bounds.Resize(3);
+			bounds.Set(0, CreateBox(glm::vec3(0.0f, 0.0f, -20.0f), 1.0f));
+			bounds.Set(1, CreateBox(glm::vec3(0.0f, 0.0f, -3.0f), 0.5f));
+			bounds.Set(2, CreateBox(glm::vec3(30.0f, 0.0f, -20.0f), 1.0f));
+
+			std::vector<std::uint32_t> candidates{ 0, 1, 2 };
+			std::vector<std::uint32_t> visible;
+			culler.CullInstances(bounds, candidates, &visible);
+
+			EXPECT_THAT(visible, ElementsAre(1, 2));
+		}
+	}
+}
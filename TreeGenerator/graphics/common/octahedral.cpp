@@ -0,0 +1,39 @@
+#include "octahedral.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		// Like glm::sign, but never 0, so that points on an axis still fold
+		// to a corner.
+		glm::vec2 SignNotZero(glm::vec2 v)
+		{
+			return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+		}
+	}
+
+	glm::vec2 EncodeOctahedral(glm::vec3 direction)
+	{
+		const glm::vec3 n =
+			direction / (glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z));
+		glm::vec2 encoded(n.x, n.z);
+		if (n.y < 0.0f)
+		{
+			encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * SignNotZero(encoded);
+		}
+		return encoded;
+	}
+
+	glm::vec3 DecodeOctahedral(glm::vec2 encoded)
+	{
+		glm::vec3 n(encoded.x, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y), encoded.y);
+		if (n.y < 0.0f)
+		{
+			const glm::vec2 folded =
+				(1.0f - glm::abs(glm::vec2(n.z, n.x))) * SignNotZero(glm::vec2(n.x, n.z));
+			n.x = folded.x;
+			n.z = folded.y;
+		}
+		return glm::normalize(n);
+	}
+}
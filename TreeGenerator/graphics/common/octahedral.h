@@ -0,0 +1,21 @@
+#ifndef TREE_GENERATOR_OCTAHEDRAL_H_
+#define TREE_GENERATOR_OCTAHEDRAL_H_
+
+#include <glm/glm.hpp>
+
+namespace tree_generator
+{
+	// Octahedral mapping between directions and the square [-1, 1]^2. The
+	// directions are projected onto an octahedron around the y axis, whose
+	// upper half maps to the diamond in the middle of the square and whose
+	// lower half is folded out into the corners.
+	//
+	// See Cigolle et al., "A Survey of Efficient Representations for
+	// Independent Unit Vectors".
+	glm::vec2 EncodeOctahedral(glm::vec3 direction);
+
+	// Returns the unit direction mapped to the point of the square.
+	glm::vec3 DecodeOctahedral(glm::vec2 encoded);
+}
+
+#endif  // !TREE_GENERATOR_OCTAHEDRAL_H_
@@ -0,0 +1,104 @@
+#include "octahedral.h"
+
+#include <random>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "impostor.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		void ExpectNear(glm::vec3 actual, glm::vec3 expected, float tolerance)
+		{
+			EXPECT_NEAR(actual.x, expected.x, tolerance);
+			EXPECT_NEAR(actual.y, expected.y, tolerance);
+			EXPECT_NEAR(actual.z, expected.z, tolerance);
+		}
+
+		TEST(OctahedralTest, RoundTripsRandomDirections)
+		{
+			std::mt19937 random(42);
+			std::normal_distribution<float> component;
+			for (int i = 0; i < 1000; ++i)
+			{
+				const glm::vec3 direction = glm::normalize(
+					glm::vec3(component(random), component(random), component(random)));
+				const glm::vec2 encoded = EncodeOctahedral(direction);
+
+				EXPECT_LE(glm::abs(encoded.x), 1.0f);
+				EXPECT_LE(glm::abs(encoded.y), 1.0f);
+				ExpectNear(DecodeOctahedral(encoded), direction, 1e-5f);
+			}
+		}
+
+		TEST(OctahedralTest, MapsPolesToCenterAndCorners)
+		{
+			const glm::vec2 up = EncodeOctahedral(glm::vec3(0.0f, 1.0f, 0.0f));
+			EXPECT_FLOAT_EQ(up.x, 0.0f);
+			EXPECT_FLOAT_EQ(up.y, 0.0f);
+
+			const glm::vec2 down = EncodeOctahedral(glm::vec3(0.0f, -1.0f, 0.0f));
+			EXPECT_FLOAT_EQ(glm::abs(down.x), 1.0f);
+			EXPECT_FLOAT_EQ(glm::abs(down.y), 1.0f);
+
+			for (glm::vec2 corner : { glm::vec2(1, 1), glm::vec2(-1, 1), glm::vec2(1, -1), glm::vec2(-1, -1) })
+			{
+				ExpectNear(DecodeOctahedral(corner), glm::vec3(0.0f, -1.0f, 0.0f), 1e-6f);
+			}
+		}
+
+		TEST(OctahedralTest, MapsEquatorToDiamond)
+		{
+			const glm::vec2 encoded = EncodeOctahedral(glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f)));
+			EXPECT_FLOAT_EQ(glm::abs(encoded.x) + glm::abs(encoded.y), 1.0f);
+		}
+
+		TEST(ImpostorTest, FrameOfFrameDirectionIsFrame)
+		{
+			constexpr int kFrameCount = 8;
+			for (int y = 0; y < kFrameCount; ++y)
+			{
+				for (int x = 0; x < kFrameCount; ++x)
+				{
+					const glm::ivec2 frame = GetImpostorFrame(
+						GetImpostorFrameDirection(x, y, kFrameCount), kFrameCount);
+					EXPECT_EQ(frame.x, x);
+					EXPECT_EQ(frame.y, y);
+				}
+			}
+		}
+
+		TEST(ImpostorTest, ViewProjectionFitsBoundingSphere)
+		{
+			const glm::vec3 center(1.0f, 2.0f, 3.0f);
+			const float radius = 2.0f;
+			for (glm::vec3 direction : {
+				glm::vec3(0.0f, 0.0f, 1.0f),
+				glm::vec3(0.0f, 1.0f, 0.0f),
+				glm::normalize(glm::vec3(1.0f, -1.0f, 0.5f)) })
+			{
+				const glm::mat4 viewProjection =
+					GetImpostorProjection(radius) * GetImpostorView(direction, center, radius);
+
+				// The point of the sphere nearest the viewer is at the near
+				// plane, and the furthest at the far plane.
+				const glm::vec4 front = viewProjection * glm::vec4(center + direction * radius, 1.0f);
+				const glm::vec4 back = viewProjection * glm::vec4(center - direction * radius, 1.0f);
+				ExpectNear(glm::vec3(front), glm::vec3(0.0f, 0.0f, -1.0f), 1e-5f);
+				ExpectNear(glm::vec3(back), glm::vec3(0.0f, 0.0f, 1.0f), 1e-5f);
+
+				// The sphere's silhouette touches the edges of the frame.
+				const glm::vec3 up = GetImpostorUp(direction);
+				const glm::vec3 frameUp = glm::normalize(up - glm::dot(up, direction) * direction);
+				const glm::vec4 top = viewProjection * glm::vec4(center + frameUp * radius, 1.0f);
+				EXPECT_NEAR(top.y, 1.0f, 1e-5f);
+				EXPECT_NEAR(top.x, 0.0f, 1e-5f);
+			}
+		}
+	}
+}
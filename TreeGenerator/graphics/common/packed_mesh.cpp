@@ -0,0 +1,92 @@
+#include "packed_mesh.h"
+
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
+
+#include "bounding_box.h"
+#include "octahedral.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		std::int16_t PackSnorm(float value)
+		{
+			return static_cast<std::int16_t>(glm::packSnorm1x16(value));
+		}
+
+		float UnpackSnorm(std::int16_t value)
+		{
+			return glm::unpackSnorm1x16(static_cast<std::uint16_t>(value));
+		}
+
+		// Maps each component from [-extent, extent] to [-1, 1], or to 0 if
+		// the mesh is flat along that axis.
+		float Normalize(float value, float extent)
+		{
+			return extent > 0.0f ? value / extent : 0.0f;
+		}
+	}
+
+	PackedMesh PackMesh(const MeshData& mesh)
+	{
+		PackedMesh packed;
+		const BoundingBox bounds = ComputeBounds(mesh);
+		if (!bounds.IsEmpty())
+		{
+			packed.positionOffset = bounds.Center();
+			packed.positionScale = bounds.Extent();
+		}
+
+		packed.vertices.reserve(mesh.vertices.size());
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			const glm::vec3 position = vertex.position - packed.positionOffset;
+			const glm::vec2 normal = glm::dot(vertex.normal, vertex.normal) > 0.0f
+				? EncodeOctahedral(vertex.normal)
+				: glm::vec2(0.0f);
+			packed.vertices.push_back({
+				{
+					PackSnorm(Normalize(position.x, packed.positionScale.x)),
+					PackSnorm(Normalize(position.y, packed.positionScale.y)),
+					PackSnorm(Normalize(position.z, packed.positionScale.z)),
+					0,
+				},
+				{ PackSnorm(normal.x), PackSnorm(normal.y) },
+				{ glm::packHalf1x16(vertex.uv.x), glm::packHalf1x16(vertex.uv.y) } });
+		}
+
+		if (mesh.vertices.size() <= std::size_t{ std::numeric_limits<std::uint16_t>::max() } + 1)
+		{
+			packed.shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+		}
+		else
+		{
+			packed.indices = mesh.indices;
+		}
+		return packed;
+	}
+
+	MeshData UnpackMesh(const PackedMesh& mesh)
+	{
+		MeshData unpacked;
+		unpacked.vertices.reserve(mesh.vertices.size());
+		for (const PackedVertex& vertex : mesh.vertices)
+		{
+			const glm::vec3 position(
+				UnpackSnorm(vertex.position[0]),
+				UnpackSnorm(vertex.position[1]),
+				UnpackSnorm(vertex.position[2]));
+			unpacked.vertices.push_back({
+				mesh.positionOffset + mesh.positionScale * position,
+				DecodeOctahedral(glm::vec2(UnpackSnorm(vertex.normal[0]), UnpackSnorm(vertex.normal[1]))),
+				glm::vec2(glm::unpackHalf1x16(vertex.uv[0]), glm::unpackHalf1x16(vertex.uv[1])) });
+		}
+
+		unpacked.indices.reserve(mesh.IndexCount());
+		unpacked.indices.insert(unpacked.indices.end(), mesh.shortIndices.begin(), mesh.shortIndices.end());
+		unpacked.indices.insert(unpacked.indices.end(), mesh.indices.begin(), mesh.indices.end());
+		return unpacked;
+	}
+}
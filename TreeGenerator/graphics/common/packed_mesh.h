@@ -0,0 +1,57 @@
+#ifndef TREE_GENERATOR_PACKED_MESH_H_
+#define TREE_GENERATOR_PACKED_MESH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh_data.h"
+
+namespace tree_generator
+{
+	// A vertex quantized to 16 bytes, half the size of Vertex.
+	struct PackedVertex
+	{
+		// Position within the mesh's bounds as signed normalized 16-bit
+		// integers, with one unused component to keep the next attribute
+		// aligned. See PackedMesh::positionOffset.
+		std::int16_t position[4];
+
+		// Octahedral encoding of the normal (see EncodeOctahedral()) as
+		// signed normalized 16-bit integers.
+		std::int16_t normal[2];
+
+		// Half-precision floats.
+		std::uint16_t uv[2];
+	};
+	static_assert(sizeof(PackedVertex) == 16, "PackedVertex must not be padded");
+
+	// A mesh with quantized vertices. Its indices are 16-bit when every
+	// vertex can be addressed with them, like a BakedMesh's.
+	struct PackedMesh
+	{
+		std::vector<PackedVertex> vertices;
+		std::vector<std::uint16_t> shortIndices;
+		std::vector<std::uint32_t> indices;
+
+		// A vertex's position is positionOffset + positionScale * p, where p
+		// is its normalized position in [-1, 1]. The offset and scale are
+		// the center and extent of the mesh's bounds.
+		glm::vec3 positionOffset = glm::vec3(0.0f);
+		glm::vec3 positionScale = glm::vec3(1.0f);
+
+		std::size_t IndexCount() const { return shortIndices.size() + indices.size(); }
+	};
+
+	// Quantizes the mesh's vertices to its bounds. Positions are accurate to
+	// within 1/65534 of the mesh's size on each axis, normals to about 0.01
+	// degrees and uvs to 11 significant bits.
+	PackedMesh PackMesh(const MeshData& mesh);
+
+	// Returns the mesh with float vertices and 32-bit indices.
+	MeshData UnpackMesh(const PackedMesh& mesh);
+}
+
+#endif  // !TREE_GENERATOR_PACKED_MESH_H_
@@ -0,0 +1,95 @@
+#include "packed_mesh.h"
+
+#include <cstdint>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "mesh_data.h"
+
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		void ExpectRoundTrips(const MeshData& mesh)
+		{
+			const PackedMesh packed = PackMesh(mesh);
+			const MeshData unpacked = UnpackMesh(packed);
+
+			ASSERT_THAT(unpacked.vertices, SizeIs(mesh.vertices.size()));
+			EXPECT_THAT(unpacked.indices, ElementsAreArray(mesh.indices));
+			const glm::vec3 tolerance = packed.positionScale / 32767.0f + 1e-6f;
+			for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+			{
+				const Vertex& expected = mesh.vertices[i];
+				const Vertex& actual = unpacked.vertices[i];
+				EXPECT_NEAR(actual.position.x, expected.position.x, tolerance.x);
+				EXPECT_NEAR(actual.position.y, expected.position.y, tolerance.y);
+				EXPECT_NEAR(actual.position.z, expected.position.z, tolerance.z);
+
+				// For small angles, the distance between unit vectors is the
+				// angle between them.
+				const float angle = glm::length(actual.normal - glm::normalize(expected.normal));
+				EXPECT_LT(angle, glm::radians(0.01f));
+
+				EXPECT_NEAR(actual.uv.x, expected.uv.x, 1e-3f);
+				EXPECT_NEAR(actual.uv.y, expected.uv.y, 1e-3f);
+			}
+		}
+
+		TEST(PackedMeshTest, CylinderRoundTrips)
+		{
+			ExpectRoundTrips(CreateCylinder(16, 2.0f, 0.25f));
+		}
+
+		TEST(PackedMeshTest, FlatQuadRoundTrips)
+		{
+			const MeshData quad = CreateQuad();
+			ExpectRoundTrips(quad);
+			EXPECT_EQ(PackMesh(quad).positionScale.z, 0.0f);
+		}
+
+		TEST(PackedMeshTest, SmallMeshesUseShortIndices)
+		{
+			const PackedMesh packed = PackMesh(CreateCylinder(8));
+
+			EXPECT_THAT(packed.indices, IsEmpty());
+			EXPECT_THAT(packed.shortIndices, Not(IsEmpty()));
+		}
+
+		TEST(PackedMeshTest, LargeMeshesUseLongIndices)
+		{
+			MeshData mesh;
+			for (std::uint32_t i = 0; i < 70000; ++i)
+			{
+				mesh.vertices.push_back({
+					glm::vec3(static_cast<float>(i), 0.0f, 0.0f),
+					glm::vec3(0.0f, 1.0f, 0.0f),
+					glm::vec2(0.0f) });
+			}
+			mesh.indices = { 0, 1, 69999 };
+
+			const PackedMesh packed = PackMesh(mesh);
+
+			EXPECT_THAT(packed.shortIndices, IsEmpty());
+			EXPECT_THAT(packed.indices, ElementsAreArray(mesh.indices));
+			EXPECT_EQ(packed.IndexCount(), 3u);
+		}
+
+		TEST(PackedMeshTest, EmptyMeshPacks)
+		{
+			const PackedMesh packed = PackMesh(MeshData());
+
+			EXPECT_THAT(packed.vertices, IsEmpty());
+			EXPECT_EQ(packed.IndexCount(), 0u);
+			EXPECT_THAT(UnpackMesh(packed).vertices, IsEmpty());
+		}
+	}
+}
@@ -0,0 +1,174 @@
+#include "point_cloud.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+#include <glm/gtc/constants.hpp>
+
+namespace tree_generator
+{
+	namespace
+	{
+		// Maps cross products of vectors to the cross products of the vectors
+		// transformed by the model: cross(A * u, A * v) == Cofactor(A) *
+		// cross(u, v), where A is the model's linear part. Unlike the
+		// inverse transpose, it also scales normals by the change in area.
+		glm::mat3 Cofactor(const glm::mat4& model)
+		{
+			const glm::vec3 x(model[0]);
+			const glm::vec3 y(model[1]);
+			const glm::vec3 z(model[2]);
+			return glm::mat3(glm::cross(y, z), glm::cross(z, x), glm::cross(x, y));
+		}
+
+		// Twice the area of each of the mesh's triangles under the model.
+		void GetTriangleAreas(
+			const MeshData& mesh, const glm::mat4& model, std::vector<float>* areas)
+		{
+			const glm::mat3 cofactor = Cofactor(model);
+			areas->clear();
+			for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+			{
+				const glm::vec3 a = mesh.vertices[mesh.indices[i]].position;
+				const glm::vec3 b = mesh.vertices[mesh.indices[i + 1]].position;
+				const glm::vec3 c = mesh.vertices[mesh.indices[i + 2]].position;
+				areas->push_back(glm::length(cofactor * glm::cross(b - a, c - a)));
+			}
+		}
+
+		float Sum(const std::vector<float>& values)
+		{
+			float sum = 0.0f;
+			for (float value : values)
+			{
+				sum += value;
+			}
+			return sum;
+		}
+	}
+
+	PointCloud SamplePointCloud(
+		std::span<const MeshInstances> sources, int pointCount, std::uint32_t seed)
+	{
+		if (pointCount < 0)
+		{
+			throw std::invalid_argument("Point count must not be negative");
+		}
+
+		// The area of every instance, in the order they are sampled in.
+		std::vector<float> triangleAreas;
+		std::vector<double> instanceAreas;
+		double totalArea = 0.0;
+		for (const MeshInstances& source : sources)
+		{
+			for (const glm::mat4& model : source.instances)
+			{
+				GetTriangleAreas(*source.mesh, model, &triangleAreas);
+				instanceAreas.push_back(Sum(triangleAreas));
+				totalArea += instanceAreas.back();
+			}
+		}
+
+		// Index of each source's material in the cloud's materials.
+		PointCloud cloud;
+		std::vector<std::uint32_t> sourceMaterials;
+		for (const MeshInstances& source : sources)
+		{
+			auto material = std::find_if(cloud.materials.begin(), cloud.materials.end(),
+				[&source](const Material& other) { return other.color == source.material.color; });
+			sourceMaterials.push_back(
+				static_cast<std::uint32_t>(std::distance(cloud.materials.begin(), material)));
+			if (material == cloud.materials.end())
+			{
+				cloud.materials.push_back(source.material);
+			}
+		}
+
+		if (pointCount == 0 || totalArea <= 0.0)
+		{
+			return cloud;
+		}
+		cloud.points.reserve(pointCount);
+		cloud.pointRadius = static_cast<float>(
+			std::sqrt(0.5 * totalArea / (glm::pi<double>() * pointCount)));
+
+		// Point i is placed where (i + u) / pointCount of the way through the
+		// total area falls, for a random u. The targets only increase, so the
+		// points visit the instances in order, and each instance's triangles
+		// are only measured once more.
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		auto getTarget = [&](int point) {
+			return (point + uniform(random)) / pointCount * totalArea;
+		};
+
+		int point = 0;
+		double target = getTarget(point);
+		double areaBefore = 0.0;
+		std::size_t instance = 0;
+		for (std::size_t s = 0; s < sources.size(); ++s)
+		{
+			const MeshInstances& source = sources[s];
+			for (const glm::mat4& model : source.instances)
+			{
+				const double area = instanceAreas[instance++];
+				const double areaAfter = areaBefore + area;
+
+				// Rounding can leave the last targets past the last instance.
+				const bool isLast = instance == instanceAreas.size();
+				bool isMeasured = false;
+				glm::mat3 cofactor;
+				while (point < pointCount && (target < areaAfter || isLast))
+				{
+					if (!isMeasured)
+					{
+						GetTriangleAreas(*source.mesh, model, &triangleAreas);
+						cofactor = Cofactor(model);
+						isMeasured = true;
+					}
+
+					// Where the target falls within the instance picks the
+					// triangle.
+					const double fraction = area > 0.0 ? (target - areaBefore) / area : 0.0;
+					float remaining =
+						static_cast<float>(std::clamp(fraction, 0.0, 1.0)) * Sum(triangleAreas);
+					std::size_t triangle = 0;
+					while (triangle + 1 < triangleAreas.size() && remaining >= triangleAreas[triangle])
+					{
+						remaining -= triangleAreas[triangle];
+						++triangle;
+					}
+
+					// Uniform barycentric coordinates over the triangle.
+					const float r1 = std::sqrt(uniform(random));
+					const float r2 = uniform(random);
+					const float wa = 1.0f - r1;
+					const float wb = r1 * (1.0f - r2);
+					const float wc = r1 * r2;
+					const Vertex& a = source.mesh->vertices[source.mesh->indices[triangle * 3]];
+					const Vertex& b = source.mesh->vertices[source.mesh->indices[triangle * 3 + 1]];
+					const Vertex& c = source.mesh->vertices[source.mesh->indices[triangle * 3 + 2]];
+
+					const glm::vec3 position = wa * a.position + wb * b.position + wc * c.position;
+					const glm::vec3 normal = cofactor * (wa * a.normal + wb * b.normal + wc * c.normal);
+					const float normalLength = glm::length(normal);
+					cloud.points.push_back({
+						glm::vec3(model * glm::vec4(position, 1.0f)),
+						normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f),
+						sourceMaterials[s] });
+
+					if (++point < pointCount)
+					{
+						target = getTarget(point);
+					}
+				}
+				areaBefore = areaAfter;
+			}
+		}
+		return cloud;
+	}
+}
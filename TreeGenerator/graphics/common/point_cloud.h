@@ -0,0 +1,46 @@
+#ifndef TREE_GENERATOR_POINT_CLOUD_H_
+#define TREE_GENERATOR_POINT_CLOUD_H_
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "material.h"
+#include "mesh_instances.h"
+
+namespace tree_generator
+{
+	struct SurfacePoint
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+
+		// Index of the point's material in PointCloud::materials.
+		std::uint32_t material;
+	};
+
+	// Points scattered over the surfaces of geometry, to draw it as splats
+	// where it is too small on screen for its triangles to matter.
+	struct PointCloud
+	{
+		std::vector<SurfacePoint> points;
+		std::vector<Material> materials;
+
+		// Radius of the disks that, one per point, would cover as much area
+		// as the surfaces the points were sampled from.
+		float pointRadius = 0.0f;
+	};
+
+	// Scatters pointCount points over the surfaces of the instances, with
+	// as many points per area everywhere. The points are stratified, so that
+	// every instance gets a number of points within one of its share of the
+	// area. The same seed always gives the same points. Sources with the
+	// same color share one of the cloud's materials. Throws a
+	// std::invalid_argument if pointCount is negative.
+	PointCloud SamplePointCloud(
+		std::span<const MeshInstances> sources, int pointCount, std::uint32_t seed);
+}
+
+#endif  // !TREE_GENERATOR_POINT_CLOUD_H_
@@ -0,0 +1,32 @@
+#ifndef TREE_GENERATOR_POINT_CLOUD_RENDERER_H_
+#define TREE_GENERATOR_POINT_CLOUD_RENDERER_H_
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "point_cloud.h"
+
+namespace tree_generator
+{
+	// Draws instances of a point cloud as round splats, each as large on
+	// screen as the cloud's point radius.
+	class PointCloudRenderer
+	{
+	public:
+		virtual ~PointCloudRenderer() = default;
+
+		virtual void SetPointCloud(const PointCloud& pointCloud) = 0;
+
+		// Each instance is where the origin of the point cloud is placed
+		// (xyz) and a uniform scale (w), as with impostors.
+		virtual void SetInstances(std::span<const glm::vec4> instances) = 0;
+
+		virtual void Render() = 0;
+
+	protected:
+		PointCloudRenderer() {}
+	};
+}
+
+#endif  // !TREE_GENERATOR_POINT_CLOUD_RENDERER_H_
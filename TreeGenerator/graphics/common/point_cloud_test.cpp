@@ -0,0 +1,126 @@
+#include "point_cloud.h"
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "mesh_data.h"
+
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+namespace tree_generator
+{
+	namespace
+	{
+		TEST(PointCloudTest, PointsLieOnTransformedSurface)
+		{
+			// The quad spans [-0.5, 0.5] on x and y, facing -z.
+			const MeshData quad = CreateQuad();
+			const std::array<glm::mat4, 1> instances = {
+				glm::rotate(
+					glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)),
+					glm::half_pi<float>(),
+					glm::vec3(1.0f, 0.0f, 0.0f)) };
+			const std::array<MeshInstances, 1> sources = { MeshInstances{ &quad, instances, { glm::vec4(0.5f) } } };
+
+			const PointCloud cloud = SamplePointCloud(sources, 100, 1);
+
+			ASSERT_THAT(cloud.points, SizeIs(100));
+			for (const SurfacePoint& point : cloud.points)
+			{
+				// Rotating around x turns the quad's -z normal to +y.
+				EXPECT_NEAR(point.position.y, 2.0f, 1e-5f);
+				EXPECT_NEAR(point.position.x, 1.0f, 0.5f + 1e-5f);
+				EXPECT_NEAR(point.position.z, 3.0f, 0.5f + 1e-5f);
+				EXPECT_NEAR(point.normal.x, 0.0f, 1e-5f);
+				EXPECT_NEAR(point.normal.y, 1.0f, 1e-5f);
+				EXPECT_NEAR(point.normal.z, 0.0f, 1e-5f);
+				EXPECT_EQ(point.material, 0u);
+			}
+			ASSERT_THAT(cloud.materials, SizeIs(1));
+			EXPECT_EQ(cloud.materials[0].color, glm::vec4(0.5f));
+		}
+
+		TEST(PointCloudTest, PointsAreSpreadByArea)
+		{
+			const MeshData quad = CreateQuad();
+			const std::array<glm::mat4, 2> small = {
+				glm::mat4(1.0f),
+				glm::translate(glm::mat4(1.0f), glm::vec3(5.0f, 0.0f, 0.0f)) };
+			const std::array<glm::mat4, 1> large = {
+				glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 2.0f, 1.0f)) };
+			const std::array<MeshInstances, 2> sources = {
+				MeshInstances{ &quad, small, { glm::vec4(1.0f) } },
+				MeshInstances{ &quad, large, { glm::vec4(0.5f) } } };
+
+			const PointCloud cloud = SamplePointCloud(sources, 600, 1);
+
+			// The large quad has four times the area of each small quad, and
+			// stratification keeps each share within one point.
+			int counts[3] = {};
+			for (const SurfacePoint& point : cloud.points)
+			{
+				++counts[point.material == 1 ? 2 : (point.position.x > 2.5f ? 1 : 0)];
+			}
+			EXPECT_NEAR(counts[0], 100, 1);
+			EXPECT_NEAR(counts[1], 100, 1);
+			EXPECT_NEAR(counts[2], 400, 1);
+		}
+
+		TEST(PointCloudTest, PointRadiusCoversArea)
+		{
+			const MeshData quad = CreateQuad();
+			const std::array<glm::mat4, 1> instances = {
+				glm::scale(glm::mat4(1.0f), glm::vec3(3.0f)) };
+			const std::array<MeshInstances, 1> sources = { MeshInstances{ &quad, instances, { glm::vec4(1.0f) } } };
+
+			const PointCloud cloud = SamplePointCloud(sources, 50, 1);
+
+			const float area = glm::pi<float>() * cloud.pointRadius * cloud.pointRadius * 50;
+			EXPECT_NEAR(area, 9.0f, 1e-4f);
+		}
+
+		TEST(PointCloudTest, SameSeedGivesSamePoints)
+		{
+			const MeshData cylinder = CreateCylinder(8);
+			const std::array<glm::mat4, 3> instances = {
+				glm::mat4(1.0f),
+				glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+				glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, 0.0f)) };
+			const std::array<MeshInstances, 1> sources = { MeshInstances{ &cylinder, instances, { glm::vec4(1.0f) } } };
+
+			const PointCloud first = SamplePointCloud(sources, 64, 3);
+			const PointCloud second = SamplePointCloud(sources, 64, 3);
+			const PointCloud other = SamplePointCloud(sources, 64, 4);
+
+			ASSERT_THAT(first.points, SizeIs(64));
+			ASSERT_THAT(second.points, SizeIs(64));
+			ASSERT_THAT(other.points, SizeIs(64));
+			for (std::size_t i = 0; i < first.points.size(); ++i)
+			{
+				EXPECT_EQ(first.points[i].position, second.points[i].position);
+			}
+			EXPECT_NE(first.points[0].position, other.points[0].position);
+		}
+
+		TEST(PointCloudTest, NoAreaGivesNoPoints)
+		{
+			const MeshData quad = CreateQuad();
+			const std::array<glm::mat4, 1> flattened = {
+				glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 0.0f, 1.0f)) };
+			const std::array<MeshInstances, 1> sources = { MeshInstances{ &quad, flattened, { glm::vec4(1.0f) } } };
+
+			EXPECT_THAT(SamplePointCloud(sources, 10, 1).points, IsEmpty());
+			EXPECT_THAT(SamplePointCloud({}, 10, 1).points, IsEmpty());
+			EXPECT_THROW(SamplePointCloud(sources, -1, 1), std::invalid_argument);
+		}
+	}
+}
@@ -6,7 +6,9 @@
 namespace tree_generator
 {
 	class Camera;
+	class ImpostorRenderer;
 	class MeshRenderer;
+	class PointCloudRenderer;
 
 	// Manages the backend graphics library (e.g. OpenGL, Vulkan, etc) and the
 	// creation of classes that need to interact with it.
@@ -17,6 +19,8 @@ namespace tree_generator
 
 		virtual std::unique_ptr<Camera> CreateCamera() = 0;
 		virtual std::unique_ptr<MeshRenderer> CreateMeshRenderer() = 0;
+		virtual std::unique_ptr<ImpostorRenderer> CreateImpostorRenderer() = 0;
+		virtual std::unique_ptr<PointCloudRenderer> CreatePointCloudRenderer() = 0;
 
 	protected:
 		RenderContext() {}
@@ -0,0 +1,28 @@
+#include "transform.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace tree_generator
+{
+	glm::mat4 ToMatrix(const Transform& transform)
+	{
+		glm::mat4 matrix = glm::mat4(1.0f);
+
+		matrix = glm::translate(matrix, transform.position);
+
+		matrix = glm::rotate(
+			matrix,
+			glm::radians(transform.rotation.z),
+			glm::vec3(0.0f, 0.0f, 1.0f));
+		matrix = glm::rotate(
+			matrix,
+			glm::radians(transform.rotation.y),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		matrix = glm::rotate(
+			matrix,
+			glm::radians(transform.rotation.x),
+			glm::vec3(1.0f, 0.0f, 0.0f));
+
+		return glm::scale(matrix, glm::vec3(transform.scale));
+	}
+}
@@ -11,6 +11,10 @@ namespace tree_generator
 		glm::vec3 rotation;
 		float scale;
 	};
+
+	// Returns the model matrix for the transform: translation, then rotation
+	// around z, y and x (in degrees), then uniform scale.
+	glm::mat4 ToMatrix(const Transform& transform);
 }
 
-#endif  // !TREE_GENERATOR_TRANSFORM_H_
\ No newline at end of file
+#endif  // !TREE_GENERATOR_TRANSFORM_H_
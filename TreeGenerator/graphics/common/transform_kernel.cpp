@@ -0,0 +1,364 @@
+#include "transform_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define TREE_GENERATOR_TRANSFORM_KERNEL_AVX2
+#define TREE_GENERATOR_TRANSFORM_KERNEL_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TREE_GENERATOR_TRANSFORM_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace tree_generator
+{
+	namespace
+	{
+		// Transforms are gathered into structure-of-arrays blocks of this
+		// many elements by the array-of-structures overload.
+		constexpr std::size_t kGatherBlockSize = 256;
+
+		void ConvertScalar(
+			const TransformArrays& transforms,
+			std::size_t begin,
+			glm::mat4* matrices)
+		{
+			for (std::size_t i = begin; i < transforms.count; ++i)
+			{
+				const float sx = std::sin(glm::radians(transforms.rotationX[i]));
+				const float cx = std::cos(glm::radians(transforms.rotationX[i]));
+				const float sy = std::sin(glm::radians(transforms.rotationY[i]));
+				const float cy = std::cos(glm::radians(transforms.rotationY[i]));
+				const float sz = std::sin(glm::radians(transforms.rotationZ[i]));
+				const float cz = std::cos(glm::radians(transforms.rotationZ[i]));
+				const float s = transforms.scale[i];
+
+				// Columns of T * Rz * Ry * Rx * S.
+				matrices[i] = glm::mat4(
+					glm::vec4(cz * cy * s, sz * cy * s, -sy * s, 0.0f),
+					glm::vec4(
+						(cz * sy * sx - sz * cx) * s,
+						(sz * sy * sx + cz * cx) * s,
+						cy * sx * s,
+						0.0f),
+					glm::vec4(
+						(cz * sy * cx + sz * sx) * s,
+						(sz * sy * cx - cz * sx) * s,
+						cy * cx * s,
+						0.0f),
+					glm::vec4(
+						transforms.positionX[i],
+						transforms.positionY[i],
+						transforms.positionZ[i],
+						1.0f));
+			}
+		}
+
+#ifdef TREE_GENERATOR_TRANSFORM_KERNEL_SSE2
+		// Thin wrappers around the SIMD registers, so the kernel below can be
+		// written once for every vector width.
+		struct Int4
+		{
+			__m128i v;
+
+			static Int4 Broadcast(int value) { return { _mm_set1_epi32(value) }; }
+
+			friend Int4 operator+(Int4 a, Int4 b) { return { _mm_add_epi32(a.v, b.v) }; }
+			friend Int4 operator-(Int4 a, Int4 b) { return { _mm_sub_epi32(a.v, b.v) }; }
+			friend Int4 operator&(Int4 a, Int4 b) { return { _mm_and_si128(a.v, b.v) }; }
+			// Returns ~a & b.
+			friend Int4 AndNot(Int4 a, Int4 b) { return { _mm_andnot_si128(a.v, b.v) }; }
+			friend Int4 ShiftLeft29(Int4 a) { return { _mm_slli_epi32(a.v, 29) }; }
+		};
+
+		struct Float4
+		{
+			using Int = Int4;
+			static constexpr std::size_t kWidth = 4;
+
+			__m128 v;
+
+			static Float4 Load(const float* values) { return { _mm_loadu_ps(values) }; }
+			static Float4 Broadcast(float value) { return { _mm_set1_ps(value) }; }
+			static Float4 FromInt(Int4 a) { return { _mm_cvtepi32_ps(a.v) }; }
+			static Float4 FromBits(Int4 a) { return { _mm_castsi128_ps(a.v) }; }
+			// All bits set in the lanes of `a` that are zero.
+			static Float4 EqualZero(Int4 a)
+			{
+				return { _mm_castsi128_ps(_mm_cmpeq_epi32(a.v, _mm_setzero_si128())) };
+			}
+
+			friend Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+			friend Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+			friend Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+			friend Float4 operator&(Float4 a, Float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+			friend Float4 operator|(Float4 a, Float4 b) { return { _mm_or_ps(a.v, b.v) }; }
+			friend Float4 operator^(Float4 a, Float4 b) { return { _mm_xor_ps(a.v, b.v) }; }
+			// Returns ~a & b.
+			friend Float4 AndNot(Float4 a, Float4 b) { return { _mm_andnot_ps(a.v, b.v) }; }
+			friend Int4 Truncate(Float4 a) { return { _mm_cvttps_epi32(a.v) }; }
+			friend Float4 Round(Float4 a) { return { _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)) }; }
+
+			// Writes (x, y, z, w) of lane i to the column of the i-th matrix.
+			friend void StoreColumn(
+				float* column, Float4 x, Float4 y, Float4 z, Float4 w)
+			{
+				_MM_TRANSPOSE4_PS(x.v, y.v, z.v, w.v);
+				_mm_storeu_ps(column, x.v);
+				_mm_storeu_ps(column + 16, y.v);
+				_mm_storeu_ps(column + 32, z.v);
+				_mm_storeu_ps(column + 48, w.v);
+			}
+		};
+#endif
+
+#ifdef TREE_GENERATOR_TRANSFORM_KERNEL_AVX2
+		struct Int8
+		{
+			__m256i v;
+
+			static Int8 Broadcast(int value) { return { _mm256_set1_epi32(value) }; }
+
+			friend Int8 operator+(Int8 a, Int8 b) { return { _mm256_add_epi32(a.v, b.v) }; }
+			friend Int8 operator-(Int8 a, Int8 b) { return { _mm256_sub_epi32(a.v, b.v) }; }
+			friend Int8 operator&(Int8 a, Int8 b) { return { _mm256_and_si256(a.v, b.v) }; }
+			friend Int8 AndNot(Int8 a, Int8 b) { return { _mm256_andnot_si256(a.v, b.v) }; }
+			friend Int8 ShiftLeft29(Int8 a) { return { _mm256_slli_epi32(a.v, 29) }; }
+		};
+
+		struct Float8
+		{
+			using Int = Int8;
+			static constexpr std::size_t kWidth = 8;
+
+			__m256 v;
+
+			static Float8 Load(const float* values) { return { _mm256_loadu_ps(values) }; }
+			static Float8 Broadcast(float value) { return { _mm256_set1_ps(value) }; }
+			static Float8 FromInt(Int8 a) { return { _mm256_cvtepi32_ps(a.v) }; }
+			static Float8 FromBits(Int8 a) { return { _mm256_castsi256_ps(a.v) }; }
+			static Float8 EqualZero(Int8 a)
+			{
+				return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, _mm256_setzero_si256())) };
+			}
+
+			friend Float8 operator+(Float8 a, Float8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+			friend Float8 operator-(Float8 a, Float8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+			friend Float8 operator*(Float8 a, Float8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+			friend Float8 operator&(Float8 a, Float8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+			friend Float8 operator|(Float8 a, Float8 b) { return { _mm256_or_ps(a.v, b.v) }; }
+			friend Float8 operator^(Float8 a, Float8 b) { return { _mm256_xor_ps(a.v, b.v) }; }
+			friend Float8 AndNot(Float8 a, Float8 b) { return { _mm256_andnot_ps(a.v, b.v) }; }
+			friend Int8 Truncate(Float8 a) { return { _mm256_cvttps_epi32(a.v) }; }
+			friend Float8 Round(Float8 a)
+			{
+				return { _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC) };
+			}
+
+			// Each 128-bit half holds four whole matrices, so the columns are
+			// transposed and written in two halves.
+			friend void StoreColumn(
+				float* column, Float8 x, Float8 y, Float8 z, Float8 w)
+			{
+				StoreColumn(
+					column,
+					Float4{ _mm256_castps256_ps128(x.v) },
+					Float4{ _mm256_castps256_ps128(y.v) },
+					Float4{ _mm256_castps256_ps128(z.v) },
+					Float4{ _mm256_castps256_ps128(w.v) });
+				StoreColumn(
+					column + 64,
+					Float4{ _mm256_extractf128_ps(x.v, 1) },
+					Float4{ _mm256_extractf128_ps(y.v, 1) },
+					Float4{ _mm256_extractf128_ps(z.v, 1) },
+					Float4{ _mm256_extractf128_ps(w.v, 1) });
+			}
+		};
+
+		using KernelFloat = Float8;
+		constexpr const char* kInstructionSet = "AVX2";
+#elif defined(TREE_GENERATOR_TRANSFORM_KERNEL_SSE2)
+		using KernelFloat = Float4;
+		constexpr const char* kInstructionSet = "SSE2";
+#else
+		constexpr const char* kInstructionSet = "Scalar";
+#endif
+
+#ifdef TREE_GENERATOR_TRANSFORM_KERNEL_SSE2
+		// Converts degrees to radians in [-pi, pi]. Removing whole turns while
+		// still in degrees keeps large accumulated angles accurate, and keeps
+		// the range reduction in SinCos() short.
+		template <typename TFloat>
+		TFloat DegreesToRadians(TFloat degrees)
+		{
+			const TFloat turns = Round(degrees * TFloat::Broadcast(1.0f / 360.0f));
+			return (degrees - turns * TFloat::Broadcast(360.0f))
+				* TFloat::Broadcast(0.01745329251994329577f);
+		}
+
+		// Computes sin(x) and cos(x) together, following the Cephes sinf and
+		// cosf implementations: x is reduced to [-pi/4, pi/4] by multiples of
+		// pi/2 and the octant picks between the sine and cosine polynomials
+		// and their signs.
+		template <typename TFloat>
+		void SinCos(TFloat x, TFloat* sine, TFloat* cosine)
+		{
+			using TInt = typename TFloat::Int;
+
+			const TFloat signMask = TFloat::Broadcast(-0.0f);
+			TFloat sineSign = x & signMask;
+			x = AndNot(signMask, x);
+
+			// Round the octant up to an even number, so the remainder is
+			// centered around zero.
+			TInt octant = Truncate(x * TFloat::Broadcast(1.27323954473516f));
+			octant = (octant + TInt::Broadcast(1)) & TInt::Broadcast(~1);
+			const TFloat y = TFloat::FromInt(octant);
+
+			sineSign = sineSign
+				^ TFloat::FromBits(ShiftLeft29(octant & TInt::Broadcast(4)));
+			const TFloat cosineSign = TFloat::FromBits(
+				ShiftLeft29(AndNot(octant - TInt::Broadcast(2), TInt::Broadcast(4))));
+			const TFloat useSinePolynomial =
+				TFloat::EqualZero(octant & TInt::Broadcast(2));
+
+			// Extended precision subtraction of y * pi/4.
+			x = x - y * TFloat::Broadcast(0.78515625f);
+			x = x - y * TFloat::Broadcast(2.4187564849853515625e-4f);
+			x = x - y * TFloat::Broadcast(3.77489497744594108e-8f);
+
+			const TFloat z = x * x;
+
+			TFloat cosinePolynomial = TFloat::Broadcast(2.443315711809948e-5f);
+			cosinePolynomial = cosinePolynomial * z - TFloat::Broadcast(1.388731625493765e-3f);
+			cosinePolynomial = cosinePolynomial * z + TFloat::Broadcast(4.166664568298827e-2f);
+			cosinePolynomial = cosinePolynomial * z * z
+				- z * TFloat::Broadcast(0.5f)
+				+ TFloat::Broadcast(1.0f);
+
+			TFloat sinePolynomial = TFloat::Broadcast(-1.9515295891e-4f);
+			sinePolynomial = sinePolynomial * z + TFloat::Broadcast(8.3321608736e-3f);
+			sinePolynomial = sinePolynomial * z - TFloat::Broadcast(1.6666654611e-1f);
+			sinePolynomial = sinePolynomial * z * x + x;
+
+			*sine = ((useSinePolynomial & sinePolynomial)
+				| AndNot(useSinePolynomial, cosinePolynomial)) ^ sineSign;
+			*cosine = ((useSinePolynomial & cosinePolynomial)
+				| AndNot(useSinePolynomial, sinePolynomial)) ^ cosineSign;
+		}
+
+		// Converts the TFloat::kWidth transforms starting at `first`.
+		template <typename TFloat>
+		void ConvertBatch(
+			const TransformArrays& transforms,
+			std::size_t first,
+			float* matrices)
+		{
+			TFloat sx, cx, sy, cy, sz, cz;
+			SinCos(DegreesToRadians(TFloat::Load(transforms.rotationX + first)), &sx, &cx);
+			SinCos(DegreesToRadians(TFloat::Load(transforms.rotationY + first)), &sy, &cy);
+			SinCos(DegreesToRadians(TFloat::Load(transforms.rotationZ + first)), &sz, &cz);
+			const TFloat s = TFloat::Load(transforms.scale + first);
+
+			const TFloat czsy = cz * sy;
+			const TFloat szsy = sz * sy;
+			const TFloat zero = TFloat::Broadcast(0.0f);
+
+			// Columns of T * Rz * Ry * Rx * S, as in ConvertScalar().
+			float* matrix = matrices + first * 16;
+			StoreColumn(
+				matrix,
+				cz * cy * s,
+				sz * cy * s,
+				(zero - sy) * s,
+				zero);
+			StoreColumn(
+				matrix + 4,
+				(czsy * sx - sz * cx) * s,
+				(szsy * sx + cz * cx) * s,
+				cy * sx * s,
+				zero);
+			StoreColumn(
+				matrix + 8,
+				(czsy * cx + sz * sx) * s,
+				(szsy * cx - cz * sx) * s,
+				cy * cx * s,
+				zero);
+			StoreColumn(
+				matrix + 12,
+				TFloat::Load(transforms.positionX + first),
+				TFloat::Load(transforms.positionY + first),
+				TFloat::Load(transforms.positionZ + first),
+				TFloat::Broadcast(1.0f));
+		}
+#endif
+	}
+
+	void ToMatrices(const TransformArrays& transforms, glm::mat4* matrices)
+	{
+		std::size_t index = 0;
+
+#ifdef TREE_GENERATOR_TRANSFORM_KERNEL_SSE2
+		if (transforms.count > 0)
+		{
+			float* values = &matrices[0][0][0];
+			for (; index + KernelFloat::kWidth <= transforms.count;
+				index += KernelFloat::kWidth)
+			{
+				ConvertBatch<KernelFloat>(transforms, index, values);
+			}
+		}
+#endif
+
+		ConvertScalar(transforms, index, matrices);
+	}
+
+	void ToMatrices(std::span<const Transform> transforms, glm::mat4* matrices)
+	{
+		alignas(64) float positionX[kGatherBlockSize];
+		alignas(64) float positionY[kGatherBlockSize];
+		alignas(64) float positionZ[kGatherBlockSize];
+		alignas(64) float rotationX[kGatherBlockSize];
+		alignas(64) float rotationY[kGatherBlockSize];
+		alignas(64) float rotationZ[kGatherBlockSize];
+		alignas(64) float scale[kGatherBlockSize];
+
+		for (std::size_t begin = 0; begin < transforms.size(); begin += kGatherBlockSize)
+		{
+			const std::size_t count =
+				std::min(kGatherBlockSize, transforms.size() - begin);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const Transform& transform = transforms[begin + i];
+				positionX[i] = transform.position.x;
+				positionY[i] = transform.position.y;
+				positionZ[i] = transform.position.z;
+				rotationX[i] = transform.rotation.x;
+				rotationY[i] = transform.rotation.y;
+				rotationZ[i] = transform.rotation.z;
+				scale[i] = transform.scale;
+			}
+
+			ToMatrices(
+				{
+					positionX, positionY, positionZ,
+					rotationX, rotationY, rotationZ,
+					scale,
+					count
+				},
+				matrices + begin);
+		}
+	}
+
+	void ToMatricesScalar(const TransformArrays& transforms, glm::mat4* matrices)
+	{
+		ConvertScalar(transforms, 0, matrices);
+	}
+
+	const char* GetTransformKernelInstructionSet()
+	{
+		return kInstructionSet;
+	}
+}
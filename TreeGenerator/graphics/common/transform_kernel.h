@@ -0,0 +1,48 @@
+#ifndef TREE_GENERATOR_TRANSFORM_KERNEL_H_
+#define TREE_GENERATOR_TRANSFORM_KERNEL_H_
+
+#include <cstddef>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "transform.h"
+
+namespace tree_generator
+{
+	// Read-only structure-of-arrays view over a batch of transforms. Every
+	// array must hold at least `count` values; rotations are in degrees.
+	struct TransformArrays
+	{
+		const float* positionX;
+		const float* positionY;
+		const float* positionZ;
+		const float* rotationX;
+		const float* rotationY;
+		const float* rotationZ;
+		const float* scale;
+		std::size_t count;
+	};
+
+	// Writes the model matrix of every transform in the batch to
+	// `matrices[0..count)`, matching ToMatrix() to within float rounding.
+	//
+	// Transforms are converted 8 (AVX2) or 4 (SSE2) at a time depending on
+	// the instruction set the library was compiled for, with a scalar loop
+	// for the remainder and for targets without either.
+	void ToMatrices(const TransformArrays& transforms, glm::mat4* matrices);
+
+	// Convenience overload for array-of-structures input. The transforms are
+	// gathered into structure-of-arrays blocks before conversion.
+	void ToMatrices(std::span<const Transform> transforms, glm::mat4* matrices);
+
+	// The scalar fallback of ToMatrices(), exposed for testing and
+	// benchmarking.
+	void ToMatricesScalar(const TransformArrays& transforms, glm::mat4* matrices);
+
+	// Name of the instruction set used by ToMatrices(): "AVX2", "SSE2" or
+	// "Scalar".
+	const char* GetTransformKernelInstructionSet();
+}
+
+#endif  // !TREE_GENERATOR_TRANSFORM_KERNEL_H_
@@ -0,0 +1,128 @@
+#include "transform_kernel.h"
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+
+#include "transform.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		// Transforms stored both ways, so every variant converts the same
+		// input.
+		struct TransformBatch
+		{
+			explicit TransformBatch(std::size_t count)
+			{
+				std::mt19937 random(42);
+				std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+				std::uniform_real_distribution<float> rotation(-360.0f, 360.0f);
+				std::uniform_real_distribution<float> scale(0.1f, 2.0f);
+
+				transforms.resize(count);
+				for (Transform& transform : transforms)
+				{
+					transform.position = glm::vec3(
+						position(random), position(random), position(random));
+					transform.rotation = glm::vec3(
+						rotation(random), rotation(random), rotation(random));
+					transform.scale = scale(random);
+
+					positionX.push_back(transform.position.x);
+					positionY.push_back(transform.position.y);
+					positionZ.push_back(transform.position.z);
+					rotationX.push_back(transform.rotation.x);
+					rotationY.push_back(transform.rotation.y);
+					rotationZ.push_back(transform.rotation.z);
+					this->scale.push_back(transform.scale);
+				}
+			}
+
+			TransformArrays Arrays() const
+			{
+				return {
+					positionX.data(), positionY.data(), positionZ.data(),
+					rotationX.data(), rotationY.data(), rotationZ.data(),
+					scale.data(),
+					transforms.size()
+				};
+			}
+
+			std::vector<Transform> transforms;
+			std::vector<float> positionX, positionY, positionZ;
+			std::vector<float> rotationX, rotationY, rotationZ;
+			std::vector<float> scale;
+		};
+
+		void BM_ToMatrix(benchmark::State& state)
+		{
+			const TransformBatch batch(state.range(0));
+			std::vector<glm::mat4> matrices(batch.transforms.size());
+
+			for (auto _ : state)
+			{
+				for (std::size_t i = 0; i < batch.transforms.size(); ++i)
+				{
+					matrices[i] = ToMatrix(batch.transforms[i]);
+				}
+				benchmark::DoNotOptimize(matrices.data());
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		void BM_ToMatricesScalar(benchmark::State& state)
+		{
+			const TransformBatch batch(state.range(0));
+			std::vector<glm::mat4> matrices(batch.transforms.size());
+
+			for (auto _ : state)
+			{
+				ToMatricesScalar(batch.Arrays(), matrices.data());
+				benchmark::DoNotOptimize(matrices.data());
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		void BM_ToMatrices(benchmark::State& state)
+		{
+			const TransformBatch batch(state.range(0));
+			std::vector<glm::mat4> matrices(batch.transforms.size());
+			state.SetLabel(GetTransformKernelInstructionSet());
+
+			for (auto _ : state)
+			{
+				ToMatrices(batch.Arrays(), matrices.data());
+				benchmark::DoNotOptimize(matrices.data());
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		void BM_ToMatricesFromTransforms(benchmark::State& state)
+		{
+			const TransformBatch batch(state.range(0));
+			std::vector<glm::mat4> matrices(batch.transforms.size());
+			state.SetLabel(GetTransformKernelInstructionSet());
+
+			for (auto _ : state)
+			{
+				ToMatrices(batch.transforms, matrices.data());
+				benchmark::DoNotOptimize(matrices.data());
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * state.range(0));
+		}
+
+		BENCHMARK(BM_ToMatrix)->Arg(1 << 10)->Arg(100000);
+		BENCHMARK(BM_ToMatricesScalar)->Arg(1 << 10)->Arg(100000);
+		BENCHMARK(BM_ToMatrices)->Arg(1 << 10)->Arg(100000);
+		BENCHMARK(BM_ToMatricesFromTransforms)->Arg(1 << 10)->Arg(100000);
+	}
+}
@@ -0,0 +1,141 @@
+#include "transform_kernel.h"
+
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "transform.h"
+
+namespace tree_generator
+{
+	namespace
+	{
+		constexpr float kTolerance = 1e-5f;
+
+		// The reference converts to radians before reducing the angle, which
+		// loses precision for angles of many turns.
+		constexpr float kLargeAngleTolerance = 1e-4f;
+
+		std::vector<Transform> CreateRandomTransforms(
+			std::size_t count, float maxDegrees)
+		{
+			std::mt19937 random(42);
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+			std::uniform_real_distribution<float> rotation(-maxDegrees, maxDegrees);
+			std::uniform_real_distribution<float> scale(0.1f, 2.0f);
+
+			std::vector<Transform> transforms(count);
+			for (Transform& transform : transforms)
+			{
+				transform.position = glm::vec3(
+					position(random), position(random), position(random));
+				transform.rotation = glm::vec3(
+					rotation(random), rotation(random), rotation(random));
+				transform.scale = scale(random);
+			}
+			return transforms;
+		}
+
+		// Compares against ToMatrix(), relative to the size of the transform.
+		void ExpectMatchesReference(
+			const std::vector<Transform>& transforms,
+			const std::vector<glm::mat4>& matrices,
+			float tolerance = kTolerance)
+		{
+			ASSERT_EQ(transforms.size(), matrices.size());
+			for (std::size_t i = 0; i < transforms.size(); ++i)
+			{
+				const glm::mat4 expected = ToMatrix(transforms[i]);
+				for (int column = 0; column < 4; ++column)
+				{
+					const float columnTolerance = column == 3
+						? 0.0f
+						: tolerance * transforms[i].scale;
+					for (int row = 0; row < 4; ++row)
+					{
+						EXPECT_NEAR(matrices[i][column][row], expected[column][row], columnTolerance)
+							<< "instance " << i << ", column " << column << ", row " << row;
+					}
+				}
+			}
+		}
+
+		TEST(GraphicsTransformKernelTest, MatchesReference)
+		{
+			// An odd count exercises both the vector and the remainder loops.
+			const std::vector<Transform> transforms = CreateRandomTransforms(1003, 360.0f);
+			std::vector<glm::mat4> matrices(transforms.size());
+
+			ToMatrices(transforms, matrices.data());
+
+			ExpectMatchesReference(transforms, matrices);
+		}
+
+		TEST(GraphicsTransformKernelTest, MatchesReferenceForLargeAngles)
+		{
+			const std::vector<Transform> transforms = CreateRandomTransforms(256, 20000.0f);
+			std::vector<glm::mat4> matrices(transforms.size());
+
+			ToMatrices(transforms, matrices.data());
+
+			ExpectMatchesReference(transforms, matrices, kLargeAngleTolerance);
+		}
+
+		TEST(GraphicsTransformKernelTest, MatchesReferenceForOctantBoundaries)
+		{
+			std::vector<Transform> transforms;
+			for (float degrees = -720.0f; degrees <= 720.0f; degrees += 45.0f)
+			{
+				transforms.push_back({ glm::vec3(0.0f), glm::vec3(degrees, 0.0f, 0.0f), 1.0f });
+				transforms.push_back({ glm::vec3(0.0f), glm::vec3(0.0f, degrees, 0.0f), 1.0f });
+				transforms.push_back({ glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, degrees), 1.0f });
+			}
+			std::vector<glm::mat4> matrices(transforms.size());
+
+			ToMatrices(transforms, matrices.data());
+
+			ExpectMatchesReference(transforms, matrices);
+		}
+
+		TEST(GraphicsTransformKernelTest, ScalarMatchesReference)
+		{
+			const std::vector<Transform> transforms = CreateRandomTransforms(17, 360.0f);
+			std::vector<float> px, py, pz, rx, ry, rz, s;
+			for (const Transform& transform : transforms)
+			{
+				px.push_back(transform.position.x);
+				py.push_back(transform.position.y);
+				pz.push_back(transform.position.z);
+				rx.push_back(transform.rotation.x);
+				ry.push_back(transform.rotation.y);
+				rz.push_back(transform.rotation.z);
+				s.push_back(transform.scale);
+			}
+			std::vector<glm::mat4> matrices(transforms.size());
+
+			ToMatricesScalar(
+				{
+					px.data(), py.data(), pz.data(),
+					rx.data(), ry.data(), rz.data(),
+					s.data(),
+					transforms.size()
+				},
+				matrices.data());
+
+			ExpectMatchesReference(transforms, matrices);
+		}
+
+		TEST(GraphicsTransformKernelTest, EmptyBatchWritesNothing)
+		{
+			glm::mat4 matrix(7.0f);
+
+			ToMatrices(std::span<const Transform>(), &matrix);
+
+			EXPECT_EQ(matrix, glm::mat4(7.0f));
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#include "egl_context.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+
+namespace tree_generator::opengl
+{
+	namespace
+	{
+		bool HasExtension(const char* extensions, const char* extension)
+		{
+			return extensions != nullptr && std::strstr(extensions, extension) != nullptr;
+		}
+
+		// Prefers Mesa's surfaceless platform, which needs neither an X
+		// server nor a GPU device, over whatever the default display is.
+		EGLDisplay GetDisplay()
+		{
+			const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+			if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+			{
+				auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+					eglGetProcAddress("eglGetPlatformDisplayEXT"));
+				if (getPlatformDisplay != nullptr)
+				{
+					EGLDisplay display = getPlatformDisplay(
+						EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+					if (display != EGL_NO_DISPLAY)
+					{
+						return display;
+					}
+				}
+			}
+			return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+	}
+
+	EglContext::EglContext() :
+		display_(EGL_NO_DISPLAY),
+		context_(EGL_NO_CONTEXT)
+	{
+		EGLDisplay display = GetDisplay();
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+		{
+			throw std::runtime_error("Failed to initialize an EGL display");
+		}
+		display_ = display;
+
+		if (!eglBindAPI(EGL_OPENGL_API))
+		{
+			eglTerminate(display);
+			throw std::runtime_error("EGL display does not support OpenGL");
+		}
+
+		// No surface is ever created, so any config that renders OpenGL will
+		// do.
+		const EGLint configAttributes[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE,
+		};
+		EGLConfig config = nullptr;
+		EGLint configCount = 0;
+		if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) ||
+			configCount == 0)
+		{
+			config = nullptr;
+		}
+
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE,
+		};
+		EGLContext context = eglCreateContext(
+			display, config, EGL_NO_CONTEXT, contextAttributes);
+		if (context == EGL_NO_CONTEXT)
+		{
+			eglTerminate(display);
+			throw std::runtime_error("Failed to create an OpenGL 3.3 context");
+		}
+		context_ = context;
+
+		if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+		{
+			eglDestroyContext(display, context);
+			eglTerminate(display);
+			throw std::runtime_error("Failed to make the surfaceless context current");
+		}
+
+		if (gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)) == 0)
+		{
+			eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(display, context);
+			eglTerminate(display);
+			throw std::runtime_error("Failed to load OpenGL");
+		}
+	}
+
+	EglContext::~EglContext()
+	{
+		eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display_, context_);
+		eglTerminate(display_);
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef TREE_GENERATOR_OPENGL_EGL_CONTEXT_H_
+#define TREE_GENERATOR_OPENGL_EGL_CONTEXT_H_
+
+namespace tree_generator::opengl
+{
+	// An OpenGL 3.3 core context without a window or surface, for rendering
+	// into framebuffer objects on machines without a display (e.g. with
+	// Mesa's llvmpipe on a build server). The context is made current and
+	// OpenGL is loaded on construction; throws a std::runtime_error if no
+	// such context can be created.
+	class EglContext
+	{
+	public:
+		EglContext();
+		~EglContext();
+
+		EglContext(const EglContext&) = delete;
+		EglContext& operator=(const EglContext&) = delete;
+
+	private:
+		void* display_;
+		void* context_;
+	};
+}
+
+#endif  // !TREE_GENERATOR_OPENGL_EGL_CONTEXT_H_
@@ -22,7 +22,9 @@ namespace tree_generator::opengl
 	OpenGLCamera::OpenGLCamera(unsigned int uniformBlockIndex) :
 		clearColor_(0.0f, 0.0f, 0.0f),
 		uniformBuffer_(0),
-		viewport_({})
+		viewport_({}),
+		view_(1.0f),
+		projection_(1.0f)
 	{
 		glGenBuffers(1, &uniformBuffer_);
 		glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer_);
@@ -42,6 +44,7 @@ namespace tree_generator::opengl
 
 	void OpenGLCamera::SetView(glm::mat4 view)
 	{
+		view_ = view;
 		glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer_);
 		glBufferSubData(
 			GL_UNIFORM_BUFFER,
@@ -53,7 +56,7 @@ namespace tree_generator::opengl
 	void OpenGLCamera::SetViewport(Viewport viewport)
 	{
 		viewport_ = viewport;
-		glm::mat4 projection = glm::perspective(
+		projection_ = glm::perspective(
 			glm::radians(45.0f),
 			(float)viewport.width / viewport.height,
 			0.1f, 1000.0f);
@@ -62,7 +65,17 @@ namespace tree_generator::opengl
 			GL_UNIFORM_BUFFER,
 			offsetof(CameraData, projection),
 			sizeof(glm::mat4),
-			&projection);
+			&projection_);
+	}
+
+	glm::mat4 OpenGLCamera::GetViewProjection() const
+	{
+		return projection_ * view_;
+	}
+
+	Frustum OpenGLCamera::GetFrustum() const
+	{
+		return Frustum::FromMatrix(GetViewProjection());
 	}
 
 	void OpenGLCamera::Bind()
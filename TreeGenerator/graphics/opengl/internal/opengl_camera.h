@@ -17,10 +17,15 @@ namespace tree_generator::opengl
 		void SetView(glm::mat4 view) override;
 		void SetViewport(Viewport viewport) override;
 
+		glm::mat4 GetViewProjection() const override;
+		Frustum GetFrustum() const override;
+
 		void Bind() override;
 
 	private:
 		Viewport viewport_;
+		glm::mat4 view_;
+		glm::mat4 projection_;
 		glm::vec3 clearColor_;
 		unsigned int uniformBuffer_;
 	};
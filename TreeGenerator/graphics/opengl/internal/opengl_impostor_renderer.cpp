@@ -0,0 +1,127 @@
+#include "opengl_impostor_renderer.h"
+
+#include <glad/glad.h>
+
+#include "shader_program.h"
+
+namespace tree_generator::opengl
+{
+	OpenGLImpostorRenderer::OpenGLImpostorRenderer(ShaderProgram* shader) :
+		vertexArray_(0),
+		cornerBuffer_(0),
+		instanceBuffer_(0),
+		colorTexture_(0),
+		depthTexture_(0),
+
+		instanceCount_(0),
+		frameCount_(0),
+		sphere_(0.0f),
+
+		shader_(shader)
+	{
+		glGenVertexArrays(1, &vertexArray_);
+		glGenBuffers(1, &cornerBuffer_);
+		glGenBuffers(1, &instanceBuffer_);
+		glGenTextures(1, &colorTexture_);
+		glGenTextures(1, &depthTexture_);
+
+		// Corners of the quad, drawn as a triangle strip.
+		const glm::vec2 corners[] = {
+			{ -1.0f, -1.0f },
+			{ 1.0f, -1.0f },
+			{ -1.0f, 1.0f },
+			{ 1.0f, 1.0f },
+		};
+
+		glBindVertexArray(vertexArray_);
+
+		glBindBuffer(GL_ARRAY_BUFFER, cornerBuffer_);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+		glEnableVertexAttribArray(0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribDivisor(1, 1);
+
+		// Colors are filtered for smoother edges. Depths are not, since
+		// blending the depth of a branch with the background's would place
+		// the edges of the branch somewhere behind it.
+		glBindTexture(GL_TEXTURE_2D, colorTexture_);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindTexture(GL_TEXTURE_2D, depthTexture_);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	OpenGLImpostorRenderer::~OpenGLImpostorRenderer()
+	{
+		glDeleteBuffers(1, &cornerBuffer_);
+		glDeleteBuffers(1, &instanceBuffer_);
+		glDeleteTextures(1, &colorTexture_);
+		glDeleteTextures(1, &depthTexture_);
+		glDeleteVertexArrays(1, &vertexArray_);
+	}
+
+	void OpenGLImpostorRenderer::SetAtlas(const ImpostorAtlas& atlas)
+	{
+		frameCount_ = atlas.frameCount;
+		sphere_ = glm::vec4(atlas.center, atlas.radius);
+
+		const int size = atlas.GetSize();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		glBindTexture(GL_TEXTURE_2D, colorTexture_);
+		glTexImage2D(
+			GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, atlas.color.data());
+
+		glBindTexture(GL_TEXTURE_2D, depthTexture_);
+		glTexImage2D(
+			GL_TEXTURE_2D, 0, GL_R32F, size, size, 0,
+			GL_RED, GL_FLOAT, atlas.depth.data());
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	void OpenGLImpostorRenderer::SetInstances(std::span<const glm::vec4> instances)
+	{
+		instanceCount_ = instances.size();
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			sizeof(glm::vec4) * instances.size(),
+			instances.data(),
+			GL_STREAM_DRAW);
+	}
+
+	void OpenGLImpostorRenderer::Render()
+	{
+		if (instanceCount_ == 0 || frameCount_ == 0)
+		{
+			return;
+		}
+
+		shader_->Bind();
+		shader_->SetUniform("atlasSphere", sphere_);
+		shader_->SetUniform("frameCount", frameCount_);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, colorTexture_);
+		shader_->SetUniform("colorAtlas", 0);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, depthTexture_);
+		shader_->SetUniform("depthAtlas", 1);
+		glActiveTexture(GL_TEXTURE0);
+
+		glBindVertexArray(vertexArray_);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount_);
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef TREE_GENERATOR_OPENGL_IMPOSTOR_RENDERER_H_
+#define TREE_GENERATOR_OPENGL_IMPOSTOR_RENDERER_H_
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "../../common/impostor.h"
+#include "../../common/impostor_renderer.h"
+
+namespace tree_generator::opengl
+{
+	class ShaderProgram;
+
+	class OpenGLImpostorRenderer : public ImpostorRenderer
+	{
+	public:
+		OpenGLImpostorRenderer(ShaderProgram* shader);
+		~OpenGLImpostorRenderer();
+
+		void SetAtlas(const ImpostorAtlas& atlas) override;
+		void SetInstances(std::span<const glm::vec4> instances) override;
+
+		void Render() override;
+
+	private:
+		unsigned int vertexArray_;
+		unsigned int cornerBuffer_;
+		unsigned int instanceBuffer_;
+		unsigned int colorTexture_;
+		unsigned int depthTexture_;
+
+		int instanceCount_;
+		int frameCount_;
+
+		// Bounding sphere of the baked geometry: center (xyz) and radius (w).
+		glm::vec4 sphere_;
+
+		ShaderProgram* shader_;
+	};
+}
+
+#endif // !TREE_GENERATOR_OPENGL_IMPOSTOR_RENDERER_H_
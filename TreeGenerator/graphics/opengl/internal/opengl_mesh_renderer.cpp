@@ -1,26 +1,44 @@
 #include "opengl_mesh_renderer.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../../common/transform_kernel.h"
 #include "shader_program.h"
 
 namespace tree_generator::opengl
 {
 	OpenGLMeshRenderer::OpenGLMeshRenderer(
 		ShaderProgram* materialShader,
-		ShaderProgram* normalShader) :
+		ShaderProgram* normalShader,
+		ShaderProgram* subtreeMaterialShader,
+		ShaderProgram* subtreeNormalShader) :
 		vertexArray_(0),
 		vertexBuffer_(0),
 		indexBuffer_(0),
 		instanceTransformBuffer_(0),
 
+		localInstanceBuffer_(0),
+		localInstanceTexture_(0),
+
 		indexCount_(0),
+		indexType_(GL_UNSIGNED_INT),
 		instanceCount_(0),
+		localInstanceCount_(0),
+		positionOffset_(0.0f),
+		positionScale_(1.0f),
+		isPacked_(false),
 
 		material_({}),
 		materialShader_(materialShader),
-		normalShader_(normalShader)
+		normalShader_(normalShader),
+		subtreeMaterialShader_(subtreeMaterialShader),
+		subtreeNormalShader_(subtreeNormalShader)
 	{
 		glGenBuffers(1, &vertexBuffer_);
 		glGenBuffers(1, &indexBuffer_);
@@ -33,6 +51,8 @@ namespace tree_generator::opengl
 		glDeleteBuffers(1, &vertexBuffer_);
 		glDeleteBuffers(1, &indexBuffer_);
 		glDeleteBuffers(1, &instanceTransformBuffer_);
+		glDeleteBuffers(1, &localInstanceBuffer_);
+		glDeleteTextures(1, &localInstanceTexture_);
 		glDeleteVertexArrays(1, &vertexArray_);
 	}
 
@@ -50,8 +70,178 @@ namespace tree_generator::opengl
 	void OpenGLMeshRenderer::SetMeshData(
 		const MeshData& meshData, const std::vector<Transform>& instances)
 	{
-		indexCount_ = meshData.indices.size();
+		// Calculate the model matrices based on the provided transforms.
+		// Sending the entire model matrix for each instance over VBO is
+		// a bit expensive (4 vec4s, each taking up a binding point).
+		// The main alternative would be to calculate the model matrix from
+		// the transform within the shader itself, but those calculations
+		// are moderately expensive and repeating them every frame is
+		// wasteful.
+		std::vector<glm::mat4> modelMatrices(instances.size());
+		ToMatrices(instances, modelMatrices.data());
+		SetMeshData(meshData, std::span<const glm::mat4>(modelMatrices));
+	}
+
+	void OpenGLMeshRenderer::SetMeshData(
+		const MeshData& meshData, std::span<const glm::mat4> instances)
+	{
 		instanceCount_ = instances.size();
+		localInstanceCount_ = 0;
+
+		UploadMesh(meshData);
+		UploadInstanceMatrices(instances, 1);
+	}
+
+	void OpenGLMeshRenderer::SetMeshData(
+		const MeshData& meshData,
+		std::span<const glm::mat4> localInstances,
+		std::span<const glm::mat4> placements)
+	{
+		// Buffer textures are only guaranteed to hold 65536 texels, so larger
+		// subtrees are expanded here instead.
+		GLint maxTexelCount = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexelCount);
+		if (localInstances.size() * 4 > static_cast<std::size_t>(maxTexelCount) ||
+			placements.size() == 1)
+		{
+			std::vector<glm::mat4> modelMatrices;
+			modelMatrices.reserve(localInstances.size() * placements.size());
+			for (const glm::mat4& placement : placements)
+			{
+				for (const glm::mat4& localInstance : localInstances)
+				{
+					modelMatrices.push_back(placement * localInstance);
+				}
+			}
+			SetMeshData(meshData, std::span<const glm::mat4>(modelMatrices));
+			return;
+		}
+
+		instanceCount_ = localInstances.size() * placements.size();
+		localInstanceCount_ = localInstances.size();
+
+		UploadMesh(meshData);
+		UploadInstanceMatrices(placements, std::max(localInstanceCount_, 1));
+
+		if (localInstanceBuffer_ == 0)
+		{
+			glGenBuffers(1, &localInstanceBuffer_);
+			glGenTextures(1, &localInstanceTexture_);
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, localInstanceBuffer_);
+		glBufferData(
+			GL_TEXTURE_BUFFER,
+			sizeof(glm::mat4) * localInstances.size(),
+			localInstances.data(),
+			GL_STATIC_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, localInstanceTexture_);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, localInstanceBuffer_);
+	}
+
+	void OpenGLMeshRenderer::SetMeshData(
+		const PackedMesh& meshData, std::span<const glm::mat4> instances)
+	{
+		instanceCount_ = instances.size();
+		localInstanceCount_ = 0;
+
+		UploadMesh(meshData);
+		UploadInstanceMatrices(instances, 1);
+	}
+
+	void OpenGLMeshRenderer::SetInstances(std::span<const glm::mat4> instances)
+	{
+		if (localInstanceCount_ > 0)
+		{
+			std::cerr << "Cannot replace the instances of subtree placements" << std::endl;
+			return;
+		}
+
+		// Respecifying the storage lets the driver hand out fresh memory
+		// instead of waiting for draws still reading the old instances. The
+		// vertex array keeps referring to the same buffer object.
+		instanceCount_ = instances.size();
+		glBindBuffer(GL_ARRAY_BUFFER, instanceTransformBuffer_);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			sizeof(glm::mat4) * instances.size(),
+			instances.data(),
+			GL_STREAM_DRAW);
+	}
+
+	void OpenGLMeshRenderer::SetMesh(const MeshData& meshData)
+	{
+		if (localInstanceCount_ > 0)
+		{
+			std::cerr << "Cannot replace the mesh of subtree placements" << std::endl;
+			return;
+		}
+		UploadMesh(meshData);
+	}
+
+	void OpenGLMeshRenderer::SetMesh(const PackedMesh& meshData)
+	{
+		if (localInstanceCount_ > 0)
+		{
+			std::cerr << "Cannot replace the mesh of subtree placements" << std::endl;
+			return;
+		}
+		UploadMesh(meshData);
+	}
+
+	void OpenGLMeshRenderer::SetMaterial(Material material)
+	{
+		material_ = material;
+	}
+
+	void OpenGLMeshRenderer::Render(RenderMode mode)
+	{
+		ShaderProgram* shader = nullptr;
+		if (mode == RenderMode::Material)
+		{
+			shader = localInstanceCount_ > 0 ? subtreeMaterialShader_ : materialShader_;
+			shader->Bind();
+			shader->SetUniform(
+				"material.color", material_.color);
+		}
+		else if(mode == RenderMode::Normals)
+		{
+			shader = localInstanceCount_ > 0 ? subtreeNormalShader_ : normalShader_;
+			shader->Bind();
+		}
+
+		if (shader != nullptr)
+		{
+			shader->SetUniform("positionOffset", positionOffset_);
+			shader->SetUniform("positionScale", positionScale_);
+			shader->SetUniform("isPacked", isPacked_ ? 1 : 0);
+		}
+		if (localInstanceCount_ > 0 && shader != nullptr)
+		{
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_BUFFER, localInstanceTexture_);
+			shader->SetUniform("localInstances", 0);
+			shader->SetUniform("localInstanceCount", localInstanceCount_);
+		}
+		if (instanceCount_ == 0)
+		{
+			return;
+		}
+		glBindVertexArray(vertexArray_);
+		glDrawElementsInstanced(
+			GL_TRIANGLES,
+			indexCount_,
+			indexType_,
+			0,
+			instanceCount_);
+	}
+
+	void OpenGLMeshRenderer::UploadMesh(const MeshData& meshData)
+	{
+		indexCount_ = meshData.indices.size();
+		indexType_ = GL_UNSIGNED_INT;
+		positionOffset_ = glm::vec4(0.0f);
+		positionScale_ = glm::vec4(1.0f);
+		isPacked_ = false;
 
 		glBindVertexArray(vertexArray_);
 
@@ -86,45 +276,75 @@ namespace tree_generator::opengl
 			GL_FLOAT, GL_FALSE,
 			sizeof(Vertex), (void*)offsetof(Vertex, uv));
 		glEnableVertexAttribArray(2);
+	}
 
-		// Calculate the model matrices based on the provided transforms.
-		// Sending the entire model matrix for each instance over VBO is
-		// a bit expensive (4 vec4s, each taking up a binding point).
-		// The main alternative would be to calculate the model matrix from
-		// the transform within the shader itself, but those calculations
-		// are moderately expensive and repeating them every frame is
-		// wasteful.
-		std::vector<glm::mat4> modelMatrices;
-		modelMatrices.reserve(instances.size());
-		for (int i = 0; i < instances.size(); ++i)
+	void OpenGLMeshRenderer::UploadMesh(const PackedMesh& meshData)
+	{
+		indexCount_ = meshData.IndexCount();
+		positionOffset_ = glm::vec4(meshData.positionOffset, 0.0f);
+		positionScale_ = glm::vec4(meshData.positionScale, 1.0f);
+		isPacked_ = true;
+
+		glBindVertexArray(vertexArray_);
+
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			sizeof(PackedVertex) * meshData.vertices.size(),
+			meshData.vertices.data(),
+			GL_STATIC_DRAW);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+		if (!meshData.shortIndices.empty())
+		{
+			indexType_ = GL_UNSIGNED_SHORT;
+			glBufferData(
+				GL_ELEMENT_ARRAY_BUFFER,
+				sizeof(std::uint16_t) * meshData.shortIndices.size(),
+				meshData.shortIndices.data(),
+				GL_STATIC_DRAW);
+		}
+		else
 		{
-			glm::mat4 matrix = glm::mat4(1.0f);
-
-			matrix = glm::translate(matrix, instances[i].position);
-
-			matrix = glm::rotate(
-				matrix,
-				glm::radians(instances[i].rotation.z),
-				glm::vec3(0.0f, 0.0f, 1.0f));
-			matrix = glm::rotate(
-				matrix,
-				glm::radians(instances[i].rotation.y),
-				glm::vec3(0.0f, 1.0f, 0.0f));
-			matrix = glm::rotate(
-				matrix,
-				glm::radians(instances[i].rotation.x),
-				glm::vec3(1.0f, 0.0f, 0.0f));
-
-			matrix = glm::scale(matrix, glm::vec3(instances[i].scale));
-
-			modelMatrices.push_back(matrix);
+			indexType_ = GL_UNSIGNED_INT;
+			glBufferData(
+				GL_ELEMENT_ARRAY_BUFFER,
+				sizeof(std::uint32_t) * meshData.indices.size(),
+				meshData.indices.data(),
+				GL_STATIC_DRAW);
 		}
 
+		// The shaders dequantize the positions and decode the normals, which
+		// arrive in the first two components of aNormal.
+		glVertexAttribPointer(
+			0, 3,
+			GL_SHORT, GL_TRUE,
+			sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+		glEnableVertexAttribArray(0);
+
+		glVertexAttribPointer(
+			1, 2,
+			GL_SHORT, GL_TRUE,
+			sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+		glEnableVertexAttribArray(1);
+
+		glVertexAttribPointer(
+			2, 2,
+			GL_HALF_FLOAT, GL_FALSE,
+			sizeof(PackedVertex), (void*)offsetof(PackedVertex, uv));
+		glEnableVertexAttribArray(2);
+	}
+
+	void OpenGLMeshRenderer::UploadInstanceMatrices(
+		std::span<const glm::mat4> matrices, int divisor)
+	{
+		glBindVertexArray(vertexArray_);
+
 		glBindBuffer(GL_ARRAY_BUFFER, instanceTransformBuffer_);
 		glBufferData(
 			GL_ARRAY_BUFFER,
-			sizeof(glm::mat4) * instanceCount_,
-			modelMatrices.data(),
+			sizeof(glm::mat4) * matrices.size(),
+			matrices.data(),
 			GL_STATIC_DRAW);
 
 		glVertexAttribPointer(
@@ -132,53 +352,27 @@ namespace tree_generator::opengl
 			GL_FLOAT, GL_FALSE,
 			sizeof(glm::mat4), (void*)0);
 		glEnableVertexAttribArray(3);
-		glVertexAttribDivisor(3, 1);
+		glVertexAttribDivisor(3, divisor);
 
 		glVertexAttribPointer(
 			4, 4,
 			GL_FLOAT, GL_FALSE,
 			sizeof(glm::mat4), (void*)sizeof(glm::vec4));
 		glEnableVertexAttribArray(4);
-		glVertexAttribDivisor(4, 1);
+		glVertexAttribDivisor(4, divisor);
 
 		glVertexAttribPointer(
 			5, 4,
 			GL_FLOAT, GL_FALSE,
 			sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * 2));
 		glEnableVertexAttribArray(5);
-		glVertexAttribDivisor(5, 1);
+		glVertexAttribDivisor(5, divisor);
 
 		glVertexAttribPointer(
 			6, 4,
 			GL_FLOAT, GL_FALSE,
 			sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * 3));
 		glEnableVertexAttribArray(6);
-		glVertexAttribDivisor(6, 1);
-	}
-
-	void OpenGLMeshRenderer::SetMaterial(Material material)
-	{
-		material_ = material;
-	}
-
-	void OpenGLMeshRenderer::Render(RenderMode mode)
-	{
-		if (mode == RenderMode::Material)
-		{
-			materialShader_->Bind();
-			materialShader_->SetUniform(
-				"material.color", material_.color);
-		}
-		else if(mode == RenderMode::Normals)
-		{
-			normalShader_->Bind();
-		}
-		glBindVertexArray(vertexArray_);
-		glDrawElementsInstanced(
-			GL_TRIANGLES,
-			indexCount_,
-			GL_UNSIGNED_INT,
-			0,
-			instanceCount_);
+		glVertexAttribDivisor(6, divisor);
 	}
 }
\ No newline at end of file
@@ -1,9 +1,14 @@
 #ifndef TREE_GENERATOR_OPENGL_MESH_RENDERER_H_
 #define TREE_GENERATOR_OPENGL_MESH_RENDERER_H_
 
+#include <span>
+
+#include <glm/glm.hpp>
+
 #include "../../common/material.h"
 #include "../../common/mesh_data.h"
 #include "../../common/mesh_renderer.h"
+#include "../../common/packed_mesh.h"
 
 namespace tree_generator::opengl
 {
@@ -25,13 +30,31 @@ namespace tree_generator::opengl
 	class OpenGLMeshRenderer : public MeshRenderer
 	{
 	public:
-		OpenGLMeshRenderer(ShaderProgram* materialShader, ShaderProgram* normalShader);
+		// The subtree shaders draw meshes set with local instances and
+		// placements.
+		OpenGLMeshRenderer(
+			ShaderProgram* materialShader,
+			ShaderProgram* normalShader,
+			ShaderProgram* subtreeMaterialShader,
+			ShaderProgram* subtreeNormalShader);
 		~OpenGLMeshRenderer();
 
 		void SetMeshData(const MeshData& meshData) override;
 		void SetMeshData(const MeshData& meshData, const Transform& instance) override;
 		void SetMeshData(
 			const MeshData& meshData, const std::vector<Transform>& instances) override;
+		void SetMeshData(
+			const MeshData& meshData, std::span<const glm::mat4> instances) override;
+		void SetMeshData(
+			const MeshData& meshData,
+			std::span<const glm::mat4> localInstances,
+			std::span<const glm::mat4> placements) override;
+		void SetMeshData(
+			const PackedMesh& meshData, std::span<const glm::mat4> instances) override;
+
+		void SetInstances(std::span<const glm::mat4> instances) override;
+		void SetMesh(const MeshData& meshData) override;
+		void SetMesh(const PackedMesh& meshData) override;
 
 		void SetMaterial(Material material) override;
 
@@ -43,12 +66,35 @@ namespace tree_generator::opengl
 		unsigned int indexBuffer_;
 		unsigned int instanceTransformBuffer_;
 
+		// Local instances of a subtree, read through a buffer texture.
+		unsigned int localInstanceBuffer_;
+		unsigned int localInstanceTexture_;
+
 		int indexCount_;
+		unsigned int indexType_;
 		int instanceCount_;
 
+		// Number of local instances drawn per placement, or 0 if the
+		// instances are complete model matrices.
+		int localInstanceCount_;
+
+		// Maps the mesh's vertex positions to model space, and whether its
+		// normals are octahedrally encoded. See PackedMesh.
+		glm::vec4 positionOffset_;
+		glm::vec4 positionScale_;
+		bool isPacked_;
+
 		Material material_;
 		ShaderProgram* materialShader_;
 		ShaderProgram* normalShader_;
+		ShaderProgram* subtreeMaterialShader_;
+		ShaderProgram* subtreeNormalShader_;
+
+		void UploadMesh(const MeshData& meshData);
+		void UploadMesh(const PackedMesh& meshData);
+
+		// Each matrix is used for `divisor` consecutive instances.
+		void UploadInstanceMatrices(std::span<const glm::mat4> matrices, int divisor);
 	};
 }
 
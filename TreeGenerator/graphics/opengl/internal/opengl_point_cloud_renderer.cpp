@@ -0,0 +1,116 @@
+#include "opengl_point_cloud_renderer.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "shader_program.h"
+
+namespace tree_generator::opengl
+{
+	OpenGLPointCloudRenderer::OpenGLPointCloudRenderer(ShaderProgram* shader) :
+		vertexArray_(0),
+		pointBuffer_(0),
+		instanceBuffer_(0),
+
+		pointCount_(0),
+		instanceCount_(0),
+		pointRadius_(0.0f),
+
+		shader_(shader)
+	{
+		glGenVertexArrays(1, &vertexArray_);
+		glGenBuffers(1, &pointBuffer_);
+		glGenBuffers(1, &instanceBuffer_);
+
+		glBindVertexArray(vertexArray_);
+
+		glBindBuffer(GL_ARRAY_BUFFER, pointBuffer_);
+		glVertexAttribPointer(
+			0, 3,
+			GL_FLOAT, GL_FALSE,
+			sizeof(SurfacePoint), (void*)offsetof(SurfacePoint, position));
+		glEnableVertexAttribArray(0);
+
+		glVertexAttribPointer(
+			1, 3,
+			GL_FLOAT, GL_FALSE,
+			sizeof(SurfacePoint), (void*)offsetof(SurfacePoint, normal));
+		glEnableVertexAttribArray(1);
+
+		glVertexAttribIPointer(
+			2, 1,
+			GL_UNSIGNED_INT,
+			sizeof(SurfacePoint), (void*)offsetof(SurfacePoint, material));
+		glEnableVertexAttribArray(2);
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glEnableVertexAttribArray(3);
+		glVertexAttribDivisor(3, 1);
+	}
+
+	OpenGLPointCloudRenderer::~OpenGLPointCloudRenderer()
+	{
+		glDeleteBuffers(1, &pointBuffer_);
+		glDeleteBuffers(1, &instanceBuffer_);
+		glDeleteVertexArrays(1, &vertexArray_);
+	}
+
+	void OpenGLPointCloudRenderer::SetPointCloud(const PointCloud& pointCloud)
+	{
+		if (pointCloud.materials.size() > kMaxMaterialCount)
+		{
+			std::cerr << "Point clouds can have at most " << kMaxMaterialCount <<
+				" materials; the rest are drawn with the last one" << std::endl;
+		}
+
+		pointCount_ = pointCloud.points.size();
+		pointRadius_ = pointCloud.pointRadius;
+		materialColors_.clear();
+		for (std::size_t i = 0; i < std::min(pointCloud.materials.size(), kMaxMaterialCount); ++i)
+		{
+			materialColors_.push_back(pointCloud.materials[i].color);
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, pointBuffer_);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			sizeof(SurfacePoint) * pointCloud.points.size(),
+			pointCloud.points.data(),
+			GL_STATIC_DRAW);
+	}
+
+	void OpenGLPointCloudRenderer::SetInstances(std::span<const glm::vec4> instances)
+	{
+		instanceCount_ = instances.size();
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			sizeof(glm::vec4) * instances.size(),
+			instances.data(),
+			GL_STREAM_DRAW);
+	}
+
+	void OpenGLPointCloudRenderer::Render()
+	{
+		if (pointCount_ == 0 || instanceCount_ == 0)
+		{
+			return;
+		}
+
+		// The size of the points depends on the viewport they are drawn to.
+		GLint viewport[4] = {};
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		shader_->Bind();
+		shader_->SetUniform("pointRadius", pointRadius_);
+		shader_->SetUniform("viewportHeight", static_cast<float>(viewport[3]));
+		shader_->SetUniform("materials", std::span<const glm::vec4>(materialColors_));
+		shader_->SetUniform("materialCount", static_cast<int>(materialColors_.size()));
+
+		glBindVertexArray(vertexArray_);
+		glDrawArraysInstanced(GL_POINTS, 0, pointCount_, instanceCount_);
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef TREE_GENERATOR_OPENGL_POINT_CLOUD_RENDERER_H_
+#define TREE_GENERATOR_OPENGL_POINT_CLOUD_RENDERER_H_
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../../common/point_cloud.h"
+#include "../../common/point_cloud_renderer.h"
+
+namespace tree_generator::opengl
+{
+	class ShaderProgram;
+
+	class OpenGLPointCloudRenderer : public PointCloudRenderer
+	{
+	public:
+		// Must match the size of the materials array in the shader.
+		static constexpr std::size_t kMaxMaterialCount = 16;
+
+		OpenGLPointCloudRenderer(ShaderProgram* shader);
+		~OpenGLPointCloudRenderer();
+
+		void SetPointCloud(const PointCloud& pointCloud) override;
+		void SetInstances(std::span<const glm::vec4> instances) override;
+
+		void Render() override;
+
+	private:
+		unsigned int vertexArray_;
+		unsigned int pointBuffer_;
+		unsigned int instanceBuffer_;
+
+		int pointCount_;
+		int instanceCount_;
+		float pointRadius_;
+		std::vector<glm::vec4> materialColors_;
+
+		ShaderProgram* shader_;
+	};
+}
+
+#endif // !TREE_GENERATOR_OPENGL_POINT_CLOUD_RENDERER_H_
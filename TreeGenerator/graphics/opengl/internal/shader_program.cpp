@@ -47,6 +47,29 @@ namespace tree_generator::opengl
 		glUniform4fv(GetUniformLocation(uniform), 1, glm::value_ptr(value));
 	}
 
+	void ShaderProgram::SetUniform(const std::string& uniform, float value)
+	{
+		glUniform1f(GetUniformLocation(uniform), value);
+	}
+
+	void ShaderProgram::SetUniform(const std::string& uniform, int value)
+	{
+		glUniform1i(GetUniformLocation(uniform), value);
+	}
+
+	void ShaderProgram::SetUniform(
+		const std::string& uniform, std::span<const glm::vec4> values)
+	{
+		if (values.empty())
+		{
+			return;
+		}
+		glUniform4fv(
+			GetUniformLocation(uniform),
+			static_cast<GLsizei>(values.size()),
+			glm::value_ptr(values.front()));
+	}
+
 	int ShaderProgram::GetUniformLocation(const std::string& uniform)
 	{
 		auto iter = uniformLocations_.find(uniform);
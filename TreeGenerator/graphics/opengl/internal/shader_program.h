@@ -2,6 +2,7 @@
 #define TREE_GENERATOR_OPENGL_SHADER_PROGRAM_H_
 
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 
@@ -30,6 +31,11 @@ namespace tree_generator::opengl
 			GLuint uniformBlockBinding);
 
 		void SetUniform(const std::string& uniform, glm::vec4 value);
+		void SetUniform(const std::string& uniform, float value);
+		void SetUniform(const std::string& uniform, int value);
+
+		// Sets the elements of an array uniform, starting with the first.
+		void SetUniform(const std::string& uniform, std::span<const glm::vec4> values);
 
 	private:
 		GLuint name_;
@@ -0,0 +1,258 @@
+#include "opengl_impostor_baker.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "../common/bounding_box.h"
+#include "../../utility/error_handling.h"
+
+#include "internal/opengl_mesh_renderer.h"
+#include "internal/shader_program.h"
+#include "internal/typed_shader.h"
+
+using ::tree_generator::utility::ThrowIfNull;
+
+namespace tree_generator::opengl
+{
+	namespace
+	{
+		// The baker's camera is bound to its own block binding, so that baking
+		// leaves the buffer of the application's camera (binding 1) alone.
+		constexpr GLuint kCameraBinding = 2;
+
+		const char* bakeVertexShaderSource = R"s(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// Model matrix (per instance)
+layout (location = 3) in vec4 aModel0;
+layout (location = 4) in vec4 aModel1;
+layout (location = 5) in vec4 aModel2;
+layout (location = 6) in vec4 aModel3;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+} camera;
+
+void main()
+{
+	mat4 model = mat4(aModel0, aModel1, aModel2, aModel3);
+	gl_Position = camera.projection * camera.view * model * vec4(aPos, 1.0f);
+})s";
+
+		// Coverage is written to alpha regardless of the material, so that
+		// the impostor can tell the geometry from the background.
+		const char* bakeFragmentShaderSource = R"s(
+#version 330 core
+
+struct Material
+{
+    vec4 color;
+};
+
+uniform Material material;
+
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = vec4(material.color.rgb, 1.0f);
+})s";
+
+		struct BakeCameraData
+		{
+			glm::mat4 view;
+			glm::mat4 projection;
+		};
+
+		// OpenGL state changed by baking, to be restored afterwards.
+		struct SavedState
+		{
+			GLint drawFramebuffer = 0;
+			GLint readFramebuffer = 0;
+			GLint viewport[4] = {};
+			GLfloat clearColor[4] = {};
+			GLboolean depthTest = GL_FALSE;
+
+			SavedState()
+			{
+				glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+				glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+				glGetIntegerv(GL_VIEWPORT, viewport);
+				glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+				depthTest = glIsEnabled(GL_DEPTH_TEST);
+			}
+
+			~SavedState()
+			{
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+				glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+				glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+				if (depthTest)
+				{
+					glEnable(GL_DEPTH_TEST);
+				}
+				else
+				{
+					glDisable(GL_DEPTH_TEST);
+				}
+			}
+		};
+
+		// Framebuffer with color and depth renderbuffers, deleted when it
+		// goes out of scope.
+		struct BakeTarget
+		{
+			GLuint framebuffer = 0;
+			GLuint colorBuffer = 0;
+			GLuint depthBuffer = 0;
+
+			explicit BakeTarget(int size)
+			{
+				glGenRenderbuffers(1, &colorBuffer);
+				glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+				glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+
+				glGenRenderbuffers(1, &depthBuffer);
+				glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+				glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+
+				glGenFramebuffers(1, &framebuffer);
+				glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+				glFramebufferRenderbuffer(
+					GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+				glFramebufferRenderbuffer(
+					GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+			}
+
+			~BakeTarget()
+			{
+				glDeleteFramebuffers(1, &framebuffer);
+				glDeleteRenderbuffers(1, &colorBuffer);
+				glDeleteRenderbuffers(1, &depthBuffer);
+			}
+		};
+	}
+
+	OpenGLImpostorBaker::OpenGLImpostorBaker() :
+		cameraBuffer_(0)
+	{
+		std::unique_ptr<VertexShader> vertexShader = ThrowIfNull(
+			VertexShader::Create(bakeVertexShaderSource),
+			"Impostor vertex shader compilation failed");
+		std::unique_ptr<FragmentShader> fragmentShader = ThrowIfNull(
+			FragmentShader::Create(bakeFragmentShaderSource),
+			"Impostor fragment shader compilation failed");
+		shader_ = ThrowIfNull(
+			ShaderProgram::Create(*vertexShader, *fragmentShader),
+			"Impostor shader linking failed");
+		shader_->BindUniformBlock("Camera", kCameraBinding);
+
+		glGenBuffers(1, &cameraBuffer_);
+		glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer_);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(BakeCameraData), nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	OpenGLImpostorBaker::~OpenGLImpostorBaker()
+	{
+		glDeleteBuffers(1, &cameraBuffer_);
+	}
+
+	ImpostorAtlas OpenGLImpostorBaker::Bake(
+		std::span<const MeshInstances> sources, int frameCount, int frameSize)
+	{
+		if (frameCount <= 0 || frameSize <= 0)
+		{
+			throw std::invalid_argument("Impostor frame count and size must be positive");
+		}
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+		if (frameCount * frameSize > maxSize)
+		{
+			throw std::invalid_argument("Impostor atlas is larger than a renderbuffer can be");
+		}
+
+		BoundingBox bounds;
+		for (const MeshInstances& source : sources)
+		{
+			const BoundingBox meshBounds = ComputeBounds(*source.mesh);
+			for (const glm::mat4& instance : source.instances)
+			{
+				bounds.Add(TransformBounds(meshBounds, instance));
+			}
+		}
+
+		ImpostorAtlas atlas;
+		atlas.frameCount = frameCount;
+		atlas.frameSize = frameSize;
+		const int size = atlas.GetSize();
+		atlas.color.assign(static_cast<std::size_t>(size) * size * 4, 0);
+		atlas.depth.assign(static_cast<std::size_t>(size) * size, 1.0f);
+		if (bounds.IsEmpty())
+		{
+			return atlas;
+		}
+		atlas.center = bounds.Center();
+		atlas.radius = glm::length(bounds.Extent());
+		if (atlas.radius <= 0.0f)
+		{
+			return atlas;
+		}
+
+		const SavedState savedState;
+		const BakeTarget target(size);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			throw std::runtime_error("Impostor framebuffer is incomplete");
+		}
+
+		std::vector<std::unique_ptr<OpenGLMeshRenderer>> renderers;
+		for (const MeshInstances& source : sources)
+		{
+			// Only plain instances are drawn, so the subtree shaders are never
+			// used.
+			auto renderer = std::make_unique<OpenGLMeshRenderer>(
+				shader_.get(), shader_.get(), shader_.get(), shader_.get());
+			renderer->SetMeshData(*source.mesh, source.instances);
+			renderer->SetMaterial(source.material);
+			renderers.push_back(std::move(renderer));
+		}
+
+		glEnable(GL_DEPTH_TEST);
+		glViewport(0, 0, size, size);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glBindBufferBase(GL_UNIFORM_BUFFER, kCameraBinding, cameraBuffer_);
+		BakeCameraData camera;
+		camera.projection = GetImpostorProjection(atlas.radius);
+		for (int y = 0; y < frameCount; ++y)
+		{
+			for (int x = 0; x < frameCount; ++x)
+			{
+				const glm::vec3 direction = GetImpostorFrameDirection(x, y, frameCount);
+				camera.view = GetImpostorView(direction, atlas.center, atlas.radius);
+				glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer_);
+				glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(camera), &camera);
+
+				glViewport(x * frameSize, y * frameSize, frameSize, frameSize);
+				for (const std::unique_ptr<OpenGLMeshRenderer>& renderer : renderers)
+				{
+					renderer->Render(MeshRenderer::RenderMode::Material);
+				}
+			}
+		}
+
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, atlas.color.data());
+		glReadPixels(0, 0, size, size, GL_DEPTH_COMPONENT, GL_FLOAT, atlas.depth.data());
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		return atlas;
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef TREE_GENERATOR_OPENGL_IMPOSTOR_BAKER_H_
+#define TREE_GENERATOR_OPENGL_IMPOSTOR_BAKER_H_
+
+#include <memory>
+#include <span>
+
+#include "../common/impostor.h"
+#include "../common/mesh_instances.h"
+
+namespace tree_generator::opengl
+{
+	class ShaderProgram;
+
+	// Renders geometry into an impostor atlas in an offscreen framebuffer.
+	// Needs a current OpenGL context with OpenGL loaded, either an
+	// OpenGLRenderContext's or a headless EglContext.
+	class OpenGLImpostorBaker
+	{
+	public:
+		OpenGLImpostorBaker();
+		~OpenGLImpostorBaker();
+
+		// Renders the instances of the sources from each of the
+		// frameCount x frameCount directions into frames of frameSize x
+		// frameSize pixels, and reads the atlas back. The bound framebuffer,
+		// viewport, clear color and depth test are restored afterwards.
+		ImpostorAtlas Bake(
+			std::span<const MeshInstances> sources, int frameCount, int frameSize);
+
+	private:
+		std::unique_ptr<ShaderProgram> shader_;
+		unsigned int cameraBuffer_;
+	};
+}
+
+#endif  // !TREE_GENERATOR_OPENGL_IMPOSTOR_BAKER_H_
@@ -0,0 +1,167 @@
+#include "opengl_impostor_baker.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "egl_context.h"
+
+namespace tree_generator::opengl
+{
+	namespace
+	{
+		// Unit cube around the origin. Normals and uvs are not used by the
+		// baker.
+		MeshData CreateCube()
+		{
+			MeshData cube;
+			for (int i = 0; i < 8; ++i)
+			{
+				const glm::vec3 position(
+					(i & 1) ? 0.5f : -0.5f,
+					(i & 2) ? 0.5f : -0.5f,
+					(i & 4) ? 0.5f : -0.5f);
+				cube.vertices.push_back({ position, glm::normalize(position), glm::vec2(0.0f) });
+			}
+			cube.indices = {
+				0, 2, 1, 1, 2, 3,
+				4, 5, 6, 5, 7, 6,
+				0, 1, 4, 1, 5, 4,
+				2, 6, 3, 3, 6, 7,
+				0, 4, 2, 2, 4, 6,
+				1, 3, 5, 3, 7, 5,
+			};
+			return cube;
+		}
+
+		class OpenGLImpostorBakerTest : public ::testing::Test
+		{
+		protected:
+			void SetUp() override
+			{
+				try
+				{
+					context_.emplace();
+				}
+				catch (const std::runtime_error& error)
+				{
+					GTEST_SKIP() << "No headless OpenGL context: " << error.what();
+				}
+			}
+
+			std::optional<EglContext> context_;
+		};
+
+		TEST_F(OpenGLImpostorBakerTest, BakesEveryFrame)
+		{
+			constexpr int kFrameCount = 4;
+			constexpr int kFrameSize = 16;
+			const MeshData cube = CreateCube();
+			const std::array<glm::mat4, 1> instances = {
+				glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)) };
+			const std::array<MeshInstances, 1> sources = {
+				MeshInstances{ &cube, instances, Material{ glm::vec4(1.0f, 0.0f, 0.0f, 0.5f) } } };
+
+			OpenGLImpostorBaker baker;
+			const ImpostorAtlas atlas = baker.Bake(sources, kFrameCount, kFrameSize);
+
+			EXPECT_EQ(atlas.frameCount, kFrameCount);
+			EXPECT_EQ(atlas.frameSize, kFrameSize);
+			EXPECT_FLOAT_EQ(atlas.center.x, 2.0f);
+			EXPECT_FLOAT_EQ(atlas.radius, glm::length(glm::vec3(0.5f)));
+			const int size = atlas.GetSize();
+			ASSERT_EQ(atlas.color.size(), static_cast<std::size_t>(size * size * 4));
+			ASSERT_EQ(atlas.depth.size(), static_cast<std::size_t>(size * size));
+
+			for (int frameY = 0; frameY < kFrameCount; ++frameY)
+			{
+				for (int frameX = 0; frameX < kFrameCount; ++frameX)
+				{
+					// The cube covers the middle of every frame, but never the
+					// corners of its bounding sphere's frame.
+					for (glm::ivec2 pixel : { glm::ivec2(kFrameSize / 2), glm::ivec2(0) })
+					{
+						const int x = frameX * kFrameSize + pixel.x;
+						const int y = frameY * kFrameSize + pixel.y;
+						const std::size_t index = static_cast<std::size_t>(y) * size + x;
+						const bool covered = pixel.x != 0;
+
+						EXPECT_EQ(atlas.color[index * 4 + 0], covered ? 255 : 0);
+						EXPECT_EQ(atlas.color[index * 4 + 1], 0);
+						EXPECT_EQ(atlas.color[index * 4 + 2], 0);
+						EXPECT_EQ(atlas.color[index * 4 + 3], covered ? 255 : 0);
+						if (covered)
+						{
+							// Somewhere between the front of the bounding
+							// sphere and the cube's center.
+							EXPECT_GE(atlas.depth[index], 0.0f);
+							EXPECT_LT(atlas.depth[index], 0.5f);
+						}
+						else
+						{
+							EXPECT_FLOAT_EQ(atlas.depth[index], 1.0f);
+						}
+					}
+				}
+			}
+		}
+
+		TEST_F(OpenGLImpostorBakerTest, RestoresState)
+		{
+			const MeshData cube = CreateCube();
+			const std::array<glm::mat4, 1> instances = { glm::mat4(1.0f) };
+			const std::array<MeshInstances, 1> sources = {
+				MeshInstances{ &cube, instances, Material{ glm::vec4(1.0f) } } };
+
+			GLuint framebuffer = 0;
+			glGenFramebuffers(1, &framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glViewport(1, 2, 3, 4);
+			glClearColor(0.1f, 0.2f, 0.3f, 0.4f);
+			glDisable(GL_DEPTH_TEST);
+
+			OpenGLImpostorBaker baker;
+			baker.Bake(sources, 2, 8);
+
+			GLint boundFramebuffer = 0;
+			glGetIntegerv(GL_FRAMEBUFFER_BINDING, &boundFramebuffer);
+			EXPECT_EQ(boundFramebuffer, static_cast<GLint>(framebuffer));
+			GLint viewport[4] = {};
+			glGetIntegerv(GL_VIEWPORT, viewport);
+			EXPECT_THAT(viewport, ::testing::ElementsAre(1, 2, 3, 4));
+			GLfloat clearColor[4] = {};
+			glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+			EXPECT_THAT(clearColor, ::testing::ElementsAre(0.1f, 0.2f, 0.3f, 0.4f));
+			EXPECT_EQ(glIsEnabled(GL_DEPTH_TEST), GL_FALSE);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glDeleteFramebuffers(1, &framebuffer);
+		}
+
+		TEST_F(OpenGLImpostorBakerTest, EmptySourcesBakeEmptyAtlas)
+		{
+			OpenGLImpostorBaker baker;
+			const ImpostorAtlas atlas = baker.Bake({}, 2, 4);
+
+			EXPECT_EQ(atlas.GetSize(), 8);
+			EXPECT_THAT(atlas.color, ::testing::Each(0));
+			EXPECT_THAT(atlas.depth, ::testing::Each(1.0f));
+		}
+
+		TEST_F(OpenGLImpostorBakerTest, ThrowsOnEmptyFrames)
+		{
+			OpenGLImpostorBaker baker;
+			EXPECT_THROW(baker.Bake({}, 0, 4), std::invalid_argument);
+			EXPECT_THROW(baker.Bake({}, 2, 0), std::invalid_argument);
+		}
+	}
+}
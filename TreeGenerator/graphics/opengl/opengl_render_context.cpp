@@ -8,11 +8,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "../common/camera.h"
+#include "../common/impostor_renderer.h"
+#include "../common/point_cloud_renderer.h"
 #include "../common/window.h"
 #include "../../utility/error_handling.h"
 
 #include "internal/opengl_camera.h"
+#include "internal/opengl_impostor_renderer.h"
 #include "internal/opengl_mesh_renderer.h"
+#include "internal/opengl_point_cloud_renderer.h"
 #include "internal/typed_shader.h"
 #include "internal/shader_program.h"
 
@@ -31,6 +35,12 @@ layout (location = 4) in vec4 aModel1;
 layout (location = 5) in vec4 aModel2;
 layout (location = 6) in vec4 aModel3;
 
+// Maps packed positions back to model space, and whether aNormal holds an
+// octahedrally encoded normal. See PackedMesh.
+uniform vec4 positionOffset;
+uniform vec4 positionScale;
+uniform bool isPacked;
+
 layout (std140) uniform Camera
 {
 	mat4 view;
@@ -42,11 +52,91 @@ out VS_OUT
 	vec3 normal;
 } vs_out;
 
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.x, 1.0f - abs(e.x) - abs(e.y), e.y);
+	if (n.y < 0.0f)
+	{
+		n.xz = (1.0f - abs(n.zx)) * signNotZero(n.xz);
+	}
+	return normalize(n);
+}
+
 void main()
 {
 	mat4 model = mat4(aModel0, aModel1, aModel2, aModel3);
-	gl_Position = camera.projection * camera.view * model * vec4(aPos, 1.0f);
-	vs_out.normal = aNormal;
+	vec3 position = positionOffset.xyz + aPos * positionScale.xyz;
+	gl_Position = camera.projection * camera.view * model * vec4(position, 1.0f);
+	vs_out.normal = isPacked ? decodeOctahedral(aNormal.xy) : aNormal;
+})s";
+
+	// Draws subtree instances: each placement matrix is shared by
+	// localInstanceCount consecutive instances, which each read their local
+	// model matrix from the localInstances buffer texture.
+	const char* subtreeVertexShaderSource = R"s(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+// Placement matrix (per localInstanceCount instances)
+layout (location = 3) in vec4 aPlacement0;
+layout (location = 4) in vec4 aPlacement1;
+layout (location = 5) in vec4 aPlacement2;
+layout (location = 6) in vec4 aPlacement3;
+
+// Local model matrices, four texels each
+uniform samplerBuffer localInstances;
+uniform int localInstanceCount;
+
+// Maps packed positions back to model space, and whether aNormal holds an
+// octahedrally encoded normal. See PackedMesh.
+uniform vec4 positionOffset;
+uniform vec4 positionScale;
+uniform bool isPacked;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+} camera;
+
+out VS_OUT
+{
+	vec3 normal;
+} vs_out;
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.x, 1.0f - abs(e.x) - abs(e.y), e.y);
+	if (n.y < 0.0f)
+	{
+		n.xz = (1.0f - abs(n.zx)) * signNotZero(n.xz);
+	}
+	return normalize(n);
+}
+
+void main()
+{
+	int local = (gl_InstanceID % localInstanceCount) * 4;
+	mat4 localModel = mat4(
+		texelFetch(localInstances, local),
+		texelFetch(localInstances, local + 1),
+		texelFetch(localInstances, local + 2),
+		texelFetch(localInstances, local + 3));
+	mat4 placement = mat4(aPlacement0, aPlacement1, aPlacement2, aPlacement3);
+	vec3 position = positionOffset.xyz + aPos * positionScale.xyz;
+	gl_Position = camera.projection * camera.view * placement * localModel * vec4(position, 1.0f);
+	vs_out.normal = isPacked ? decodeOctahedral(aNormal.xy) : aNormal;
 })s";
 
 	const char* normalFragmentShaderSource = R"s(
@@ -81,6 +171,181 @@ void main()
 	FragColor = material.color;
 })s";
 
+	// Draws impostors as quads facing the camera. Each instance shows the
+	// atlas frame baked from the direction nearest to the one it is seen
+	// from, and writes the depth of the baked surface rather than the quad.
+	const char* impostorVertexShaderSource = R"s(
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+
+// Origin (xyz) and scale (w) (per instance)
+layout (location = 1) in vec4 aInstance;
+
+// Bounding sphere of the baked geometry: center (xyz) and radius (w)
+uniform vec4 atlasSphere;
+uniform int frameCount;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+} camera;
+
+out VS_OUT
+{
+	vec2 uv;
+	vec3 position;
+	flat vec3 direction;
+	flat float radius;
+} vs_out;
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+vec2 encodeOctahedral(vec3 d)
+{
+	vec3 n = d / (abs(d.x) + abs(d.y) + abs(d.z));
+	vec2 e = n.xz;
+	return n.y < 0.0f ? (1.0f - abs(e.yx)) * signNotZero(e) : e;
+}
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.x, 1.0f - abs(e.x) - abs(e.y), e.y);
+	if (n.y < 0.0f)
+	{
+		n.xz = (1.0f - abs(n.zx)) * signNotZero(n.xz);
+	}
+	return normalize(n);
+}
+
+void main()
+{
+	vec3 eye = -transpose(mat3(camera.view)) * camera.view[3].xyz;
+	vec3 center = aInstance.xyz + atlasSphere.xyz * aInstance.w;
+	float radius = atlasSphere.w * aInstance.w;
+
+	vec2 cell = (encodeOctahedral(normalize(eye - center)) * 0.5f + 0.5f) * frameCount;
+	ivec2 frame = clamp(ivec2(cell), ivec2(0), ivec2(frameCount - 1));
+	vec3 direction = decodeOctahedral((vec2(frame) + 0.5f) / frameCount * 2.0f - 1.0f);
+
+	// Same basis as the frame's view when it was baked.
+	vec3 up = abs(direction.y) > 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+	vec3 right = normalize(cross(-direction, up));
+	up = cross(right, -direction);
+
+	vec3 position = center + (right * aCorner.x + up * aCorner.y) * radius;
+	gl_Position = camera.projection * camera.view * vec4(position, 1.0f);
+
+	vs_out.uv = (vec2(frame) + aCorner * 0.5f + 0.5f) / frameCount;
+	vs_out.position = position;
+	vs_out.direction = direction;
+	vs_out.radius = radius;
+})s";
+
+	const char* impostorFragmentShaderSource = R"s(
+#version 330 core
+
+in VS_OUT
+{
+	vec2 uv;
+	vec3 position;
+	flat vec3 direction;
+	flat float radius;
+} vs_out;
+
+uniform sampler2D colorAtlas;
+uniform sampler2D depthAtlas;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+} camera;
+
+out vec4 FragColor;
+
+void main()
+{
+	vec4 color = texture(colorAtlas, vs_out.uv);
+	if (color.a < 0.5f)
+	{
+		discard;
+	}
+
+	// The baked depth runs from the front of the bounding sphere (0) to its
+	// back (1), and the quad passes through its center.
+	float depth = texture(depthAtlas, vs_out.uv).r;
+	vec3 position = vs_out.position - vs_out.direction * (depth * 2.0f - 1.0f) * vs_out.radius;
+	vec4 clip = camera.projection * camera.view * vec4(position, 1.0f);
+	gl_FragDepth = clip.z / clip.w * 0.5f + 0.5f;
+
+	FragColor = vec4(color.rgb / color.a, 1.0f);
+})s";
+
+	// Draws point clouds as round splats, sized so that each covers a disk
+	// of the cloud's point radius.
+	const char* pointCloudVertexShaderSource = R"s(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in uint aMaterial;
+
+// Origin (xyz) and scale (w) (per instance)
+layout (location = 3) in vec4 aInstance;
+
+uniform float pointRadius;
+uniform float viewportHeight;
+
+// Must have as many elements as OpenGLPointCloudRenderer::kMaxMaterialCount
+uniform vec4 materials[16];
+uniform int materialCount;
+
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+} camera;
+
+out VS_OUT
+{
+	flat vec4 color;
+} vs_out;
+
+void main()
+{
+	vec3 position = aInstance.xyz + aPos * aInstance.w;
+	gl_Position = camera.projection * camera.view * vec4(position, 1.0f);
+
+	// Diameter in pixels of the point's disk at its distance.
+	float radius = pointRadius * aInstance.w;
+	gl_PointSize = max(radius * camera.projection[1][1] * viewportHeight / gl_Position.w, 1.0f);
+
+	vs_out.color = materials[min(int(aMaterial), materialCount - 1)];
+})s";
+
+	const char* pointCloudFragmentShaderSource = R"s(
+#version 330 core
+
+in VS_OUT
+{
+	flat vec4 color;
+} vs_out;
+
+out vec4 FragColor;
+
+void main()
+{
+	vec2 offset = gl_PointCoord * 2.0f - 1.0f;
+	if (dot(offset, offset) > 1.0f)
+	{
+		discard;
+	}
+	FragColor = vs_out.color;
+})s";
+
 	OpenGLRenderContext::OpenGLRenderContext()
 	{
 		int version = gladLoadGL();
@@ -90,11 +355,16 @@ void main()
 		}
 
 		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_PROGRAM_POINT_SIZE);
 
 		std::unique_ptr<VertexShader> vertexShader = ThrowIfNull(
 			VertexShader::Create(vertexShaderSource),
 			"Vertex shader compilation failed");
 
+		std::unique_ptr<VertexShader> subtreeVertexShader = ThrowIfNull(
+			VertexShader::Create(subtreeVertexShaderSource),
+			"Subtree vertex shader compilation failed");
+
 		std::unique_ptr<FragmentShader> normalFragmentShader = ThrowIfNull(
 			FragmentShader::Create(normalFragmentShaderSource),
 			"Normal fragment shader compilation failed");
@@ -109,9 +379,39 @@ void main()
 		materialShader_ = ThrowIfNull(
 			ShaderProgram::Create(*vertexShader, *materialFragmentShader),
 			"Material shader linking failed");
+		subtreeNormalShader_ = ThrowIfNull(
+			ShaderProgram::Create(*subtreeVertexShader, *normalFragmentShader),
+			"Subtree normal shader linking failed");
+		subtreeMaterialShader_ = ThrowIfNull(
+			ShaderProgram::Create(*subtreeVertexShader, *materialFragmentShader),
+			"Subtree material shader linking failed");
+
+		std::unique_ptr<VertexShader> impostorVertexShader = ThrowIfNull(
+			VertexShader::Create(impostorVertexShaderSource),
+			"Impostor vertex shader compilation failed");
+		std::unique_ptr<FragmentShader> impostorFragmentShader = ThrowIfNull(
+			FragmentShader::Create(impostorFragmentShaderSource),
+			"Impostor fragment shader compilation failed");
+		impostorShader_ = ThrowIfNull(
+			ShaderProgram::Create(*impostorVertexShader, *impostorFragmentShader),
+			"Impostor shader linking failed");
+
+		std::unique_ptr<VertexShader> pointCloudVertexShader = ThrowIfNull(
+			VertexShader::Create(pointCloudVertexShaderSource),
+			"Point cloud vertex shader compilation failed");
+		std::unique_ptr<FragmentShader> pointCloudFragmentShader = ThrowIfNull(
+			FragmentShader::Create(pointCloudFragmentShaderSource),
+			"Point cloud fragment shader compilation failed");
+		pointCloudShader_ = ThrowIfNull(
+			ShaderProgram::Create(*pointCloudVertexShader, *pointCloudFragmentShader),
+			"Point cloud shader linking failed");
 
 		normalShader_->BindUniformBlock("Camera", 1);
 		materialShader_->BindUniformBlock("Camera", 1);
+		subtreeNormalShader_->BindUniformBlock("Camera", 1);
+		subtreeMaterialShader_->BindUniformBlock("Camera", 1);
+		impostorShader_->BindUniformBlock("Camera", 1);
+		pointCloudShader_->BindUniformBlock("Camera", 1);
 	}
 
 	OpenGLRenderContext::~OpenGLRenderContext()
@@ -126,7 +426,19 @@ void main()
 	std::unique_ptr<MeshRenderer> OpenGLRenderContext::CreateMeshRenderer()
 	{
 		return std::make_unique<OpenGLMeshRenderer>(
-			materialShader_.get(), normalShader_.get());
+			materialShader_.get(),
+			normalShader_.get(),
+			subtreeMaterialShader_.get(),
+			subtreeNormalShader_.get());
+	}
+
+	std::unique_ptr<ImpostorRenderer> OpenGLRenderContext::CreateImpostorRenderer()
+	{
+		return std::make_unique<OpenGLImpostorRenderer>(impostorShader_.get());
 	}
-}
 
+	std::unique_ptr<PointCloudRenderer> OpenGLRenderContext::CreatePointCloudRenderer()
+	{
+		return std::make_unique<OpenGLPointCloudRenderer>(pointCloudShader_.get());
+	}
+}
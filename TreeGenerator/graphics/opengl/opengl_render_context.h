@@ -8,7 +8,9 @@
 namespace tree_generator
 {
 	class Camera;
+	class ImpostorRenderer;
 	class MeshRenderer;
+	class PointCloudRenderer;
 	class Window;
 }
 
@@ -27,10 +29,16 @@ namespace tree_generator::opengl
 		std::unique_ptr<Camera> CreateCamera() override;
 
 		std::unique_ptr<MeshRenderer> CreateMeshRenderer() override;
+		std::unique_ptr<ImpostorRenderer> CreateImpostorRenderer() override;
+		std::unique_ptr<PointCloudRenderer> CreatePointCloudRenderer() override;
 
 	private:
 		std::unique_ptr<ShaderProgram> normalShader_;
 		std::unique_ptr<ShaderProgram> materialShader_;
+		std::unique_ptr<ShaderProgram> subtreeNormalShader_;
+		std::unique_ptr<ShaderProgram> subtreeMaterialShader_;
+		std::unique_ptr<ShaderProgram> impostorShader_;
+		std::unique_ptr<ShaderProgram> pointCloudShader_;
 	};
 }
 
@@ -12,6 +12,17 @@ namespace tree_generator::lsystem
 		return output;
 	}
 
+	std::vector<std::vector<Symbol>> GenerateDerivation(
+		const LSystem& lSystem, int iterations)
+	{
+		std::vector<std::vector<Symbol>> derivation{ lSystem.axiom };
+		for (int i = 0; i < iterations; ++i)
+		{
+			derivation.push_back(Iterate(derivation.back(), lSystem.rules));
+		}
+		return derivation;
+	}
+
 	std::vector<Symbol> Iterate(const std::vector<Symbol>& previous, const RuleMap& rules)
 	{
 		std::vector<Symbol> next;
@@ -52,4 +63,16 @@ namespace tree_generator::lsystem
 	{
 		return static_cast<Symbol>(c);
 	}
+
+	void AppendHash(const LSystem& lSystem, utility::ContentHasher* hasher)
+	{
+		// Symbols are chars, so each sequence hashes as text.
+		hasher->Add(ToString(lSystem.axiom));
+		hasher->Add(lSystem.rules.size());
+		for (const auto& [symbol, successor] : lSystem.rules)
+		{
+			hasher->Add(symbol);
+			hasher->Add(ToString(successor));
+		}
+	}
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+#include "../../utility/content_hash.h"
+
 namespace tree_generator::lsystem
 {
 	enum class Symbol : char {};
@@ -17,6 +19,11 @@ namespace tree_generator::lsystem
 	};
 
 	std::vector<Symbol> Generate(const LSystem& lSystem, int iterations);
+
+	// Returns every generation of the derivation, from the axiom (index 0)
+	// to the result of Generate(lSystem, iterations).
+	std::vector<std::vector<Symbol>> GenerateDerivation(
+		const LSystem& lSystem, int iterations);
 	std::vector<Symbol> Iterate(
 		const std::vector<Symbol>& previous, const RuleMap& rules);
 
@@ -24,6 +31,10 @@ namespace tree_generator::lsystem
 	std::string ToString(const std::vector<Symbol>& symbols);
 
 	Symbol ToSymbol(char c);
+
+	// Adds the axiom and every rule to the hash, in order of the rules'
+	// symbols, so that equal L-systems always hash the same.
+	void AppendHash(const LSystem& lSystem, utility::ContentHasher* hasher);
 }
 
 #endif  // !TREE_GENERATOR_LSYSTEM_H_
\ No newline at end of file
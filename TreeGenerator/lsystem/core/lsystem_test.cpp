@@ -6,7 +6,11 @@
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
 
+using ::tree_generator::lsystem::AppendHash;
+using ::tree_generator::lsystem::Generate;
+using ::tree_generator::lsystem::GenerateDerivation;
 using ::tree_generator::lsystem::Iterate;
+using ::tree_generator::lsystem::LSystem;
 using ::tree_generator::lsystem::RuleMap;
 using ::tree_generator::lsystem::Symbol;
 
@@ -89,4 +93,39 @@ TEST(LSystemTest, IterateMultipleCalls)
 	std::vector<Symbol> step2 = Iterate(step1, rules);
 
 	EXPECT_THAT(step2, ElementsAre(B, B, B, A));
+}
+
+TEST(LSystemTest, GenerateDerivationKeepsEveryGeneration)
+{
+	Symbol A{ 'a' };
+	Symbol B{ 'b' };
+	LSystem lSystem{ { A }, { { A, { B, A }} } };
+
+	std::vector<std::vector<Symbol>> derivation = GenerateDerivation(lSystem, 3);
+
+	ASSERT_EQ(derivation.size(), 4);
+	EXPECT_THAT(derivation[0], ElementsAre(A));
+	for (int i = 1; i <= 3; ++i)
+	{
+		EXPECT_THAT(derivation[i], ElementsAreArray(Generate(lSystem, i)));
+	}
+}
+
+TEST(LSystemTest, AppendHashDependsOnAxiomAndRules)
+{
+	Symbol A{ 'a' };
+	Symbol B{ 'b' };
+	auto hash = [](const LSystem& lSystem) {
+		::tree_generator::utility::ContentHasher hasher;
+		AppendHash(lSystem, &hasher);
+		return hasher.Finish();
+		};
+
+	const LSystem lSystem{ { A }, { { A, { B, A }} } };
+	EXPECT_EQ(hash(lSystem), hash(LSystem{ { A }, { { A, { B, A }} } }));
+	EXPECT_NE(hash(lSystem), hash(LSystem{ { B }, { { A, { B, A }} } }));
+	EXPECT_NE(hash(lSystem), hash(LSystem{ { A }, { { A, { A, B }} } }));
+	EXPECT_NE(hash(lSystem), hash(LSystem{ { A }, { { B, { B, A }} } }));
+	// The axiom and a rule's successor can't run together.
+	EXPECT_NE(hash(lSystem), hash(LSystem{ { A, B }, { { A, { A }} } }));
 }
\ No newline at end of file
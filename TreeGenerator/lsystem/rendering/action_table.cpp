@@ -0,0 +1,14 @@
+#include "action_table.h"
+
+namespace tree_generator::lsystem
+{
+	ActionTable CreateActionTable(const MeshGenerator::ActionMap& actions)
+	{
+		ActionTable table{};
+		for (const auto& [symbol, action] : actions)
+		{
+			table[static_cast<unsigned char>(symbol)] = action.get();
+		}
+		return table;
+	}
+}
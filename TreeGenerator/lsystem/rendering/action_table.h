@@ -0,0 +1,24 @@
+#ifndef TREE_GENERATOR_LSYSTEM_ACTION_TABLE_H_
+#define TREE_GENERATOR_LSYSTEM_ACTION_TABLE_H_
+
+#include <array>
+
+#include "../core/lsystem.h"
+#include "mesh_generator.h"
+#include "mesh_generator_action.h"
+
+namespace tree_generator::lsystem
+{
+	// Lookup table from every possible symbol to its action, or nullptr if the
+	// symbol has no action. Avoids hashing every symbol during interpretation.
+	using ActionTable = std::array<MeshGeneratorAction*, 256>;
+
+	ActionTable CreateActionTable(const MeshGenerator::ActionMap& actions);
+
+	inline MeshGeneratorAction* GetAction(const ActionTable& table, Symbol symbol)
+	{
+		return table[static_cast<unsigned char>(symbol)];
+	}
+}
+
+#endif  // !TREE_GENERATOR_LSYSTEM_ACTION_TABLE_H_
@@ -0,0 +1,59 @@
+#include "mesh_cache.h"
+
+namespace tree_generator::lsystem
+{
+	MeshCache& MeshCache::Global()
+	{
+		static MeshCache cache;
+		return cache;
+	}
+
+	MeshCache::MeshCache(std::size_t capacity) :
+		capacity_(capacity < 1 ? 1 : capacity),
+		hits_(0),
+		misses_(0)
+	{
+	}
+
+	std::shared_ptr<const MeshData> MeshCache::GetOrCreate(
+		const MeshKey& key, const std::function<MeshData()>& create)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (auto iter = index_.find(key); iter != index_.end())
+		{
+			++hits_;
+			entries_.splice(entries_.begin(), entries_, iter->second);
+			return iter->second->second;
+		}
+
+		++misses_;
+		if (entries_.size() >= capacity_)
+		{
+			index_.erase(entries_.back().first);
+			entries_.pop_back();
+		}
+		entries_.emplace_front(key, std::make_shared<const MeshData>(create()));
+		index_.emplace(key, entries_.begin());
+		return entries_.front().second;
+	}
+
+	void MeshCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		index_.clear();
+		entries_.clear();
+	}
+
+	void MeshCache::ResetStatistics()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		hits_ = 0;
+		misses_ = 0;
+	}
+
+	MeshCache::Statistics MeshCache::GetStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return { hits_, misses_, entries_.size(), capacity_ };
+	}
+}
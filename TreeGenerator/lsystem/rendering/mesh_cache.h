@@ -0,0 +1,66 @@
+#ifndef TREE_GENERATOR_LSYSTEM_MESH_CACHE_H_
+#define TREE_GENERATOR_LSYSTEM_MESH_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "../../graphics/common/mesh_data.h"
+#include "mesh_definition.h"
+
+namespace tree_generator::lsystem
+{
+	// Least-recently-used cache of generated meshes, keyed by mesh type and
+	// the exact parameters used to generate the mesh.
+	//
+	// Meshes are handed out as shared pointers, so evicting an entry does not
+	// invalidate meshes that are still in use elsewhere.
+	//
+	// All member functions are thread-safe.
+	class MeshCache
+	{
+	public:
+		struct Statistics
+		{
+			std::size_t hits;
+			std::size_t misses;
+			std::size_t size;
+			std::size_t capacity;
+		};
+
+		static constexpr std::size_t kDefaultCapacity = 64;
+
+		// The process-wide cache used by MeshDefinition::GetMesh.
+		static MeshCache& Global();
+
+		explicit MeshCache(std::size_t capacity = kDefaultCapacity);
+
+		// Returns the cached mesh for this key, calling create to generate it
+		// (and evicting the least recently used entry, if full) on a miss.
+		std::shared_ptr<const MeshData> GetOrCreate(
+			const MeshKey& key, const std::function<MeshData()>& create);
+
+		// Removes all entries. Does not reset the hit/miss counters.
+		void Clear();
+		void ResetStatistics();
+		Statistics GetStatistics() const;
+
+	private:
+		using Entry = std::pair<MeshKey, std::shared_ptr<const MeshData>>;
+
+		mutable std::mutex mutex_;
+		std::size_t capacity_;
+		std::size_t hits_;
+		std::size_t misses_;
+
+		// Ordered from most to least recently used.
+		std::list<Entry> entries_;
+		std::unordered_map<MeshKey, std::list<Entry>::iterator, MeshKeyHash> index_;
+	};
+}
+
+#endif  // !TREE_GENERATOR_LSYSTEM_MESH_CACHE_H_
@@ -0,0 +1,173 @@
+#include "mesh_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "../../graphics/common/mesh_data.h"
+#include "mesh_definition.h"
+
+using ::testing::ElementsAre;
+using ::testing::FieldsAre;
+using ::testing::SizeIs;
+
+namespace tree_generator::lsystem
+{
+	namespace
+	{
+		MeshKey CylinderKey(int sideCount)
+		{
+			MeshKey key{ MeshType::Cylinder };
+			key.sideCount = sideCount;
+			key.height = 1.0f;
+			key.radius = 1.0f;
+			return key;
+		}
+
+		TEST(LSystemMeshCacheTest, MissGeneratesMesh)
+		{
+			MeshCache cache;
+			int createCount = 0;
+			auto mesh = cache.GetOrCreate(CylinderKey(3), [&]() {
+				++createCount;
+				return CreateCylinder(3);
+				});
+
+			EXPECT_EQ(createCount, 1);
+			EXPECT_THAT(mesh->vertices, SizeIs(CreateCylinder(3).vertices.size()));
+			EXPECT_THAT(cache.GetStatistics(), FieldsAre(0, 1, 1, MeshCache::kDefaultCapacity));
+		}
+
+		TEST(LSystemMeshCacheTest, HitReturnsSharedMesh)
+		{
+			MeshCache cache;
+			int createCount = 0;
+			auto create = [&]() {
+				++createCount;
+				return CreateCylinder(3);
+				};
+
+			auto first = cache.GetOrCreate(CylinderKey(3), create);
+			auto second = cache.GetOrCreate(CylinderKey(3), create);
+
+			EXPECT_EQ(createCount, 1);
+			EXPECT_EQ(first, second);
+			EXPECT_THAT(cache.GetStatistics(), FieldsAre(1, 1, 1, MeshCache::kDefaultCapacity));
+		}
+
+		TEST(LSystemMeshCacheTest, DifferentParametersAreDifferentEntries)
+		{
+			MeshCache cache;
+			auto first = cache.GetOrCreate(CylinderKey(3), []() { return CreateCylinder(3); });
+			auto second = cache.GetOrCreate(CylinderKey(4), []() { return CreateCylinder(4); });
+
+			EXPECT_NE(first, second);
+			EXPECT_EQ(cache.GetStatistics().misses, 2);
+		}
+
+		TEST(LSystemMeshCacheTest, EvictsLeastRecentlyUsed)
+		{
+			MeshCache cache(2);
+			auto create = []() { return CreateQuad(); };
+
+			auto evicted = cache.GetOrCreate(CylinderKey(3), create);
+			cache.GetOrCreate(CylinderKey(4), create);
+			cache.GetOrCreate(CylinderKey(3), create);
+			cache.GetOrCreate(CylinderKey(5), create);
+
+			// 4 was least recently used, so it is regenerated; 3 is not.
+			cache.ResetStatistics();
+			cache.GetOrCreate(CylinderKey(3), create);
+			cache.GetOrCreate(CylinderKey(4), create);
+			EXPECT_THAT(cache.GetStatistics(), FieldsAre(1, 1, 2, 2));
+
+			// Evicted meshes stay valid for their existing owners.
+			EXPECT_THAT(evicted->indices, SizeIs(6));
+		}
+
+		TEST(LSystemMeshCacheTest, DefinitionsWithSameParametersShareMesh)
+		{
+			CylinderDefinition first(5, 2.0f, 0.25f);
+			CylinderDefinition second(5, 2.0f, 0.25f);
+			CylinderDefinition different(6, 2.0f, 0.25f);
+
+			EXPECT_EQ(first.GetMesh(), second.GetMesh());
+			EXPECT_NE(first.GetMesh(), different.GetMesh());
+		}
+
+		TEST(LSystemMeshCacheTest, CylinderOptionsAreKeptApart)
+		{
+			CylinderOptions options;
+			options.hasCaps = true;
+			options.hasUvs = true;
+			CylinderDefinition plain(5, 2.0f, 0.25f);
+			CylinderDefinition capped(5, 2.0f, 0.25f, options);
+
+			EXPECT_NE(plain.GetMeshKey(), capped.GetMeshKey());
+			EXPECT_NE(plain.GetMesh(), capped.GetMesh());
+			EXPECT_THAT(capped.GetMesh()->vertices, SizeIs(GetCylinderVertexCount(5, options)));
+
+			// Coarser levels keep the options.
+			std::vector<std::shared_ptr<const MeshData>> lods = capped.GetLods();
+			ASSERT_THAT(lods, SizeIs(2));
+			EXPECT_TRUE(capped.GetLodKey(1).hasCaps);
+			EXPECT_THAT(lods[1]->vertices, SizeIs(GetCylinderVertexCount(3, options)));
+		}
+
+		TEST(LSystemMeshCacheTest, CylinderLodsHalveSideCount)
+		{
+			EXPECT_THAT(GetCylinderLodSideCounts(16), ElementsAre(16, 8, 4, 3));
+			EXPECT_THAT(GetCylinderLodSideCounts(7), ElementsAre(7, 3));
+			EXPECT_THAT(GetCylinderLodSideCounts(3), ElementsAre(3));
+		}
+
+		TEST(LSystemMeshCacheTest, CylinderLodsAreSharedWithCoarserCylinders)
+		{
+			CylinderDefinition cylinder(16, 2.0f, 0.25f);
+			CylinderDefinition coarse(4, 2.0f, 0.25f);
+
+			std::vector<std::shared_ptr<const MeshData>> lods = cylinder.GetLods();
+			ASSERT_THAT(lods, SizeIs(4));
+			EXPECT_EQ(lods[0], cylinder.GetMesh());
+			EXPECT_EQ(lods[2], coarse.GetMesh());
+			for (std::size_t i = 1; i < lods.size(); ++i)
+			{
+				EXPECT_LT(lods[i]->indices.size(), lods[i - 1]->indices.size());
+			}
+		}
+
+		TEST(LSystemMeshCacheTest, QuadLodIsTriangleWithSameArea)
+		{
+			QuadDefinition quad;
+			std::vector<std::shared_ptr<const MeshData>> lods = quad.GetLods();
+			ASSERT_THAT(lods, SizeIs(2));
+			ASSERT_THAT(lods[1]->vertices, SizeIs(3));
+			ASSERT_THAT(lods[1]->indices, SizeIs(3));
+
+			auto TriangleArea = [](const MeshData& mesh, std::size_t first) {
+				const glm::vec3 a = mesh.vertices[mesh.indices[first]].position;
+				const glm::vec3 b = mesh.vertices[mesh.indices[first + 1]].position;
+				const glm::vec3 c = mesh.vertices[mesh.indices[first + 2]].position;
+				return glm::cross(b - a, c - a);
+				};
+			const glm::vec3 quadArea = TriangleArea(*lods[0], 0) + TriangleArea(*lods[0], 3);
+			const glm::vec3 triangleArea = TriangleArea(*lods[1], 0);
+
+			// Same area, and facing the same way.
+			EXPECT_NEAR(triangleArea.z, quadArea.z, 1e-5f);
+			EXPECT_NE(quadArea.z, 0.0f);
+
+			glm::vec3 center(0.0f);
+			for (const Vertex& vertex : lods[1]->vertices)
+			{
+				center += vertex.position / 3.0f;
+			}
+			EXPECT_NEAR(glm::length(center), 0.0f, 1e-5f);
+		}
+	}
+}
@@ -1,10 +1,41 @@
 #include "mesh_definition.h"
 
+#include <algorithm>
+#include <functional>
+
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
 
+#include "mesh_cache.h"
+
 namespace tree_generator::lsystem
 {
+	namespace
+	{
+		struct QuadCorners
+		{
+			glm::vec2 bottomLeft;
+			glm::vec2 topLeft;
+			glm::vec2 bottomRight;
+			glm::vec2 topRight;
+		};
+
+		QuadCorners GetQuadCorners(float width, float height, float skew)
+		{
+			float x = width / 2;
+
+			float skewX = glm::sin(glm::radians(skew)) * height / 2;
+			float skewY = glm::cos(glm::radians(skew)) * height / 2;
+
+			return {
+				glm::vec2(-x - skewX, -skewY),
+				glm::vec2(-x + skewX, skewY),
+				glm::vec2(x - skewX, -skewY),
+				glm::vec2(x + skewX, skewY) };
+		}
+	}
+
 	std::string GetName(MeshType meshType)
 	{
 		switch (meshType)
@@ -17,6 +48,24 @@ namespace tree_generator::lsystem
 		return "Unknown";
 	}
 
+	std::size_t MeshKeyHash::operator()(const MeshKey& key) const
+	{
+		// Boost-style hash_combine.
+		std::size_t seed = std::hash<int>()(static_cast<int>(key.meshType));
+		auto combine = [&seed](std::size_t value) {
+			seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+			};
+		combine(std::hash<int>()(key.sideCount));
+		combine(std::hash<float>()(key.height));
+		combine(std::hash<float>()(key.radius));
+		combine(std::hash<float>()(key.width));
+		combine(std::hash<float>()(key.skew));
+		combine(std::hash<bool>()(key.hasCaps));
+		combine(std::hash<bool>()(key.hasUvs));
+		combine(std::hash<int>()(key.lod));
+		return seed;
+	}
+
 	std::unique_ptr<MeshDefinition> MeshDefinition::FromMeshType(MeshType meshType)
 	{
 		switch (meshType)
@@ -29,10 +78,54 @@ namespace tree_generator::lsystem
 		return nullptr;
 	}
 
-	CylinderDefinition::CylinderDefinition(int sideCount, float height, float radius) :
+	void MeshDefinition::AppendHash(utility::ContentHasher* hasher) const
+	{
+		const MeshKey key = GetMeshKey();
+		hasher->Add(key.meshType);
+		hasher->Add(key.sideCount);
+		hasher->Add(key.height);
+		hasher->Add(key.radius);
+		hasher->Add(key.width);
+		hasher->Add(key.skew);
+		hasher->Add(key.hasCaps);
+		hasher->Add(key.hasUvs);
+		hasher->Add(key.lod);
+	}
+
+	std::shared_ptr<const MeshData> MeshDefinition::GetMesh() const
+	{
+		return MeshCache::Global().GetOrCreate(
+			GetMeshKey(), [this]() { return GenerateMesh(); });
+	}
+
+	std::vector<std::shared_ptr<const MeshData>> MeshDefinition::GetLods() const
+	{
+		std::vector<std::shared_ptr<const MeshData>> lods{ GetMesh() };
+		for (int lod = 1; lod < GetLodCount(); ++lod)
+		{
+			lods.push_back(MeshCache::Global().GetOrCreate(
+				GetLodKey(lod), [this, lod]() { return GenerateLod(lod); }));
+		}
+		return lods;
+	}
+
+	std::vector<int> GetCylinderLodSideCounts(int sideCount)
+	{
+		std::vector<int> sideCounts{ sideCount };
+		while (sideCount > 3)
+		{
+			sideCount = std::max(sideCount / 2, 3);
+			sideCounts.push_back(sideCount);
+		}
+		return sideCounts;
+	}
+
+	CylinderDefinition::CylinderDefinition(
+		int sideCount, float height, float radius, const CylinderOptions& options) :
 		sideCount_(sideCount),
 		height_(height),
-		radius_(radius)
+		radius_(radius),
+		options_(options)
 	{
 
 	}
@@ -79,12 +172,46 @@ namespace tree_generator::lsystem
 				wasChanged = true;
 			}
 		}
+
+		wasChanged |= ImGui::Checkbox("Caps", &options_.hasCaps);
+		wasChanged |= ImGui::Checkbox("Uvs", &options_.hasUvs);
 		return wasChanged;
 	}
 
 	MeshData CylinderDefinition::GenerateMesh() const
 	{
-		return CreateCylinder(sideCount_, height_, radius_);
+		return CreateCylinder(sideCount_, height_, radius_, options_);
+	}
+
+	MeshKey CylinderDefinition::GetMeshKey() const
+	{
+		MeshKey key{ MeshType::Cylinder };
+		key.sideCount = sideCount_;
+		key.height = height_;
+		key.radius = radius_;
+		key.hasCaps = options_.hasCaps;
+		key.hasUvs = options_.hasUvs;
+		return key;
+	}
+
+	int CylinderDefinition::GetLodCount() const
+	{
+		return static_cast<int>(GetCylinderLodSideCounts(sideCount_).size());
+	}
+
+	MeshData CylinderDefinition::GenerateLod(int lod) const
+	{
+		return CreateCylinder(
+			GetCylinderLodSideCounts(sideCount_)[lod], height_, radius_, options_);
+	}
+
+	MeshKey CylinderDefinition::GetLodKey(int lod) const
+	{
+		// Coarser levels are just cylinders with fewer sides, so they are
+		// shared with definitions of those cylinders.
+		MeshKey key = GetMeshKey();
+		key.sideCount = GetCylinderLodSideCounts(sideCount_)[lod];
+		return key;
 	}
 
 	QuadDefinition::QuadDefinition() :
@@ -105,17 +232,52 @@ namespace tree_generator::lsystem
 
 	MeshData QuadDefinition::GenerateMesh() const
 	{
-		float x = width_ / 2;
-		float y = height_ / 2;
+		QuadCorners corners = GetQuadCorners(width_, height_, skew_);
+		return CreateQuad(
+			corners.bottomLeft, corners.topLeft, corners.bottomRight, corners.topRight);
+	}
 
-		float skewX = glm::sin(glm::radians(skew_)) * height_ / 2;
-		float skewY = glm::cos(glm::radians(skew_)) * height_ / 2;
+	MeshData QuadDefinition::GenerateLod(int lod) const
+	{
+		if (lod == 0)
+		{
+			return GenerateMesh();
+		}
 
-		glm::vec2 bottomLeft(-x - skewX, -skewY);
-		glm::vec2 topLeft(-x + skewX, skewY);
-		glm::vec2 bottomRight(x - skewX, -skewY);
-		glm::vec2 topRight(x + skewX, skewY);
+		// The triangle spans the quad's edges scaled by sqrt(2), which gives
+		// it the quad's area, and is shifted to share the quad's center.
+		QuadCorners corners = GetQuadCorners(width_, height_, skew_);
+		const glm::vec2 across = glm::root_two<float>() * (corners.bottomRight - corners.bottomLeft);
+		const glm::vec2 up = glm::root_two<float>() * (corners.topLeft - corners.bottomLeft);
+		const glm::vec2 bottomLeft = -across / 2.0f - up / 3.0f;
+		const glm::vec2 bottomRight = across / 2.0f - up / 3.0f;
+		const glm::vec2 top = 2.0f * up / 3.0f;
 
-		return CreateQuad(bottomLeft, topLeft, bottomRight, topRight);
+		// Wound the same way as the quad's triangles.
+		glm::vec3 normal(0.0f, 0.0f, -1.0f);
+		MeshData triangle;
+		triangle.vertices = {
+			{ glm::vec3(bottomRight, 0.0f), normal },
+			{ glm::vec3(bottomLeft, 0.0f), normal },
+			{ glm::vec3(top, 0.0f), normal }
+		};
+		triangle.indices = { 0, 1, 2 };
+		return triangle;
+	}
+
+	MeshKey QuadDefinition::GetLodKey(int lod) const
+	{
+		MeshKey key = GetMeshKey();
+		key.lod = lod;
+		return key;
+	}
+
+	MeshKey QuadDefinition::GetMeshKey() const
+	{
+		MeshKey key{ MeshType::Quad };
+		key.height = height_;
+		key.width = width_;
+		key.skew = skew_;
+		return key;
 	}
 }
\ No newline at end of file
@@ -1,11 +1,14 @@
 #ifndef TREE_GENERATOR_LSYSTEM_MESH_DEFINITION_H_
 #define TREE_GENERATOR_LSYSTEM_MESH_DEFINITION_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "../../graphics/common/mesh_data.h"
+#include "../../utility/content_hash.h"
 #include "../../utility/enum_helper.h"
 
 namespace tree_generator::lsystem
@@ -22,6 +25,31 @@ namespace tree_generator::lsystem
 
 	std::string GetName(MeshType meshType);
 
+	// Identifies a generated mesh by its type and the exact parameters used to
+	// generate it. Parameters that do not apply to a mesh type are left as 0.
+	struct MeshKey
+	{
+		MeshType meshType;
+		int sideCount = 0;
+		float height = 0.0f;
+		float radius = 0.0f;
+		float width = 0.0f;
+		float skew = 0.0f;
+		bool hasCaps = false;
+		bool hasUvs = false;
+
+		// Level of detail, for meshes whose coarser levels can't be described
+		// by the other parameters.
+		int lod = 0;
+
+		bool operator==(const MeshKey& other) const = default;
+	};
+
+	struct MeshKeyHash
+	{
+		std::size_t operator()(const MeshKey& key) const;
+	};
+
 	class MeshDefinition
 	{
 	public:
@@ -34,24 +62,54 @@ namespace tree_generator::lsystem
 		virtual MeshData GenerateMesh() const = 0;
 
 		virtual MeshType GetMeshType() const = 0;
+		virtual MeshKey GetMeshKey() const = 0;
+
+		// Adds every parameter of the mesh to the hash. The mesh key
+		// already holds them all, so only definitions with parameters
+		// outside it need to override this.
+		virtual void AppendHash(utility::ContentHasher* hasher) const;
+
+		// Number of levels of detail the mesh can be drawn with. Level 0 is
+		// the mesh itself, and every following level is coarser.
+		virtual int GetLodCount() const { return 1; }
+		virtual MeshData GenerateLod(int lod) const { return GenerateMesh(); }
+		virtual MeshKey GetLodKey(int lod) const { return GetMeshKey(); }
+
+		// Returns the generated mesh, shared with every other definition that
+		// has the same key. See MeshCache.
+		std::shared_ptr<const MeshData> GetMesh() const;
+
+		// Returns the mesh at every level of detail, shared like GetMesh().
+		std::vector<std::shared_ptr<const MeshData>> GetLods() const;
 	};
 
+	// Side counts of a cylinder's levels of detail: the side count is halved
+	// for each level, down to 3.
+	std::vector<int> GetCylinderLodSideCounts(int sideCount);
+
 	class CylinderDefinition : public MeshDefinition
 	{
 	public:
-		CylinderDefinition(int sideCount, float height, float radius);
+		CylinderDefinition(
+			int sideCount, float height, float radius, const CylinderOptions& options = {});
 
 		bool ShowGUI() override;
 		const std::string_view Name() const override { return kName_; }
 		MeshData GenerateMesh() const override;
 
 		MeshType GetMeshType() const override { return MeshType::Cylinder; }
+		MeshKey GetMeshKey() const override;
+
+		int GetLodCount() const override;
+		MeshData GenerateLod(int lod) const override;
+		MeshKey GetLodKey(int lod) const override;
 
 	private:
 		inline static const std::string kName_ = "Cylinder";
 		int sideCount_;
 		float height_;
 		float radius_;
+		CylinderOptions options_;
 	};
 
 	class QuadDefinition : public MeshDefinition
@@ -64,6 +122,13 @@ namespace tree_generator::lsystem
 		MeshData GenerateMesh() const override;
 
 		MeshType GetMeshType() const override { return MeshType::Quad; }
+		MeshKey GetMeshKey() const override;
+
+		// The quad's only coarser level is a single triangle with the same
+		// center and area.
+		int GetLodCount() const override { return 2; }
+		MeshData GenerateLod(int lod) const override;
+		MeshKey GetLodKey(int lod) const override;
 
 	private:
 		inline static const std::string kName_ = "Quad";
@@ -1,10 +1,51 @@
 #include "mesh_generator.h"
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../../graphics/common/mesh_baker.h"
+#include "../../graphics/common/mesh_optimizer.h"
+#include "../../graphics/common/mesh_simplifier.h"
+#include "../../utility/task_pool.h"
+#include "action_table.h"
+#include "mesh_definition.h"
+#include "op_stream.h"
+#include "parallel_interpreter.h"
+#include "subtree_instancer.h"
 
 namespace tree_generator::lsystem
 {
+	namespace
+	{
+		constexpr std::size_t kNoGroup = static_cast<std::size_t>(-1);
+
+		// Number of instances baked by one task.
+		constexpr std::size_t kBakeChunkSize = 1024;
+
+		// Point clouds are sampled with a fixed seed, so that regenerating a
+		// tree doesn't make its points flicker.
+		constexpr std::uint32_t kPointCloudSeed = 0;
+
+		// Instances of one mesh group baked by one task, and where in its
+		// material's mesh they are written.
+		struct BakeJob
+		{
+			std::size_t material;
+			const MatrixMeshGroup* group;
+			std::size_t firstInstance;
+			std::size_t instanceCount;
+			std::size_t firstVertex;
+			std::size_t firstIndex;
+		};
+	}
+
 	void MeshGenerator::Define(
 		const Symbol& symbol,
 		std::unique_ptr<MeshGeneratorAction> action)
@@ -29,22 +70,395 @@ namespace tree_generator::lsystem
 		state.positionStack.push_back(glm::vec3(0.0f));
 		state.rotationStack.push_back(glm::vec3(0.0f));
 
-		for (const Symbol& symbol : symbols)
+		ExecuteOpStream(
+			CompileOpStream(symbols, CreateActionTable(actions_)),
+			&state,
+			[&state](const Op& op) { op.action->PerformAction(op.symbol, &state); });
+
+		std::vector<MeshGroup> meshes;
+		for (auto& [symbol, meshGroup] : state.symbolMeshMap)
+		{
+			meshes.push_back(std::move(meshGroup));
+		}
+		return meshes;
+	}
+
+	std::vector<MeshGroup> MeshGenerator::Generate(
+		const std::vector<Symbol>& symbols, GenerationMode mode) const
+	{
+		switch (mode)
+		{
+		case GenerationMode::Serial:
+			return Generate(symbols);
+		case GenerationMode::PrefixScan:
+			return GenerateWithPrefixScan(
+				symbols,
+				CreateActionTable(actions_),
+				&utility::TaskPool::Default());
+		case GenerationMode::BranchParallel:
+			return GenerateWithBranchTasks(
+				symbols,
+				CreateActionTable(actions_),
+				&utility::TaskPool::Default());
+		}
+		return Generate(symbols);
+	}
+
+	std::vector<MatrixMeshGroup> MeshGenerator::GenerateMatrices(
+		const std::vector<Symbol>& symbols, InstanceBuffer* instances) const
+	{
+		const OpStream stream = CompileOpStream(symbols, CreateActionTable(actions_));
+
+		// Count the instances of each mesh first, so that every matrix can
+		// be written straight to its final position in the buffer.
+		std::vector<const DrawAction*> drawActions;
+		std::vector<Symbol> drawSymbols;
+		std::array<std::size_t, 256> groupIndices;
+		groupIndices.fill(kNoGroup);
+		std::vector<std::size_t> instanceCounts;
+		for (const Op& op : stream.ops)
+		{
+			if (op.type != OpType::Draw)
+			{
+				continue;
+			}
+
+			std::size_t& groupIndex = groupIndices[static_cast<unsigned char>(op.symbol)];
+			if (groupIndex == kNoGroup)
+			{
+				groupIndex = drawActions.size();
+				drawActions.push_back(static_cast<const DrawAction*>(op.action));
+				drawSymbols.push_back(op.symbol);
+				instanceCounts.push_back(0);
+			}
+			++instanceCounts[groupIndex];
+		}
+
+		std::vector<std::size_t> nextInstances(drawActions.size());
+		std::size_t instanceCount = 0;
+		for (std::size_t i = 0; i < drawActions.size(); ++i)
+		{
+			nextInstances[i] = instanceCount;
+			instanceCount += instanceCounts[i];
+		}
+		instances->Resize(instanceCount);
+
+		MeshGeneratorState state;
+		state.positionStack.push_back(glm::vec3(0.0f));
+		state.rotationStack.push_back(glm::vec3(0.0f));
+		ExecuteOpStream(stream, &state, [&](const Op& op) {
+			std::size_t groupIndex = groupIndices[static_cast<unsigned char>(op.symbol)];
+			if (groupIndex == kNoGroup)
+			{
+				op.action->PerformAction(op.symbol, &state);
+			}
+			else
+			{
+				(*instances)[nextInstances[groupIndex]++] =
+					ToMatrix(drawActions[groupIndex]->CreateInstance(state));
+			}
+			});
+
+		std::vector<MatrixMeshGroup> meshes;
+		std::size_t firstInstance = 0;
+		for (std::size_t i = 0; i < drawActions.size(); ++i)
+		{
+			meshes.push_back({
+				drawActions[i]->GetMesh(),
+				instances->Matrices().subspan(firstInstance, instanceCounts[i]),
+				drawActions[i]->GetMaterial(),
+				drawActions[i]->GetLods(),
+				drawSymbols[i] });
+			firstInstance += instanceCounts[i];
+		}
+		return meshes;
+	}
+
+	std::vector<MatrixMeshGroup> MeshGenerator::GenerateMatrices(
+		const std::vector<Symbol>& symbols,
+		InstanceBuffer* instances,
+		InstanceBounds* bounds) const
+	{
+		std::vector<MatrixMeshGroup> meshes = GenerateMatrices(symbols, instances);
+
+		bounds->Resize(instances->Size());
+		std::size_t instance = 0;
+		for (const MatrixMeshGroup& group : meshes)
+		{
+			const BoundingBox meshBounds = ComputeBounds(*group.mesh);
+			for (const glm::mat4& model : group.instances)
+			{
+				bounds->Set(instance++, TransformBounds(meshBounds, model));
+			}
+		}
+		return meshes;
+	}
+
+	std::vector<DepthLod> MeshGenerator::GenerateDepthLods(
+		const std::vector<std::vector<Symbol>>& derivation,
+		std::span<const int> depths,
+		const BoundingBox& bounds) const
+	{
+		std::vector<DepthLod> lods;
+		lods.reserve(depths.size());
+		for (int depth : depths)
+		{
+			DepthLod& lod = lods.emplace_back();
+			lod.depth = depth;
+			InstanceBounds lodBounds;
+			lod.groups = GenerateMatrices(derivation.at(depth), &lod.instances, &lodBounds);
+
+			// The groups refer to the buffer's storage, which moving the lod
+			// keeps.
+			const BoundingBox totalBounds = lodBounds.GetTotalBounds();
+			const float lodSize = totalBounds.IsEmpty() ? 0.0f : glm::length(totalBounds.Extent());
+			lod.scale = lodSize > 0.0f && !bounds.IsEmpty()
+				? glm::length(bounds.Extent()) / lodSize
+				: 1.0f;
+			const glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(lod.scale));
+			for (glm::mat4& model : lod.instances.Matrices())
+			{
+				model = scale * model;
+			}
+		}
+		return lods;
+	}
+
+	std::vector<BakedMeshGroup> MeshGenerator::GenerateBaked(
+		const std::vector<Symbol>& symbols,
+		float weldTolerance,
+		bool doOptimize,
+		int lodCount) const
+	{
+		if (lodCount < 1)
+		{
+			throw std::invalid_argument("LOD count must be positive");
+		}
+
+		InstanceBuffer instances;
+		const std::vector<MatrixMeshGroup> groups = GenerateMatrices(symbols, &instances);
+
+		// Lay out every material's mesh first, so that the instances can be
+		// baked in parallel straight to their final position.
+		std::vector<Material> materials;
+		std::vector<std::size_t> vertexCounts;
+		std::vector<std::size_t> indexCounts;
+		std::vector<BakeJob> jobs;
+		for (const MatrixMeshGroup& group : groups)
 		{
-			if (auto iter = actions_.find(symbol); iter != actions_.end())
+			auto material = std::find_if(materials.begin(), materials.end(),
+				[&group](const Material& other) { return other.color == group.material.color; });
+			const std::size_t materialIndex = std::distance(materials.begin(), material);
+			if (material == materials.end())
+			{
+				materials.push_back(group.material);
+				vertexCounts.push_back(0);
+				indexCounts.push_back(0);
+			}
+
+			for (std::size_t first = 0; first < group.instances.size(); first += kBakeChunkSize)
+			{
+				const std::size_t count = std::min(kBakeChunkSize, group.instances.size() - first);
+				jobs.push_back({
+					materialIndex,
+					&group,
+					first,
+					count,
+					vertexCounts[materialIndex],
+					indexCounts[materialIndex] });
+				vertexCounts[materialIndex] += count * group.mesh->vertices.size();
+				indexCounts[materialIndex] += count * group.mesh->indices.size();
+			}
+		}
+
+		std::vector<std::vector<Vertex>> vertices(materials.size());
+		std::vector<std::vector<std::uint32_t>> indices(materials.size());
+		for (std::size_t i = 0; i < materials.size(); ++i)
+		{
+			vertices[i].resize(vertexCounts[i]);
+			indices[i].resize(indexCounts[i]);
+		}
+
+		utility::TaskPool& pool = utility::TaskPool::Default();
+		utility::ParallelFor(pool, jobs.size(), [&](std::size_t j) {
+			const BakeJob& job = jobs[j];
+			const MeshData& mesh = *job.group->mesh;
+			std::size_t vertex = job.firstVertex;
+			std::size_t index = job.firstIndex;
+			for (std::size_t i = 0; i < job.instanceCount; ++i)
+			{
+				BakeInstance(
+					mesh,
+					job.group->instances[job.firstInstance + i],
+					static_cast<std::uint32_t>(vertex),
+					vertices[job.material].data() + vertex,
+					indices[job.material].data() + index);
+				vertex += mesh.vertices.size();
+				index += mesh.indices.size();
+			}
+			});
+
+		std::vector<BakedMeshGroup> meshes(materials.size());
+		utility::ParallelFor(pool, materials.size(), [&](std::size_t i) {
+			WeldVertices(weldTolerance, &vertices[i], &indices[i]);
+			std::vector<MeshData> lods;
+			if (lodCount > 1)
 			{
-				if (iter->second != nullptr)
+				SimplifyOptions options;
+				options.doRemoveParts = true;
+				lods = GenerateSimplifiedLods(
+					MeshData{ std::move(vertices[i]), std::move(indices[i]) },
+					lodCount,
+					0.5f,
+					options);
+
+				// The first level is the welded mesh itself.
+				vertices[i] = std::move(lods[0].vertices);
+				indices[i] = std::move(lods[0].indices);
+			}
+			if (doOptimize)
+			{
+				OptimizeMesh(&vertices[i], &indices[i]);
+			}
+			meshes[i] = {
+				CreateBakedMesh(std::move(vertices[i]), std::move(indices[i])),
+				materials[i] };
+			for (std::size_t lod = 1; lod < lods.size(); ++lod)
+			{
+				if (doOptimize)
 				{
-					iter->second->PerformAction(symbol, &state);
+					OptimizeMesh(&lods[lod]);
 				}
+				meshes[i].lods.push_back(CreateBakedMesh(
+					std::move(lods[lod].vertices), std::move(lods[lod].indices)));
 			}
+			});
+		return meshes;
+	}
+
+	PointCloud MeshGenerator::GeneratePointCloud(
+		const std::vector<Symbol>& symbols, int pointCount) const
+	{
+		InstanceBuffer instances;
+		const std::vector<MatrixMeshGroup> groups = GenerateMatrices(symbols, &instances);
+		return GeneratePointCloud(groups, pointCount);
+	}
+
+	PointCloud MeshGenerator::GeneratePointCloud(
+		std::span<const MatrixMeshGroup> groups, int pointCount)
+	{
+		std::vector<MeshInstances> sources;
+		for (const MatrixMeshGroup& group : groups)
+		{
+			sources.push_back({ group.mesh.get(), group.instances, group.material });
 		}
+		return SamplePointCloud(sources, pointCount, kPointCloudSeed);
+	}
 
-		std::vector<MeshGroup> meshes;
-		for (auto& [symbol, meshGroup] : state.symbolMeshMap)
+	std::vector<SubtreeMeshGroup> MeshGenerator::GenerateSubtrees(
+		const LSystem& lSystem, int iterations) const
+	{
+		return GenerateSubtreeInstances(
+			lSystem, iterations, CreateActionTable(actions_));
+	}
+
+	void MeshGenerator::AppendHash(utility::ContentHasher* hasher) const
+	{
+		const std::vector<std::pair<Symbol, const MeshGeneratorAction*>> actions =
+			GetSortedActions();
+		hasher->Add(actions.size());
+		for (const auto& [symbol, action] : actions)
 		{
-			meshes.push_back(std::move(meshGroup));
+			hasher->Add(symbol);
+			if (action == nullptr)
+			{
+				hasher->Add(MeshGeneratorActionType::None);
+			}
+			else
+			{
+				action->AppendHash(hasher);
+			}
 		}
-		return meshes;
+	}
+
+	void MeshGenerator::AppendPlacementHash(utility::ContentHasher* hasher) const
+	{
+		const std::vector<std::pair<Symbol, const MeshGeneratorAction*>> actions =
+			GetSortedActions();
+		hasher->Add(actions.size());
+		for (const auto& [symbol, action] : actions)
+		{
+			hasher->Add(symbol);
+			if (action == nullptr)
+			{
+				hasher->Add(MeshGeneratorActionType::None);
+			}
+			else
+			{
+				action->AppendPlacementHash(hasher);
+			}
+		}
+	}
+
+	std::vector<std::pair<Symbol, const MeshGeneratorAction*>> MeshGenerator::GetSortedActions() const
+	{
+		std::vector<std::pair<Symbol, const MeshGeneratorAction*>> actions;
+		actions.reserve(actions_.size());
+		for (const auto& [symbol, action] : actions_)
+		{
+			actions.emplace_back(symbol, action.get());
+		}
+		std::sort(actions.begin(), actions.end());
+		return actions;
+	}
+
+	utility::ContentHash HashTree(
+		const LSystem& lSystem, int iterations, const MeshGenerator& meshGenerator)
+	{
+		utility::ContentHasher hasher;
+		AppendHash(lSystem, &hasher);
+		hasher.Add(iterations);
+		meshGenerator.AppendHash(&hasher);
+		return hasher.Finish();
+	}
+
+	MeshGenerator CreateDefaultMeshGenerator(glm::vec3 rotation)
+	{
+		Symbol trunk{ 'F' };
+		Symbol leaf{ 'X' };
+
+		Symbol push{ '[' };
+		Symbol pop{ ']' };
+
+		Symbol rotateRight{ '-' };
+		Symbol rotateLeft{ '+' };
+		Symbol advance{ 'A' };
+
+		Material trunkMaterial = { {0.5f, 0.2f, 0.0f, 1.0f} };
+		Material leafMaterial = { {0.0f, 0.5f, 0.0f, 1.0f} };
+
+		MeshGenerator generator;
+		generator.Define(
+			trunk,
+			std::make_unique<DrawAction>(
+				std::make_unique<CylinderDefinition>(8, 0.15f, 0.1f),
+				trunkMaterial));
+		generator.Define(
+			leaf,
+			std::make_unique<DrawAction>(
+				std::make_unique<QuadDefinition>(),
+				leafMaterial));
+		generator.Define(
+			push, std::make_unique<PushStateAction>());
+		generator.Define(
+			pop, std::make_unique<PopStateAction>());
+		generator.Define(
+			rotateRight, std::make_unique<RotateAction>(-rotation));
+		generator.Define(
+			rotateLeft, std::make_unique<RotateAction>(rotation));
+		generator.Define(
+			advance, std::make_unique<MoveAction>(0.15f));
+
+		return generator;
 	}
 }
@@ -2,19 +2,40 @@
 #define TREE_GENERATOR_LSYSTEM_MESH_GENERATOR_H_
 
 #include <memory>
+#include <span>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "../core/lsystem.h"
+#include "../../graphics/common/bounding_box.h"
+#include "../../graphics/common/instance_buffer.h"
 #include "../../graphics/common/mesh_data.h"
+#include "../../graphics/common/point_cloud.h"
 #include "../../graphics/common/transform.h"
+#include "../../utility/content_hash.h"
 #include "mesh_generator_action.h"
 
 namespace tree_generator::lsystem
 {
+	enum class GenerationMode
+	{
+		// Interpret the symbols one after another on the calling thread.
+		Serial,
+
+		// Interpret chunks of symbols in parallel, using a prefix scan over
+		// the chunks to find each chunk's starting state. The output is
+		// identical to Serial.
+		PrefixScan,
+
+		// Interpret large bracketed branches as separate parallel tasks. The
+		// output is identical to Serial.
+		BranchParallel,
+	};
+
 	class MeshGenerator
 	{
 	public:
@@ -33,11 +54,111 @@ namespace tree_generator::lsystem
 		bool HasDefinition(Symbol symbol);
 
 		std::vector<MeshGroup> Generate(const std::vector<Symbol>& symbols) const;
+		std::vector<MeshGroup> Generate(
+			const std::vector<Symbol>& symbols, GenerationMode mode) const;
+
+		// Generates the final model matrix of every instance, written directly
+		// into instances (which is resized to fit). Each group's instances are
+		// contiguous, and groups are ordered by their first drawn instance.
+		std::vector<MatrixMeshGroup> GenerateMatrices(
+			const std::vector<Symbol>& symbols, InstanceBuffer* instances) const;
+
+		// Also writes the world space bounds of every instance to bounds, in
+		// the same order as the matrices. A Bvh can be built over them to
+		// find instances by location.
+		std::vector<MatrixMeshGroup> GenerateMatrices(
+			const std::vector<Symbol>& symbols,
+			InstanceBuffer* instances,
+			InstanceBounds* bounds) const;
+
+		// Generates the instances of shallower generations of a derivation,
+		// as returned by GenerateDerivation(), to stand in for its last
+		// generation where the tree is too small on screen to show the
+		// difference. Each generation is scaled uniformly to the size of
+		// `bounds`, normally the bounds of the last generation's instances.
+		std::vector<DepthLod> GenerateDepthLods(
+			const std::vector<std::vector<Symbol>>& derivation,
+			std::span<const int> depths,
+			const BoundingBox& bounds) const;
+
+		// Generates the geometry of every instance, transformed by its model
+		// matrix, merged into one mesh per material. Vertices whose
+		// attributes all differ by at most weldTolerance are welded
+		// together, and indices are 16-bit where possible. Unless doOptimize
+		// is false, each mesh is then reordered by OptimizeMesh(), and
+		// otherwise its vertices and indices follow the instances. Groups are
+		// ordered by the first drawn instance of their material.
+		//
+		// With a lodCount above one, each group also gets up to lodCount - 1
+		// coarser levels from GenerateSimplifiedLods(), each with half the
+		// triangles of the one before. Once its branches can't get any
+		// coarser, the smallest ones are left out. Throws a
+		// std::invalid_argument if lodCount isn't positive.
+		std::vector<BakedMeshGroup> GenerateBaked(
+			const std::vector<Symbol>& symbols,
+			float weldTolerance,
+			bool doOptimize = true,
+			int lodCount = 1) const;
+
+		// Samples at most pointCount points over the surfaces of every
+		// instance, evenly by area, for drawing the tree as a point cloud
+		// where it is too small on screen for its meshes. Groups with the
+		// same material color share a material index. The points are the
+		// same every time for the same symbols.
+		PointCloud GeneratePointCloud(
+			const std::vector<Symbol>& symbols, int pointCount) const;
+
+		// Samples the points over groups already generated by
+		// GenerateMatrices().
+		static PointCloud GeneratePointCloud(
+			std::span<const MatrixMeshGroup> groups, int pointCount);
+
+		// Generates the instances of the L-system's derivation as templates
+		// of repeated subtrees. Every occurrence of a symbol with the same
+		// number of iterations left expands to the same geometry relative to
+		// the turtle, so that geometry is generated once, in the turtle's
+		// frame, and placed at each occurrence. The depth of the templates is
+		// chosen to minimize the number of matrices.
+		//
+		// Turtle rotations are Euler angles, which only compose like this
+		// when every rotation is around the same axis. Otherwise, each group
+		// holds every instance with a single identity placement.
+		std::vector<SubtreeMeshGroup> GenerateSubtrees(
+			const LSystem& lSystem, int iterations) const;
+
+		// Adds every action, with all of its parameters, to the hash, in
+		// order of the actions' symbols.
+		void AppendHash(utility::ContentHasher* hasher) const;
+
+		// Adds only what changes where instances are drawn: every action,
+		// but not the meshes and materials of draw actions. While this hash
+		// stays the same, GenerateMatrices() writes the same matrices, and
+		// only the groups' meshes and materials can change.
+		void AppendPlacementHash(utility::ContentHasher* hasher) const;
+
 		ActionMap& GetActionMap() { return actions_; }
+		const ActionMap& GetActionMap() const { return actions_; }
 
 	private:
+		// The actions in order of their symbols, which is the same in every
+		// run, unlike the map's.
+		std::vector<std::pair<Symbol, const MeshGeneratorAction*>> GetSortedActions() const;
+
 		std::unordered_map<Symbol, std::unique_ptr<MeshGeneratorAction>> actions_;
 	};
+
+	// Identifies the tree generated from iterations of the L-system by the
+	// mesh generator: equal settings always hash the same, in every run and
+	// on every platform, and changing any of them changes the hash. Hashing
+	// only reads the settings, so it takes microseconds.
+	utility::ContentHash HashTree(
+		const LSystem& lSystem, int iterations, const MeshGenerator& meshGenerator);
+
+	// The actions the editor starts with, also used by batch jobs without
+	// their own: F draws a branch and X a leaf, [ and ] push and pop the
+	// turtle's state, + and - turn by the rotation and A moves forward.
+	MeshGenerator CreateDefaultMeshGenerator(
+		glm::vec3 rotation = glm::vec3(0.0f, 0.0f, 22.5f));
 }
 
 #endif  // !TREE_GENERATOR_LSYSTEM_MESH_GENERATOR_H_
\ No newline at end of file
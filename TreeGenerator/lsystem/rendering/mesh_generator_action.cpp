@@ -12,17 +12,6 @@
 
 namespace tree_generator::lsystem
 {
-	namespace
-	{
-		Transform CreateTransform(const MeshGeneratorState& state)
-		{
-			return Transform { 
-				state.positionStack.back(), 
-				state.rotationStack.back(), 
-				1.0f };
-		}
-	}
-
 	// TODO: Consolidate the names with those in the child MeshGeneratorAction
 	// classes.
 	//
@@ -50,11 +39,27 @@ namespace tree_generator::lsystem
 		return "Unknown action";
 	}
 
+	glm::vec3 GetTurtleDirection(const glm::vec3& rotation)
+	{
+		glm::mat4 matrix = glm::mat4(1.0f);
+		matrix = glm::rotate(matrix, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		matrix = glm::rotate(matrix, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		matrix = glm::rotate(matrix, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+
+		glm::vec3 direction = glm::vec3(0.0f, 1.0f, 0.0f);
+		return glm::mat3(matrix) * direction;
+	}
+
 	void MeshGeneratorAction::ShowGUI()
 	{
 		ImGui::Text("<No options>");
 	}
 
+	void MeshGeneratorAction::AppendHash(utility::ContentHasher* hasher) const
+	{
+		hasher->Add(GetActionType());
+	}
+
 	DrawAction::DrawAction(
 		std::unique_ptr<MeshDefinition> meshDefinition, Material material) :
 		meshDefinition_(std::move(meshDefinition)),
@@ -65,7 +70,7 @@ namespace tree_generator::lsystem
 			throw std::invalid_argument(
 				"Failed to initialize DrawAction: meshDefinition must be non-null");
 		}
-		meshData_ = meshDefinition_->GenerateMesh();
+		UpdateMeshes();
 	}
 
 	void DrawAction::PerformAction(const Symbol& symbol, MeshGeneratorState* state)
@@ -73,15 +78,23 @@ namespace tree_generator::lsystem
 		if (auto iter = state->symbolMeshMap.find(symbol);
 			iter != state->symbolMeshMap.end())
 		{
-			iter->second.instances.push_back(CreateTransform(*state));
+			iter->second.instances.push_back(CreateInstance(*state));
 		}
 		else
 		{
 			state->symbolMeshMap.emplace(symbol,
-				MeshGroup{ meshData_, { CreateTransform(*state) }, material_ });
+				MeshGroup{ *meshData_, { CreateInstance(*state) }, material_ });
 		}
 	}
 
+	Transform DrawAction::CreateInstance(const MeshGeneratorState& state) const
+	{
+		return Transform {
+			state.positionStack.back(),
+			state.rotationStack.back(),
+			1.0f };
+	}
+
 	void DrawAction::ShowGUI()
 	{
 		MeshType currentMeshType = meshDefinition_->GetMeshType();
@@ -98,7 +111,7 @@ namespace tree_generator::lsystem
 			else
 			{
 				meshDefinition_ = std::move(newDefinition);
-				meshData_ = meshDefinition_->GenerateMesh();
+				UpdateMeshes();
 			}
 		}
 
@@ -108,7 +121,7 @@ namespace tree_generator::lsystem
 
 		if (meshDefinition_->ShowGUI())
 		{
-			meshData_ = meshDefinition_->GenerateMesh();
+			UpdateMeshes();
 		}
 		ImGui::ColorEdit4("Material color", glm::value_ptr(material_.color));
 	}
@@ -118,20 +131,27 @@ namespace tree_generator::lsystem
 		return meshDefinition_->Name(); 
 	}
 
-	MoveAction::MoveAction(float distance) : distance_(distance) {}
-
-	void MoveAction::PerformAction(const Symbol& symbol, MeshGeneratorState* state)
+	void DrawAction::AppendHash(utility::ContentHasher* hasher) const
 	{
-		glm::vec3 rotation = state->rotationStack.back();
+		MeshGeneratorAction::AppendHash(hasher);
+		meshDefinition_->AppendHash(hasher);
+		for (int i = 0; i < 4; ++i)
+		{
+			hasher->Add(material_.color[i]);
+		}
+	}
 
-		glm::mat4 matrix = glm::mat4(1.0f);
-		matrix = glm::rotate(matrix, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-		matrix = glm::rotate(matrix, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		matrix = glm::rotate(matrix, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	void DrawAction::UpdateMeshes()
+	{
+		lods_ = meshDefinition_->GetLods();
+		meshData_ = lods_.front();
+	}
 
-		glm::vec3 direction = glm::vec3(0.0f, 1.0f, 0.0f);
-		direction = glm::mat3(matrix) * direction;
+	MoveAction::MoveAction(float distance) : distance_(distance) {}
 
+	void MoveAction::PerformAction(const Symbol& symbol, MeshGeneratorState* state)
+	{
+		glm::vec3 direction = GetTurtleDirection(state->rotationStack.back());
 		state->positionStack.back() += (direction * distance_);
 	}
 
@@ -140,6 +160,12 @@ namespace tree_generator::lsystem
 		ImGui::InputFloat("Distance", &distance_, 0.01f, 0.1f);
 	}
 
+	void MoveAction::AppendHash(utility::ContentHasher* hasher) const
+	{
+		MeshGeneratorAction::AppendHash(hasher);
+		hasher->Add(distance_);
+	}
+
 	RotateAction::RotateAction(glm::vec3 rotation) : rotation_(rotation) {}
 
 	void RotateAction::PerformAction(const Symbol& symbol, MeshGeneratorState* state)
@@ -152,6 +178,15 @@ namespace tree_generator::lsystem
 		ImGui::InputFloat3("Angles (degrees)", &rotation_.x);
 	}
 
+	void RotateAction::AppendHash(utility::ContentHasher* hasher) const
+	{
+		MeshGeneratorAction::AppendHash(hasher);
+		for (int i = 0; i < 3; ++i)
+		{
+			hasher->Add(rotation_[i]);
+		}
+	}
+
 	void PushStateAction::PerformAction(const Symbol& symbol, MeshGeneratorState* state)
 	{
 		state->positionStack.push_back(state->positionStack.back());
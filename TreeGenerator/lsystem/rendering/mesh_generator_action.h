@@ -2,6 +2,7 @@
 #define TREE_GENERATOR_LSYSTEM_MESH_GENERATOR_ACTION_H_
 
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -10,9 +11,12 @@
 #include <glm/glm.hpp>
 
 #include "../core/lsystem.h"
+#include "../../graphics/common/instance_buffer.h"
 #include "../../graphics/common/material.h"
+#include "../../graphics/common/mesh_baker.h"
 #include "../../graphics/common/mesh_data.h"
 #include "../../graphics/common/transform.h"
+#include "../../utility/content_hash.h"
 #include "../../utility/enum_helper.h"
 
 namespace tree_generator::lsystem
@@ -27,6 +31,58 @@ namespace tree_generator::lsystem
 		Material material;
 	};
 
+	// Output type of the mesh generator when generating model matrices
+	// directly. The instances refer to the InstanceBuffer passed to the
+	// generator, and stay valid until that buffer is next resized.
+	struct MatrixMeshGroup
+	{
+		std::shared_ptr<const MeshData> mesh;
+		std::span<const glm::mat4> instances;
+		Material material;
+
+		// The mesh at every level of detail, starting with mesh itself. See
+		// MeshDefinition::GetLods().
+		std::vector<std::shared_ptr<const MeshData>> lods;
+
+		// Symbol whose draw action drew the instances.
+		Symbol symbol{};
+	};
+
+	// Output type of the mesh generator when instancing subtrees. Every
+	// placement draws all of the local instances, each transformed by the
+	// placement: the model matrix of an instance is placement * local.
+	struct SubtreeMeshGroup
+	{
+		std::shared_ptr<const MeshData> mesh;
+		std::vector<glm::mat4> localInstances;
+		std::vector<glm::mat4> placements;
+		Material material;
+	};
+
+	// Output type of the mesh generator for drawing a tree from a shallower
+	// depth of its derivation. The instances are scaled about the origin so
+	// the tree is as large as the deepest generation, and the groups refer
+	// to them.
+	struct DepthLod
+	{
+		int depth;
+		float scale;
+		InstanceBuffer instances;
+		std::vector<MatrixMeshGroup> groups;
+	};
+
+	// Output type of the mesh generator when baking. All instances drawn
+	// with the same material are merged into one mesh.
+	struct BakedMeshGroup
+	{
+		BakedMesh mesh;
+		Material material;
+
+		// Coarser versions of the mesh, each simplified from the one before.
+		// Empty unless levels of detail were asked for.
+		std::vector<BakedMesh> lods;
+	};
+
 	// State of the mesh generator during construction of the MeshGroups.
 	// 
 	// In the long run, this should be replaced with some other interface/type
@@ -40,6 +96,10 @@ namespace tree_generator::lsystem
 		std::unordered_map<Symbol, MeshGroup> symbolMeshMap;
 	};
 
+	// Direction the turtle moves in when rotated by the given Euler angles
+	// (in degrees).
+	glm::vec3 GetTurtleDirection(const glm::vec3& rotation);
+
 	enum class MeshGeneratorActionType
 	{
 		None,
@@ -66,6 +126,17 @@ namespace tree_generator::lsystem
 		virtual void ShowGUI();
 		virtual const std::string_view Name() const = 0;
 		virtual MeshGeneratorActionType GetActionType() const = 0;
+
+		// Adds the action's type and every parameter that changes what it
+		// does to the hash. Actions with parameters must override this.
+		virtual void AppendHash(utility::ContentHasher* hasher) const;
+
+		// Adds only what changes where instances are drawn, leaving out
+		// what they're drawn with.
+		virtual void AppendPlacementHash(utility::ContentHasher* hasher) const
+		{
+			AppendHash(hasher);
+		}
 	};
 
 	// Render a mesh to the screen.
@@ -75,14 +146,31 @@ namespace tree_generator::lsystem
 		DrawAction(std::unique_ptr<MeshDefinition> meshDefinition, Material material);
 		void PerformAction(const Symbol& symbol, MeshGeneratorState* state) override;
 
+		// The transform of the instance drawn for the given state.
+		Transform CreateInstance(const MeshGeneratorState& state) const;
+
+		std::shared_ptr<const MeshData> GetMesh() const { return meshData_; }
+		const std::vector<std::shared_ptr<const MeshData>>& GetLods() const { return lods_; }
+		const Material& GetMaterial() const { return material_; }
+
 		void ShowGUI() override;
 		const std::string_view Name() const override;
 		MeshGeneratorActionType GetActionType() const override { return MeshGeneratorActionType::Draw; }
+		void AppendHash(utility::ContentHasher* hasher) const override;
+
+		// Instances are placed the same whatever their mesh and material.
+		void AppendPlacementHash(utility::ContentHasher* hasher) const override
+		{
+			MeshGeneratorAction::AppendHash(hasher);
+		}
 
 	private:
 		std::unique_ptr<MeshDefinition> meshDefinition_;
-		MeshData meshData_;
+		std::shared_ptr<const MeshData> meshData_;
+		std::vector<std::shared_ptr<const MeshData>> lods_;
 		Material material_;
+
+		void UpdateMeshes();
 	};
 
 	// Move the generator's turtle position forward.
@@ -94,9 +182,12 @@ namespace tree_generator::lsystem
 
 		void PerformAction(const Symbol& symbol, MeshGeneratorState* state) override;
 
+		float GetDistance() const { return distance_; }
+
 		void ShowGUI() override;
 		const std::string_view Name() const override { return kName_; }
 		MeshGeneratorActionType GetActionType() const override { return MeshGeneratorActionType::Move; }
+		void AppendHash(utility::ContentHasher* hasher) const override;
 
 	private:
 		inline static const std::string kName_ = "Move forward";
@@ -110,9 +201,12 @@ namespace tree_generator::lsystem
 		RotateAction(glm::vec3 rotation);
 		void PerformAction(const Symbol& symbol, MeshGeneratorState* state) override;
 
+		const glm::vec3& GetRotation() const { return rotation_; }
+
 		void ShowGUI() override;
 		const std::string_view Name() const override { return kName_; }
 		MeshGeneratorActionType GetActionType() const override { return MeshGeneratorActionType::Rotate; }
+		void AppendHash(utility::ContentHasher* hasher) const override;
 
 	private:
 		inline static const std::string kName_ = "Rotate";
@@ -0,0 +1,120 @@
+#include "mesh_generator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/glm.hpp>
+
+#include "../core/lsystem.h"
+#include "../core/lsystem_parser.h"
+#include "../../graphics/common/instance_buffer.h"
+#include "mesh_definition.h"
+
+namespace tree_generator::lsystem
+{
+	namespace
+	{
+		std::vector<Symbol> CreateTree(int iterations)
+		{
+			StringLSystem stringLSystem;
+			stringLSystem.axiom = "X";
+			stringLSystem.rules = {
+				{ "F", "FF" },
+				{ "X", "F+[[X]-X]-F[-FX]+X" }
+			};
+			return Generate(ParseLSystem(stringLSystem), iterations);
+		}
+
+		MeshGenerator CreateTreeGenerator()
+		{
+			MeshGenerator generator;
+			generator.Define(Symbol{ 'F' },
+				std::make_unique<DrawAction>(
+					std::make_unique<CylinderDefinition>(8, 0.2f, 0.1f),
+					Material{ glm::vec4(0.4f, 0.3f, 0.2f, 1.0f) }));
+			generator.Define(Symbol{ 'X' },
+				std::make_unique<DrawAction>(
+					std::make_unique<QuadDefinition>(),
+					Material{ glm::vec4(0.2f, 0.6f, 0.2f, 1.0f) }));
+			generator.Define(Symbol{ '+' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, 25.0f)));
+			generator.Define(Symbol{ '-' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, -25.0f)));
+			generator.Define(Symbol{ '[' }, std::make_unique<PushStateAction>());
+			generator.Define(Symbol{ ']' }, std::make_unique<PopStateAction>());
+			return generator;
+		}
+
+		// Both modes report the number of instances processed, so their items
+		// per second compare directly. Bytes are what would be uploaded. Baking
+		// runs on the task pool, so the benchmarks measure wall time.
+		void BM_GenerateMatrices(benchmark::State& state)
+		{
+			const MeshGenerator generator = CreateTreeGenerator();
+			const std::vector<Symbol> symbols = CreateTree(static_cast<int>(state.range(0)));
+			InstanceBuffer instances;
+
+			for (auto _ : state)
+			{
+				std::vector<MatrixMeshGroup> groups = generator.GenerateMatrices(symbols, &instances);
+				benchmark::DoNotOptimize(groups.data());
+				benchmark::ClobberMemory();
+			}
+			state.SetItemsProcessed(state.iterations() * instances.Size());
+			state.SetBytesProcessed(state.iterations() * instances.Size() * sizeof(glm::mat4));
+		}
+
+		void BM_GenerateBaked(benchmark::State& state)
+		{
+			const MeshGenerator generator = CreateTreeGenerator();
+			const std::vector<Symbol> symbols = CreateTree(static_cast<int>(state.range(0)));
+			InstanceBuffer instances;
+			generator.GenerateMatrices(symbols, &instances);
+
+			std::size_t uploadSize = 0;
+			for (auto _ : state)
+			{
+				std::vector<BakedMeshGroup> groups = generator.GenerateBaked(symbols, 1e-5f);
+				benchmark::DoNotOptimize(groups.data());
+				benchmark::ClobberMemory();
+
+				uploadSize = 0;
+				for (const BakedMeshGroup& group : groups)
+				{
+					uploadSize += group.mesh.vertices.size() * sizeof(Vertex) +
+						group.mesh.shortIndices.size() * sizeof(std::uint16_t) +
+						group.mesh.indices.size() * sizeof(std::uint32_t);
+				}
+			}
+			state.SetItemsProcessed(state.iterations() * instances.Size());
+			state.SetBytesProcessed(state.iterations() * uploadSize);
+		}
+
+		// Hashing runs on every change to the settings, so it must stay far
+		// below a frame.
+		void BM_HashTree(benchmark::State& state)
+		{
+			const MeshGenerator generator = CreateTreeGenerator();
+			StringLSystem stringLSystem;
+			stringLSystem.axiom = "X";
+			stringLSystem.rules = {
+				{ "F", "FF" },
+				{ "X", "F+[[X]-X]-F[-FX]+X" }
+			};
+			const LSystem lSystem = ParseLSystem(stringLSystem);
+
+			for (auto _ : state)
+			{
+				benchmark::DoNotOptimize(HashTree(lSystem, 6, generator));
+			}
+		}
+
+		BENCHMARK(BM_GenerateMatrices)->Arg(4)->Arg(6)->Unit(benchmark::kMillisecond)->UseRealTime();
+		BENCHMARK(BM_GenerateBaked)->Arg(4)->Arg(6)->Unit(benchmark::kMillisecond)->UseRealTime();
+		BENCHMARK(BM_HashTree)->Unit(benchmark::kMicrosecond);
+	}
+}
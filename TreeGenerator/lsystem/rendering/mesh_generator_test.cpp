@@ -1,6 +1,13 @@
 #include "mesh_generator.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
 #include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -8,8 +15,15 @@
 #include <glm/glm.hpp>
 
 #include "../core/lsystem.h"
+#include "../core/lsystem_parser.h"
+#include "../../graphics/common/bounding_box.h"
+#include "../../graphics/common/instance_buffer.h"
 #include "../../graphics/common/mesh_data.h"
+#include "../../graphics/common/mesh_optimizer.h"
+#include "../../graphics/common/mesh_simplifier.h"
+#include "../../graphics/common/point_cloud.h"
 #include "../../graphics/common/transform.h"
+#include "../../utility/content_hash.h"
 #include "mesh_definition.h"
 
 using ::testing::AllOf;
@@ -19,6 +33,7 @@ using ::testing::Eq;
 using ::testing::Field;
 using ::testing::FieldsAre;
 using ::testing::IsEmpty;
+using ::testing::Not;
 using ::testing::PrintToString;
 using ::testing::SizeIs;
 
@@ -70,6 +85,161 @@ namespace tree_generator::lsystem
 
 	namespace
 	{
+		// A tree that branches in three dimensions, and is large enough to be
+		// split across several chunks/tasks when generated in parallel.
+		LSystem CreateBranchingTreeLSystem()
+		{
+			StringLSystem stringLSystem;
+			stringLSystem.axiom = "X";
+			stringLSystem.rules = {
+				{ "F", "FAF" },
+				{ "X", "F-[[AX]+AX]&+AF[+A^FAX]-AX" }
+			};
+			return ParseLSystem(stringLSystem);
+		}
+
+		std::vector<Symbol> CreateBranchingTree(int iterations)
+		{
+			return lsystem::Generate(CreateBranchingTreeLSystem(), iterations);
+		}
+
+		MeshGenerator CreateBranchingTreeGenerator()
+		{
+			MeshGenerator generator;
+			generator.Define(Symbol{ 'F' },
+				std::make_unique<DrawAction>(
+					std::make_unique<CylinderDefinition>(5, 0.2f, 0.1f),
+					Material()));
+			generator.Define(Symbol{ 'X' },
+				std::make_unique<DrawAction>(
+					std::make_unique<QuadDefinition>(),
+					Material()));
+			generator.Define(Symbol{ 'A' }, std::make_unique<MoveAction>(0.15f));
+			generator.Define(Symbol{ '+' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, 22.5f)));
+			generator.Define(Symbol{ '-' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, -22.5f)));
+			generator.Define(Symbol{ '&' },
+				std::make_unique<RotateAction>(glm::vec3(17.0f, 5.0f, 0.0f)));
+			generator.Define(Symbol{ '^' },
+				std::make_unique<RotateAction>(glm::vec3(-11.0f, 0.0f, 3.0f)));
+			generator.Define(Symbol{ '[' }, std::make_unique<PushStateAction>());
+			generator.Define(Symbol{ ']' }, std::make_unique<PopStateAction>());
+			return generator;
+		}
+
+		// A tree that only turns around the z axis, so its subtrees can be
+		// instanced.
+		LSystem CreatePlanarTree()
+		{
+			StringLSystem stringLSystem;
+			stringLSystem.axiom = "X";
+			stringLSystem.rules = {
+				{ "F", "FF" },
+				{ "X", "F+[[X]-X]-F[-FX]+X" }
+			};
+			return ParseLSystem(stringLSystem);
+		}
+
+		MeshGenerator CreatePlanarTreeGenerator()
+		{
+			MeshGenerator generator;
+			generator.Define(Symbol{ 'F' },
+				std::make_unique<DrawAction>(
+					std::make_unique<CylinderDefinition>(5, 0.2f, 0.1f),
+					Material()));
+			generator.Define(Symbol{ 'X' },
+				std::make_unique<DrawAction>(
+					std::make_unique<QuadDefinition>(),
+					Material()));
+			generator.Define(Symbol{ 'A' }, std::make_unique<MoveAction>(0.15f));
+			generator.Define(Symbol{ '+' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, 25.0f)));
+			generator.Define(Symbol{ '-' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, -25.0f)));
+			generator.Define(Symbol{ '[' }, std::make_unique<PushStateAction>());
+			generator.Define(Symbol{ ']' }, std::make_unique<PopStateAction>());
+			return generator;
+		}
+
+		// Expands every subtree group to its final model matrices, and checks
+		// that each expected instance has a matching one, within rounding.
+		void ExpectSubtreesMatchInstances(
+			const std::vector<SubtreeMeshGroup>& subtrees,
+			const std::vector<MeshGroup>& expected)
+		{
+			for (const MeshGroup& expectedGroup : expected)
+			{
+				std::vector<glm::mat4> actualMatrices;
+				for (const SubtreeMeshGroup& subtree : subtrees)
+				{
+					if (subtree.mesh->indices != expectedGroup.mesh.indices)
+					{
+						continue;
+					}
+					for (const glm::mat4& placement : subtree.placements)
+					{
+						for (const glm::mat4& local : subtree.localInstances)
+						{
+							actualMatrices.push_back(placement * local);
+						}
+					}
+				}
+
+				ASSERT_EQ(actualMatrices.size(), expectedGroup.instances.size());
+				std::vector<bool> isMatched(actualMatrices.size(), false);
+				for (const Transform& instance : expectedGroup.instances)
+				{
+					const glm::mat4 expectedMatrix = ToMatrix(instance);
+					auto match = std::find_if(
+						actualMatrices.begin(), actualMatrices.end(),
+						[&](const glm::mat4& actual) {
+							if (isMatched[&actual - actualMatrices.data()])
+							{
+								return false;
+							}
+							for (int column = 0; column < 4; ++column)
+							{
+								for (int row = 0; row < 4; ++row)
+								{
+									if (std::abs(actual[column][row] - expectedMatrix[column][row]) > 1e-4f)
+									{
+										return false;
+									}
+								}
+							}
+							return true;
+						});
+					ASSERT_NE(match, actualMatrices.end())
+						<< "No match for " << PrintToString(instance);
+					isMatched[match - actualMatrices.begin()] = true;
+				}
+			}
+		}
+
+		void ExpectIdenticalMeshGroups(
+			const std::vector<MeshGroup>& actual,
+			const std::vector<MeshGroup>& expected)
+		{
+			ASSERT_EQ(actual.size(), expected.size());
+			for (int i = 0; i < actual.size(); ++i)
+			{
+				EXPECT_EQ(actual[i].mesh.indices, expected[i].mesh.indices);
+				ASSERT_EQ(actual[i].instances.size(), expected[i].instances.size());
+				for (int j = 0; j < actual[i].instances.size(); ++j)
+				{
+					const Transform& actualInstance = actual[i].instances[j];
+					const Transform& expectedInstance = expected[i].instances[j];
+					ASSERT_EQ(actualInstance.position, expectedInstance.position)
+						<< "group " << i << ", instance " << j;
+					ASSERT_EQ(actualInstance.rotation, expectedInstance.rotation)
+						<< "group " << i << ", instance " << j;
+					ASSERT_EQ(actualInstance.scale, expectedInstance.scale)
+						<< "group " << i << ", instance " << j;
+				}
+			}
+		}
+
 		TEST(LSystemMeshGeneratorTest, NoSymbolsGeneratesNoMeshes)
 		{
 			MeshGenerator generator;
@@ -274,5 +444,544 @@ namespace tree_generator::lsystem
 			EXPECT_TRUE(generator.HasDefinition(a));
 			EXPECT_FALSE(generator.HasDefinition(b));
 		}
+
+		TEST(LSystemMeshGeneratorTest, SerialMatchesPerformingEachAction)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(4);
+
+			MeshGeneratorState state;
+			state.positionStack.push_back(glm::vec3(0.0f));
+			state.rotationStack.push_back(glm::vec3(0.0f));
+			for (const Symbol& symbol : symbols)
+			{
+				generator.GetActionMap()[symbol]->PerformAction(symbol, &state);
+			}
+			std::vector<MeshGroup> expected;
+			for (auto& [symbol, meshGroup] : state.symbolMeshMap)
+			{
+				expected.push_back(std::move(meshGroup));
+			}
+
+			ExpectIdenticalMeshGroups(generator.Generate(symbols), expected);
+		}
+
+		TEST(LSystemMeshGeneratorTest, PrefixScanMatchesSerial)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(6);
+			ASSERT_GT(symbols.size(), 16 * 1024);
+
+			ExpectIdenticalMeshGroups(
+				generator.Generate(symbols, GenerationMode::PrefixScan),
+				generator.Generate(symbols));
+		}
+
+		TEST(LSystemMeshGeneratorTest, PrefixScanMatchesSerialForSmallInput)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(2);
+
+			ExpectIdenticalMeshGroups(
+				generator.Generate(symbols, GenerationMode::PrefixScan),
+				generator.Generate(symbols));
+		}
+
+		TEST(LSystemMeshGeneratorTest, PrefixScanThrowsOnUnmatchedRestore)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			EXPECT_THROW(
+				generator.Generate(ParseSymbols("F]F"), GenerationMode::PrefixScan),
+				std::runtime_error);
+		}
+
+		TEST(LSystemMeshGeneratorTest, BranchParallelMatchesSerial)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(6);
+
+			ExpectIdenticalMeshGroups(
+				generator.Generate(symbols, GenerationMode::BranchParallel),
+				generator.Generate(symbols));
+		}
+
+		TEST(LSystemMeshGeneratorTest, BranchParallelThrowsOnUnmatchedRestore)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			EXPECT_THROW(
+				generator.Generate(ParseSymbols("F]F"), GenerationMode::BranchParallel),
+				std::runtime_error);
+		}
+
+		TEST(LSystemMeshGeneratorTest, GenerateMatricesMatchesTransforms)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(3);
+			std::vector<MeshGroup> expected = generator.Generate(symbols);
+
+			InstanceBuffer instances;
+			std::vector<MatrixMeshGroup> actual =
+				generator.GenerateMatrices(symbols, &instances);
+
+			ASSERT_EQ(actual.size(), expected.size());
+			std::size_t instanceCount = 0;
+			for (const MatrixMeshGroup& group : actual)
+			{
+				auto expectedGroup = std::find_if(expected.begin(), expected.end(),
+					[&](const MeshGroup& expectedGroup) {
+						return expectedGroup.mesh.indices == group.mesh->indices;
+					});
+				ASSERT_NE(expectedGroup, expected.end());
+				ASSERT_EQ(group.instances.size(), expectedGroup->instances.size());
+				for (int i = 0; i < group.instances.size(); ++i)
+				{
+					EXPECT_EQ(group.instances[i], ToMatrix(expectedGroup->instances[i]));
+				}
+				instanceCount += group.instances.size();
+			}
+			EXPECT_EQ(instances.Size(), instanceCount);
+		}
+
+		TEST(LSystemMeshGeneratorTest, GenerateMatricesReusesBuffer)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(3);
+
+			InstanceBuffer instances;
+			generator.GenerateMatrices(symbols, &instances);
+			const glm::mat4* data = instances.Data();
+			std::vector<MatrixMeshGroup> groups =
+				generator.GenerateMatrices(symbols, &instances);
+
+			EXPECT_EQ(instances.Data(), data);
+			EXPECT_EQ(groups[0].instances.data(), data);
+		}
+
+		TEST(LSystemMeshGeneratorTest, GenerateMatricesBoundsContainInstances)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(3);
+
+			InstanceBuffer instances;
+			InstanceBounds bounds;
+			std::vector<MatrixMeshGroup> groups =
+				generator.GenerateMatrices(symbols, &instances, &bounds);
+
+			ASSERT_EQ(bounds.Size(), instances.Size());
+			std::size_t instance = 0;
+			for (const MatrixMeshGroup& group : groups)
+			{
+				for (const glm::mat4& model : group.instances)
+				{
+					const BoundingBox instanceBounds = bounds.Get(instance++);
+					for (const Vertex& vertex : group.mesh->vertices)
+					{
+						const glm::vec3 position = glm::vec3(model * glm::vec4(vertex.position, 1.0f));
+						for (int axis = 0; axis < 3; ++axis)
+						{
+							EXPECT_GE(position[axis], instanceBounds.min[axis] - 1e-5f);
+							EXPECT_LE(position[axis], instanceBounds.max[axis] + 1e-5f);
+						}
+					}
+				}
+			}
+		}
+
+		TEST(LSystemMeshGeneratorTest, DepthLodsScaleShallowerGenerations)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<std::vector<Symbol>> derivation =
+				GenerateDerivation(CreateBranchingTreeLSystem(), 4);
+
+			InstanceBuffer instances;
+			InstanceBounds bounds;
+			generator.GenerateMatrices(derivation.back(), &instances, &bounds);
+			const BoundingBox treeBounds = bounds.GetTotalBounds();
+
+			const std::vector<int> depths{ 3, 2 };
+			std::vector<DepthLod> lods = generator.GenerateDepthLods(derivation, depths, treeBounds);
+
+			ASSERT_THAT(lods, SizeIs(2));
+			for (const DepthLod& lod : lods)
+			{
+				InstanceBuffer expected;
+				std::vector<MatrixMeshGroup> expectedGroups =
+					generator.GenerateMatrices(derivation[lod.depth], &expected);
+				ASSERT_EQ(lod.instances.Size(), expected.Size());
+				ASSERT_EQ(lod.groups.size(), expectedGroups.size());
+				EXPECT_LT(lod.instances.Size(), instances.Size());
+				EXPECT_GT(lod.scale, 1.0f);
+
+				for (std::size_t i = 0; i < expected.Size(); ++i)
+				{
+					const glm::vec3 expectedPosition = lod.scale * glm::vec3(expected[i][3]);
+					const glm::vec3 actualPosition = glm::vec3(lod.instances[i][3]);
+					EXPECT_NEAR(actualPosition.x, expectedPosition.x, 1e-4f);
+					EXPECT_NEAR(actualPosition.y, expectedPosition.y, 1e-4f);
+					EXPECT_NEAR(actualPosition.z, expectedPosition.z, 1e-4f);
+				}
+				for (const MatrixMeshGroup& group : lod.groups)
+				{
+					EXPECT_GE(group.instances.data(), lod.instances.Data());
+					EXPECT_LE(
+						group.instances.data() + group.instances.size(),
+						lod.instances.Data() + lod.instances.Size());
+				}
+			}
+		}
+
+		TEST(LSystemMeshGeneratorTest, BakedMatchesTransformedInstances)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(3);
+			InstanceBuffer instances;
+			std::vector<MatrixMeshGroup> expected =
+				generator.GenerateMatrices(symbols, &instances);
+
+			// A negative tolerance welds nothing, and without optimization the
+			// vertices are in the same order as the instances.
+			std::vector<BakedMeshGroup> actual =
+				generator.GenerateBaked(symbols, -1.0f, false);
+
+			ASSERT_THAT(actual, SizeIs(1));
+			MeshData baked = actual[0].mesh.ToMeshData();
+			std::size_t vertex = 0;
+			std::size_t index = 0;
+			for (const MatrixMeshGroup& group : expected)
+			{
+				for (const glm::mat4& model : group.instances)
+				{
+					for (unsigned int meshIndex : group.mesh->indices)
+					{
+						ASSERT_LT(index, baked.indices.size());
+						const glm::vec3 expectedPosition = glm::vec3(
+							model * glm::vec4(group.mesh->vertices[meshIndex].position, 1.0f));
+						const glm::vec3 actualPosition =
+							baked.vertices[baked.indices[index++]].position;
+						EXPECT_NEAR(actualPosition.x, expectedPosition.x, 1e-5f);
+						EXPECT_NEAR(actualPosition.y, expectedPosition.y, 1e-5f);
+						EXPECT_NEAR(actualPosition.z, expectedPosition.z, 1e-5f);
+					}
+					vertex += group.mesh->vertices.size();
+				}
+			}
+			EXPECT_EQ(baked.vertices.size(), vertex);
+			EXPECT_EQ(baked.indices.size(), index);
+		}
+
+		TEST(LSystemMeshGeneratorTest, BakedWeldsOverlappingInstances)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+
+			std::vector<BakedMeshGroup> baked =
+				generator.GenerateBaked(ParseSymbols("XXX"), 1e-5f);
+
+			const MeshData quad = CreateQuad();
+			ASSERT_THAT(baked, SizeIs(1));
+			EXPECT_THAT(baked[0].mesh.vertices, SizeIs(quad.vertices.size()));
+			EXPECT_EQ(baked[0].mesh.IndexCount(), 3 * quad.indices.size());
+		}
+
+		TEST(LSystemMeshGeneratorTest, BakedOptimizationKeepsGeometry)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			const std::vector<Symbol> symbols = CreateBranchingTree(4);
+
+			std::vector<BakedMeshGroup> unoptimized = generator.GenerateBaked(symbols, 1e-5f, false);
+			std::vector<BakedMeshGroup> optimized = generator.GenerateBaked(symbols, 1e-5f);
+
+			ASSERT_THAT(optimized, SizeIs(unoptimized.size()));
+			for (std::size_t i = 0; i < optimized.size(); ++i)
+			{
+				const MeshData expected = unoptimized[i].mesh.ToMeshData();
+				const MeshData actual = optimized[i].mesh.ToMeshData();
+				EXPECT_THAT(actual.vertices, SizeIs(expected.vertices.size()));
+				EXPECT_THAT(actual.indices, SizeIs(expected.indices.size()));
+				EXPECT_LE(
+					AnalyzeVertexCache(actual.indices).acmr,
+					AnalyzeVertexCache(expected.indices).acmr);
+			}
+		}
+
+		TEST(LSystemMeshGeneratorTest, BakedSplitsGroupsByMaterial)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			generator.Define(Symbol{ 'X' },
+				std::make_unique<DrawAction>(
+					std::make_unique<QuadDefinition>(),
+					Material{ glm::vec4(0.0f, 1.0f, 0.0f, 1.0f) }));
+
+			std::vector<BakedMeshGroup> baked =
+				generator.GenerateBaked(CreateBranchingTree(3), 1e-5f);
+
+			ASSERT_THAT(baked, SizeIs(2));
+			EXPECT_EQ(baked[0].material.color, Material().color);
+			EXPECT_EQ(baked[1].material.color, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+			EXPECT_THAT(baked[1].mesh.indices, IsEmpty());
+			EXPECT_THAT(baked[1].mesh.shortIndices, Not(IsEmpty()));
+		}
+
+		TEST(LSystemMeshGeneratorTest, PointCloudSamplesEveryMaterial)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			generator.Define(Symbol{ 'X' },
+				std::make_unique<DrawAction>(
+					std::make_unique<QuadDefinition>(),
+					Material{ glm::vec4(0.0f, 1.0f, 0.0f, 1.0f) }));
+			const std::vector<Symbol> tree = CreateBranchingTree(3);
+
+			const PointCloud cloud = generator.GeneratePointCloud(tree, 256);
+
+			ASSERT_THAT(cloud.materials, SizeIs(2));
+			EXPECT_EQ(cloud.materials[0].color, Material().color);
+			EXPECT_EQ(cloud.materials[1].color, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+			ASSERT_THAT(cloud.points, SizeIs(256));
+			EXPECT_GT(cloud.pointRadius, 0.0f);
+
+			InstanceBuffer instances;
+			InstanceBounds bounds;
+			generator.GenerateMatrices(tree, &instances, &bounds);
+			BoundingBox treeBounds = bounds.GetTotalBounds();
+			const glm::vec3 tolerance(1e-4f);
+			treeBounds.min -= tolerance;
+			treeBounds.max += tolerance;
+			bool hasMaterial[2] = {};
+			for (const SurfacePoint& point : cloud.points)
+			{
+				BoundingBox pointBounds;
+				pointBounds.Add(point.position);
+				EXPECT_TRUE(treeBounds.Contains(pointBounds));
+				EXPECT_NEAR(glm::length(point.normal), 1.0f, 1e-4f);
+				ASSERT_LT(point.material, 2u);
+				hasMaterial[point.material] = true;
+			}
+			EXPECT_TRUE(hasMaterial[0]);
+			EXPECT_TRUE(hasMaterial[1]);
+
+			const PointCloud again = generator.GeneratePointCloud(tree, 256);
+			ASSERT_THAT(again.points, SizeIs(256));
+			EXPECT_EQ(again.points[100].position, cloud.points[100].position);
+		}
+
+		TEST(LSystemMeshGeneratorTest, SimplifiesBakedMeshesToTheirTarget)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			const std::vector<BakedMeshGroup> baked =
+				generator.GenerateBaked(CreateBranchingTree(3), 1e-4f);
+			ASSERT_THAT(baked, SizeIs(1));
+			EXPECT_THAT(baked[0].lods, IsEmpty());
+			const MeshData mesh = baked[0].mesh.ToMeshData();
+			const std::size_t triangleCount = mesh.indices.size() / 3;
+
+			// Each branch is a separate tube, which can't get coarser than
+			// three sides without removing the smallest ones.
+			MeshData simplified = mesh;
+			SimplifyOptions options;
+			options.targetTriangleCount = triangleCount / 4;
+			options.doRemoveParts = true;
+			SimplifyMesh(options, &simplified);
+
+			EXPECT_LE(simplified.indices.size() / 3, options.targetTriangleCount);
+			EXPECT_GE(simplified.indices.size() / 3, options.targetTriangleCount - 6);
+
+			const std::vector<BakedMeshGroup> lods =
+				generator.GenerateBaked(CreateBranchingTree(3), 1e-4f, true, 4);
+			ASSERT_THAT(lods, SizeIs(1));
+			EXPECT_EQ(lods[0].mesh.IndexCount(), mesh.indices.size());
+			ASSERT_THAT(lods[0].lods, SizeIs(3));
+			std::size_t previousCount = mesh.indices.size();
+			for (const BakedMesh& lod : lods[0].lods)
+			{
+				EXPECT_LE(lod.IndexCount(), previousCount / 2 + 3);
+				EXPECT_GT(lod.IndexCount(), 0u);
+				previousCount = lod.IndexCount();
+			}
+
+			EXPECT_THROW(
+				generator.GenerateBaked(CreateBranchingTree(3), 1e-4f, true, 0),
+				std::invalid_argument);
+		}
+
+		TEST(LSystemMeshGeneratorTest, SubtreesMatchSerial)
+		{
+			MeshGenerator generator = CreatePlanarTreeGenerator();
+			LSystem lSystem = CreatePlanarTree();
+
+			std::vector<SubtreeMeshGroup> subtrees = generator.GenerateSubtrees(lSystem, 5);
+
+			ExpectSubtreesMatchInstances(
+				subtrees, generator.Generate(lsystem::Generate(lSystem, 5)));
+		}
+
+		TEST(LSystemMeshGeneratorTest, SubtreesReduceMatrixCount)
+		{
+			MeshGenerator generator = CreatePlanarTreeGenerator();
+			LSystem lSystem = CreatePlanarTree();
+
+			std::size_t instanceCount = 0;
+			for (const MeshGroup& group : generator.Generate(lsystem::Generate(lSystem, 7)))
+			{
+				instanceCount += group.instances.size();
+			}
+
+			std::size_t matrixCount = 0;
+			for (const SubtreeMeshGroup& group : generator.GenerateSubtrees(lSystem, 7))
+			{
+				matrixCount += group.localInstances.size() + group.placements.size();
+			}
+			EXPECT_LT(matrixCount * 10, instanceCount);
+		}
+
+		TEST(LSystemMeshGeneratorTest, SubtreesWithUnmatchedSavesAreExpanded)
+		{
+			MeshGenerator generator = CreatePlanarTreeGenerator();
+			StringLSystem stringLSystem;
+			stringLSystem.axiom = "X";
+			stringLSystem.rules = {
+				{ "X", "F[+X" },
+				{ "Y", "]F" }
+			};
+			LSystem lSystem = ParseLSystem(stringLSystem);
+			lSystem.axiom = ParseSymbols("XYYYY");
+
+			ExpectSubtreesMatchInstances(
+				generator.GenerateSubtrees(lSystem, 4),
+				generator.Generate(lsystem::Generate(lSystem, 4)));
+		}
+
+		TEST(LSystemMeshGeneratorTest, SubtreesFallBackForMixedRotationAxes)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			std::vector<Symbol> symbols = CreateBranchingTree(3);
+			std::vector<MeshGroup> expected = generator.Generate(symbols);
+
+			std::vector<SubtreeMeshGroup> subtrees =
+				generator.GenerateSubtrees(CreateBranchingTreeLSystem(), 3);
+
+			ASSERT_EQ(subtrees.size(), expected.size());
+			for (const SubtreeMeshGroup& subtree : subtrees)
+			{
+				EXPECT_THAT(subtree.placements, ElementsAre(glm::mat4(1.0f)));
+			}
+			ExpectSubtreesMatchInstances(subtrees, expected);
+		}
+
+		TEST(LSystemMeshGeneratorTest, HashTreeIgnoresDefinitionOrder)
+		{
+			const MeshGenerator generator = CreateBranchingTreeGenerator();
+			MeshGenerator reversed;
+			reversed.Define(Symbol{ ']' }, std::make_unique<PopStateAction>());
+			reversed.Define(Symbol{ '[' }, std::make_unique<PushStateAction>());
+			reversed.Define(Symbol{ '^' },
+				std::make_unique<RotateAction>(glm::vec3(-11.0f, 0.0f, 3.0f)));
+			reversed.Define(Symbol{ '&' },
+				std::make_unique<RotateAction>(glm::vec3(17.0f, 5.0f, 0.0f)));
+			reversed.Define(Symbol{ '-' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, -22.5f)));
+			reversed.Define(Symbol{ '+' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, 22.5f)));
+			reversed.Define(Symbol{ 'A' }, std::make_unique<MoveAction>(0.15f));
+			reversed.Define(Symbol{ 'X' },
+				std::make_unique<DrawAction>(
+					std::make_unique<QuadDefinition>(),
+					Material()));
+			reversed.Define(Symbol{ 'F' },
+				std::make_unique<DrawAction>(
+					std::make_unique<CylinderDefinition>(5, 0.2f, 0.1f),
+					Material()));
+
+			EXPECT_EQ(
+				HashTree(CreateBranchingTreeLSystem(), 4, generator),
+				HashTree(CreateBranchingTreeLSystem(), 4, reversed));
+		}
+
+		TEST(LSystemMeshGeneratorTest, HashTreeChangesWithEverySetting)
+		{
+			const LSystem lSystem = CreateBranchingTreeLSystem();
+			std::vector<utility::ContentHash> hashes{
+				HashTree(lSystem, 4, CreateBranchingTreeGenerator()) };
+
+			hashes.push_back(HashTree(lSystem, 5, CreateBranchingTreeGenerator()));
+
+			LSystem otherAxiom = lSystem;
+			otherAxiom.axiom = ParseSymbols("F");
+			hashes.push_back(HashTree(otherAxiom, 4, CreateBranchingTreeGenerator()));
+
+			LSystem otherRule = lSystem;
+			otherRule.rules[Symbol{ 'F' }] = ParseSymbols("FF");
+			hashes.push_back(HashTree(otherRule, 4, CreateBranchingTreeGenerator()));
+
+			// Each generator differs from CreateBranchingTreeGenerator() by one
+			// setting.
+			auto hashWith = [&](Symbol symbol, std::unique_ptr<MeshGeneratorAction> action) {
+				MeshGenerator generator = CreateBranchingTreeGenerator();
+				generator.Define(symbol, std::move(action));
+				hashes.push_back(HashTree(lSystem, 4, generator));
+				};
+			hashWith(Symbol{ 'A' }, std::make_unique<MoveAction>(0.25f));
+			hashWith(Symbol{ '+' }, std::make_unique<RotateAction>(glm::vec3(0.0f, 22.5f, 0.0f)));
+			hashWith(Symbol{ '[' }, std::make_unique<PopStateAction>());
+			hashWith(Symbol{ 'F' }, std::make_unique<DrawAction>(
+				std::make_unique<CylinderDefinition>(6, 0.2f, 0.1f), Material()));
+			hashWith(Symbol{ 'F' }, std::make_unique<DrawAction>(
+				std::make_unique<CylinderDefinition>(5, 0.2f, 0.2f), Material()));
+			hashWith(Symbol{ 'F' }, std::make_unique<DrawAction>(
+				std::make_unique<QuadDefinition>(), Material()));
+			hashWith(Symbol{ 'F' }, std::make_unique<DrawAction>(
+				std::make_unique<CylinderDefinition>(5, 0.2f, 0.1f),
+				Material{ glm::vec4(1.0f, 0.0f, 0.0f, 1.0f) }));
+
+			MeshGenerator removed = CreateBranchingTreeGenerator();
+			removed.Remove(Symbol{ 'A' });
+			hashes.push_back(HashTree(lSystem, 4, removed));
+
+			for (std::size_t i = 0; i < hashes.size(); ++i)
+			{
+				for (std::size_t j = 0; j < i; ++j)
+				{
+					EXPECT_NE(hashes[i], hashes[j]) << "settings " << i << " and " << j;
+				}
+			}
+		}
+
+		TEST(LSystemMeshGeneratorTest, MatrixGroupsKeepTheirSymbols)
+		{
+			MeshGenerator generator = CreateBranchingTreeGenerator();
+			InstanceBuffer instances;
+
+			const std::vector<MatrixMeshGroup> groups =
+				generator.GenerateMatrices(CreateBranchingTree(2), &instances);
+
+			ASSERT_THAT(groups, SizeIs(2));
+			EXPECT_EQ(groups[0].symbol, Symbol{ 'F' });
+			EXPECT_EQ(groups[1].symbol, Symbol{ 'X' });
+		}
+
+		TEST(LSystemMeshGeneratorTest, PlacementHashIgnoresMeshesAndMaterials)
+		{
+			auto placementHash = [](const MeshGenerator& generator) {
+				utility::ContentHasher hasher;
+				generator.AppendPlacementHash(&hasher);
+				return hasher.Finish();
+				};
+			const MeshGenerator generator = CreateBranchingTreeGenerator();
+
+			MeshGenerator otherMesh = CreateBranchingTreeGenerator();
+			otherMesh.Define(Symbol{ 'F' }, std::make_unique<DrawAction>(
+				std::make_unique<QuadDefinition>(),
+				Material{ glm::vec4(1.0f, 0.0f, 0.0f, 1.0f) }));
+			EXPECT_EQ(placementHash(otherMesh), placementHash(generator));
+			EXPECT_NE(
+				HashTree(CreateBranchingTreeLSystem(), 4, otherMesh),
+				HashTree(CreateBranchingTreeLSystem(), 4, generator));
+
+			MeshGenerator otherMove = CreateBranchingTreeGenerator();
+			otherMove.Define(Symbol{ 'A' }, std::make_unique<MoveAction>(0.25f));
+			EXPECT_NE(placementHash(otherMove), placementHash(generator));
+
+			MeshGenerator undefined = CreateBranchingTreeGenerator();
+			undefined.Define(Symbol{ 'F' }, nullptr);
+			EXPECT_NE(placementHash(undefined), placementHash(generator));
+		}
 	}
-}
\ No newline at end of file
+}
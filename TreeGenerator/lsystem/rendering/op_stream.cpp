@@ -0,0 +1,118 @@
+#include "op_stream.h"
+
+#include <array>
+
+namespace tree_generator::lsystem
+{
+	namespace
+	{
+		// What each symbol compiles to, looked up once per symbol value rather
+		// than through a virtual call per symbol.
+		struct SymbolOp
+		{
+			MeshGeneratorActionType actionType = MeshGeneratorActionType::None;
+			MeshGeneratorAction* action = nullptr;
+			TurtleStep step{};
+		};
+
+		std::array<SymbolOp, 256> CreateSymbolOps(const ActionTable& actions)
+		{
+			std::array<SymbolOp, 256> symbolOps{};
+			for (std::size_t i = 0; i < actions.size(); ++i)
+			{
+				MeshGeneratorAction* action = actions[i];
+				if (action == nullptr)
+				{
+					continue;
+				}
+
+				SymbolOp& symbolOp = symbolOps[i];
+				symbolOp.actionType = action->GetActionType();
+				symbolOp.action = action;
+				if (symbolOp.actionType == MeshGeneratorActionType::Move)
+				{
+					symbolOp.step = {
+						TurtleStep::Type::Move,
+						glm::vec3(0.0f),
+						static_cast<MoveAction*>(action)->GetDistance() };
+				}
+				else if (symbolOp.actionType == MeshGeneratorActionType::Rotate)
+				{
+					symbolOp.step = {
+						TurtleStep::Type::Rotate,
+						static_cast<RotateAction*>(action)->GetRotation(),
+						0.0f };
+				}
+			}
+			return symbolOps;
+		}
+
+		void AppendTurtleStep(const TurtleStep& step, OpStream* stream)
+		{
+			if (stream->ops.empty() || stream->ops.back().type != OpType::Turtle)
+			{
+				stream->ops.push_back({
+					OpType::Turtle, Symbol{}, nullptr, stream->steps.size(), 0 });
+			}
+			stream->steps.push_back(step);
+			++stream->ops.back().stepCount;
+		}
+
+		void RemoveTrailingTurtleOp(OpStream* stream)
+		{
+			if (!stream->ops.empty() && stream->ops.back().type == OpType::Turtle)
+			{
+				stream->steps.resize(stream->ops.back().firstStep);
+				stream->ops.pop_back();
+			}
+		}
+	}
+
+	OpStream CompileOpStream(
+		const std::vector<Symbol>& symbols, const ActionTable& actions)
+	{
+		const std::array<SymbolOp, 256> symbolOps = CreateSymbolOps(actions);
+
+		OpStream stream;
+		for (const Symbol& symbol : symbols)
+		{
+			const SymbolOp& symbolOp = symbolOps[static_cast<unsigned char>(symbol)];
+			switch (symbolOp.actionType)
+			{
+			case MeshGeneratorActionType::None:
+				if (symbolOp.action != nullptr)
+				{
+					stream.ops.push_back({ OpType::Action, symbol, symbolOp.action });
+				}
+				break;
+			case MeshGeneratorActionType::Draw:
+				stream.ops.push_back({ OpType::Draw, symbol, symbolOp.action });
+				break;
+			case MeshGeneratorActionType::Move:
+			case MeshGeneratorActionType::Rotate:
+				AppendTurtleStep(symbolOp.step, &stream);
+				break;
+			case MeshGeneratorActionType::Save:
+				stream.ops.push_back({ OpType::Save });
+				break;
+			case MeshGeneratorActionType::Restore:
+				// The state the turtle steps produced is about to be discarded,
+				// and if that leaves an empty branch, the save is too.
+				RemoveTrailingTurtleOp(&stream);
+				if (!stream.ops.empty() && stream.ops.back().type == OpType::Save)
+				{
+					stream.ops.pop_back();
+				}
+				else
+				{
+					stream.ops.push_back({ OpType::Restore });
+				}
+				break;
+			}
+		}
+
+		// Nothing observes the final state.
+		RemoveTrailingTurtleOp(&stream);
+		return stream;
+	}
+}
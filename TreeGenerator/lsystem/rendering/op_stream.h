@@ -0,0 +1,134 @@
+#ifndef TREE_GENERATOR_LSYSTEM_OP_STREAM_H_
+#define TREE_GENERATOR_LSYSTEM_OP_STREAM_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../core/lsystem.h"
+#include "action_table.h"
+#include "mesh_generator_action.h"
+
+namespace tree_generator::lsystem
+{
+	// A single rotation or move of the turtle within a Turtle op.
+	struct TurtleStep
+	{
+		enum class Type
+		{
+			Rotate,
+			Move
+		};
+
+		Type type;
+		glm::vec3 rotation;
+		float distance;
+	};
+
+	enum class OpType
+	{
+		// Perform a DrawAction.
+		Draw,
+		// Perform any other action that isn't a turtle or stack action.
+		Action,
+		// Apply a run of turtle steps.
+		Turtle,
+		Save,
+		Restore
+	};
+
+	struct Op
+	{
+		OpType type;
+
+		// The symbol and its action, for Draw and Action ops.
+		Symbol symbol;
+		MeshGeneratorAction* action;
+
+		// Range of the op's steps in OpStream::steps, for Turtle ops.
+		std::size_t firstStep;
+		std::size_t stepCount;
+	};
+
+	// Symbols compiled into the operations that are actually observable:
+	// every run of Move and Rotate symbols becomes a single Turtle op, and
+	// symbols without actions are dropped.
+	//
+	// Turtle ops whose result is never observed, because they are directly
+	// followed by a restore or by the end of the symbols, are dropped, and so
+	// are saves that are directly followed by a restore. This removes
+	// bracketed branches that contain no draws.
+	struct OpStream
+	{
+		std::vector<Op> ops;
+		std::vector<TurtleStep> steps;
+	};
+
+	OpStream CompileOpStream(
+		const std::vector<Symbol>& symbols, const ActionTable& actions);
+
+	// Interprets the ops in order, which leaves the state exactly as
+	// performing every symbol's action would. Draw and Action ops are passed
+	// to performAction, which is expected to perform them on the state.
+	template <typename TPerformAction>
+	void ExecuteOpStream(
+		const OpStream& stream,
+		MeshGeneratorState* state,
+		TPerformAction&& performAction)
+	{
+		// The direction only depends on the rotation, so it is only
+		// recomputed for the first move after the rotation changes.
+		glm::vec3 direction;
+		bool isDirectionValid = false;
+
+		for (const Op& op : stream.ops)
+		{
+			switch (op.type)
+			{
+			case OpType::Draw:
+				performAction(op);
+				break;
+			case OpType::Action:
+				performAction(op);
+				isDirectionValid = false;
+				break;
+			case OpType::Turtle:
+			{
+				glm::vec3& position = state->positionStack.back();
+				glm::vec3& rotation = state->rotationStack.back();
+				for (std::size_t i = op.firstStep; i < op.firstStep + op.stepCount; ++i)
+				{
+					const TurtleStep& step = stream.steps[i];
+					if (step.type == TurtleStep::Type::Rotate)
+					{
+						rotation += step.rotation;
+						isDirectionValid = false;
+					}
+					else
+					{
+						if (!isDirectionValid)
+						{
+							direction = GetTurtleDirection(rotation);
+							isDirectionValid = true;
+						}
+						position += (direction * step.distance);
+					}
+				}
+				break;
+			}
+			case OpType::Save:
+				state->positionStack.push_back(state->positionStack.back());
+				state->rotationStack.push_back(state->rotationStack.back());
+				break;
+			case OpType::Restore:
+				state->positionStack.pop_back();
+				state->rotationStack.pop_back();
+				isDirectionValid = false;
+				break;
+			}
+		}
+	}
+}
+
+#endif  // !TREE_GENERATOR_LSYSTEM_OP_STREAM_H_
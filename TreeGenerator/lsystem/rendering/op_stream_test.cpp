@@ -0,0 +1,161 @@
+#include "op_stream.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <glm/glm.hpp>
+
+#include "../core/lsystem.h"
+#include "../core/lsystem_parser.h"
+#include "action_table.h"
+#include "mesh_definition.h"
+#include "mesh_generator.h"
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::IsEmpty;
+
+namespace tree_generator::lsystem
+{
+	namespace
+	{
+		MeshGenerator CreateGenerator()
+		{
+			MeshGenerator generator;
+			generator.Define(Symbol{ 'F' },
+				std::make_unique<DrawAction>(
+					std::make_unique<QuadDefinition>(),
+					Material()));
+			generator.Define(Symbol{ 'A' }, std::make_unique<MoveAction>(1.0f));
+			generator.Define(Symbol{ '+' },
+				std::make_unique<RotateAction>(glm::vec3(0.0f, 0.0f, 30.0f)));
+			generator.Define(Symbol{ '[' }, std::make_unique<PushStateAction>());
+			generator.Define(Symbol{ ']' }, std::make_unique<PopStateAction>());
+			return generator;
+		}
+
+		OpStream Compile(MeshGenerator& generator, const std::string& symbols)
+		{
+			return CompileOpStream(
+				ParseSymbols(symbols), CreateActionTable(generator.GetActionMap()));
+		}
+
+		auto OpOfType(OpType type)
+		{
+			return Field(&Op::type, type);
+		}
+
+		TEST(LSystemOpStreamTest, FoldsTurtleRunIntoOneOp)
+		{
+			MeshGenerator generator = CreateGenerator();
+			OpStream stream = Compile(generator, "FAA+A+F");
+
+			EXPECT_THAT(stream.ops, ElementsAre(
+				OpOfType(OpType::Draw),
+				OpOfType(OpType::Turtle),
+				OpOfType(OpType::Draw)));
+			EXPECT_EQ(stream.ops[1].stepCount, 5);
+			EXPECT_THAT(stream.steps, ElementsAre(
+				Field(&TurtleStep::type, TurtleStep::Type::Move),
+				Field(&TurtleStep::type, TurtleStep::Type::Move),
+				Field(&TurtleStep::type, TurtleStep::Type::Rotate),
+				Field(&TurtleStep::type, TurtleStep::Type::Move),
+				Field(&TurtleStep::type, TurtleStep::Type::Rotate)));
+		}
+
+		TEST(LSystemOpStreamTest, SymbolsWithoutActionsDoNotSplitRuns)
+		{
+			MeshGenerator generator = CreateGenerator();
+			OpStream stream = Compile(generator, "FAxA+yF");
+
+			EXPECT_THAT(stream.ops, ElementsAre(
+				OpOfType(OpType::Draw),
+				OpOfType(OpType::Turtle),
+				OpOfType(OpType::Draw)));
+			EXPECT_EQ(stream.ops[1].stepCount, 3);
+		}
+
+		TEST(LSystemOpStreamTest, DropsBranchesWithoutDraws)
+		{
+			MeshGenerator generator = CreateGenerator();
+			OpStream stream = Compile(generator, "F[+A[A]]A[]AF");
+
+			EXPECT_THAT(stream.ops, ElementsAre(
+				OpOfType(OpType::Draw),
+				OpOfType(OpType::Turtle),
+				OpOfType(OpType::Draw)));
+			EXPECT_EQ(stream.ops[1].stepCount, 2);
+		}
+
+		TEST(LSystemOpStreamTest, KeepsBranchesWithDraws)
+		{
+			MeshGenerator generator = CreateGenerator();
+			OpStream stream = Compile(generator, "F[+AF+A]F");
+
+			EXPECT_THAT(stream.ops, ElementsAre(
+				OpOfType(OpType::Draw),
+				OpOfType(OpType::Save),
+				OpOfType(OpType::Turtle),
+				OpOfType(OpType::Draw),
+				OpOfType(OpType::Restore),
+				OpOfType(OpType::Draw)));
+		}
+
+		TEST(LSystemOpStreamTest, DropsTrailingTurtleSteps)
+		{
+			MeshGenerator generator = CreateGenerator();
+			OpStream stream = Compile(generator, "A+AF+A");
+
+			EXPECT_THAT(stream.ops, ElementsAre(
+				OpOfType(OpType::Turtle),
+				OpOfType(OpType::Draw)));
+			EXPECT_EQ(stream.steps.size(), 3);
+		}
+
+		TEST(LSystemOpStreamTest, EmptySymbolsCompileToNoOps)
+		{
+			MeshGenerator generator = CreateGenerator();
+			OpStream stream = Compile(generator, "");
+
+			EXPECT_THAT(stream.ops, IsEmpty());
+			EXPECT_THAT(stream.steps, IsEmpty());
+		}
+
+		TEST(LSystemOpStreamTest, ExecuteMatchesPerformingEachAction)
+		{
+			MeshGenerator generator = CreateGenerator();
+			std::vector<Symbol> symbols = ParseSymbols("A+AF[+A+AF]A[A]+F+AAF");
+
+			MeshGeneratorState expected;
+			expected.positionStack.push_back(glm::vec3(0.0f));
+			expected.rotationStack.push_back(glm::vec3(0.0f));
+			for (const Symbol& symbol : symbols)
+			{
+				generator.GetActionMap()[symbol]->PerformAction(symbol, &expected);
+			}
+
+			MeshGeneratorState actual;
+			actual.positionStack.push_back(glm::vec3(0.0f));
+			actual.rotationStack.push_back(glm::vec3(0.0f));
+			ExecuteOpStream(
+				CompileOpStream(symbols, CreateActionTable(generator.GetActionMap())),
+				&actual,
+				[&actual](const Op& op) { op.action->PerformAction(op.symbol, &actual); });
+
+			const std::vector<Transform>& expectedInstances =
+				expected.symbolMeshMap.at(Symbol{ 'F' }).instances;
+			const std::vector<Transform>& actualInstances =
+				actual.symbolMeshMap.at(Symbol{ 'F' }).instances;
+			ASSERT_EQ(actualInstances.size(), expectedInstances.size());
+			for (std::size_t i = 0; i < actualInstances.size(); ++i)
+			{
+				EXPECT_EQ(actualInstances[i].position, expectedInstances[i].position);
+				EXPECT_EQ(actualInstances[i].rotation, expectedInstances[i].rotation);
+			}
+		}
+	}
+}
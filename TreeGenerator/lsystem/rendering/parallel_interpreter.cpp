@@ -0,0 +1,470 @@
+#include "parallel_interpreter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+namespace tree_generator::lsystem
+{
+	namespace
+	{
+		// Chunks smaller than this cost more to schedule than to interpret.
+		constexpr std::size_t kMinChunkSize = 1024;
+
+		// Extra chunks per thread help balance chunks of uneven cost.
+		constexpr std::size_t kChunksPerThread = 4;
+
+		struct TurtleState
+		{
+			glm::vec3 position;
+			glm::vec3 rotation;
+		};
+
+		// A state within a chunk, defined relative to the chunk's entry stack.
+		//
+		// Ids of at least 0 refer to the node at that index: the state
+		// produced by applying the turtle action at symbolIndex to the state
+		// with id parent. Negative ids refer to entry stack states, where -1
+		// is the top of the stack, -2 the one below it, and so on.
+		struct StateNode
+		{
+			std::ptrdiff_t parent;
+			std::size_t symbolIndex;
+		};
+
+		std::ptrdiff_t EntryStateId(std::size_t depthFromTop)
+		{
+			return -static_cast<std::ptrdiff_t>(depthFromTop) - 1;
+		}
+
+		struct ChunkSummary
+		{
+			std::size_t begin;
+			std::size_t end;
+
+			// Number of entry stack states popped by restores that have no
+			// matching save within the chunk.
+			std::size_t restoresBelowEntry = 0;
+
+			std::vector<StateNode> nodes;
+
+			// Ids of the states the chunk leaves on top of the untouched part
+			// of the entry stack, from bottom to top.
+			std::vector<std::ptrdiff_t> exitStack;
+		};
+
+		ChunkSummary Summarize(
+			const std::vector<Symbol>& symbols,
+			const ActionTable& actions,
+			std::size_t begin,
+			std::size_t end)
+		{
+			ChunkSummary summary{ begin, end };
+			summary.exitStack.push_back(EntryStateId(0));
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				MeshGeneratorAction* action = GetAction(actions, symbols[i]);
+				if (action == nullptr)
+				{
+					continue;
+				}
+
+				switch (action->GetActionType())
+				{
+				case MeshGeneratorActionType::Draw:
+					break;
+				case MeshGeneratorActionType::Save:
+					summary.exitStack.push_back(summary.exitStack.back());
+					break;
+				case MeshGeneratorActionType::Restore:
+					if (summary.exitStack.size() > 1)
+					{
+						summary.exitStack.pop_back();
+					}
+					else
+					{
+						++summary.restoresBelowEntry;
+						summary.exitStack.back() = EntryStateId(summary.restoresBelowEntry);
+					}
+					break;
+				default:
+					summary.nodes.push_back({ summary.exitStack.back(), i });
+					summary.exitStack.back() =
+						static_cast<std::ptrdiff_t>(summary.nodes.size()) - 1;
+					break;
+				}
+			}
+			return summary;
+		}
+
+		// Computes the states a chunk leaves on the stack, given the stack it
+		// starts with.
+		class ExitStateEvaluator
+		{
+		public:
+			ExitStateEvaluator(
+				const std::vector<Symbol>& symbols,
+				const ActionTable& actions,
+				const ChunkSummary& summary,
+				const std::vector<TurtleState>& entryStack) :
+				symbols_(symbols),
+				actions_(actions),
+				summary_(summary),
+				entryStack_(entryStack),
+				states_(summary.nodes.size()),
+				isEvaluated_(summary.nodes.size(), false)
+			{
+				scratch_.positionStack.resize(1);
+				scratch_.rotationStack.resize(1);
+			}
+
+			TurtleState Evaluate(std::ptrdiff_t id)
+			{
+				// Walk back to the nearest known state, then replay the turtle
+				// actions from there in their original order. Nodes shared by
+				// several exit states are only replayed once.
+				std::vector<std::ptrdiff_t> chain;
+				while (id >= 0 && !isEvaluated_[id])
+				{
+					chain.push_back(id);
+					id = summary_.nodes[id].parent;
+				}
+
+				TurtleState state = id >= 0 ?
+					states_[id] :
+					entryStack_[entryStack_.size() - static_cast<std::size_t>(-id)];
+				for (auto iter = chain.rbegin(); iter != chain.rend(); ++iter)
+				{
+					std::size_t symbolIndex = summary_.nodes[*iter].symbolIndex;
+					scratch_.positionStack[0] = state.position;
+					scratch_.rotationStack[0] = state.rotation;
+					GetAction(actions_, symbols_[symbolIndex])->PerformAction(
+						symbols_[symbolIndex], &scratch_);
+					state = { scratch_.positionStack[0], scratch_.rotationStack[0] };
+
+					states_[*iter] = state;
+					isEvaluated_[*iter] = true;
+				}
+				return state;
+			}
+
+		private:
+			const std::vector<Symbol>& symbols_;
+			const ActionTable& actions_;
+			const ChunkSummary& summary_;
+			const std::vector<TurtleState>& entryStack_;
+
+			std::vector<TurtleState> states_;
+			std::vector<bool> isEvaluated_;
+			MeshGeneratorState scratch_;
+		};
+
+		// The meshes drawn by a contiguous run of symbols.
+		struct InterpretedRun
+		{
+			std::size_t begin = 0;
+			std::unordered_map<Symbol, MeshGroup> symbolMeshMap;
+
+			// Drawn symbols in the order they first appear in the run.
+			std::vector<Symbol> drawOrder;
+		};
+
+		// Performs the actions for the symbols in [begin, end), recording
+		// the order in which new meshes are drawn.
+		void Interpret(
+			const std::vector<Symbol>& symbols,
+			const ActionTable& actions,
+			std::size_t begin,
+			std::size_t end,
+			MeshGeneratorState* state,
+			std::vector<Symbol>* drawOrder)
+		{
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				MeshGeneratorAction* action = GetAction(actions, symbols[i]);
+				if (action == nullptr)
+				{
+					continue;
+				}
+
+				std::size_t meshCount = state->symbolMeshMap.size();
+				action->PerformAction(symbols[i], state);
+				if (state->symbolMeshMap.size() != meshCount)
+				{
+					drawOrder->push_back(symbols[i]);
+				}
+			}
+		}
+
+		// Combines runs, given in symbol order, into the generator's output.
+		//
+		// Meshes are inserted in the same order as serial interpretation would
+		// insert them, so that the map (and therefore the output) is ordered
+		// identically.
+		std::vector<MeshGroup> MergeRuns(const std::vector<InterpretedRun*>& runs)
+		{
+			std::unordered_map<Symbol, MeshGroup> symbolMeshMap;
+			for (InterpretedRun* run : runs)
+			{
+				for (Symbol symbol : run->drawOrder)
+				{
+					MeshGroup& group = run->symbolMeshMap.at(symbol);
+					if (auto iter = symbolMeshMap.find(symbol); iter != symbolMeshMap.end())
+					{
+						iter->second.instances.insert(
+							iter->second.instances.end(),
+							group.instances.begin(),
+							group.instances.end());
+					}
+					else
+					{
+						symbolMeshMap.emplace(symbol, std::move(group));
+					}
+				}
+			}
+
+			std::vector<MeshGroup> meshes;
+			for (auto& [symbol, meshGroup] : symbolMeshMap)
+			{
+				meshes.push_back(std::move(meshGroup));
+			}
+			return meshes;
+		}
+
+		// Interprets a range of symbols, handing every sufficiently large
+		// bracketed branch in it to the task pool as a new range.
+		class BranchScheduler
+		{
+		public:
+			BranchScheduler(
+				const std::vector<Symbol>& symbols,
+				const ActionTable& actions,
+				utility::TaskPool* pool) :
+				symbols_(symbols),
+				actions_(actions),
+				pool_(pool),
+				matchingRestores_(FindMatchingRestores(symbols, actions))
+			{
+			}
+
+			std::vector<MeshGroup> Run()
+			{
+				Submit(0, symbols_.size(), { glm::vec3(0.0f), glm::vec3(0.0f) });
+
+				// Tasks only add tasks before they finish, so once every task
+				// seen so far is finished, no more will be added.
+				for (std::size_t i = 0; ; ++i)
+				{
+					std::future<void>* task = nullptr;
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						if (i == tasks_.size())
+						{
+							break;
+						}
+						task = &tasks_[i];
+					}
+					task->wait();
+				}
+				for (std::future<void>& task : tasks_)
+				{
+					task.get();
+				}
+
+				std::vector<InterpretedRun*> runs;
+				runs.reserve(runs_.size());
+				for (const std::unique_ptr<InterpretedRun>& run : runs_)
+				{
+					runs.push_back(run.get());
+				}
+				std::sort(runs.begin(), runs.end(),
+					[](const InterpretedRun* a, const InterpretedRun* b) {
+						return a->begin < b->begin;
+					});
+				return MergeRuns(runs);
+			}
+
+		private:
+			// Branches shorter than this are interpreted by the task that
+			// reaches them.
+			static constexpr std::size_t kMinBranchSize = 1024;
+			static constexpr std::size_t kNoMatch = static_cast<std::size_t>(-1);
+
+			const std::vector<Symbol>& symbols_;
+			const ActionTable& actions_;
+			utility::TaskPool* pool_;
+
+			// For each save, the index of the restore that ends its branch,
+			// or kNoMatch.
+			std::vector<std::size_t> matchingRestores_;
+
+			std::mutex mutex_;
+			std::deque<std::future<void>> tasks_;
+			std::vector<std::unique_ptr<InterpretedRun>> runs_;
+
+			static std::vector<std::size_t> FindMatchingRestores(
+				const std::vector<Symbol>& symbols,
+				const ActionTable& actions)
+			{
+				std::vector<std::size_t> matches(symbols.size(), kNoMatch);
+				std::vector<std::size_t> openSaves;
+				for (std::size_t i = 0; i < symbols.size(); ++i)
+				{
+					MeshGeneratorAction* action = GetAction(actions, symbols[i]);
+					if (action == nullptr)
+					{
+						continue;
+					}
+
+					MeshGeneratorActionType actionType = action->GetActionType();
+					if (actionType == MeshGeneratorActionType::Save)
+					{
+						openSaves.push_back(i);
+					}
+					else if (actionType == MeshGeneratorActionType::Restore)
+					{
+						if (openSaves.empty())
+						{
+							throw std::runtime_error(
+								"Failed to generate mesh: symbols restore more states than they save");
+						}
+						matches[openSaves.back()] = i;
+						openSaves.pop_back();
+					}
+				}
+				return matches;
+			}
+
+			void Submit(std::size_t begin, std::size_t end, TurtleState state)
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.push_back(pool_->Submit([this, begin, end, state]() {
+					InterpretBranch(begin, end, state);
+					}));
+			}
+
+			InterpretedRun* AddRun(std::size_t begin)
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				runs_.push_back(std::make_unique<InterpretedRun>());
+				runs_.back()->begin = begin;
+				return runs_.back().get();
+			}
+
+			void InterpretBranch(std::size_t begin, std::size_t end, TurtleState entryState)
+			{
+				MeshGeneratorState state;
+				state.positionStack.push_back(entryState.position);
+				state.rotationStack.push_back(entryState.rotation);
+
+				InterpretedRun* run = AddRun(begin);
+				std::size_t runBegin = begin;
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					std::size_t restore = matchingRestores_[i];
+					if (restore == kNoMatch || restore - i < kMinBranchSize)
+					{
+						continue;
+					}
+
+					// Saving then restoring leaves the state unchanged, so the
+					// branch can be skipped here once it has been handed off
+					// with a copy of the current state.
+					Interpret(symbols_, actions_, runBegin, i, &state, &run->drawOrder);
+					run->symbolMeshMap = std::move(state.symbolMeshMap);
+					state.symbolMeshMap.clear();
+
+					Submit(i + 1, restore, { state.positionStack.back(), state.rotationStack.back() });
+
+					i = restore;
+					runBegin = restore + 1;
+					run = AddRun(runBegin);
+				}
+				Interpret(symbols_, actions_, runBegin, end, &state, &run->drawOrder);
+				run->symbolMeshMap = std::move(state.symbolMeshMap);
+			}
+		};
+	}
+
+	std::vector<MeshGroup> GenerateWithPrefixScan(
+		const std::vector<Symbol>& symbols,
+		const ActionTable& actions,
+		utility::TaskPool* pool)
+	{
+		std::size_t chunkCount = std::clamp<std::size_t>(
+			symbols.size() / kMinChunkSize,
+			1,
+			pool->ThreadCount() * kChunksPerThread);
+		std::size_t chunkSize = (symbols.size() + chunkCount - 1) / chunkCount;
+
+		std::vector<ChunkSummary> summaries(chunkCount);
+		utility::ParallelFor(*pool, chunkCount, [&](std::size_t chunk) {
+			std::size_t begin = std::min(chunk * chunkSize, symbols.size());
+			std::size_t end = std::min(begin + chunkSize, symbols.size());
+			summaries[chunk] = Summarize(symbols, actions, begin, end);
+			});
+
+		// Scan over the chunks to find the states each chunk can reach from
+		// its entry stack: the top of the stack plus every state it restores.
+		std::vector<std::vector<TurtleState>> entryStates(chunkCount);
+		std::vector<TurtleState> stack{ { glm::vec3(0.0f), glm::vec3(0.0f) } };
+		for (std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			const ChunkSummary& summary = summaries[chunk];
+			if (summary.restoresBelowEntry >= stack.size())
+			{
+				throw std::runtime_error(
+					"Failed to generate mesh: symbols restore more states than they save");
+			}
+
+			std::size_t untouchedDepth = stack.size() - summary.restoresBelowEntry - 1;
+			entryStates[chunk].assign(stack.begin() + untouchedDepth, stack.end());
+
+			ExitStateEvaluator evaluator(symbols, actions, summary, entryStates[chunk]);
+			stack.resize(untouchedDepth);
+			for (std::ptrdiff_t id : summary.exitStack)
+			{
+				stack.push_back(evaluator.Evaluate(id));
+			}
+		}
+
+		std::vector<InterpretedRun> runs(chunkCount);
+		utility::ParallelFor(*pool, chunkCount, [&](std::size_t chunk) {
+			MeshGeneratorState state;
+			for (const TurtleState& entryState : entryStates[chunk])
+			{
+				state.positionStack.push_back(entryState.position);
+				state.rotationStack.push_back(entryState.rotation);
+			}
+			Interpret(
+				symbols, actions,
+				summaries[chunk].begin, summaries[chunk].end,
+				&state, &runs[chunk].drawOrder);
+			runs[chunk].begin = summaries[chunk].begin;
+			runs[chunk].symbolMeshMap = std::move(state.symbolMeshMap);
+			});
+
+		std::vector<InterpretedRun*> orderedRuns;
+		for (InterpretedRun& run : runs)
+		{
+			orderedRuns.push_back(&run);
+		}
+		return MergeRuns(orderedRuns);
+	}
+
+	std::vector<MeshGroup> GenerateWithBranchTasks(
+		const std::vector<Symbol>& symbols,
+		const ActionTable& actions,
+		utility::TaskPool* pool)
+	{
+		BranchScheduler scheduler(symbols, actions, pool);
+		return scheduler.Run();
+	}
+}
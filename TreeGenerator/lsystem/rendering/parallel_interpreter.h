@@ -0,0 +1,40 @@
+#ifndef TREE_GENERATOR_LSYSTEM_PARALLEL_INTERPRETER_H_
+#define TREE_GENERATOR_LSYSTEM_PARALLEL_INTERPRETER_H_
+
+#include <vector>
+
+#include "../core/lsystem.h"
+#include "../../utility/task_pool.h"
+#include "action_table.h"
+#include "mesh_generator.h"
+#include "mesh_generator_action.h"
+
+namespace tree_generator::lsystem
+{
+	// Interprets the symbols in parallel chunks. The output is identical to
+	// interpreting them serially.
+	//
+	// Each chunk first records, in parallel, how it changes the state stack:
+	// how many states it restores from below its entry stack, and which
+	// turtle actions lead to each state it leaves on the stack. Bracketed
+	// branches that are closed within the chunk drop out of this summary.
+	// A serial scan over the summaries then computes the exact stack each
+	// chunk starts with, by replaying only those remaining actions. Finally,
+	// the chunks are interpreted in parallel from their entry stacks and
+	// their instances are merged in order.
+	std::vector<MeshGroup> GenerateWithPrefixScan(
+		const std::vector<Symbol>& symbols,
+		const ActionTable& actions,
+		utility::TaskPool* pool);
+
+	// Interprets sufficiently large bracketed branches as separate tasks,
+	// each starting from a copy of the state at the branch's save. Branches
+	// within those branches are split off the same way. The output is
+	// identical to interpreting the symbols serially.
+	std::vector<MeshGroup> GenerateWithBranchTasks(
+		const std::vector<Symbol>& symbols,
+		const ActionTable& actions,
+		utility::TaskPool* pool);
+}
+
+#endif  // !TREE_GENERATOR_LSYSTEM_PARALLEL_INTERPRETER_H_
@@ -0,0 +1,383 @@
+#include "subtree_instancer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "../../graphics/common/transform.h"
+
+namespace tree_generator::lsystem
+{
+	namespace
+	{
+		constexpr std::size_t kNoGroup = static_cast<std::size_t>(-1);
+
+		template <typename T>
+		using SymbolArray = std::array<T, 256>;
+
+		std::size_t ToIndex(Symbol symbol)
+		{
+			return static_cast<unsigned char>(symbol);
+		}
+
+		std::vector<Symbol> Expand(Symbol symbol, const RuleMap& rules, int iterations)
+		{
+			std::vector<Symbol> expansion{ symbol };
+			for (int i = 0; i < iterations; ++i)
+			{
+				expansion = Iterate(expansion, rules);
+			}
+			return expansion;
+		}
+
+		// Summary of every symbol's expansion at every depth, computed without
+		// expanding anything, to choose the depth of the templates. Counts
+		// grow exponentially with the depth, so they are kept as doubles.
+		class ExpansionStatistics
+		{
+		public:
+			ExpansionStatistics(
+				const LSystem& lSystem,
+				int iterations,
+				const ActionTable& actions) :
+				iterations_(iterations),
+				successors_{},
+				drawCounts_(iterations + 1),
+				bracketBalances_(iterations + 1),
+				lowestBracketBalances_(iterations + 1),
+				occurrences_(iterations + 1)
+			{
+				for (const auto& [symbol, successor] : lSystem.rules)
+				{
+					successors_[ToIndex(symbol)] = &successor;
+				}
+
+				for (std::size_t i = 0; i < actions.size(); ++i)
+				{
+					MeshGeneratorActionType type = actions[i] == nullptr
+						? MeshGeneratorActionType::None
+						: actions[i]->GetActionType();
+					drawCounts_[0][i] = type == MeshGeneratorActionType::Draw ? 1.0 : 0.0;
+					bracketBalances_[0][i] =
+						type == MeshGeneratorActionType::Save ? 1.0 :
+						type == MeshGeneratorActionType::Restore ? -1.0 :
+						0.0;
+					lowestBracketBalances_[0][i] = std::min(0.0, bracketBalances_[0][i]);
+				}
+
+				for (int depth = 1; depth <= iterations; ++depth)
+				{
+					for (std::size_t i = 0; i < successors_.size(); ++i)
+					{
+						if (successors_[i] == nullptr)
+						{
+							drawCounts_[depth][i] = drawCounts_[0][i];
+							bracketBalances_[depth][i] = bracketBalances_[0][i];
+							lowestBracketBalances_[depth][i] = lowestBracketBalances_[0][i];
+							continue;
+						}
+
+						double drawCount = 0.0;
+						double balance = 0.0;
+						double lowestBalance = 0.0;
+						for (Symbol child : *successors_[i])
+						{
+							std::size_t c = ToIndex(child);
+							drawCount += drawCounts_[depth - 1][c];
+							lowestBalance = std::min(
+								lowestBalance, balance + lowestBracketBalances_[depth - 1][c]);
+							balance += bracketBalances_[depth - 1][c];
+						}
+						drawCounts_[depth][i] = drawCount;
+						bracketBalances_[depth][i] = balance;
+						lowestBracketBalances_[depth][i] = lowestBalance;
+					}
+				}
+
+				for (Symbol symbol : lSystem.axiom)
+				{
+					occurrences_[0][ToIndex(symbol)] += 1.0;
+				}
+				for (int generation = 1; generation <= iterations; ++generation)
+				{
+					for (std::size_t i = 0; i < successors_.size(); ++i)
+					{
+						double count = occurrences_[generation - 1][i];
+						if (count == 0.0)
+						{
+							continue;
+						}
+
+						if (successors_[i] == nullptr)
+						{
+							occurrences_[generation][i] += count;
+							continue;
+						}
+						for (Symbol child : *successors_[i])
+						{
+							occurrences_[generation][ToIndex(child)] += count;
+						}
+					}
+				}
+			}
+
+			// Whether occurrences of the symbol with `depth` iterations left can
+			// be drawn from a template: the symbol must expand, and its
+			// expansion must restore exactly the states it saves.
+			bool IsTemplate(Symbol symbol, int depth) const
+			{
+				std::size_t i = ToIndex(symbol);
+				return depth > 0 &&
+					successors_[i] != nullptr &&
+					bracketBalances_[depth][i] == 0.0 &&
+					lowestBracketBalances_[depth][i] == 0.0;
+			}
+
+			// Number of matrices needed when all possible subtrees with `depth`
+			// iterations left are templated. A depth of 0 uses no templates.
+			double GetMatrixCount(int depth) const
+			{
+				const SymbolArray<double>& occurrences = occurrences_[iterations_ - depth];
+
+				double matrixCount = 0.0;
+				for (std::size_t i = 0; i < occurrences.size(); ++i)
+				{
+					double drawCount = drawCounts_[depth][i];
+					if (occurrences[i] == 0.0 || drawCount == 0.0)
+					{
+						continue;
+					}
+
+					if (IsTemplate(static_cast<Symbol>(i), depth))
+					{
+						matrixCount += drawCount + occurrences[i];
+					}
+					else
+					{
+						matrixCount += drawCount * occurrences[i];
+					}
+				}
+				return matrixCount;
+			}
+
+		private:
+			int iterations_;
+			SymbolArray<const std::vector<Symbol>*> successors_;
+
+			// Indexed by depth, then symbol. A save counts as +1 to the
+			// bracket balance and a restore as -1.
+			std::vector<SymbolArray<double>> drawCounts_;
+			std::vector<SymbolArray<double>> bracketBalances_;
+			std::vector<SymbolArray<double>> lowestBracketBalances_;
+
+			// Indexed by generation, then symbol.
+			std::vector<SymbolArray<double>> occurrences_;
+		};
+
+		// The instances drawn by one subtree, or by everything outside of the
+		// templates.
+		struct Template
+		{
+			// Index of the group drawn into for each symbol, and the groups in
+			// the order they were first drawn.
+			SymbolArray<std::size_t> groupIndices;
+			std::vector<std::size_t> groups;
+
+			// Change of the turtle's position and rotation over the subtree,
+			// relative to the turtle's frame before it.
+			glm::vec3 exitPosition = glm::vec3(0.0f);
+			glm::vec3 exitRotation = glm::vec3(0.0f);
+
+			Template() { groupIndices.fill(kNoGroup); }
+		};
+
+		class SubtreeBuilder
+		{
+		public:
+			SubtreeBuilder(
+				const LSystem& lSystem,
+				const ActionTable& actions,
+				const ExpansionStatistics& statistics,
+				int depth) :
+				lSystem_(lSystem),
+				actions_(actions),
+				statistics_(statistics),
+				depth_(depth)
+			{
+				state_.positionStack.push_back(glm::vec3(0.0f));
+				state_.rotationStack.push_back(glm::vec3(0.0f));
+			}
+
+			void Interpret(Symbol symbol)
+			{
+				if (statistics_.IsTemplate(symbol, depth_))
+				{
+					Place(GetTemplate(symbol));
+				}
+				else if (depth_ > 0 && lSystem_.rules.contains(symbol))
+				{
+					for (Symbol child : Expand(symbol, lSystem_.rules, depth_))
+					{
+						Interpret(child, &state_, &root_);
+					}
+				}
+				else
+				{
+					Interpret(symbol, &state_, &root_);
+				}
+			}
+
+			std::vector<SubtreeMeshGroup> Finish()
+			{
+				for (std::size_t group : root_.groups)
+				{
+					groups_[group].placements.push_back(glm::mat4(1.0f));
+				}
+				return std::move(groups_);
+			}
+
+		private:
+			const LSystem& lSystem_;
+			const ActionTable& actions_;
+			const ExpansionStatistics& statistics_;
+			int depth_;
+
+			MeshGeneratorState state_;
+			Template root_;
+			SymbolArray<std::unique_ptr<Template>> templates_;
+			std::vector<SubtreeMeshGroup> groups_;
+
+			void Interpret(Symbol symbol, MeshGeneratorState* state, Template* target)
+			{
+				MeshGeneratorAction* action = GetAction(actions_, symbol);
+				if (action == nullptr)
+				{
+					return;
+				}
+				if (action->GetActionType() != MeshGeneratorActionType::Draw)
+				{
+					action->PerformAction(symbol, state);
+					return;
+				}
+
+				const DrawAction* drawAction = static_cast<const DrawAction*>(action);
+				std::size_t& groupIndex = target->groupIndices[ToIndex(symbol)];
+				if (groupIndex == kNoGroup)
+				{
+					groupIndex = groups_.size();
+					target->groups.push_back(groupIndex);
+					groups_.push_back({ drawAction->GetMesh(), {}, {}, drawAction->GetMaterial() });
+				}
+				groups_[groupIndex].localInstances.push_back(
+					ToMatrix(drawAction->CreateInstance(*state)));
+			}
+
+			const Template& GetTemplate(Symbol symbol)
+			{
+				std::unique_ptr<Template>& subtree = templates_[ToIndex(symbol)];
+				if (subtree == nullptr)
+				{
+					subtree = std::make_unique<Template>();
+
+					MeshGeneratorState state;
+					state.positionStack.push_back(glm::vec3(0.0f));
+					state.rotationStack.push_back(glm::vec3(0.0f));
+					for (Symbol child : Expand(symbol, lSystem_.rules, depth_))
+					{
+						Interpret(child, &state, subtree.get());
+					}
+					subtree->exitPosition = state.positionStack.back();
+					subtree->exitRotation = state.rotationStack.back();
+				}
+				return *subtree;
+			}
+
+			void Place(const Template& subtree)
+			{
+				glm::vec3& position = state_.positionStack.back();
+				glm::vec3& rotation = state_.rotationStack.back();
+
+				const glm::mat4 placement = ToMatrix({ position, rotation, 1.0f });
+				for (std::size_t group : subtree.groups)
+				{
+					groups_[group].placements.push_back(placement);
+				}
+
+				position += glm::vec3(placement * glm::vec4(subtree.exitPosition, 0.0f));
+				rotation += subtree.exitRotation;
+			}
+		};
+	}
+
+	bool CanInstanceSubtrees(const ActionTable& actions)
+	{
+		int rotationAxis = -1;
+		for (MeshGeneratorAction* action : actions)
+		{
+			if (action == nullptr)
+			{
+				continue;
+			}
+
+			switch (action->GetActionType())
+			{
+			case MeshGeneratorActionType::None:
+				return false;
+			case MeshGeneratorActionType::Rotate:
+			{
+				const glm::vec3& rotation = static_cast<RotateAction*>(action)->GetRotation();
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					if (rotation[axis] == 0.0f)
+					{
+						continue;
+					}
+					if (rotationAxis >= 0 && rotationAxis != axis)
+					{
+						return false;
+					}
+					rotationAxis = axis;
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+		return true;
+	}
+
+	std::vector<SubtreeMeshGroup> GenerateSubtreeInstances(
+		const LSystem& lSystem,
+		int iterations,
+		const ActionTable& actions)
+	{
+		iterations = std::max(iterations, 0);
+		ExpansionStatistics statistics(lSystem, iterations, actions);
+
+		int depth = 0;
+		if (CanInstanceSubtrees(actions))
+		{
+			double matrixCount = statistics.GetMatrixCount(0);
+			for (int candidate = 1; candidate <= iterations; ++candidate)
+			{
+				if (double candidateCount = statistics.GetMatrixCount(candidate);
+					candidateCount < matrixCount)
+				{
+					matrixCount = candidateCount;
+					depth = candidate;
+				}
+			}
+		}
+
+		SubtreeBuilder builder(lSystem, actions, statistics, depth);
+		for (Symbol symbol : Generate(lSystem, iterations - depth))
+		{
+			builder.Interpret(symbol);
+		}
+		return builder.Finish();
+	}
+}
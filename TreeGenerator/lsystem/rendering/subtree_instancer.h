@@ -0,0 +1,25 @@
+#ifndef TREE_GENERATOR_LSYSTEM_SUBTREE_INSTANCER_H_
+#define TREE_GENERATOR_LSYSTEM_SUBTREE_INSTANCER_H_
+
+#include <vector>
+
+#include "../core/lsystem.h"
+#include "action_table.h"
+#include "mesh_generator_action.h"
+
+namespace tree_generator::lsystem
+{
+	// Returns whether the geometry drawn by equal subtrees only differs by a
+	// rigid transform: every rotation must be around the same single axis,
+	// and every action must be one of the known types.
+	bool CanInstanceSubtrees(const ActionTable& actions);
+
+	// Generates the derivation's instances as subtree templates and their
+	// placements. See MeshGenerator::GenerateSubtrees().
+	std::vector<SubtreeMeshGroup> GenerateSubtreeInstances(
+		const LSystem& lSystem,
+		int iterations,
+		const ActionTable& actions);
+}
+
+#endif  // !TREE_GENERATOR_LSYSTEM_SUBTREE_INSTANCER_H_
@@ -1,10 +1,18 @@
 #include "tree_generator_app.h"
 
 #include <algorithm>
+#include <exception>
 #include <format>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <numeric>
 #include <optional>
+#include <span>
+#include <stdexcept>
 #include <string_view>
+#include <utility>
 
 #include <glm/glm.hpp>
 #include <imgui.h>
@@ -12,16 +20,29 @@
 
 #include <config.h>
 
+#include "graphics/common/bounding_box.h"
 #include "graphics/common/camera.h"
+#include "graphics/common/frustum_culler.h"
+#include "graphics/common/impostor.h"
+#include "graphics/common/impostor_renderer.h"
+#include "graphics/common/lod_selector.h"
 #include "graphics/common/mesh_data.h"
+#include "graphics/common/mesh_instances.h"
 #include "graphics/common/mesh_renderer.h"
+#include "graphics/common/packed_mesh.h"
+#include "graphics/common/point_cloud_renderer.h"
 #include "graphics/common/render_context.h"
 #include "graphics/common/window.h"
+#include "graphics/opengl/opengl_impostor_baker.h"
 #include "graphics/opengl/opengl_render_context.h"
 #include "graphics/opengl/opengl_window.h"
+#include "export/glb_writer.h"
+#include "export/obj_writer.h"
+#include "export/ply_writer.h"
 #include "imgui/imgui_extensions.h"
 #include "input/camera_controller.h"
 #include "lsystem/core/lsystem.h"
+#include "lsystem/rendering/mesh_cache.h"
 #include "lsystem/rendering/mesh_definition.h"
 #include "lsystem/rendering/mesh_generator_action.h"
 
@@ -126,6 +147,65 @@ namespace tree_generator
 			}
 		}
 
+		// Size of the depth buffer used for occlusion culling, and the number
+		// of instances drawn into it as occluders.
+		constexpr int kOcclusionBufferWidth = 256;
+		constexpr int kOcclusionBufferHeight = 144;
+		constexpr std::size_t kMaxOccluderCount = 512;
+
+		// Smallest screen size, in pixels, each level of detail is drawn at,
+		// and how far past one an instance must be to switch level.
+		constexpr float kLodScreenSizes[] = { 48.0f, 16.0f, 6.0f };
+		constexpr float kLodHysteresis = 0.15f;
+
+		// Smallest screen size the whole tree, then each shallower depth of
+		// its derivation, is drawn at. Each depth is one iteration less, and
+		// trees smaller than the last size are drawn as an impostor or point
+		// cloud.
+		constexpr float kTreeLodScreenSizes[] = { 320.0f, 160.0f, 80.0f, 40.0f };
+		constexpr int kFarLod = std::size(kTreeLodScreenSizes);
+		constexpr int kMaxDepthLodCount = kFarLod - 1;
+
+		// The impostor's atlas has 8 x 8 frames of 128 x 128 pixels, much
+		// more than a tree smaller than the last level needs.
+		constexpr int kImpostorFrameCount = 8;
+		constexpr int kImpostorFrameSize = 128;
+
+		// Points sampled per tree, whatever its size, so that every tree
+		// past the last level costs the same to draw.
+		constexpr int kPointCloudBudget = 2048;
+
+		// Uploads only the mesh, keeping the renderer's instances.
+		void SetMesh(MeshRenderer* renderer, const MeshData& mesh, bool doPack)
+		{
+			if (doPack)
+			{
+				renderer->SetMesh(PackMesh(mesh));
+			}
+			else
+			{
+				renderer->SetMesh(mesh);
+			}
+		}
+
+		// Uploads the mesh, quantized if packing, which halves its vertex
+		// memory.
+		void SetMeshData(
+			MeshRenderer* renderer,
+			const MeshData& mesh,
+			std::span<const glm::mat4> instances,
+			bool doPack)
+		{
+			if (doPack)
+			{
+				renderer->SetMeshData(PackMesh(mesh), instances);
+			}
+			else
+			{
+				renderer->SetMeshData(mesh, instances);
+			}
+		}
+
 		void HandleScrollInput(CameraController* camera, double xOffset, double yOffset)
 		{
 			camera->GetCurrentMovement().remainingDistanceChange -= static_cast<float>(yOffset);
@@ -142,47 +222,6 @@ namespace tree_generator
 			lSystem.rules.push_back({ "X", "F-[[AX]+AX]+AF[+AFAX]-AX" });
 			return lSystem;
 		}
-
-		lsystem::MeshGenerator CreateDefaultMeshGenerator(
-			glm::vec3 rotation)
-		{
-			lsystem::Symbol trunk{ 'F' };
-			lsystem::Symbol leaf{ 'X' };
-
-			lsystem::Symbol push{ '[' };
-			lsystem::Symbol pop{ ']' };
-
-			lsystem::Symbol rotateRight{ '-' };
-			lsystem::Symbol rotateLeft{ '+' };
-			lsystem::Symbol advance{ 'A' };
-
-			Material trunkMaterial = { {0.5f, 0.2f, 0.0f, 1.0f} };
-			Material leafMaterial = { {0.0f, 0.5f, 0.0f, 1.0f} };
-
-			lsystem::MeshGenerator generator;
-			generator.Define(
-				trunk,
-				std::make_unique<lsystem::DrawAction>(
-					std::make_unique<lsystem::CylinderDefinition>(8, 0.15f, 0.1f),
-					trunkMaterial));
-			generator.Define(
-				leaf,
-				std::make_unique<lsystem::DrawAction>(
-					std::make_unique<lsystem::QuadDefinition>(),
-					leafMaterial));
-			generator.Define(
-				push, std::make_unique<lsystem::PushStateAction>());
-			generator.Define(
-				pop, std::make_unique<lsystem::PopStateAction>());
-			generator.Define(
-				rotateRight, std::make_unique<lsystem::RotateAction>(-rotation));
-			generator.Define(
-				rotateLeft,	std::make_unique<lsystem::RotateAction>(rotation));
-			generator.Define(
-				advance, std::make_unique<lsystem::MoveAction>(0.15f));
-
-			return generator;
-		}
 	}
 
 	TreeGeneratorApp::TreeGeneratorApp() :
@@ -195,12 +234,39 @@ namespace tree_generator
 
 		stringLSystem_(CreateTreeTypeB()),
 		meshGenerator_(
-			CreateDefaultMeshGenerator(glm::vec3(0.0f, 0.0f, 22.5f))),
+			lsystem::CreateDefaultMeshGenerator(glm::vec3(0.0f, 0.0f, 22.5f))),
+		isTreeGenerated_(false),
+
+		occlusionCuller_(kOcclusionBufferWidth, kOcclusionBufferHeight),
+		isCullingDirty_(true),
+		lodSelector_(
+			std::vector<float>(std::begin(kLodScreenSizes), std::end(kLodScreenSizes)),
+			kLodHysteresis),
+		depthLod_(0),
+		impostorBaker_(std::make_unique<opengl::OpenGLImpostorBaker>()),
+		isFarLodDrawn_(false),
+		areDistantLodsDirty_(false),
+		treeLodSelector_(
+			std::vector<float>(std::begin(kTreeLodScreenSizes), std::end(kTreeLodScreenSizes)),
+			kLodHysteresis),
+		treeLod_(0),
 
 		showDemoWindow_(false),
+		doUpdateWhileEditing_(false),
 		iterations_(5),
 		doOutputToConsole_(false),
-		doShowNormals_(false)
+		doShowNormals_(false),
+		doInstanceSubtrees_(false),
+		doPackVertices_(true),
+		doCullInstances_(true),
+		doCullOccludedInstances_(false),
+		doSelectLods_(true),
+		doSelectDepthLods_(true),
+		doDrawFarLods_(true),
+		doDrawPointClouds_(false),
+		uploadedMatrixCount_(0),
+		visibleInstanceCount_(0),
+		exportPath_("tree")
 	{
 		window_->SetKeyboardCallback([&](KeyToken keyToken, KeyAction action) {
 			HandleCameraInput(cameraController_.get(), keyToken, action);
@@ -233,14 +299,33 @@ namespace tree_generator
 
 			cameraController_->Update(elapsedTime);
 			camera_->Bind();
+			UpdateTreeLod();
+			if (isFarLodDrawn_)
+			{
+				if (doDrawPointClouds_)
+				{
+					pointCloud_->Render();
+				}
+				else
+				{
+					impostor_->Render();
+				}
+				return;
+			}
+			if (depthLod_ == 0)
+			{
+				UpdateVisibleInstances();
+			}
 
 			MeshRenderer::RenderMode renderMode =
 				doShowNormals_ ?
 				MeshRenderer::RenderMode::Normals : 
 				MeshRenderer::RenderMode::Material;
-			for (int i = 0; i < meshes_.size(); ++i)
+			const std::vector<std::unique_ptr<MeshRenderer>>& meshes =
+				depthLod_ == 0 ? meshes_ : depthLodMeshes_[depthLod_ - 1];
+			for (int i = 0; i < meshes.size(); ++i)
 			{
-				meshes_[i]->Render(renderMode);
+				meshes[i]->Render(renderMode);
 			}
 			});
 	}
@@ -253,32 +338,472 @@ namespace tree_generator
 		ShowGenerateButton();
 		ShowLSystemSection();
 		ShowMeshSection();
+		ShowExportSection();
 		ShowDebugSection();
 
 		ImGui::End();
 	}
 
-	void TreeGeneratorApp::ShowGenerateButton()
+	void TreeGeneratorApp::UpdateVisibleInstances()
+	{
+		if ((!doCullInstances_ && !doSelectLods_) || meshGroups_.empty())
+		{
+			return;
+		}
+
+		const Frustum frustum = camera_->GetFrustum();
+		if (!isCullingDirty_ && frustum.planes == culledFrustum_.planes)
+		{
+			return;
+		}
+		culledFrustum_ = frustum;
+		isCullingDirty_ = false;
+
+		visibleInstances_.clear();
+		if (doCullInstances_)
+		{
+			CullInstances(frustum, bvh_, &visibleInstances_);
+			if (doCullOccludedInstances_)
+			{
+				CullOccludedInstances();
+			}
+		}
+		else
+		{
+			visibleInstances_.resize(instanceBuffer_.Size());
+			std::iota(visibleInstances_.begin(), visibleInstances_.end(), 0);
+		}
+
+		if (doSelectLods_)
+		{
+			lodSelector_.Select(
+				instanceBounds_,
+				visibleInstances_,
+				camera_->GetViewProjection(),
+				static_cast<float>(window_->Height()),
+				instanceLods_);
+		}
+
+		// Each group's instances are a contiguous range of the instance
+		// buffer, so its visible instances are a range of the sorted indices.
+		visibleInstanceBuffer_.Resize(visibleInstances_.size());
+		std::size_t visibleCount = 0;
+		for (std::size_t i = 0; i < meshGroups_.size(); ++i)
+		{
+			const lsystem::MatrixMeshGroup& group = meshGroups_[i];
+			const std::size_t firstInstance = group.instances.data() - instanceBuffer_.Data();
+			auto Upload = [&](std::size_t lod, std::span<const std::uint32_t> visible) {
+				const std::size_t count = GatherVisibleInstances(
+					group.instances,
+					firstInstance,
+					visible,
+					visibleInstanceBuffer_.Data() + visibleCount);
+				meshes_[groupMeshIndices_[i] + lod]->SetInstances(
+					visibleInstanceBuffer_.Matrices().subspan(visibleCount, count));
+				visibleCount += count;
+				};
+
+			if (!doSelectLods_)
+			{
+				Upload(0, visibleInstances_);
+				for (std::size_t lod = 1; lod < group.lods.size(); ++lod)
+				{
+					meshes_[groupMeshIndices_[i] + lod]->SetInstances({});
+				}
+				continue;
+			}
+
+			// Levels past the group's coarsest are drawn with its coarsest.
+			lodInstances_.resize(std::max(lodInstances_.size(), group.lods.size()));
+			for (std::vector<std::uint32_t>& instances : lodInstances_)
+			{
+				instances.clear();
+			}
+			const auto first = std::lower_bound(
+				visibleInstances_.begin(), visibleInstances_.end(), firstInstance);
+			const auto last = std::lower_bound(
+				first, visibleInstances_.end(), firstInstance + group.instances.size());
+			for (auto instance = first; instance != last; ++instance)
+			{
+				const std::size_t lod = std::min<std::size_t>(
+					instanceLods_[*instance], group.lods.size() - 1);
+				lodInstances_[lod].push_back(*instance);
+			}
+			for (std::size_t lod = 0; lod < group.lods.size(); ++lod)
+			{
+				Upload(lod, lodInstances_[lod]);
+			}
+		}
+		visibleInstanceCount_ = visibleCount;
+	}
+
+	void TreeGeneratorApp::UpdateTreeLod()
 	{
-		if (ImGui::Button("Generate"))
+		int lod = 0;
+		if (doSelectDepthLods_ && !meshGroups_.empty())
+		{
+			const float screenSize = GetScreenSize(
+				bvh_.GetBounds(),
+				camera_->GetViewProjection(),
+				static_cast<float>(window_->Height()));
+			lod = treeLodSelector_.Select(screenSize, treeLod_);
+		}
+		treeLod_ = lod;
+		if (lod > 0 && areDistantLodsDirty_)
+		{
+			GenerateDistantLods();
+		}
+
+		// Without an impostor, trees smaller than the last level are drawn
+		// from the shallowest depth instead.
+		const bool isFarLodDrawn =
+			lod == kFarLod && doDrawFarLods_ && impostor_ != nullptr;
+		const int depthLod = isFarLodDrawn ?
+			0 : std::min(lod, static_cast<int>(depthLods_.size()));
+
+		// The whole tree's visible instances weren't kept up to date while
+		// it wasn't drawn.
+		if (!isFarLodDrawn && depthLod == 0 && (depthLod_ != 0 || isFarLodDrawn_))
+		{
+			isCullingDirty_ = true;
+		}
+		isFarLodDrawn_ = isFarLodDrawn;
+		depthLod_ = depthLod;
+	}
+
+	void TreeGeneratorApp::CullOccludedInstances()
+	{
+		occlusionCuller_.Begin(camera_->GetViewProjection());
+
+		// The instances covering the most of the screen are likely to hide
+		// the most, so only those are drawn as occluders.
+		std::vector<std::pair<float, std::uint32_t>> occluders;
+		occluders.reserve(visibleInstances_.size());
+		for (std::uint32_t instance : visibleInstances_)
+		{
+			const ProjectedBounds projected = occlusionCuller_.Project(instanceBounds_.Get(instance));
+			if (!projected.isClipped)
+			{
+				occluders.emplace_back(projected.Area(), instance);
+			}
+		}
+		const std::size_t occluderCount = std::min(occluders.size(), kMaxOccluderCount);
+		std::partial_sort(
+			occluders.begin(),
+			occluders.begin() + occluderCount,
+			occluders.end(),
+			std::greater<>());
+
+		for (std::size_t i = 0; i < occluderCount; ++i)
+		{
+			const std::uint32_t instance = occluders[i].second;
+			auto group = std::find_if(meshGroups_.begin(), meshGroups_.end(),
+				[this, instance](const lsystem::MatrixMeshGroup& group) {
+					const std::size_t first = group.instances.data() - instanceBuffer_.Data();
+					return instance >= first && instance < first + group.instances.size();
+				});
+			occlusionCuller_.RasterizeOccluder(*group->mesh, instanceBuffer_[instance]);
+		}
+		occlusionCuller_.Finish();
+
+		unoccludedInstances_.clear();
+		occlusionCuller_.CullInstances(instanceBounds_, visibleInstances_, &unoccludedInstances_);
+		visibleInstances_.swap(unoccludedInstances_);
+	}
+
+	void TreeGeneratorApp::ShowAllInstances()
+	{
+		for (std::size_t i = 0; i < meshGroups_.size(); ++i)
+		{
+			meshes_[groupMeshIndices_[i]]->SetInstances(meshGroups_[i].instances);
+			for (std::size_t lod = 1; lod < meshGroups_[i].lods.size(); ++lod)
+			{
+				meshes_[groupMeshIndices_[i] + lod]->SetInstances({});
+			}
+		}
+		visibleInstanceCount_ = instanceBuffer_.Size();
+	}
+
+	void TreeGeneratorApp::UpdateTree()
+	{
+		lsystem::LSystem lSystem;
+		try
+		{
+			lSystem = ParseLSystem(stringLSystem_);
+		}
+		catch (const std::runtime_error& e)
+		{
+			// Rules are often invalid while they're typed, so the tree is
+			// kept as it was until they're fixed.
+			generationError_ = e.what();
+			return;
+		}
+		generationError_.clear();
+
+		utility::ContentHasher derivationHasher;
+		AppendHash(lSystem, &derivationHasher);
+		derivationHasher.Add(iterations_);
+		const utility::ContentHash derivationHash = derivationHasher.Finish();
+
+		// Subtrees are instanced with their meshes and materials, so any
+		// change to the actions instances them again.
+		utility::ContentHasher placementHasher;
+		placementHasher.Add(doInstanceSubtrees_);
+		placementHasher.Add(doPackVertices_);
+		if (doInstanceSubtrees_)
+		{
+			meshGenerator_.AppendHash(&placementHasher);
+		}
+		else
+		{
+			meshGenerator_.AppendPlacementHash(&placementHasher);
+		}
+		const utility::ContentHash placementHash = placementHasher.Finish();
+
+		const bool isDerivationDirty = !isTreeGenerated_ || derivationHash != derivationHash_;
+		const bool isPlacementDirty = isDerivationDirty || placementHash != placementHash_;
+		derivationHash_ = derivationHash;
+		placementHash_ = placementHash;
+		isTreeGenerated_ = true;
+
+		if (isDerivationDirty)
+		{
+			derivation_.clear();
+		}
+		if (derivation_.empty() && (doOutputToConsole_ || !doInstanceSubtrees_))
 		{
-			meshes_.clear();
-			lsystem::LSystem lSystem = ParseLSystem(stringLSystem_);
-			std::vector<lsystem::Symbol> tree = lsystem::Generate(lSystem, iterations_);
+			// Every generation is kept, so the shallower depths can be drawn
+			// without deriving them again.
+			derivation_ = lsystem::GenerateDerivation(lSystem, iterations_);
 			if (doOutputToConsole_)
 			{
 				std::cout << "Generated tree: " <<
-					ToString(tree) << std::endl;
+					ToString(derivation_.back()) << std::endl;
 			}
-			std::vector<lsystem::MeshGroup> meshGroups =
-				meshGenerator_.Generate(tree);
-			for (const lsystem::MeshGroup& group : meshGroups)
+		}
+
+		if (isPlacementDirty)
+		{
+			ClearTree();
+			if (doInstanceSubtrees_)
+			{
+				GenerateSubtrees(lSystem);
+			}
+			else
+			{
+				GenerateInstances();
+			}
+			return;
+		}
+
+		bool areBoundsChanged = false;
+		for (std::size_t i = 0; i < meshGroups_.size(); ++i)
+		{
+			areBoundsChanged |= UpdateGroup(i);
+		}
+		if (areBoundsChanged)
+		{
+			bvh_ = Bvh(instanceBounds_);
+			isCullingDirty_ = true;
+		}
+	}
+
+	void TreeGeneratorApp::ClearTree()
+	{
+		meshes_.clear();
+		groupMeshIndices_.clear();
+		meshGroups_.clear();
+		depthLods_.clear();
+		depthLodMeshes_.clear();
+		depthLod_ = 0;
+		impostor_.reset();
+		pointCloud_.reset();
+		isFarLodDrawn_ = false;
+		areDistantLodsDirty_ = false;
+		uploadedMatrixCount_ = 0;
+		visibleInstanceCount_ = 0;
+	}
+
+	void TreeGeneratorApp::GenerateInstances()
+	{
+		meshGroups_ = meshGenerator_.GenerateMatrices(
+			derivation_.back(), &instanceBuffer_, &instanceBounds_);
+		bvh_ = Bvh(instanceBounds_);
+		instanceLods_.assign(instanceBuffer_.Size(), 0);
+		isCullingDirty_ = true;
+		areDistantLodsDirty_ = true;
+		for (const lsystem::MatrixMeshGroup& group : meshGroups_)
+		{
+			// Every instance starts out at the finest level, until the
+			// levels are first selected.
+			groupMeshIndices_.push_back(meshes_.size());
+			for (std::size_t lod = 0; lod < group.lods.size(); ++lod)
 			{
 				auto mesh = renderer_->CreateMeshRenderer();
-				mesh->SetMeshData(group.mesh, group.instances);
+				SetMeshData(
+					mesh.get(),
+					*group.lods[lod],
+					lod == 0 ? group.instances : std::span<const glm::mat4>(),
+					doPackVertices_);
 				mesh->SetMaterial(group.material);
 				meshes_.push_back(std::move(mesh));
 			}
+			uploadedMatrixCount_ += group.instances.size();
+		}
+		visibleInstanceCount_ = uploadedMatrixCount_;
+	}
+
+	void TreeGeneratorApp::GenerateSubtrees(const lsystem::LSystem& lSystem)
+	{
+		std::vector<lsystem::SubtreeMeshGroup> meshGroups =
+			meshGenerator_.GenerateSubtrees(lSystem, iterations_);
+		for (const lsystem::SubtreeMeshGroup& group : meshGroups)
+		{
+			auto mesh = renderer_->CreateMeshRenderer();
+			mesh->SetMeshData(*group.mesh, group.localInstances, group.placements);
+			mesh->SetMaterial(group.material);
+			meshes_.push_back(std::move(mesh));
+			uploadedMatrixCount_ +=
+				group.localInstances.size() + group.placements.size();
+		}
+	}
+
+	bool TreeGeneratorApp::UpdateGroup(std::size_t i)
+	{
+		// The placement of instances hasn't changed, so the group's symbol
+		// still has a draw action.
+		lsystem::MatrixMeshGroup& group = meshGroups_[i];
+		const lsystem::DrawAction& action = static_cast<const lsystem::DrawAction&>(
+			*meshGenerator_.GetActionMap().at(group.symbol));
+
+		bool isMaterialChanged = action.GetMaterial().color != group.material.color;
+		const bool isMeshChanged = action.GetLods() != group.lods;
+		if (isMeshChanged)
+		{
+			// Only this group's meshes are uploaded. Its renderers keep their
+			// instances, which are uploaded again after culling, since the
+			// instances' bounds change with the mesh.
+			const std::size_t firstMesh = groupMeshIndices_[i];
+			const std::size_t previousLodCount = group.lods.size();
+			group.lods = action.GetLods();
+			group.mesh = action.GetMesh();
+			if (group.lods.size() == previousLodCount)
+			{
+				for (std::size_t lod = 0; lod < group.lods.size(); ++lod)
+				{
+					SetMesh(meshes_[firstMesh + lod].get(), *group.lods[lod], doPackVertices_);
+				}
+			}
+			else
+			{
+				// A different number of levels needs new renderers, which start
+				// out without instances.
+				meshes_.erase(
+					meshes_.begin() + firstMesh,
+					meshes_.begin() + firstMesh + previousLodCount);
+				for (std::size_t lod = 0; lod < group.lods.size(); ++lod)
+				{
+					auto mesh = renderer_->CreateMeshRenderer();
+					SetMeshData(mesh.get(), *group.lods[lod], {}, doPackVertices_);
+					meshes_.insert(meshes_.begin() + firstMesh + lod, std::move(mesh));
+				}
+				for (std::size_t next = i + 1; next < groupMeshIndices_.size(); ++next)
+				{
+					groupMeshIndices_[next] =
+						groupMeshIndices_[next] + group.lods.size() - previousLodCount;
+				}
+				if (!doCullInstances_ && !doSelectLods_)
+				{
+					meshes_[firstMesh]->SetInstances(group.instances);
+				}
+				isMaterialChanged = true;
+			}
+
+			const BoundingBox meshBounds = ComputeBounds(*group.mesh);
+			const std::size_t firstInstance = group.instances.data() - instanceBuffer_.Data();
+			for (std::size_t instance = 0; instance < group.instances.size(); ++instance)
+			{
+				instanceBounds_.Set(
+					firstInstance + instance,
+					TransformBounds(meshBounds, group.instances[instance]));
+			}
+			areDistantLodsDirty_ = true;
+		}
+
+		if (isMaterialChanged)
+		{
+			group.material = action.GetMaterial();
+			for (std::size_t lod = 0; lod < group.lods.size(); ++lod)
+			{
+				meshes_[groupMeshIndices_[i] + lod]->SetMaterial(group.material);
+			}
+			areDistantLodsDirty_ = true;
+		}
+		return isMeshChanged;
+	}
+
+	void TreeGeneratorApp::GenerateDistantLods()
+	{
+		depthLods_.clear();
+		depthLodMeshes_.clear();
+		uploadedMatrixCount_ = instanceBuffer_.Size();
+		areDistantLodsDirty_ = false;
+
+		// Depth lods are only drawn where the tree is small, so their
+		// instances use the coarsest meshes.
+		std::vector<int> depths;
+		for (int depth = static_cast<int>(derivation_.size()) - 2;
+			depth > 0 && depths.size() < kMaxDepthLodCount;
+			--depth)
+		{
+			depths.push_back(depth);
+		}
+		depthLods_ = meshGenerator_.GenerateDepthLods(derivation_, depths, bvh_.GetBounds());
+		for (const lsystem::DepthLod& lod : depthLods_)
+		{
+			std::vector<std::unique_ptr<MeshRenderer>>& lodMeshes =
+				depthLodMeshes_.emplace_back();
+			for (const lsystem::MatrixMeshGroup& group : lod.groups)
+			{
+				auto mesh = renderer_->CreateMeshRenderer();
+				SetMeshData(
+					mesh.get(), *group.lods.back(), group.instances, doPackVertices_);
+				mesh->SetMaterial(group.material);
+				lodMeshes.push_back(std::move(mesh));
+			}
+			uploadedMatrixCount_ += lod.instances.Size();
+		}
+
+		std::vector<MeshInstances> impostorSources;
+		for (const lsystem::MatrixMeshGroup& group : meshGroups_)
+		{
+			impostorSources.push_back(
+				{ group.mesh.get(), group.instances, group.material });
+		}
+		impostor_ = renderer_->CreateImpostorRenderer();
+		impostor_->SetAtlas(impostorBaker_->Bake(
+			impostorSources, kImpostorFrameCount, kImpostorFrameSize));
+		const glm::vec4 farLodInstance(0.0f, 0.0f, 0.0f, 1.0f);
+		impostor_->SetInstances({ &farLodInstance, 1 });
+
+		pointCloud_ = renderer_->CreatePointCloudRenderer();
+		pointCloud_->SetPointCloud(
+			lsystem::MeshGenerator::GeneratePointCloud(meshGroups_, kPointCloudBudget));
+		pointCloud_->SetInstances({ &farLodInstance, 1 });
+	}
+
+	void TreeGeneratorApp::ShowGenerateButton()
+	{
+		const bool doGenerate = ImGui::Button("Generate");
+		ImGui::SameLine();
+		ImGui::Checkbox("Update while editing", &doUpdateWhileEditing_);
+		if (doGenerate || (doUpdateWhileEditing_ && isTreeGenerated_))
+		{
+			UpdateTree();
+		}
+		if (!generationError_.empty())
+		{
+			ImGui::Text("%s", generationError_.c_str());
 		}
 	}
 
@@ -398,12 +923,113 @@ namespace tree_generator
 		}
 	}
 
+	void TreeGeneratorApp::ShowExportSection()
+	{
+		if (ImGui::CollapsingHeader("Export"))
+		{
+			if (meshGroups_.empty())
+			{
+				ImGui::Text("Only trees without instanced subtrees can be exported");
+				return;
+			}
+
+			ImGui::InputText("Path", &exportPath_);
+			const bool doExportObj = ImGui::Button("Export OBJ");
+			ImGui::SameLine();
+			const bool doExportPly = ImGui::Button("Export PLY");
+			ImGui::SameLine();
+			const bool doExportGlb = ImGui::Button("Export GLB");
+			if (!doExportObj && !doExportPly && !doExportGlb)
+			{
+				return;
+			}
+
+			std::vector<MeshInstances> sources;
+			for (const lsystem::MatrixMeshGroup& group : meshGroups_)
+			{
+				sources.push_back({ group.mesh.get(), group.instances, group.material });
+			}
+			try
+			{
+				if (doExportObj)
+				{
+					// The material library sits next to the OBJ file, which
+					// refers to it by its name alone.
+					const std::string materialPath = exportPath_ + ".mtl";
+					const std::string materialName =
+						materialPath.substr(materialPath.find_last_of("/\\") + 1);
+					std::ofstream materials(materialPath, std::ios::binary);
+					WriteObjMaterials(sources, &materials);
+					std::ofstream obj(exportPath_ + ".obj", std::ios::binary);
+					WriteObj(sources, &obj, materialName);
+				}
+				else if (doExportPly)
+				{
+					std::ofstream ply(exportPath_ + ".ply", std::ios::binary);
+					WritePly(sources, &ply);
+				}
+				else
+				{
+					std::ofstream glb(exportPath_ + ".glb", std::ios::binary);
+					WriteGlb(sources, &glb);
+				}
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "Failed to export to " << exportPath_ << ": " << e.what() << std::endl;
+			}
+		}
+	}
+
 	void TreeGeneratorApp::ShowDebugSection()
 	{
 		if (ImGui::CollapsingHeader("Debug"))
 		{
 			ImGui::Checkbox("Output to console", &doOutputToConsole_);
 			ImGui::Checkbox("Show normals", &doShowNormals_);
+			ImGui::Checkbox("Instance repeated subtrees", &doInstanceSubtrees_);
+			ImGui::Checkbox("Pack vertices", &doPackVertices_);
+			ImGui::Text("Uploaded matrices: %zu", uploadedMatrixCount_);
+			if (ImGui::Checkbox("Cull instances outside of view", &doCullInstances_))
+			{
+				isCullingDirty_ = true;
+				if (!doCullInstances_ && !doSelectLods_)
+				{
+					ShowAllInstances();
+				}
+			}
+			if (ImGui::Checkbox("Cull instances hidden behind others", &doCullOccludedInstances_))
+			{
+				isCullingDirty_ = true;
+			}
+			if (ImGui::Checkbox("Simplify instances by screen size", &doSelectLods_))
+			{
+				isCullingDirty_ = true;
+				if (!doCullInstances_ && !doSelectLods_)
+				{
+					ShowAllInstances();
+				}
+			}
+			ImGui::Text("Visible instances: %zu", visibleInstanceCount_);
+			ImGui::Checkbox("Draw small trees from fewer iterations", &doSelectDepthLods_);
+			ImGui::Checkbox("Draw tiny trees as impostors", &doDrawFarLods_);
+			ImGui::Checkbox("Use points instead of impostors", &doDrawPointClouds_);
+			if (isFarLodDrawn_)
+			{
+				ImGui::Text(doDrawPointClouds_ ? "Drawn as points" : "Drawn as an impostor");
+			}
+			else if (depthLod_ > 0)
+			{
+				ImGui::Text("Drawn iterations: %d", depthLods_[depthLod_ - 1].depth);
+			}
+
+			lsystem::MeshCache::Statistics meshCacheStatistics =
+				lsystem::MeshCache::Global().GetStatistics();
+			ImGui::Text("Mesh cache: %zu/%zu entries, %zu hits, %zu misses",
+				meshCacheStatistics.size,
+				meshCacheStatistics.capacity,
+				meshCacheStatistics.hits,
+				meshCacheStatistics.misses);
 			if (ImGui::Button("Open Demo Window"))
 			{
 				showDemoWindow_ = true;
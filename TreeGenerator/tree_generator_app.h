@@ -1,21 +1,38 @@
 #ifndef TREE_GENERATOR_APP_H_
 #define TREE_GENERATOR_APP_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "graphics/common/bounding_box.h"
+#include "graphics/common/bvh.h"
+#include "graphics/common/frustum.h"
+#include "graphics/common/instance_buffer.h"
+#include "graphics/common/lod_selector.h"
+#include "graphics/common/occlusion_culler.h"
 #include "lsystem/core/lsystem.h"
 #include "lsystem/core/lsystem_parser.h"
 #include "lsystem/rendering/mesh_generator.h"
+#include "utility/content_hash.h"
 
 namespace tree_generator
 {
 	class Camera;
 	class CameraController;
+	class ImpostorRenderer;
 	class MeshRenderer;
+	class PointCloudRenderer;
 	class RenderContext;
 	class Window;
 
+	namespace opengl
+	{
+		class OpenGLImpostorBaker;
+	}
+
 	class TreeGeneratorApp
 	{
 	public:
@@ -33,19 +50,136 @@ namespace tree_generator
 		lsystem::StringLSystem stringLSystem_;
 		lsystem::MeshGenerator meshGenerator_;
 
+		// Every generation of the current tree's derivation, kept so that
+		// changes to how it's drawn don't derive it again. Empty when
+		// subtrees are instanced.
+		std::vector<std::vector<lsystem::Symbol>> derivation_;
+
+		// Hashes of the settings the current tree was generated from, one
+		// for each stage: deriving the L-system, and placing its instances
+		// (see MeshGenerator::AppendPlacementHash()). Only the stages whose
+		// settings changed are redone, see UpdateTree().
+		utility::ContentHash derivationHash_;
+		utility::ContentHash placementHash_;
+		bool isTreeGenerated_;
+		std::string generationError_;
+
 		std::vector<std::unique_ptr<MeshRenderer>> meshes_;
 
+		// Index of the first of each mesh group's renderers in meshes_. A
+		// group has one renderer for each of its levels of detail.
+		std::vector<std::size_t> groupMeshIndices_;
+
+		// Reused across generations to avoid reallocating instance storage.
+		InstanceBuffer instanceBuffer_;
+
+		// Groups of the current tree when drawn with complete model
+		// matrices, and the bounds of their instances. Empty when subtrees
+		// are instanced.
+		std::vector<lsystem::MatrixMeshGroup> meshGroups_;
+		InstanceBounds instanceBounds_;
+		Bvh bvh_;
+
+		// Instances inside of the frustum they were last culled with, and
+		// not hidden behind the largest of them.
+		OcclusionCuller occlusionCuller_;
+		std::vector<std::uint32_t> visibleInstances_;
+		std::vector<std::uint32_t> unoccludedInstances_;
+		InstanceBuffer visibleInstanceBuffer_;
+		Frustum culledFrustum_;
+		bool isCullingDirty_;
+
+		// Level of detail each instance was last drawn at, and the visible
+		// instances of one group at each level.
+		LodSelector lodSelector_;
+		std::vector<std::uint8_t> instanceLods_;
+		std::vector<std::vector<std::uint32_t>> lodInstances_;
+
+		// The current tree drawn from shallower depths of its derivation, for
+		// when it is small on screen, with one renderer per group. Level 0
+		// draws the whole tree, and level i the depth lod i - 1.
+		std::vector<lsystem::DepthLod> depthLods_;
+		std::vector<std::vector<std::unique_ptr<MeshRenderer>>> depthLodMeshes_;
+		int depthLod_;
+
+		// The current tree baked into an impostor, and sampled into a point
+		// cloud, for when it is tiny on screen. Null when subtrees are
+		// instanced.
+		std::unique_ptr<opengl::OpenGLImpostorBaker> impostorBaker_;
+		std::unique_ptr<ImpostorRenderer> impostor_;
+		std::unique_ptr<PointCloudRenderer> pointCloud_;
+		bool isFarLodDrawn_;
+
+		// Whether the depth lods, impostor and point cloud are out of date.
+		// They're only generated again once the tree is small enough on
+		// screen to draw them, so editing a tree up close doesn't wait on
+		// them.
+		bool areDistantLodsDirty_;
+
+		// Selects between the whole tree, its depth lods and its impostor or
+		// point cloud.
+		// The selected level is kept apart from depthLod_, which is clamped
+		// to the depth lods that exist.
+		LodSelector treeLodSelector_;
+		int treeLod_;
+
 		bool showDemoWindow_;
+		bool doUpdateWhileEditing_;
 		int iterations_;
 		bool doOutputToConsole_;
 		bool doShowNormals_;
+		bool doInstanceSubtrees_;
+		bool doPackVertices_;
+		bool doCullInstances_;
+		bool doCullOccludedInstances_;
+		bool doSelectLods_;
+		bool doSelectDepthLods_;
+		bool doDrawFarLods_;
+		bool doDrawPointClouds_;
+
+		// Number of matrices uploaded for the current tree.
+		std::size_t uploadedMatrixCount_;
+		std::size_t visibleInstanceCount_;
 		std::string newSymbolInput_;
 
+		// Path of exported files, without the extension.
+		std::string exportPath_;
+
 		void ShowMenu();
 
+		// Uploads only the instances inside of the camera's frustum, each to
+		// the renderer of its level of detail, if the camera changed since
+		// they were last culled.
+		void UpdateVisibleInstances();
+
+		// Chooses the depth lod, or whether to draw the impostor or point
+		// cloud, from the whole tree's screen size.
+		void UpdateTreeLod();
+		void CullOccludedInstances();
+		void ShowAllInstances();
+
+		// Redoes the stages of generating the tree whose settings changed
+		// since it was last generated: material changes only update the
+		// renderers' materials, mesh changes only upload their groups'
+		// meshes, and changes to the actions placing instances interpret
+		// the kept derivation again.
+		void UpdateTree();
+		void ClearTree();
+
+		// Interprets the last generation of the derivation into meshGroups_
+		// and uploads every group.
+		void GenerateInstances();
+		void GenerateSubtrees(const lsystem::LSystem& lSystem);
+
+		// Updates the group's renderers to its draw action's current mesh
+		// and material. Returns whether the instances' bounds changed.
+		bool UpdateGroup(std::size_t group);
+		void GenerateDistantLods();
+
 		void ShowGenerateButton();
 		void ShowLSystemSection();
 		void ShowMeshSection();
+		void ShowExportSection();
 		void ShowDebugSection();
 	};
 }
@@ -0,0 +1,224 @@
+#ifndef TREE_GENERATOR_UTILITY_CONTENT_HASH_H_
+#define TREE_GENERATOR_UTILITY_CONTENT_HASH_H_
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace tree_generator::utility
+{
+	// A 128-bit hash identifying some content, such as the inputs a tree
+	// was generated from. Hashes are the same on every platform and in
+	// every run, so they can name files.
+	struct ContentHash
+	{
+		std::uint64_t low = 0;
+		std::uint64_t high = 0;
+
+		bool operator==(const ContentHash&) const = default;
+
+		// Returns the hash as 32 lowercase hexadecimal digits.
+		std::string ToString() const
+		{
+			constexpr char kDigits[] = "0123456789abcdef";
+			std::string text(32, '0');
+			for (int i = 0; i < 16; ++i)
+			{
+				text[15 - i] = kDigits[(high >> (4 * i)) & 0xF];
+				text[31 - i] = kDigits[(low >> (4 * i)) & 0xF];
+			}
+			return text;
+		}
+	};
+
+	namespace internal
+	{
+		constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87;
+		constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4F;
+		constexpr std::uint64_t kPrime3 = 0x165667B19E3779F9;
+
+		// Keys mixed into each 16-byte stripe, so that equal stripes at
+		// different positions of the input don't cancel out.
+		constexpr std::uint64_t kSecret[8] = {
+			0xBE4BA423396CFEB8, 0x1CAD21F72C81017C, 0xDB979083E96DD4DE, 0x1F67B3B7A4A44072,
+			0x78E5C0CC4EE679CB, 0x2172FFCC7DD05A82, 0x8E2443F7744608B8, 0x4C263A81E69035E0,
+		};
+
+		inline std::uint64_t ReadLittleEndian64(const unsigned char* bytes)
+		{
+			std::uint64_t value;
+			std::memcpy(&value, bytes, sizeof(value));
+			if constexpr (std::endian::native == std::endian::big)
+			{
+				std::uint64_t swapped = 0;
+				for (int i = 0; i < 8; ++i)
+				{
+					swapped = swapped << 8 | ((value >> (8 * i)) & 0xFF);
+				}
+				value = swapped;
+			}
+			return value;
+		}
+
+		// Multiplies to 128 bits and folds the halves together, which mixes
+		// every input bit into the result.
+		inline std::uint64_t MultiplyFold(std::uint64_t a, std::uint64_t b)
+		{
+#if defined(__SIZEOF_INT128__)
+			const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+			return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+#else
+			const std::uint64_t aLow = a & 0xFFFFFFFF;
+			const std::uint64_t aHigh = a >> 32;
+			const std::uint64_t bLow = b & 0xFFFFFFFF;
+			const std::uint64_t bHigh = b >> 32;
+			const std::uint64_t lowLow = aLow * bLow;
+			const std::uint64_t highLow = aHigh * bLow;
+			const std::uint64_t lowHigh = aLow * bHigh;
+			const std::uint64_t highHigh = aHigh * bHigh;
+			const std::uint64_t cross = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + lowHigh;
+			const std::uint64_t productHigh = (highLow >> 32) + (cross >> 32) + highHigh;
+			const std::uint64_t productLow = (cross << 32) | (lowLow & 0xFFFFFFFF);
+			return productLow ^ productHigh;
+#endif
+		}
+
+		inline std::uint64_t Avalanche(std::uint64_t value)
+		{
+			value ^= value >> 37;
+			value *= 0x165667919E3779F9;
+			value ^= value >> 32;
+			return value;
+		}
+	}
+
+	// Hashes the bytes in the style of XXH3: each 16-byte stripe is mixed
+	// with a key and multiplied to 128 bits, accumulating into two
+	// independent 64-bit lanes that become the two halves of the hash.
+	// Hashing anything the size of a tree's settings takes well under a
+	// microsecond.
+	inline ContentHash HashBytes(std::span<const std::byte> bytes, std::uint64_t seed = 0)
+	{
+		using namespace internal;
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(bytes.data());
+		const std::size_t size = bytes.size();
+
+		std::uint64_t low = seed + size * kPrime1;
+		std::uint64_t high = (seed ^ kPrime3) - size * kPrime2;
+		std::size_t offset = 0;
+		for (std::size_t stripe = 0; offset + 16 <= size; offset += 16, ++stripe)
+		{
+			const std::uint64_t first = ReadLittleEndian64(data + offset);
+			const std::uint64_t second = ReadLittleEndian64(data + offset + 8);
+			const std::uint64_t* key = &kSecret[2 * (stripe % 4)];
+			low += MultiplyFold(first ^ (key[0] + seed), second ^ (key[1] - seed));
+			high += MultiplyFold(second ^ (key[1] + seed), first ^ (key[0] - seed)) + first;
+
+			// Scrambled after every 4 stripes, once the keys repeat, so that
+			// stripes moved by a multiple of 4 still change the hash.
+			if (stripe % 4 == 3)
+			{
+				low = (low << 23 | low >> 41) * kPrime1;
+				high = (high << 29 | high >> 35) * kPrime2;
+			}
+		}
+
+		// The last 1 to 15 bytes, zero padded. The length already mixed in
+		// tells apart inputs that differ only by trailing zeros.
+		if (offset < size)
+		{
+			unsigned char tail[16] = {};
+			std::memcpy(tail, data + offset, size - offset);
+			const std::uint64_t first = ReadLittleEndian64(tail);
+			const std::uint64_t second = ReadLittleEndian64(tail + 8);
+			low += MultiplyFold(first ^ kSecret[6], second ^ kSecret[7]);
+			high += MultiplyFold(second ^ kSecret[5], first ^ (kSecret[4] + low));
+		}
+
+		ContentHash hash;
+		hash.low = Avalanche(low + MultiplyFold(high ^ kPrime2, kSecret[0]));
+		hash.high = Avalanche(high + MultiplyFold(low ^ kPrime3, kSecret[1]));
+		return hash;
+	}
+
+	inline ContentHash HashBytes(std::string_view text, std::uint64_t seed = 0)
+	{
+		return HashBytes(std::as_bytes(std::span<const char>(text)), seed);
+	}
+
+	// Builds a ContentHash from a sequence of values, each written in a
+	// fixed little-endian form, so that the same values hash the same on
+	// every platform. Values are only buffered, and hashed together by
+	// Finish().
+	class ContentHasher
+	{
+	public:
+		explicit ContentHasher(std::uint64_t seed = 0) : seed_(seed) {}
+
+		// Integers and enums are widened to 64 bits, so a value hashes the
+		// same whatever type holds it.
+		template <typename T>
+			requires std::integral<T> || std::is_enum_v<T>
+		void Add(T value)
+		{
+			std::uint64_t bits;
+			if constexpr (std::is_enum_v<T>)
+			{
+				bits = static_cast<std::uint64_t>(static_cast<std::underlying_type_t<T>>(value));
+			}
+			else
+			{
+				bits = static_cast<std::uint64_t>(value);
+			}
+			for (int i = 0; i < 8; ++i)
+			{
+				bytes_.push_back(static_cast<char>(bits >> (8 * i)));
+			}
+		}
+
+		// -0 hashes as 0, and every NaN the same, since they can't be told
+		// apart by anything they're used for.
+		void Add(float value)
+		{
+			if (value == 0.0f)
+			{
+				value = 0.0f;
+			}
+			else if (value != value)
+			{
+				value = std::numeric_limits<float>::quiet_NaN();
+			}
+			const std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+			for (int i = 0; i < 4; ++i)
+			{
+				bytes_.push_back(static_cast<char>(bits >> (8 * i)));
+			}
+		}
+
+		// Text is prefixed with its length, so that "ab", "c" and "a", "bc"
+		// hash differently.
+		void Add(std::string_view text)
+		{
+			Add(text.size());
+			bytes_.append(text);
+		}
+
+		ContentHash Finish() const
+		{
+			return HashBytes(bytes_, seed_);
+		}
+
+	private:
+		std::uint64_t seed_;
+		std::string bytes_;
+	};
+}
+
+#endif // !TREE_GENERATOR_UTILITY_CONTENT_HASH_H_
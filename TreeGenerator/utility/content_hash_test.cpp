@@ -0,0 +1,146 @@
+#include "content_hash.h"
+
+#include <bit>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace tree_generator::utility
+{
+	namespace
+	{
+		int CountDifferentBits(const ContentHash& a, const ContentHash& b)
+		{
+			return std::popcount(a.low ^ b.low) + std::popcount(a.high ^ b.high);
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, HashesAreStable)
+		{
+			// Hashes name cache files, so they must never change.
+			EXPECT_EQ(HashBytes("").ToString(), "8d6678d30cf152b7b8b68c18a239a16a");
+			EXPECT_EQ(HashBytes("tree").ToString(), "50cdd8566de0e9445e2bcf53d45db22a");
+			EXPECT_EQ(
+				HashBytes("The quick brown fox jumps over the lazy dog").ToString(),
+				"837068012437f48482a62bd814a27533");
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, HashesDependOnSeed)
+		{
+			EXPECT_NE(HashBytes("tree", 1), HashBytes("tree"));
+			EXPECT_EQ(HashBytes("tree", 1), HashBytes("tree", 1));
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, TellsApartTrailingZeros)
+		{
+			std::set<std::pair<std::uint64_t, std::uint64_t>> hashes;
+			for (std::size_t size = 0; size <= 64; ++size)
+			{
+				const ContentHash hash = HashBytes(std::string(size, '\0'));
+				EXPECT_TRUE(hashes.insert({ hash.low, hash.high }).second) << size << " zeros";
+			}
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, TellsApartMovedStripes)
+		{
+			// Two 16-byte stripes swapped, 4 stripes apart, where the keys
+			// mixed into them are the same.
+			std::string a(128, 'a');
+			std::string b = a;
+			a.replace(0, 16, 16, 'x');
+			b.replace(64, 16, 16, 'x');
+
+			EXPECT_NE(HashBytes(a), HashBytes(b));
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, HasNoCollisionsOnShortStrings)
+		{
+			std::set<std::pair<std::uint64_t, std::uint64_t>> hashes;
+			for (int i = 0; i < 100000; ++i)
+			{
+				const ContentHash hash = HashBytes(std::to_string(i));
+				EXPECT_TRUE(hashes.insert({ hash.low, hash.high }).second) << i;
+			}
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, FlipsHalfOfTheBitsForEveryInputBit)
+		{
+			int totalBitCount = 0;
+			int flipCount = 0;
+			for (std::size_t size = 1; size <= 48; ++size)
+			{
+				std::string input(size, '\0');
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					input[i] = static_cast<char>(i * 37 + size);
+				}
+				const ContentHash hash = HashBytes(input);
+				for (std::size_t bit = 0; bit < 8 * size; ++bit)
+				{
+					std::string flipped = input;
+					flipped[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+					const int bitCount = CountDifferentBits(hash, HashBytes(flipped));
+					EXPECT_GT(bitCount, 32) << size << " bytes, bit " << bit;
+					EXPECT_LT(bitCount, 96) << size << " bytes, bit " << bit;
+					totalBitCount += bitCount;
+					++flipCount;
+				}
+			}
+			EXPECT_NEAR(static_cast<double>(totalBitCount) / flipCount, 64.0, 1.0);
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, HasherWritesValuesInFixedForm)
+		{
+			enum class Small : char { Value = 5 };
+			ContentHasher a;
+			a.Add(5);
+			a.Add(1.5f);
+			a.Add("tree");
+			ContentHasher b;
+			b.Add(Small::Value);
+			b.Add(1.5f);
+			b.Add(std::string("tree"));
+
+			EXPECT_EQ(a.Finish(), b.Finish());
+			EXPECT_EQ(
+				a.Finish(),
+				HashBytes(std::string_view(
+					"\x05\0\0\0\0\0\0\0" "\0\0\xC0\x3F" "\x04\0\0\0\0\0\0\0" "tree", 24)));
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, HasherSeparatesText)
+		{
+			ContentHasher a;
+			a.Add("ab");
+			a.Add("c");
+			ContentHasher b;
+			b.Add("a");
+			b.Add("bc");
+
+			EXPECT_NE(a.Finish(), b.Finish());
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, HasherTreatsEqualFloatsAlike)
+		{
+			ContentHasher zero;
+			zero.Add(0.0f);
+			ContentHasher negativeZero;
+			negativeZero.Add(-0.0f);
+			ContentHasher other;
+			other.Add(1e-30f);
+
+			EXPECT_EQ(zero.Finish(), negativeZero.Finish());
+			EXPECT_NE(zero.Finish(), other.Finish());
+		}
+
+		TEST(TreeGeneratorUtilityContentHashTest, FormatsAsHexadecimal)
+		{
+			const ContentHash hash{ 0x0123456789ABCDEF, 0xFEDCBA9876543210 };
+
+			EXPECT_EQ(hash.ToString(), "fedcba98765432100123456789abcdef");
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#ifndef TREE_GENERATOR_UTILITY_TASK_POOL_H_
+#define TREE_GENERATOR_UTILITY_TASK_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tree_generator::utility
+{
+	// A fixed set of worker threads that run submitted tasks in FIFO order.
+	//
+	// Tasks may submit further tasks, but must not block waiting on them:
+	// with every worker waiting, nothing would be left to run the new tasks.
+	class TaskPool
+	{
+	public:
+		// A pool shared by the whole process, sized to the hardware.
+		static TaskPool& Default()
+		{
+			static TaskPool pool(std::thread::hardware_concurrency());
+			return pool;
+		}
+
+		explicit TaskPool(unsigned int threadCount)
+		{
+			if (threadCount < 1)
+			{
+				threadCount = 1;
+			}
+			workers_.reserve(threadCount);
+			for (unsigned int i = 0; i < threadCount; ++i)
+			{
+				workers_.emplace_back([this]() { RunWorker(); });
+			}
+		}
+
+		~TaskPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				isStopping_ = true;
+			}
+			condition_.notify_all();
+			for (std::thread& worker : workers_)
+			{
+				worker.join();
+			}
+		}
+
+		// Disallow copy and move
+		TaskPool(const TaskPool&) = delete;
+		TaskPool& operator=(const TaskPool&) = delete;
+		TaskPool(TaskPool&&) = delete;
+		TaskPool& operator=(TaskPool&&) = delete;
+
+		unsigned int ThreadCount() const
+		{
+			return static_cast<unsigned int>(workers_.size());
+		}
+
+		template <typename TFunction>
+		std::future<std::invoke_result_t<TFunction>> Submit(TFunction function)
+		{
+			// std::function requires a copyable target, so the move-only
+			// packaged_task is kept behind a shared_ptr.
+			auto task = std::make_shared<
+				std::packaged_task<std::invoke_result_t<TFunction>()>>(
+					std::move(function));
+			std::future<std::invoke_result_t<TFunction>> result = task->get_future();
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks_.emplace([task]() { (*task)(); });
+			}
+			condition_.notify_one();
+			return result;
+		}
+
+	private:
+		std::vector<std::thread> workers_;
+		std::queue<std::function<void()>> tasks_;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		bool isStopping_ = false;
+
+		void RunWorker()
+		{
+			while (true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					condition_.wait(lock, [this]() {
+						return isStopping_ || !tasks_.empty();
+						});
+					if (tasks_.empty())
+					{
+						return;
+					}
+					task = std::move(tasks_.front());
+					tasks_.pop();
+				}
+				task();
+			}
+		}
+	};
+
+	// Calls function(i) for every i in [0, count) using the pool, and waits
+	// for all calls to finish. Exceptions thrown by function are rethrown.
+	template <typename TFunction>
+	void ParallelFor(TaskPool& pool, std::size_t count, TFunction function)
+	{
+		std::vector<std::future<void>> results;
+		results.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			results.push_back(pool.Submit([&function, i]() { function(i); }));
+		}
+		// Wait for everything before rethrowing, since the tasks refer to
+		// function.
+		for (std::future<void>& result : results)
+		{
+			result.wait();
+		}
+		for (std::future<void>& result : results)
+		{
+			result.get();
+		}
+	}
+}
+
+#endif // !TREE_GENERATOR_UTILITY_TASK_POOL_H_